@@ -5,6 +5,7 @@
 
 #include "7zCrc.h"
 #include "CpuArch.h"
+#include "CrcFold.h"
 
 #define kCrcPoly 0xEDB88320
 
@@ -37,6 +38,9 @@ extern
 CRC_FUNC g_CrcUpdateT0_64;
 CRC_FUNC g_CrcUpdateT0_64;
 extern
+CRC_FUNC g_CrcUpdateFold;
+CRC_FUNC g_CrcUpdateFold;
+extern
 CRC_FUNC g_CrcUpdate;
 CRC_FUNC g_CrcUpdate;
 
@@ -237,6 +241,35 @@ UInt32 Z7_FASTCALL CrcUpdateT0_64(UInt32 v, const void *data, size_t size, const
 
 #endif // defined(USE_ARM64_CRC) || defined(USE_CRC_EMU)
 
+
+/* ---------- carry-less multiplication folding ---------- */
+
+#if CRC_NUM_TABLES >= 8
+
+#define CRC_FOLD_MIN_SIZE  (CRC_FOLD_BLOCK_SIZE * 4)
+
+static CRC_FOLD_FUNC g_CrcFold;
+static UInt64 g_CrcFoldConsts[CRC_FOLD_NUM_CONSTS];
+
+static UInt32 Z7_FASTCALL CrcUpdateFold(UInt32 v, const void *data, size_t size, const UInt32 *table)
+{
+  if (size >= CRC_FOLD_MIN_SIZE)
+  {
+    MY_ALIGN(16)
+    UInt64 rem[2];
+    const size_t numBlocks = size / CRC_FOLD_BLOCK_SIZE;
+    rem[0] = v;
+    rem[1] = 0;
+    g_CrcFold(rem, (const Byte *)data, numBlocks, g_CrcFoldConsts);
+    v = CrcUpdateT8(0, rem, sizeof(rem), table);
+    data = (const Byte *)data + numBlocks * CRC_FOLD_BLOCK_SIZE;
+    size &= CRC_FOLD_BLOCK_SIZE - 1;
+  }
+  return CrcUpdateT8(v, data, size, table);
+}
+
+#endif
+
 #endif // MY_CPU_LE
 
 
@@ -313,6 +346,16 @@ void Z7_FASTCALL CrcGenerateTable(void)
   #endif // CRC_NUM_TABLES < 4
 
   #ifdef MY_CPU_LE
+    #if CRC_NUM_TABLES >= 8
+      g_CrcFold = CrcFold_GetFunc();
+      if (g_CrcFold)
+      {
+        CrcFold_GenerateConsts(g_CrcFoldConsts, kCrcPoly, 32);
+        g_CrcUpdateFold = CrcUpdateFold;
+        g_CrcUpdate = CrcUpdateFold;
+      }
+    #endif
+
     #ifdef USE_ARM64_CRC
       if (CPU_IsSupported_CRC32())
       {
@@ -187,6 +187,8 @@ $O/7zBuf2.o: ../../../C/7zBuf2.c
 	$(CC) $(CFLAGS) $<
 $O/7zCrc.o: ../../../C/7zCrc.c
 	$(CC) $(CFLAGS) $<
+$O/CrcFold.o: ../../../C/CrcFold.c
+	$(CC) $(CFLAGS) $<
 $O/7zDec.o: ../../../C/7zDec.c
 	$(CC) $(CFLAGS) $<
 $O/7zFile.o: ../../../C/7zFile.c
@@ -203,6 +205,8 @@ $O/Bcj2Enc.o: ../../../C/Bcj2Enc.c
 	$(CC) $(CFLAGS) $<
 $O/Blake2s.o: ../../../C/Blake2s.c
 	$(CC) $(CFLAGS) $<
+$O/Blake3.o: ../../../C/Blake3.c
+	$(CC) $(CFLAGS) $<
 $O/Bra.o: ../../../C/Bra.c
 	$(CC) $(CFLAGS) $<
 $O/Bra86.o: ../../../C/Bra86.c
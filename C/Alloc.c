@@ -10,6 +10,12 @@
 
 #include "Alloc.h"
 
+#ifdef Z7_LARGE_PAGES_LINUX
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#endif
+
 #ifdef _WIN32
 #ifdef Z7_LARGE_PAGES
 #if defined(__clang__) || defined(__GNUC__)
@@ -140,7 +146,7 @@ static void PrintAddr(void *p)
  
 #else
 
-#ifdef _WIN32
+#if defined(_WIN32) || defined(Z7_LARGE_PAGES_LINUX)
 #define PRINT_ALLOC(name, cnt, size, ptr)
 #endif
 #define PRINT_FREE(name, cnt, ptr)
@@ -462,6 +468,143 @@ static void SzAlignedFree(ISzAllocPtr pp, void *address)
 const ISzAlloc g_AlignedAlloc = { SzAlignedAlloc, SzAlignedFree };
 
 
+#ifdef Z7_LARGE_PAGES_LINUX
+
+extern
+SIZE_T g_LargePageSize;
+SIZE_T g_LargePageSize = 0;
+
+void SetLargePageSize(void)
+{
+  /* we read default huge page size from "Hugepagesize:    2048 kB" line.
+     If there is no such line, we use the size of transparent huge page in x86/arm64. */
+  SIZE_T size = 0;
+  FILE *f = fopen("/proc/meminfo", "r");
+  if (f)
+  {
+    char s[256];
+    while (fgets(s, sizeof(s), f))
+    {
+      if (strncmp(s, "Hugepagesize:", 13) == 0)
+      {
+        const char *p = s + 13;
+        UInt64 v = 0;
+        while (*p == ' ' || *p == '\t')
+          p++;
+        for (; *p >= '0' && *p <= '9'; p++)
+          v = v * 10 + (unsigned)(*p - '0');
+        if (v < ((UInt64)1 << 32))
+          size = (SIZE_T)(v << 10);
+        break;
+      }
+    }
+    fclose(f);
+  }
+  if (size == 0)
+    size = (SIZE_T)1 << 21;
+  if ((size & (size - 1)) != 0)
+    return;
+  g_LargePageSize = size;
+}
+
+
+/* BigAlloc() writes the size of mapped block to header before returned address.
+   (size == 0) in header means that the block was allocated with g_AlignedAlloc.
+   (BIG_ALLOC_HEADER_SIZE == ALLOC_ALIGN_SIZE), so the alignment is same as in g_AlignedAlloc. */
+
+#define BIG_ALLOC_HEADER_SIZE ALLOC_ALIGN_SIZE
+
+static void *BigAlloc_Map(size_t size, size_t ps)
+{
+  void *p;
+  size_t sizeA;
+  size_t pre;
+
+  #ifdef MAP_HUGETLB
+  /* it works, if the pool of huge pages (vm.nr_hugepages) is not empty */
+  p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p != MAP_FAILED)
+  {
+    PRINT_ALLOC("Alloc-BM ", g_allocCount, size, p)
+    return p;
+  }
+  #endif
+
+  /* transparent huge pages can be used only for the regions aligned for (ps).
+     So we allocate additional (ps) bytes and we unmap unaligned parts. */
+  sizeA = size + ps;
+  if (sizeA < size)
+    return NULL;
+  p = mmap(NULL, sizeA, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    return NULL;
+  pre = (size_t)(0 - (size_t)(UIntPtr)p) & (ps - 1);
+  if (pre != 0)
+    munmap(p, pre);
+  p = (char *)p + pre;
+  if (ps != pre)
+    munmap((char *)p + size, ps - pre);
+  #ifdef MADV_HUGEPAGE
+  madvise(p, size, MADV_HUGEPAGE);
+  #endif
+  PRINT_ALLOC("Alloc-BT ", g_allocCount, size, p)
+  return p;
+}
+
+void *BigAlloc(size_t size)
+{
+  char *p;
+  size_t ps = g_LargePageSize;
+  if (size == 0)
+    return NULL;
+  if (ps != 0 && ps <= ((size_t)1 << 30) && size > (ps / 2))
+  {
+    size_t size2;
+    ps--;
+    size2 = (size + BIG_ALLOC_HEADER_SIZE + ps) & ~ps;
+    if (size2 > size)
+    {
+      p = (char *)BigAlloc_Map(size2, ps + 1);
+      if (p)
+      {
+        *(size_t *)(void *)p = size2;
+        return p + BIG_ALLOC_HEADER_SIZE;
+      }
+    }
+  }
+  if (size + BIG_ALLOC_HEADER_SIZE < size)
+    return NULL;
+  p = (char *)ISzAlloc_Alloc(&g_AlignedAlloc, size + BIG_ALLOC_HEADER_SIZE);
+  if (!p)
+    return NULL;
+  *(size_t *)(void *)p = 0;
+  return p + BIG_ALLOC_HEADER_SIZE;
+}
+
+void BigFree(void *address)
+{
+  char *p;
+  size_t size2;
+  if (!address)
+    return;
+  p = (char *)address - BIG_ALLOC_HEADER_SIZE;
+  size2 = *(const size_t *)(const void *)p;
+  if (size2 != 0)
+  {
+    PRINT_FREE("Free-BM ", g_allocCount, p)
+    munmap(p, size2);
+  }
+  else
+    ISzAlloc_Free(&g_AlignedAlloc, p);
+}
+
+static void *SzBigAlloc(ISzAllocPtr p, size_t size) { UNUSED_VAR(p)  return BigAlloc(size); }
+static void SzBigFree(ISzAllocPtr p, void *address) { UNUSED_VAR(p)  BigFree(address); }
+const ISzAlloc g_BigAlloc = { SzBigAlloc, SzBigFree };
+
+#endif // Z7_LARGE_PAGES_LINUX
+
+
 
 #define MY_ALIGN_PTR_DOWN_1(p) MY_ALIGN_PTR_DOWN(p, sizeof(void *))
 
@@ -37,18 +37,36 @@ void BigFree(void *address);
 
 #define MidAlloc(size) MyAlloc(size)
 #define MidFree(address) MyFree(address)
+
+#if defined(Z7_LARGE_PAGES) && defined(__linux__)
+
+/* BigAlloc() in Linux uses huge pages (MAP_HUGETLB or transparent huge pages),
+   if SetLargePageSize() was called */
+#define Z7_LARGE_PAGES_LINUX
+void SetLargePageSize(void);
+void *BigAlloc(size_t size);
+void BigFree(void *address);
+
+#else
+
 #define BigAlloc(size) MyAlloc(size)
 #define BigFree(address) MyFree(address)
 
 #endif
 
+#endif
+
 extern const ISzAlloc g_Alloc;
 
 #ifdef _WIN32
 extern const ISzAlloc g_BigAlloc;
 extern const ISzAlloc g_MidAlloc;
 #else
+#ifdef Z7_LARGE_PAGES_LINUX
+extern const ISzAlloc g_BigAlloc;
+#else
 #define g_BigAlloc g_AlignedAlloc
+#endif
 #define g_MidAlloc g_AlignedAlloc
 #endif
 
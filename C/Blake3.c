@@ -0,0 +1,899 @@
+/* Blake3.c -- BLAKE3 Hash
+2026-10-18 : yhnmj6666/7z contributors
+This code is derived from the BLAKE3 reference implementation
+(https://github.com/BLAKE3-team/BLAKE3, C/blake3*.c) by Jack O'Connor,
+Jean-Philippe Aumasson, Samuel Neves, Zooko Wilcox-O'Hearn and contributors,
+that is dual-licensed under CC0 1.0 (public domain dedication) and Apache License 2.0.
+This file is used under CC0 1.0 : Public domain */
+
+#include "Precomp.h"
+
+#include <string.h>
+
+#include "Blake3.h"
+#include "Compiler.h"
+#include "CpuArch.h"
+#include "RotateDefs.h"
+
+#define rotr32 rotrFixed
+
+#define BLAKE3_NUM_ROUNDS 7
+
+#define BLAKE3_FLAG_CHUNK_START  (1 << 0)
+#define BLAKE3_FLAG_CHUNK_END    (1 << 1)
+#define BLAKE3_FLAG_PARENT       (1 << 2)
+#define BLAKE3_FLAG_ROOT         (1 << 3)
+
+#define BLAKE3_NUM_CHUNK_BLOCKS  (BLAKE3_CHUNK_SIZE / BLAKE3_BLOCK_SIZE)
+
+static const UInt32 k_Blake3_IV[8] =
+{
+  0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+  0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+};
+
+// the message word indexes for each round: it's the result of repeated message permutation
+static const Byte k_Blake3_Sigma[BLAKE3_NUM_ROUNDS][16] =
+{
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 } ,
+  {  2,  6,  3, 10,  7,  0,  4, 13,  1, 11, 12,  5,  9, 14, 15,  8 } ,
+  {  3,  4, 10, 12, 13,  2,  7, 14,  6,  5,  9,  0, 11, 15,  8,  1 } ,
+  { 10,  7, 12,  9, 14,  3, 13, 15,  4,  0, 11,  2,  5,  8,  1,  6 } ,
+  { 12, 13,  9, 11, 15, 10, 14,  8,  7,  2,  5,  3,  0,  1,  6,  4 } ,
+  {  9, 14, 11,  5,  8, 12, 15,  1, 13,  3,  0, 10,  2,  6,  4,  7 } ,
+  { 11, 15,  5,  0,  1,  9,  8,  6, 14, 10,  2, 12,  3,  4,  7, 13 } ,
+};
+
+
+#define G(a, b, c, d, x, y) \
+  a += b + x;  d = rotr32(d ^ a, 16);  c += d;  b = rotr32(b ^ c, 12); \
+  a += b + y;  d = rotr32(d ^ a,  8);  c += d;  b = rotr32(b ^ c,  7);
+
+/* it updates chaining value (cv) with one block */
+
+static void Blake3_Compress(UInt32 *cv, const Byte *block, UInt32 blockLen, UInt64 counter, UInt32 flags)
+{
+  UInt32 m[16];
+  UInt32 v[16];
+  unsigned i;
+
+  for (i = 0; i < 16; i++)
+    m[i] = GetUi32(block + i * 4);
+  for (i = 0; i < 8; i++)
+    v[i] = cv[i];
+  v[ 8] = k_Blake3_IV[0];
+  v[ 9] = k_Blake3_IV[1];
+  v[10] = k_Blake3_IV[2];
+  v[11] = k_Blake3_IV[3];
+  v[12] = (UInt32)counter;
+  v[13] = (UInt32)(counter >> 32);
+  v[14] = blockLen;
+  v[15] = flags;
+
+  for (i = 0; i < BLAKE3_NUM_ROUNDS; i++)
+  {
+    const Byte *s = k_Blake3_Sigma[i];
+    G(v[0], v[4], v[ 8], v[12], m[s[ 0]], m[s[ 1]])
+    G(v[1], v[5], v[ 9], v[13], m[s[ 2]], m[s[ 3]])
+    G(v[2], v[6], v[10], v[14], m[s[ 4]], m[s[ 5]])
+    G(v[3], v[7], v[11], v[15], m[s[ 6]], m[s[ 7]])
+    G(v[0], v[5], v[10], v[15], m[s[ 8]], m[s[ 9]])
+    G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]])
+    G(v[2], v[7], v[ 8], v[13], m[s[12]], m[s[13]])
+    G(v[3], v[4], v[ 9], v[14], m[s[14]], m[s[15]])
+  }
+
+  for (i = 0; i < 8; i++)
+    cv[i] = v[i] ^ v[i + 8];
+}
+
+#undef G
+
+
+static void Z7_FASTCALL Blake3_HashMany(const Byte *data, size_t stride,
+    unsigned numInputs, unsigned numBlocks, UInt64 counter, unsigned incCounter,
+    unsigned flags, unsigned flagsStart, unsigned flagsEnd, Byte *cvs)
+{
+  for (; numInputs != 0; numInputs--)
+  {
+    UInt32 cv[8];
+    unsigned i;
+    for (i = 0; i < 8; i++)
+      cv[i] = k_Blake3_IV[i];
+    for (i = 0; i < numBlocks; i++)
+    {
+      unsigned f = flags;
+      if (i == 0)
+        f |= flagsStart;
+      if (i == numBlocks - 1)
+        f |= flagsEnd;
+      Blake3_Compress(cv, data + (size_t)i * BLAKE3_BLOCK_SIZE, BLAKE3_BLOCK_SIZE, counter, f);
+    }
+    for (i = 0; i < 8; i++)
+      SetUi32(cvs + i * 4, cv[i])
+    cvs += BLAKE3_CV_SIZE;
+    data += stride;
+    if (incCounter)
+      counter++;
+  }
+}
+
+
+
+/* ---------- SIMD code ----------
+  The SIMD code hashes several inputs in parallel:
+  each vector contains same state word for (LANES) different inputs.
+  If (numInputs < LANES), the unused lanes read the data of last input. */
+
+#if defined(MY_CPU_X86_OR_AMD64)
+  #if defined(Z7_LLVM_CLANG_VERSION)  && (Z7_LLVM_CLANG_VERSION  >= 80000) \
+     || defined(Z7_APPLE_CLANG_VERSION) && (Z7_APPLE_CLANG_VERSION >= 100000) \
+     || defined(Z7_GCC_VERSION)         && (Z7_GCC_VERSION         >= 80000)
+      #define Z7_BLAKE3_USE_SSE41
+      #define Z7_BLAKE3_USE_AVX2
+      #define Z7_BLAKE3_USE_AVX512
+      #if !defined(__SSE4_1__)
+        #define ATTRIB_SSE41  __attribute__((__target__("sse4.1")))
+      #endif
+      #if !defined(__AVX2__)
+        #define ATTRIB_AVX2   __attribute__((__target__("avx2")))
+      #endif
+      #if !defined(__AVX512F__)
+        #define ATTRIB_AVX512 __attribute__((__target__("avx512f")))
+      #endif
+  #elif defined(_MSC_VER)
+    #if (_MSC_VER >= 1600)
+      #define Z7_BLAKE3_USE_SSE41
+    #endif
+    #if (_MSC_VER >= 1800)
+      #define Z7_BLAKE3_USE_AVX2
+    #endif
+    #if (_MSC_VER >= 1911)
+      #define Z7_BLAKE3_USE_AVX512
+    #endif
+  #endif
+#elif defined(MY_CPU_ARM64) && defined(MY_CPU_LE)
+  #if defined(__clang__) || defined(__GNUC__) || defined(_MSC_VER) && (_MSC_VER >= 1910)
+    // NEON is always supported in arm64
+    #define Z7_BLAKE3_USE_NEON
+  #endif
+#endif
+
+#ifndef ATTRIB_SSE41
+  #define ATTRIB_SSE41
+#endif
+#ifndef ATTRIB_AVX2
+  #define ATTRIB_AVX2
+#endif
+#ifndef ATTRIB_AVX512
+  #define ATTRIB_AVX512
+#endif
+
+#if defined(Z7_BLAKE3_USE_SSE41) || defined(Z7_BLAKE3_USE_AVX2) || defined(Z7_BLAKE3_USE_AVX512)
+#include <immintrin.h>
+#endif
+#ifdef Z7_BLAKE3_USE_NEON
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #include <arm64_neon.h>
+  #else
+    #include <arm_neon.h>
+  #endif
+#endif
+
+
+#define B3V_G(a, b, c, d, x, y) \
+  a = V_ADD(V_ADD(a, b), x);  d = V_ROR16(V_XOR(d, a));  c = V_ADD(c, d);  b = V_ROR12(V_XOR(b, c)); \
+  a = V_ADD(V_ADD(a, b), y);  d = V_ROR8 (V_XOR(d, a));  c = V_ADD(c, d);  b = V_ROR7 (V_XOR(b, c));
+
+#define B3V_ROUNDS \
+  { unsigned r; for (r = 0; r < BLAKE3_NUM_ROUNDS; r++) { \
+    const Byte *s = k_Blake3_Sigma[r]; \
+    B3V_G(v[0], v[4], v[ 8], v[12], m[s[ 0]], m[s[ 1]]) \
+    B3V_G(v[1], v[5], v[ 9], v[13], m[s[ 2]], m[s[ 3]]) \
+    B3V_G(v[2], v[6], v[10], v[14], m[s[ 4]], m[s[ 5]]) \
+    B3V_G(v[3], v[7], v[11], v[15], m[s[ 6]], m[s[ 7]]) \
+    B3V_G(v[0], v[5], v[10], v[15], m[s[ 8]], m[s[ 9]]) \
+    B3V_G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]) \
+    B3V_G(v[2], v[7], v[ 8], v[13], m[s[12]], m[s[13]]) \
+    B3V_G(v[3], v[4], v[ 9], v[14], m[s[14]], m[s[15]]) }}
+
+/*
+B3V_HASH_MANY_BODY uses the following macros:
+  LANES           : the number of lanes in vector
+  V_TYPE          : vector type
+  V_SET1(x)       : vector with same (x) in all lanes
+  V_LOADU(p)      : unaligned load of vector from UInt32 array
+  V_STOREU(p, v)  : unaligned store of vector to UInt32 array
+  V_PREPARE       : it prepares the loading for (num) lanes
+  LOAD_MSG(p)     : it loads transposed message block (m) for lanes from (p + lane * stride)
+*/
+
+#define B3V_HASH_MANY_BODY \
+  while (numInputs != 0) \
+  { \
+    const unsigned num = numInputs < LANES ? numInputs : LANES; \
+    UInt32 ctrLo[LANES], ctrHi[LANES]; \
+    UInt32 t[8][LANES]; \
+    V_TYPE cv[8]; \
+    unsigned i, b; \
+    V_PREPARE \
+    for (i = 0; i < LANES; i++) \
+    { \
+      const UInt64 c = counter + (incCounter && i < num ? i : 0); \
+      ctrLo[i] = (UInt32)c; \
+      ctrHi[i] = (UInt32)(c >> 32); \
+    } \
+    for (i = 0; i < 8; i++) \
+      cv[i] = V_SET1(k_Blake3_IV[i]); \
+    for (b = 0; b < numBlocks; b++) \
+    { \
+      V_TYPE v[16]; \
+      V_TYPE m[16]; \
+      unsigned f = flags; \
+      if (b == 0) f |= flagsStart; \
+      if (b == numBlocks - 1) f |= flagsEnd; \
+      LOAD_MSG(data + (size_t)b * BLAKE3_BLOCK_SIZE) \
+      for (i = 0; i < 8; i++) \
+        v[i] = cv[i]; \
+      v[ 8] = V_SET1(k_Blake3_IV[0]); \
+      v[ 9] = V_SET1(k_Blake3_IV[1]); \
+      v[10] = V_SET1(k_Blake3_IV[2]); \
+      v[11] = V_SET1(k_Blake3_IV[3]); \
+      v[12] = V_LOADU(ctrLo); \
+      v[13] = V_LOADU(ctrHi); \
+      v[14] = V_SET1(BLAKE3_BLOCK_SIZE); \
+      v[15] = V_SET1(f); \
+      B3V_ROUNDS \
+      for (i = 0; i < 8; i++) \
+        cv[i] = V_XOR(v[i], v[i + 8]); \
+    } \
+    for (i = 0; i < 8; i++) \
+      V_STOREU(t[i], cv[i]); \
+    for (b = 0; b < num; b++) \
+      for (i = 0; i < 8; i++) \
+        SetUi32(cvs + (size_t)b * BLAKE3_CV_SIZE + i * 4, t[i][b]) \
+    data += (size_t)num * stride; \
+    cvs += (size_t)num * BLAKE3_CV_SIZE; \
+    numInputs -= num; \
+    if (incCounter) \
+      counter += num; \
+  }
+
+#define B3V_FUNC_START(name) \
+static void Z7_FASTCALL name(const Byte *data, size_t stride, \
+    unsigned numInputs, unsigned numBlocks, UInt64 counter, unsigned incCounter, \
+    unsigned flags, unsigned flagsStart, unsigned flagsEnd, Byte *cvs)
+
+
+#ifdef Z7_BLAKE3_USE_SSE41
+
+#define LANES 4
+#define V_TYPE __m128i
+#define V_SET1(x)  _mm_set1_epi32((Int32)(x))
+#define V_LOADU(p)  _mm_loadu_si128((const __m128i *)(const void *)(p))
+#define V_STOREU(p, v)  _mm_storeu_si128((__m128i *)(void *)(p), v);
+#define V_ADD(a, b)  _mm_add_epi32(a, b)
+#define V_XOR(a, b)  _mm_xor_si128(a, b)
+#define V_ROR_SHIFT(x, n)  _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - (n)))
+#define V_ROR16(x)  _mm_shuffle_epi8(x, k_rot16)
+#define V_ROR12(x)  V_ROR_SHIFT(x, 12)
+#define V_ROR8(x)   _mm_shuffle_epi8(x, k_rot8)
+#define V_ROR7(x)   V_ROR_SHIFT(x, 7)
+
+// it loads 4x4 words from 4 lanes and transposes them
+#define V_PREPARE
+
+#define LOAD_MSG(p) \
+  { \
+    const Byte *p0 = (p); \
+    const Byte *p1 = p0 + (num > 1 ? stride : 0); \
+    const Byte *p2 = p0 + (num > 2 ? stride * 2 : 0); \
+    const Byte *p3 = p0 + (num > 3 ? stride * 3 : 0); \
+    unsigned g; \
+    for (g = 0; g < 4; g++) \
+    { \
+      const __m128i a0 = V_LOADU(p0 + g * 16); \
+      const __m128i a1 = V_LOADU(p1 + g * 16); \
+      const __m128i a2 = V_LOADU(p2 + g * 16); \
+      const __m128i a3 = V_LOADU(p3 + g * 16); \
+      const __m128i t0 = _mm_unpacklo_epi32(a0, a1); \
+      const __m128i t1 = _mm_unpacklo_epi32(a2, a3); \
+      const __m128i t2 = _mm_unpackhi_epi32(a0, a1); \
+      const __m128i t3 = _mm_unpackhi_epi32(a2, a3); \
+      m[g * 4 + 0] = _mm_unpacklo_epi64(t0, t1); \
+      m[g * 4 + 1] = _mm_unpackhi_epi64(t0, t1); \
+      m[g * 4 + 2] = _mm_unpacklo_epi64(t2, t3); \
+      m[g * 4 + 3] = _mm_unpackhi_epi64(t2, t3); \
+    } \
+  }
+
+ATTRIB_SSE41
+B3V_FUNC_START(Blake3_HashMany_SSE41)
+{
+  const __m128i k_rot16 = _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+  const __m128i k_rot8  = _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+  B3V_HASH_MANY_BODY
+}
+
+#undef LANES
+#undef V_TYPE
+#undef V_SET1
+#undef V_LOADU
+#undef V_STOREU
+#undef V_ADD
+#undef V_XOR
+#undef V_ROR_SHIFT
+#undef V_ROR16
+#undef V_ROR12
+#undef V_ROR8
+#undef V_ROR7
+#undef LOAD_MSG
+#undef V_PREPARE
+
+#endif // Z7_BLAKE3_USE_SSE41
+
+
+#ifdef Z7_BLAKE3_USE_AVX2
+
+#define LANES 8
+#define V_TYPE __m256i
+#define V_SET1(x)  _mm256_set1_epi32((Int32)(x))
+#define V_LOADU(p)  _mm256_loadu_si256((const __m256i *)(const void *)(p))
+#define V_STOREU(p, v)  _mm256_storeu_si256((__m256i *)(void *)(p), v);
+#define V_ADD(a, b)  _mm256_add_epi32(a, b)
+#define V_XOR(a, b)  _mm256_xor_si256(a, b)
+#define V_ROR_SHIFT(x, n)  _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define V_ROR16(x)  _mm256_shuffle_epi8(x, k_rot16)
+#define V_ROR12(x)  V_ROR_SHIFT(x, 12)
+#define V_ROR8(x)   _mm256_shuffle_epi8(x, k_rot8)
+#define V_ROR7(x)   V_ROR_SHIFT(x, 7)
+
+// the word offsets of lanes for gather instructions
+#define V_PREPARE \
+  { \
+    Int32 offsets[LANES]; \
+    unsigned k; \
+    for (k = 0; k < LANES; k++) \
+      offsets[k] = (Int32)((k < num ? k : num - 1) * (stride / 4)); \
+    index = V_LOADU(offsets); \
+  }
+
+#define LOAD_MSG(p) \
+  { \
+    const int *base = (const int *)(const void *)(p); \
+    unsigned w; \
+    for (w = 0; w < 16; w++) \
+      m[w] = _mm256_i32gather_epi32(base + w, index, 4); \
+  }
+
+ATTRIB_AVX2
+B3V_FUNC_START(Blake3_HashMany_AVX2)
+{
+  const __m256i k_rot16 = _mm256_setr_epi8(
+      2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+      2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+  const __m256i k_rot8 = _mm256_setr_epi8(
+      1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+      1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+  __m256i index;
+  B3V_HASH_MANY_BODY
+}
+
+#undef LANES
+#undef V_TYPE
+#undef V_SET1
+#undef V_LOADU
+#undef V_STOREU
+#undef V_ADD
+#undef V_XOR
+#undef V_ROR_SHIFT
+#undef V_ROR16
+#undef V_ROR12
+#undef V_ROR8
+#undef V_ROR7
+#undef LOAD_MSG
+#undef V_PREPARE
+
+#endif // Z7_BLAKE3_USE_AVX2
+
+
+#ifdef Z7_BLAKE3_USE_AVX512
+
+#define LANES 16
+#define V_TYPE __m512i
+#define V_SET1(x)  _mm512_set1_epi32((Int32)(x))
+#define V_LOADU(p)  _mm512_loadu_si512((const void *)(p))
+#define V_STOREU(p, v)  _mm512_storeu_si512((void *)(p), v);
+#define V_ADD(a, b)  _mm512_add_epi32(a, b)
+#define V_XOR(a, b)  _mm512_xor_si512(a, b)
+#define V_ROR16(x)  _mm512_ror_epi32(x, 16)
+#define V_ROR12(x)  _mm512_ror_epi32(x, 12)
+#define V_ROR8(x)   _mm512_ror_epi32(x, 8)
+#define V_ROR7(x)   _mm512_ror_epi32(x, 7)
+
+// the word offsets of lanes for gather instructions
+#define V_PREPARE \
+  { \
+    Int32 offsets[LANES]; \
+    unsigned k; \
+    for (k = 0; k < LANES; k++) \
+      offsets[k] = (Int32)((k < num ? k : num - 1) * (stride / 4)); \
+    index = V_LOADU(offsets); \
+  }
+
+#define LOAD_MSG(p) \
+  { \
+    const int *base = (const int *)(const void *)(p); \
+    unsigned w; \
+    for (w = 0; w < 16; w++) \
+      m[w] = _mm512_i32gather_epi32(index, base + w, 4); \
+  }
+
+ATTRIB_AVX512
+B3V_FUNC_START(Blake3_HashMany_AVX512)
+{
+  __m512i index;
+  B3V_HASH_MANY_BODY
+}
+
+#undef LANES
+#undef V_TYPE
+#undef V_SET1
+#undef V_LOADU
+#undef V_STOREU
+#undef V_ADD
+#undef V_XOR
+#undef V_ROR16
+#undef V_ROR12
+#undef V_ROR8
+#undef V_ROR7
+#undef LOAD_MSG
+#undef V_PREPARE
+
+#endif // Z7_BLAKE3_USE_AVX512
+
+
+#ifdef Z7_BLAKE3_USE_NEON
+
+#define LANES 4
+#define V_TYPE uint32x4_t
+#define V_SET1(x)  vdupq_n_u32((UInt32)(x))
+#define V_LOADU(p)  vld1q_u32((const UInt32 *)(const void *)(p))
+#define V_STOREU(p, v)  vst1q_u32((UInt32 *)(void *)(p), v);
+#define V_ADD(a, b)  vaddq_u32(a, b)
+#define V_XOR(a, b)  veorq_u32(a, b)
+#define V_ROR_SHIFT(x, n)  vsriq_n_u32(vshlq_n_u32(x, 32 - (n)), x, n)
+#define V_ROR16(x)  vreinterpretq_u32_u16(vrev32q_u16(vreinterpretq_u16_u32(x)))
+#define V_ROR12(x)  V_ROR_SHIFT(x, 12)
+#define V_ROR8(x)   V_ROR_SHIFT(x, 8)
+#define V_ROR7(x)   V_ROR_SHIFT(x, 7)
+
+// it loads 4x4 words from 4 lanes and transposes them
+#define V_PREPARE
+
+#define LOAD_MSG(p) \
+  { \
+    const Byte *p0 = (p); \
+    const Byte *p1 = p0 + (num > 1 ? stride : 0); \
+    const Byte *p2 = p0 + (num > 2 ? stride * 2 : 0); \
+    const Byte *p3 = p0 + (num > 3 ? stride * 3 : 0); \
+    unsigned g; \
+    for (g = 0; g < 4; g++) \
+    { \
+      const uint32x4x2_t t01 = vtrnq_u32(V_LOADU(p0 + g * 16), V_LOADU(p1 + g * 16)); \
+      const uint32x4x2_t t23 = vtrnq_u32(V_LOADU(p2 + g * 16), V_LOADU(p3 + g * 16)); \
+      m[g * 4 + 0] = vcombine_u32(vget_low_u32 (t01.val[0]), vget_low_u32 (t23.val[0])); \
+      m[g * 4 + 1] = vcombine_u32(vget_low_u32 (t01.val[1]), vget_low_u32 (t23.val[1])); \
+      m[g * 4 + 2] = vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])); \
+      m[g * 4 + 3] = vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])); \
+    } \
+  }
+
+B3V_FUNC_START(Blake3_HashMany_NEON)
+{
+  B3V_HASH_MANY_BODY
+}
+
+#undef LANES
+#undef V_TYPE
+#undef V_SET1
+#undef V_LOADU
+#undef V_STOREU
+#undef V_ADD
+#undef V_XOR
+#undef V_ROR_SHIFT
+#undef V_ROR16
+#undef V_ROR12
+#undef V_ROR8
+#undef V_ROR7
+#undef LOAD_MSG
+#undef V_PREPARE
+
+#endif // Z7_BLAKE3_USE_NEON
+
+
+
+#define BLAKE3_NUM_ALGOS (BLAKE3_ALGO_AVX512 + 1)
+
+static const unsigned k_Blake3_NumLanes[BLAKE3_NUM_ALGOS] = { 1, 1, 4, 8, 16 };
+
+// (g_Blake3_Funcs[i] == NULL) means that the algo is not supported
+static BLAKE3_FUNC_HASH_MANY g_Blake3_Funcs[BLAKE3_NUM_ALGOS] =
+  { Blake3_HashMany, Blake3_HashMany, NULL, NULL, NULL };
+static unsigned g_Blake3_DefaultAlgo = BLAKE3_ALGO_SW;
+
+
+BoolInt Blake3_SetFunction(CBlake3 *p, unsigned algo)
+{
+  if (algo >= BLAKE3_NUM_ALGOS)
+    return False;
+  if (algo == BLAKE3_ALGO_DEFAULT)
+    algo = g_Blake3_DefaultAlgo;
+  if (!g_Blake3_Funcs[algo])
+    return False;
+  p->func_HashMany = g_Blake3_Funcs[algo];
+  p->numLanes = k_Blake3_NumLanes[algo];
+  return True;
+}
+
+
+static void Blake3_ResetChunk(CBlake3 *p)
+{
+  unsigned i;
+  for (i = 0; i < 8; i++)
+    p->cv[i] = k_Blake3_IV[i];
+  p->numBlocks = 0;
+  p->bufPos = 0;
+}
+
+void Blake3_InitState(CBlake3 *p)
+{
+  Blake3_ResetChunk(p);
+  p->stackSize = 0;
+  p->chunkCounter = 0;
+}
+
+void Blake3_Init(CBlake3 *p)
+{
+  Blake3_SetFunction(p, BLAKE3_ALGO_DEFAULT);
+  Blake3_InitState(p);
+}
+
+
+static void Blake3_ParentCv(const Byte *pair, Byte *cv)
+{
+  UInt32 s[8];
+  unsigned i;
+  for (i = 0; i < 8; i++)
+    s[i] = k_Blake3_IV[i];
+  Blake3_Compress(s, pair, BLAKE3_BLOCK_SIZE, 0, BLAKE3_FLAG_PARENT);
+  for (i = 0; i < 8; i++)
+    SetUi32(cv + i * 4, s[i])
+}
+
+
+/* it merges the completed subtrees in stack, if the data before chunk (chunkIndex) was processed.
+   The stack is merged lazily: we don't merge the last chaining values before
+   new data, because the parent node can be root node, if no more data is available. */
+
+static void Blake3_MergeStack(CBlake3 *p, UInt64 chunkIndex)
+{
+  unsigned numBits = 0;
+  for (; chunkIndex != 0; chunkIndex &= chunkIndex - 1)
+    numBits++;
+  while (p->stackSize > numBits)
+  {
+    p->stackSize--;
+    Blake3_ParentCv(p->stack[p->stackSize - 1], p->stack[p->stackSize - 1]);
+  }
+}
+
+// it pushes the chaining value of subtree that starts from chunk (chunkIndex)
+
+static void Blake3_PushCv(CBlake3 *p, const Byte *cv, UInt64 chunkIndex)
+{
+  Blake3_MergeStack(p, chunkIndex);
+  memcpy(p->stack[p->stackSize++], cv, BLAKE3_CV_SIZE);
+}
+
+
+/* it fills current chunk.
+   The last block of chunk is not compressed, because we don't know, is it final block or not.
+   it returns the number of processed bytes */
+
+static size_t Blake3_ChunkUpdate(CBlake3 *p, const Byte *data, size_t size)
+{
+  const size_t size0 = size;
+  for (;;)
+  {
+    unsigned rem;
+    if (p->bufPos == 0)
+      while (size > BLAKE3_BLOCK_SIZE && p->numBlocks < BLAKE3_NUM_CHUNK_BLOCKS - 1)
+      {
+        Blake3_Compress(p->cv, data, BLAKE3_BLOCK_SIZE, p->chunkCounter,
+            p->numBlocks == 0 ? BLAKE3_FLAG_CHUNK_START : 0);
+        p->numBlocks++;
+        data += BLAKE3_BLOCK_SIZE;
+        size -= BLAKE3_BLOCK_SIZE;
+      }
+    if (size == 0)
+      break;
+    if (p->bufPos == BLAKE3_BLOCK_SIZE)
+    {
+      if (p->numBlocks == BLAKE3_NUM_CHUNK_BLOCKS - 1)
+        break;
+      Blake3_Compress(p->cv, p->buf, BLAKE3_BLOCK_SIZE, p->chunkCounter,
+          p->numBlocks == 0 ? BLAKE3_FLAG_CHUNK_START : 0);
+      p->numBlocks++;
+      p->bufPos = 0;
+      continue;
+    }
+    rem = BLAKE3_BLOCK_SIZE - p->bufPos;
+    if (rem > size)
+      rem = (unsigned)size;
+    memcpy(p->buf + p->bufPos, data, rem);
+    p->bufPos += rem;
+    data += rem;
+    size -= rem;
+  }
+  return size0 - size;
+}
+
+
+static void Blake3_ChunkOutput(CBlake3 *p, UInt32 *cv, UInt32 flags)
+{
+  unsigned i;
+  for (i = 0; i < 8; i++)
+    cv[i] = p->cv[i];
+  memset(p->buf + p->bufPos, 0, BLAKE3_BLOCK_SIZE - p->bufPos);
+  Blake3_Compress(cv, p->buf, p->bufPos, p->chunkCounter, flags
+      | (p->numBlocks == 0 ? BLAKE3_FLAG_CHUNK_START : 0)
+      | BLAKE3_FLAG_CHUNK_END);
+}
+
+
+size_t Blake3_GetSubtreeSize(const CBlake3 *p, size_t size)
+{
+  size_t s;
+  if (p->numBlocks != 0 || p->bufPos != 0 || size <= BLAKE3_CHUNK_SIZE)
+    return 0;
+  /* we look for largest (s = BLAKE3_CHUNK_SIZE << k) : (s <= size),
+     and (chunkCounter) must be aligned for (s / BLAKE3_CHUNK_SIZE) */
+  s = BLAKE3_CHUNK_SIZE;
+  while (s <= size / 2 && (p->chunkCounter & ((s / BLAKE3_CHUNK_SIZE) * 2 - 1)) == 0)
+    s *= 2;
+  if (s == BLAKE3_CHUNK_SIZE)
+    return 0;
+  return s;
+}
+
+
+void Blake3_HashSubtree(const CBlake3 *p, const Byte *data, size_t size, UInt64 chunkIndex, Byte *cv)
+{
+  const size_t numChunks = size / BLAKE3_CHUNK_SIZE;
+  if (numChunks <= p->numLanes)
+  {
+    Byte cvs[BLAKE3_NUM_LANES_MAX * BLAKE3_CV_SIZE];
+    Byte cvs2[BLAKE3_NUM_LANES_MAX / 2 * BLAKE3_CV_SIZE];
+    unsigned num = (unsigned)numChunks;
+    p->func_HashMany(data, BLAKE3_CHUNK_SIZE, num, BLAKE3_NUM_CHUNK_BLOCKS, chunkIndex, 1,
+        0, BLAKE3_FLAG_CHUNK_START, BLAKE3_FLAG_CHUNK_END, cvs);
+    while (num > 1)
+    {
+      // the pairs of neighbour chaining values are the blocks of parent nodes
+      num /= 2;
+      p->func_HashMany(cvs, BLAKE3_CV_SIZE * 2, num, 1, 0, 0,
+          BLAKE3_FLAG_PARENT, 0, 0, cvs2);
+      memcpy(cvs, cvs2, num * BLAKE3_CV_SIZE);
+    }
+    memcpy(cv, cvs, BLAKE3_CV_SIZE);
+    return;
+  }
+  {
+    Byte pair[BLAKE3_CV_SIZE * 2];
+    const size_t half = size / 2;
+    Blake3_HashSubtree(p, data, half, chunkIndex, pair);
+    Blake3_HashSubtree(p, data + half, half, chunkIndex + numChunks / 2, pair + BLAKE3_CV_SIZE);
+    Blake3_ParentCv(pair, cv);
+  }
+}
+
+
+static void Blake3_MergeCvs(const Byte *cvs, unsigned num, Byte *cv)
+{
+  if (num == 1)
+    memcpy(cv, cvs, BLAKE3_CV_SIZE);
+  else
+  {
+    Byte pair[BLAKE3_CV_SIZE * 2];
+    num /= 2;
+    Blake3_MergeCvs(cvs, num, pair);
+    Blake3_MergeCvs(cvs + (size_t)num * BLAKE3_CV_SIZE, num, pair + BLAKE3_CV_SIZE);
+    Blake3_ParentCv(pair, cv);
+  }
+}
+
+
+void Blake3_AddSubtree(CBlake3 *p, const Byte *cvs, unsigned numParts, size_t size)
+{
+  /* we push two children of subtree instead of subtree node,
+     because subtree node can be root node, if no more data is available */
+  Byte cv[BLAKE3_CV_SIZE];
+  const UInt64 numChunks = size / BLAKE3_CHUNK_SIZE;
+  numParts /= 2;
+  Blake3_MergeCvs(cvs, numParts, cv);
+  Blake3_PushCv(p, cv, p->chunkCounter);
+  Blake3_MergeCvs(cvs + (size_t)numParts * BLAKE3_CV_SIZE, numParts, cv);
+  Blake3_PushCv(p, cv, p->chunkCounter + numChunks / 2);
+  p->chunkCounter += numChunks;
+}
+
+
+// current chunk is full, and there is more data. So it's not root chunk
+
+static void Blake3_FlushChunk(CBlake3 *p)
+{
+  UInt32 s[8];
+  Byte cv[BLAKE3_CV_SIZE];
+  unsigned i;
+  Blake3_ChunkOutput(p, s, 0);
+  for (i = 0; i < 8; i++)
+    SetUi32(cv + i * 4, s[i])
+  Blake3_PushCv(p, cv, p->chunkCounter);
+  p->chunkCounter++;
+  Blake3_ResetChunk(p);
+}
+
+
+size_t Blake3_Update_ToChunkBoundary(CBlake3 *p, const Byte *data, size_t size)
+{
+  const size_t pos = p->numBlocks * BLAKE3_BLOCK_SIZE + p->bufPos;
+  size_t rem;
+  if (pos == 0 || size == 0)
+    return 0;
+  rem = BLAKE3_CHUNK_SIZE - pos;
+  if (rem >= size)
+  {
+    Blake3_Update(p, data, size);
+    return size;
+  }
+  Blake3_Update(p, data, rem);
+  Blake3_FlushChunk(p);
+  return rem;
+}
+
+
+void Blake3_Update(CBlake3 *p, const Byte *data, size_t size)
+{
+  while (size != 0)
+  {
+    if (p->numBlocks != 0 || p->bufPos != 0)
+    {
+      if (p->numBlocks * BLAKE3_BLOCK_SIZE + p->bufPos == BLAKE3_CHUNK_SIZE)
+      {
+        Blake3_FlushChunk(p);
+        continue;
+      }
+    }
+    else
+    {
+      const size_t subtreeSize = Blake3_GetSubtreeSize(p, size);
+      if (subtreeSize != 0)
+      {
+        Byte cvs[BLAKE3_CV_SIZE * 2];
+        const size_t half = subtreeSize / 2;
+        Blake3_HashSubtree(p, data, half, p->chunkCounter, cvs);
+        Blake3_HashSubtree(p, data + half, half, p->chunkCounter + half / BLAKE3_CHUNK_SIZE, cvs + BLAKE3_CV_SIZE);
+        Blake3_AddSubtree(p, cvs, 2, subtreeSize);
+        data += subtreeSize;
+        size -= subtreeSize;
+        continue;
+      }
+      // we start new chunk
+      Blake3_MergeStack(p, p->chunkCounter);
+    }
+    {
+      const size_t processed = Blake3_ChunkUpdate(p, data, size);
+      data += processed;
+      size -= processed;
+    }
+  }
+}
+
+
+void Blake3_Final(CBlake3 *p, Byte *digest)
+{
+  UInt32 cv[8];
+  Byte block[BLAKE3_BLOCK_SIZE];
+  UInt32 blockLen;
+  UInt64 counter;
+  UInt32 flags;
+  unsigned num;
+  unsigned i;
+
+  if (p->stackSize == 0 || p->numBlocks != 0 || p->bufPos != 0)
+  {
+    // the output node is current chunk
+    num = p->stackSize;
+    for (i = 0; i < 8; i++)
+      cv[i] = p->cv[i];
+    memset(p->buf + p->bufPos, 0, BLAKE3_BLOCK_SIZE - p->bufPos);
+    memcpy(block, p->buf, BLAKE3_BLOCK_SIZE);
+    blockLen = p->bufPos;
+    counter = p->chunkCounter;
+    flags = (p->numBlocks == 0 ? BLAKE3_FLAG_CHUNK_START : 0) | BLAKE3_FLAG_CHUNK_END;
+  }
+  else
+  {
+    // the output node is parent of two last chaining values in stack
+    num = p->stackSize - 2;
+    for (i = 0; i < 8; i++)
+      cv[i] = k_Blake3_IV[i];
+    memcpy(block, p->stack[num], BLAKE3_CV_SIZE * 2);
+    blockLen = BLAKE3_BLOCK_SIZE;
+    counter = 0;
+    flags = BLAKE3_FLAG_PARENT;
+  }
+
+  while (num != 0)
+  {
+    Blake3_Compress(cv, block, blockLen, counter, flags);
+    num--;
+    memcpy(block, p->stack[num], BLAKE3_CV_SIZE);
+    for (i = 0; i < 8; i++)
+    {
+      SetUi32(block + BLAKE3_CV_SIZE + i * 4, cv[i])
+      cv[i] = k_Blake3_IV[i];
+    }
+    blockLen = BLAKE3_BLOCK_SIZE;
+    counter = 0;
+    flags = BLAKE3_FLAG_PARENT;
+  }
+
+  Blake3_Compress(cv, block, blockLen, counter, flags | BLAKE3_FLAG_ROOT);
+  for (i = 0; i < 8; i++)
+    SetUi32(digest + i * 4, cv[i])
+
+  Blake3_InitState(p);
+}
+
+
+void Blake3Prepare(void)
+{
+  unsigned algo = BLAKE3_ALGO_SW;
+  #ifdef MY_CPU_X86_OR_AMD64
+    #ifdef Z7_BLAKE3_USE_SSE41
+    if (CPU_IsSupported_SSE41())
+    {
+      g_Blake3_Funcs[BLAKE3_ALGO_SSE41] = Blake3_HashMany_SSE41;
+      algo = BLAKE3_ALGO_SSE41;
+    }
+    #endif
+    #ifdef Z7_BLAKE3_USE_AVX2
+    if (CPU_IsSupported_AVX2())
+    {
+      g_Blake3_Funcs[BLAKE3_ALGO_AVX2] = Blake3_HashMany_AVX2;
+      algo = BLAKE3_ALGO_AVX2;
+    }
+    #endif
+    #ifdef Z7_BLAKE3_USE_AVX512
+    if (CPU_IsSupported_AVX512())
+    {
+      g_Blake3_Funcs[BLAKE3_ALGO_AVX512] = Blake3_HashMany_AVX512;
+      algo = BLAKE3_ALGO_AVX512;
+    }
+    #endif
+  #elif defined(Z7_BLAKE3_USE_NEON)
+    g_Blake3_Funcs[BLAKE3_ALGO_SSE41] = Blake3_HashMany_NEON;
+    algo = BLAKE3_ALGO_SSE41;
+  #endif
+  g_Blake3_DefaultAlgo = algo;
+}
+
+#undef B3V_G
+#undef B3V_ROUNDS
+#undef B3V_HASH_MANY_BODY
+#undef B3V_FUNC_START
+#undef ATTRIB_SSE41
+#undef ATTRIB_AVX2
+#undef ATTRIB_AVX512
@@ -0,0 +1,115 @@
+/* Blake3.h -- BLAKE3 Hash
+2026-10-18 : yhnmj6666/7z contributors
+Derived from the BLAKE3 reference implementation (https://github.com/BLAKE3-team/BLAKE3),
+used under CC0 1.0 : Public domain */
+
+#ifndef ZIP7_INC_BLAKE3_H
+#define ZIP7_INC_BLAKE3_H
+
+#include "7zTypes.h"
+
+EXTERN_C_BEGIN
+
+#define BLAKE3_BLOCK_SIZE   64
+#define BLAKE3_CHUNK_SIZE   1024
+#define BLAKE3_DIGEST_SIZE  32
+#define BLAKE3_CV_SIZE      32
+
+// the maximum depth of tree for (2^64) bytes of input
+#define BLAKE3_MAX_DEPTH    54
+
+// the maximum number of inputs that are processed in parallel by SIMD code
+#define BLAKE3_NUM_LANES_MAX 16
+
+/*
+BLAKE3_FUNC_HASH_MANY:
+  it hashes (numInputs) inputs of same size (numBlocks * BLAKE3_BLOCK_SIZE)
+  located at (data + i * stride), and it writes chaining values to (cvs + i * BLAKE3_CV_SIZE).
+  The counter for input (i) is (counter + (incCounter ? i : 0)).
+  The flags for block are (flags | flagsStart) for first block and (flags | flagsEnd) for last block.
+*/
+
+typedef void (Z7_FASTCALL *BLAKE3_FUNC_HASH_MANY)(const Byte *data, size_t stride,
+    unsigned numInputs, unsigned numBlocks, UInt64 counter, unsigned incCounter,
+    unsigned flags, unsigned flagsStart, unsigned flagsEnd, Byte *cvs);
+
+typedef struct
+{
+  BLAKE3_FUNC_HASH_MANY func_HashMany;
+  unsigned numLanes;    // the number of inputs that are processed in parallel by (func_HashMany)
+  unsigned numBlocks;   // the number of compressed blocks in current chunk
+  unsigned bufPos;
+  unsigned stackSize;
+  UInt64 chunkCounter;
+  UInt32 cv[8];         // chaining value of current chunk
+  Byte buf[BLAKE3_BLOCK_SIZE];
+  Byte stack[BLAKE3_MAX_DEPTH + 1][BLAKE3_CV_SIZE];
+} CBlake3;
+
+
+#define BLAKE3_ALGO_DEFAULT 0
+#define BLAKE3_ALGO_SW      1
+#define BLAKE3_ALGO_SSE41   2  // SSE4.1 in x86/x64 or NEON in arm/arm64
+#define BLAKE3_ALGO_AVX2    3
+#define BLAKE3_ALGO_AVX512  4
+
+/*
+Blake3_SetFunction()
+return:
+  0 - (algo) value is not supported, and func_HashMany was not changed
+  1 - func_HashMany was set according (algo) value.
+*/
+
+BoolInt Blake3_SetFunction(CBlake3 *p, unsigned algo);
+
+void Blake3_InitState(CBlake3 *p);
+void Blake3_Init(CBlake3 *p);
+void Blake3_Update(CBlake3 *p, const Byte *data, size_t size);
+void Blake3_Final(CBlake3 *p, Byte *digest);
+
+/*
+The functions for multithreaded hashing.
+Full subtrees of chunks are independent, and they can be hashed in different threads:
+
+  processed = Blake3_Update_ToChunkBoundary(p, data, size);
+  data += processed;
+  size -= processed;
+  subtreeSize = Blake3_GetSubtreeSize(p, size);
+  if (subtreeSize != 0)
+  {
+    // split subtree to (numParts) parts of equal size (power of 2)
+    for each part (k):
+      Blake3_HashSubtree(p, data + k * partSize, partSize, p->chunkCounter + k * partSize / BLAKE3_CHUNK_SIZE, cvs + k * BLAKE3_CV_SIZE);
+    Blake3_AddSubtree(p, cvs, numParts, subtreeSize);
+  }
+  else
+    Blake3_Update(p, data, size);
+
+Blake3_Update_ToChunkBoundary() processes the minimal part of data that is required
+  to reach the boundary of chunks. It returns the number of processed bytes.
+
+Blake3_GetSubtreeSize() returns the size of the largest subtree of full chunks
+  that starts at current position, if (size) bytes of data are available.
+  It returns 0, if the data must be processed by Blake3_Update() instead.
+Blake3_HashSubtree() writes the chaining value of subtree to (cv).
+  (size) must be (BLAKE3_CHUNK_SIZE << k).
+  (chunkIndex) is the index of first chunk of subtree in the stream.
+Blake3_AddSubtree() adds the subtree that consists of (numParts) parts of equal size.
+  (numParts) must be power of 2, and (numParts >= 2).
+*/
+
+size_t Blake3_Update_ToChunkBoundary(CBlake3 *p, const Byte *data, size_t size);
+size_t Blake3_GetSubtreeSize(const CBlake3 *p, size_t size);
+void Blake3_HashSubtree(const CBlake3 *p, const Byte *data, size_t size, UInt64 chunkIndex, Byte *cv);
+void Blake3_AddSubtree(CBlake3 *p, const Byte *cvs, unsigned numParts, size_t size);
+
+/*
+call Blake3Prepare() once at program start.
+It prepares all supported implementations, and detects the fastest implementation.
+*/
+
+void Blake3Prepare(void);
+
+EXTERN_C_END
+
+#endif
@@ -422,6 +422,11 @@ BoolInt CPU_IsSupported_AES(void)
   return (x86cpuid_Func_1_ECX() >> 25) & 1;
 }
 
+BoolInt CPU_IsSupported_PCLMUL(void)
+{
+  return (x86cpuid_Func_1_ECX() >> 1) & 1;
+}
+
 BoolInt CPU_IsSupported_SSSE3(void)
 {
   return (x86cpuid_Func_1_ECX() >> 9) & 1;
@@ -662,6 +667,26 @@ BoolInt CPU_IsSupported_AVX2(void)
   }
 }
 
+BoolInt CPU_IsSupported_AVX512(void)
+{
+  if (!CPU_IsSupported_AVX())
+    return False;
+  if (z7_x86_cpuid_GetMaxFunc() < 7)
+    return False;
+  {
+    UInt32 d[4];
+    const UInt32 bm = (UInt32)x86_xgetbv_0(MY_XCR_XFEATURE_ENABLED_MASK);
+    if (0 == (1
+        & (bm >> 5)   // opmask state is supported (set by OS) for storing/restoring
+        & (bm >> 6)   // ZMM_Hi256 state
+        & (bm >> 7))) // Hi16_ZMM state
+      return False;
+    z7_x86_cpuid(d, 7);
+    return 1
+      & (d[1] >> 16); // avx512f
+  }
+}
+
 BoolInt CPU_IsSupported_VAES_AVX2(void)
 {
   if (!CPU_IsSupported_AVX())
@@ -679,6 +704,18 @@ BoolInt CPU_IsSupported_VAES_AVX2(void)
   }
 }
 
+BoolInt CPU_IsSupported_VPCLMUL_AVX512(void)
+{
+  if (!CPU_IsSupported_AVX512())
+    return False;
+  {
+    UInt32 d[4];
+    z7_x86_cpuid(d, 7);
+    return 1
+      & (d[2] >> 10); // vpclmulqdq
+  }
+}
+
 BoolInt CPU_IsSupported_PageGB(void)
 {
   CHECK_CPUID_IS_SUPPORTED
@@ -703,6 +740,15 @@ BoolInt CPU_IsSupported_CRC32(void)  { return IsProcessorFeaturePresent(PF_ARM_V
 BoolInt CPU_IsSupported_CRYPTO(void) { return IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE) ? 1 : 0; }
 BoolInt CPU_IsSupported_NEON(void)   { return IsProcessorFeaturePresent(PF_ARM_NEON_INSTRUCTIONS_AVAILABLE) ? 1 : 0; }
 
+BoolInt CPU_IsSupported_SHA512(void)
+{
+  #ifdef PF_ARM_SHA512_INSTRUCTIONS_AVAILABLE
+  return IsProcessorFeaturePresent(PF_ARM_SHA512_INSTRUCTIONS_AVAILABLE) ? 1 : 0;
+  #else
+  return 0;
+  #endif
+}
+
 #else
 
 #if defined(__APPLE__)
@@ -756,6 +802,12 @@ BoolInt CPU_IsSupported_NEON(void)
 BoolInt CPU_IsSupported_SHA1(void) { return APPLE_CRYPTO_SUPPORT_VAL; }
 BoolInt CPU_IsSupported_SHA2(void) { return APPLE_CRYPTO_SUPPORT_VAL; }
 BoolInt CPU_IsSupported_AES (void) { return APPLE_CRYPTO_SUPPORT_VAL; }
+BoolInt CPU_IsSupported_PMULL(void) { return APPLE_CRYPTO_SUPPORT_VAL; }
+
+BoolInt CPU_IsSupported_SHA512(void)
+{
+  return z7_sysctlbyname_Get_BoolInt("hw.optional.armv8_2_sha512");
+}
 
 
 #else // __APPLE__
@@ -794,6 +846,16 @@ MY_HWCAP_CHECK_FUNC (CRC32)
 MY_HWCAP_CHECK_FUNC (SHA1)
 MY_HWCAP_CHECK_FUNC (SHA2)
 MY_HWCAP_CHECK_FUNC (AES)
+MY_HWCAP_CHECK_FUNC (PMULL)
+
+BoolInt CPU_IsSupported_SHA512(void)
+{
+  #if defined(USE_HWCAP) && defined(MY_CPU_ARM64) && defined(HWCAP_SHA512)
+  return (getauxval(AT_HWCAP) & HWCAP_SHA512) ? 1 : 0;
+  #else
+  return 0;
+  #endif
+}
 
 #endif // __APPLE__
 #endif // _WIN32
@@ -486,8 +486,11 @@ UInt32 Z7_FASTCALL z7_x86_cpuid_GetMaxFunc(void);
 BoolInt CPU_IsSupported_AES(void);
 BoolInt CPU_IsSupported_AVX(void);
 BoolInt CPU_IsSupported_AVX2(void);
+BoolInt CPU_IsSupported_AVX512(void);
 BoolInt CPU_IsSupported_VAES_AVX2(void);
+BoolInt CPU_IsSupported_VPCLMUL_AVX512(void);
 BoolInt CPU_IsSupported_CMOV(void);
+BoolInt CPU_IsSupported_PCLMUL(void);
 BoolInt CPU_IsSupported_SSE(void);
 BoolInt CPU_IsSupported_SSE2(void);
 BoolInt CPU_IsSupported_SSSE3(void);
@@ -499,16 +502,19 @@ BoolInt CPU_IsSupported_PageGB(void);
 
 BoolInt CPU_IsSupported_CRC32(void);
 BoolInt CPU_IsSupported_NEON(void);
+BoolInt CPU_IsSupported_SHA512(void);
 
 #if defined(_WIN32)
 BoolInt CPU_IsSupported_CRYPTO(void);
 #define CPU_IsSupported_SHA1  CPU_IsSupported_CRYPTO
 #define CPU_IsSupported_SHA2  CPU_IsSupported_CRYPTO
 #define CPU_IsSupported_AES   CPU_IsSupported_CRYPTO
+#define CPU_IsSupported_PMULL CPU_IsSupported_CRYPTO
 #else
 BoolInt CPU_IsSupported_SHA1(void);
 BoolInt CPU_IsSupported_SHA2(void);
 BoolInt CPU_IsSupported_AES(void);
+BoolInt CPU_IsSupported_PMULL(void);
 #endif
 
 #endif
@@ -0,0 +1,297 @@
+/* CrcFold.c -- CRC calculation with carry-less multiplication folding
+2026-10-18 : yhnmj6666/7z contributors : Public domain */
+
+#include "Precomp.h"
+
+#include "Compiler.h"
+#include "CpuArch.h"
+#include "CrcFold.h"
+
+/*
+We use folding method from Intel's paper
+  "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+
+(data) is processed as four 128-bit lanes per block of 64 bytes.
+For reflected CRC, 128-bit value (v) loaded from memory is polynomial,
+where low 64 bits (H) contain high-degree coefficients:
+  v(x) = H(x) * x^64 + L(x)
+To move (v) forward for (d) bits we replace v(x) * x^d by:
+  H(x) * (x^(d+64) mod P) + L(x) * (x^d mod P)
+Carry-less multiplication of two reflected 64-bit values gives product
+that is shifted by one bit. So we store constants (x^(d+63) mod P) and (x^(d-1) mod P).
+
+consts[i * 2], consts[i * 2 + 1] : the pair for (d) from k_CrcFold_Dist[i]
+*/
+
+static const UInt16 k_CrcFold_Dist[CRC_FOLD_NUM_CONSTS / 2] =
+  { 128, 256, 384, 512, 1024, 1536, 2048 };
+
+static UInt64 CrcFold_GetPowX(unsigned e, UInt64 poly, unsigned width)
+{
+  // (r) is reflected value: bit (i) is coefficient of x^(width - 1 - i)
+  UInt64 r = (UInt64)1 << (width - 1);
+  for (; e != 0; e--)
+    r = (r >> 1) ^ (poly & ((UInt64)0 - (r & 1)));
+  return r << (64 - width);
+}
+
+void CrcFold_GenerateConsts(UInt64 *consts, UInt64 poly, unsigned width)
+{
+  unsigned i;
+  for (i = 0; i < CRC_FOLD_NUM_CONSTS / 2; i++)
+  {
+    const unsigned d = k_CrcFold_Dist[i];
+    consts[i * 2    ] = CrcFold_GetPowX(d + 63, poly, width);
+    consts[i * 2 + 1] = CrcFold_GetPowX(d - 1, poly, width);
+  }
+}
+
+
+#ifdef MY_CPU_LE
+
+#ifdef MY_CPU_X86_OR_AMD64
+
+  #if defined(__INTEL_COMPILER) && (__INTEL_COMPILER >= 1600) // fix that check
+      #define USE_CRC_FOLD_PCLMUL
+  #elif defined(Z7_LLVM_CLANG_VERSION)  && (Z7_LLVM_CLANG_VERSION  >= 30800) \
+     || defined(Z7_APPLE_CLANG_VERSION) && (Z7_APPLE_CLANG_VERSION >= 50100) \
+     || defined(Z7_GCC_VERSION)         && (Z7_GCC_VERSION         >= 40900)
+      #define USE_CRC_FOLD_PCLMUL
+      #if !defined(_INTEL_COMPILER)
+      // icc defines __GNUC__, but icc doesn't support __attribute__(__target__)
+      #if !defined(__PCLMUL__)
+        #define ATTRIB_PCLMUL __attribute__((__target__("pclmul")))
+      #endif
+      #define ATTRIB_VPCLMUL __attribute__((__target__("avx512f,vpclmulqdq,pclmul")))
+      #endif
+      #if defined(Z7_LLVM_CLANG_VERSION)  && (Z7_LLVM_CLANG_VERSION  >= 60000) \
+       || defined(Z7_APPLE_CLANG_VERSION) && (Z7_APPLE_CLANG_VERSION >= 100000) \
+       || defined(Z7_GCC_VERSION)         && (Z7_GCC_VERSION         >= 80000)
+        #define USE_CRC_FOLD_VPCLMUL
+      #endif
+  #elif defined(_MSC_VER)
+    #if (_MSC_VER >= 1900)
+      #define USE_CRC_FOLD_PCLMUL
+    #endif
+    #if (_MSC_VER >= 1920)
+      #define USE_CRC_FOLD_VPCLMUL
+    #endif
+  #endif
+
+#ifdef USE_CRC_FOLD_PCLMUL
+
+#include <immintrin.h>
+
+#ifndef ATTRIB_PCLMUL
+#define ATTRIB_PCLMUL
+#endif
+#ifndef ATTRIB_VPCLMUL
+#define ATTRIB_VPCLMUL
+#endif
+
+#define LOAD_128(p)  _mm_loadu_si128((const __m128i *)(const void *)(p))
+#define K_128(i)     LOAD_128(consts + (i) * 2)
+
+#define FOLD_128(x, k) _mm_xor_si128( \
+    _mm_clmulepi64_si128(x, k, 0x00), \
+    _mm_clmulepi64_si128(x, k, 0x11))
+
+#define FOLD_128_XOR(x, k, p)  x = _mm_xor_si128(FOLD_128(x, k), LOAD_128(p));
+
+#define CRC_FOLD_LOOP_128 \
+  if (numBlocks) \
+  { \
+    const __m128i k = K_128(3); \
+    do \
+    { \
+      FOLD_128_XOR (x0, k, data) \
+      FOLD_128_XOR (x1, k, data + 16) \
+      FOLD_128_XOR (x2, k, data + 32) \
+      FOLD_128_XOR (x3, k, data + 48) \
+      data += CRC_FOLD_BLOCK_SIZE; \
+    } \
+    while (--numBlocks); \
+  } \
+  x3 = _mm_xor_si128(x3, FOLD_128(x2, K_128(0))); \
+  x3 = _mm_xor_si128(x3, FOLD_128(x1, K_128(1))); \
+  x3 = _mm_xor_si128(x3, FOLD_128(x0, K_128(2))); \
+  _mm_storeu_si128((__m128i *)(void *)rem, x3);
+
+
+ATTRIB_PCLMUL
+static void Z7_FASTCALL CrcFold_Pclmul(UInt64 *rem, const Byte *data, size_t numBlocks, const UInt64 *consts)
+{
+  __m128i x0, x1, x2, x3;
+  x0 = _mm_xor_si128(LOAD_128(data), LOAD_128(rem));
+  x1 = LOAD_128(data + 16);
+  x2 = LOAD_128(data + 32);
+  x3 = LOAD_128(data + 48);
+  data += CRC_FOLD_BLOCK_SIZE;
+  numBlocks--;
+  CRC_FOLD_LOOP_128
+}
+
+
+#ifdef USE_CRC_FOLD_VPCLMUL
+
+#define LOAD_512(p)  _mm512_loadu_si512((const void *)(p))
+#define K_512(i)     _mm512_broadcast_i32x4(K_128(i))
+
+#define FOLD_512_XOR(x, k, y) _mm512_ternarylogic_epi64( \
+    _mm512_clmulepi64_epi128(x, k, 0x00), \
+    _mm512_clmulepi64_epi128(x, k, 0x11), y, 0x96)
+
+#define NUM_VECS_512  4
+
+ATTRIB_VPCLMUL
+static void Z7_FASTCALL CrcFold_Vpclmul(UInt64 *rem, const Byte *data, size_t numBlocks, const UInt64 *consts)
+{
+  __m128i x0, x1, x2, x3;
+  if (numBlocks >= NUM_VECS_512 * 2)
+  {
+    __m512i z0, z1, z2, z3;
+    z0 = _mm512_xor_si512(LOAD_512(data),
+        _mm512_inserti32x4(_mm512_setzero_si512(), LOAD_128(rem), 0));
+    z1 = LOAD_512(data + CRC_FOLD_BLOCK_SIZE);
+    z2 = LOAD_512(data + CRC_FOLD_BLOCK_SIZE * 2);
+    z3 = LOAD_512(data + CRC_FOLD_BLOCK_SIZE * 3);
+    data += CRC_FOLD_BLOCK_SIZE * NUM_VECS_512;
+    numBlocks -= NUM_VECS_512;
+    {
+      const __m512i k = K_512(6);
+      do
+      {
+        z0 = FOLD_512_XOR(z0, k, LOAD_512(data));
+        z1 = FOLD_512_XOR(z1, k, LOAD_512(data + CRC_FOLD_BLOCK_SIZE));
+        z2 = FOLD_512_XOR(z2, k, LOAD_512(data + CRC_FOLD_BLOCK_SIZE * 2));
+        z3 = FOLD_512_XOR(z3, k, LOAD_512(data + CRC_FOLD_BLOCK_SIZE * 3));
+        data += CRC_FOLD_BLOCK_SIZE * NUM_VECS_512;
+        numBlocks -= NUM_VECS_512;
+      }
+      while (numBlocks >= NUM_VECS_512);
+    }
+    z3 = FOLD_512_XOR(z2, K_512(3), z3);
+    z3 = FOLD_512_XOR(z1, K_512(4), z3);
+    z3 = FOLD_512_XOR(z0, K_512(5), z3);
+    x0 = _mm512_extracti32x4_epi32(z3, 0);
+    x1 = _mm512_extracti32x4_epi32(z3, 1);
+    x2 = _mm512_extracti32x4_epi32(z3, 2);
+    x3 = _mm512_extracti32x4_epi32(z3, 3);
+  }
+  else
+  {
+    x0 = _mm_xor_si128(LOAD_128(data), LOAD_128(rem));
+    x1 = LOAD_128(data + 16);
+    x2 = LOAD_128(data + 32);
+    x3 = LOAD_128(data + 48);
+    data += CRC_FOLD_BLOCK_SIZE;
+    numBlocks--;
+  }
+  CRC_FOLD_LOOP_128
+}
+
+#endif // USE_CRC_FOLD_VPCLMUL
+
+#endif // USE_CRC_FOLD_PCLMUL
+
+
+#elif defined(MY_CPU_ARM64)
+
+  #if defined(__clang__)
+    #if (__clang_major__ >= 8) // fix that check
+      #define USE_CRC_FOLD_PMULL
+    #endif
+  #elif defined(__GNUC__)
+    #if (__GNUC__ >= 6) // fix that check
+      #define USE_CRC_FOLD_PMULL
+    #endif
+  #endif
+
+#ifdef USE_CRC_FOLD_PMULL
+
+#define ATTRIB_PMULL __attribute__((__target__("+crypto")))
+
+#include <arm_neon.h>
+
+#define LOAD_128(p)  vld1q_u64((const UInt64 *)(const void *)(p))
+#define K_128(i)     LOAD_128(consts + (i) * 2)
+
+#define FOLD_128(x, k) veorq_u64( \
+    vreinterpretq_u64_p128(vmull_p64( \
+        (poly64_t)vgetq_lane_u64(x, 0), \
+        (poly64_t)vgetq_lane_u64(k, 0))), \
+    vreinterpretq_u64_p128(vmull_high_p64( \
+        vreinterpretq_p64_u64(x), \
+        vreinterpretq_p64_u64(k))))
+
+#define FOLD_128_XOR(x, k, p)  x = veorq_u64(FOLD_128(x, k), LOAD_128(p));
+
+ATTRIB_PMULL
+static void Z7_FASTCALL CrcFold_Pmull(UInt64 *rem, const Byte *data, size_t numBlocks, const UInt64 *consts)
+{
+  uint64x2_t x0, x1, x2, x3;
+  x0 = veorq_u64(LOAD_128(data), LOAD_128(rem));
+  x1 = LOAD_128(data + 16);
+  x2 = LOAD_128(data + 32);
+  x3 = LOAD_128(data + 48);
+  data += CRC_FOLD_BLOCK_SIZE;
+  if (--numBlocks)
+  {
+    const uint64x2_t k = K_128(3);
+    do
+    {
+      FOLD_128_XOR (x0, k, data)
+      FOLD_128_XOR (x1, k, data + 16)
+      FOLD_128_XOR (x2, k, data + 32)
+      FOLD_128_XOR (x3, k, data + 48)
+      data += CRC_FOLD_BLOCK_SIZE;
+    }
+    while (--numBlocks);
+  }
+  x3 = veorq_u64(x3, FOLD_128(x2, K_128(0)));
+  x3 = veorq_u64(x3, FOLD_128(x1, K_128(1)));
+  x3 = veorq_u64(x3, FOLD_128(x0, K_128(2)));
+  vst1q_u64(rem, x3);
+}
+
+#endif // USE_CRC_FOLD_PMULL
+
+#endif // MY_CPU_ARM64
+
+#endif // MY_CPU_LE
+
+
+CRC_FOLD_FUNC CrcFold_GetFunc(void)
+{
+ #ifdef USE_CRC_FOLD_PCLMUL
+  if (CPU_IsSupported_PCLMUL())
+  {
+   #ifdef USE_CRC_FOLD_VPCLMUL
+    if (CPU_IsSupported_VPCLMUL_AVX512())
+      return CrcFold_Vpclmul;
+   #endif
+    return CrcFold_Pclmul;
+  }
+ #endif
+ #ifdef USE_CRC_FOLD_PMULL
+  if (CPU_IsSupported_PMULL())
+    return CrcFold_Pmull;
+ #endif
+  return NULL;
+}
+
+#undef LOAD_128
+#undef LOAD_512
+#undef K_128
+#undef K_512
+#undef FOLD_128
+#undef FOLD_128_XOR
+#undef FOLD_512_XOR
+#undef CRC_FOLD_LOOP_128
+#undef NUM_VECS_512
+#undef ATTRIB_PCLMUL
+#undef ATTRIB_VPCLMUL
+#undef ATTRIB_PMULL
+#undef USE_CRC_FOLD_PCLMUL
+#undef USE_CRC_FOLD_VPCLMUL
+#undef USE_CRC_FOLD_PMULL
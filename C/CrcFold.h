@@ -0,0 +1,39 @@
+/* CrcFold.h -- CRC calculation with carry-less multiplication folding
+2026-10-18 : yhnmj6666/7z contributors : Public domain */
+
+#ifndef ZIP7_INC_CRC_FOLD_H
+#define ZIP7_INC_CRC_FOLD_H
+
+#include "7zTypes.h"
+
+EXTERN_C_BEGIN
+
+/*
+The code supports reflected CRCs (CRC-32, CRC-64/XZ) in little-endian systems.
+It uses PCLMULQDQ or VPCLMULQDQ (AVX-512) in x86/x64 and PMULL in arm64.
+
+CRC_FOLD_FUNC processes (numBlocks) blocks of (CRC_FOLD_BLOCK_SIZE) bytes.
+  (numBlocks) must be non-zero.
+  rem[2] : 128-bit value in little-endian order.
+    input  : the value that is xored to first 16 bytes of (data).
+             The caller writes current CRC value to low bits of (rem).
+    output : the remainder of data.
+             CRC of data is equal to CRC of 16 bytes of (rem)
+             calculated with zero initial CRC value.
+  (consts) : the array that was filled by CrcFold_GenerateConsts().
+*/
+
+#define CRC_FOLD_BLOCK_SIZE  64
+#define CRC_FOLD_NUM_CONSTS  14
+
+typedef void (Z7_FASTCALL *CRC_FOLD_FUNC)(UInt64 *rem, const Byte *data, size_t numBlocks, const UInt64 *consts);
+
+/* (poly) is reflected CRC polynomial, (width) is 32 or 64 */
+void CrcFold_GenerateConsts(UInt64 *consts, UInt64 poly, unsigned width);
+
+/* it returns NULL, if the CPU or compiler doesn't support carry-less multiplication */
+CRC_FOLD_FUNC CrcFold_GetFunc(void);
+
+EXTERN_C_END
+
+#endif
@@ -83,10 +83,11 @@ Z7_NO_INLINE
 static void MtSync_Construct(CMtSync *p)
 {
   p->affinity = 0;
+  p->numaNode = -1;
   p->wasCreated = False;
   p->csWasInitialized = False;
   p->csWasEntered = False;
-  Thread_CONSTRUCT(&p->thread)
+  PoolThread_CONSTRUCT(&p->thread)
   Event_Construct(&p->canStart);
   Event_Construct(&p->wasStopped);
   Semaphore_Construct(&p->freeSemaphore);
@@ -150,7 +151,7 @@ static UInt32 MtSync_GetNextBlock(CMtSync *p)
 Z7_NO_INLINE
 static void MtSync_StopWriting(CMtSync *p)
 {
-  if (!Thread_WasCreated(&p->thread) || p->needStart)
+  if (!PoolThread_WasCreated(&p->thread) || p->needStart)
     return;
 
     PRF(printf("\nMtSync_StopWriting %p\n", p));
@@ -190,7 +191,7 @@ static void MtSync_Destruct(CMtSync *p)
 {
     PRF(printf("\nMtSync_Destruct %p\n", p));
   
-  if (Thread_WasCreated(&p->thread))
+  if (PoolThread_WasCreated(&p->thread))
   {
     /* we want thread to be in Stopped state before sending EXIT command.
        note: stop(btSync) will stop (htSync) also */
@@ -199,7 +200,7 @@ static void MtSync_Destruct(CMtSync *p)
     p->exit = True;
     // if (p->needStart)  // it's (true)
     Event_Set(&p->canStart);  // we send EXIT command to thread
-    Thread_Wait_Close(&p->thread);  // we wait thread finishing
+    PoolThread_Wait_Close(&p->thread);  // we wait thread finishing
   }
 
   if (p->csWasInitialized)
@@ -260,9 +261,15 @@ static WRes MtSync_Create_WRes(CMtSync *p, THREAD_FUNC_TYPE startAddress, void *
   // return EINVAL; // for debug
 
   if (p->affinity != 0)
-    wres = Thread_Create_With_Affinity(&p->thread, startAddress, obj, (CAffinityMask)p->affinity);
+    wres = PoolThread_Create_With_Affinity(&p->thread, startAddress, obj, (CAffinityMask)p->affinity);
   else
-    wres = Thread_Create(&p->thread, startAddress, obj);
+  {
+    CCpuSet cpuSet;
+    if (p->numaNode >= 0 && Numa_GetNodeCpuSet((UInt32)p->numaNode, &cpuSet))
+      wres = PoolThread_Create_With_CpuSet(&p->thread, startAddress, obj, &cpuSet);
+    else
+      wres = PoolThread_Create(&p->thread, startAddress, obj);
+  }
 
   RINOK_THREAD(wres)
   p->wasCreated = True;
@@ -12,8 +12,9 @@ EXTERN_C_BEGIN
 typedef struct
 {
   UInt32 numProcessedBlocks;
-  CThread thread;
+  CPoolThread thread;
   UInt64 affinity;
+  int numaNode;
 
   BoolInt wasCreated;
   BoolInt needStart;
@@ -83,8 +83,10 @@ typedef struct
   CLzmaEncHandle enc;
   Byte propsAreSet;
   Byte propsByte;
+  Byte needInitDic;
   Byte needInitState;
   Byte needInitProp;
+  int numaNode; /* it overrides (lzmaProps.numaNode), if (numaNode >= 0) */
   UInt64 srcPos;
 } CLzma2EncInt;
 
@@ -95,7 +97,10 @@ static SRes Lzma2EncInt_InitStream(CLzma2EncInt *p, const CLzma2EncProps *props)
   {
     SizeT propsSize = LZMA_PROPS_SIZE;
     Byte propsEncoded[LZMA_PROPS_SIZE];
-    RINOK(LzmaEnc_SetProps(p->enc, &props->lzmaProps))
+    CLzmaEncProps lzmaProps = props->lzmaProps;
+    if (p->numaNode >= 0)
+      lzmaProps.numaNode = p->numaNode;
+    RINOK(LzmaEnc_SetProps(p->enc, &lzmaProps))
     RINOK(LzmaEnc_WriteProperties(p->enc, propsEncoded, &propsSize))
     p->propsByte = propsEncoded[0];
     p->propsAreSet = True;
@@ -103,9 +108,10 @@ static SRes Lzma2EncInt_InitStream(CLzma2EncInt *p, const CLzma2EncProps *props)
   return SZ_OK;
 }
 
-static void Lzma2EncInt_InitBlock(CLzma2EncInt *p)
+static void Lzma2EncInt_InitBlock(CLzma2EncInt *p, BoolInt needInitDic)
 {
   p->srcPos = 0;
+  p->needInitDic = (Byte)needInitDic;
   p->needInitState = True;
   p->needInitProp = True;
 }
@@ -115,6 +121,8 @@ SRes LzmaEnc_PrepareForLzma2(CLzmaEncHandle p, ISeqInStreamPtr inStream, UInt32
     ISzAllocPtr alloc, ISzAllocPtr allocBig);
 SRes LzmaEnc_MemPrepare(CLzmaEncHandle p, const Byte *src, SizeT srcLen,
     UInt32 keepWindowSize, ISzAllocPtr alloc, ISzAllocPtr allocBig);
+SRes LzmaEnc_MemPrepare_WithPrefix(CLzmaEncHandle p, const Byte *src, UInt32 prefixSize, SizeT srcLen,
+    UInt64 startPos, UInt32 keepWindowSize, ISzAllocPtr alloc, ISzAllocPtr allocBig);
 SRes LzmaEnc_CodeOneMemBlock(CLzmaEncHandle p, BoolInt reInit,
     Byte *dest, size_t *destLen, UInt32 desiredPackSize, UInt32 *unpackSize);
 const Byte *LzmaEnc_GetCurBuf(CLzmaEncHandle p);
@@ -170,7 +178,8 @@ static SRes Lzma2EncInt_EncodeSubblock(CLzma2EncInt *p, Byte *outBuf,
       const UInt32 u = (unpackSize < LZMA2_COPY_CHUNK_SIZE) ? unpackSize : LZMA2_COPY_CHUNK_SIZE;
       if (packSizeLimit - destPos < u + 3)
         return SZ_ERROR_OUTPUT_EOF;
-      outBuf[destPos++] = (Byte)(p->srcPos == 0 ? LZMA2_CONTROL_COPY_RESET_DIC : LZMA2_CONTROL_COPY_NO_RESET);
+      outBuf[destPos++] = (Byte)(p->needInitDic ? LZMA2_CONTROL_COPY_RESET_DIC : LZMA2_CONTROL_COPY_NO_RESET);
+      p->needInitDic = False;
       outBuf[destPos++] = (Byte)((u - 1) >> 8);
       outBuf[destPos++] = (Byte)(u - 1);
       memcpy(outBuf + destPos, LzmaEnc_GetCurBuf(p->enc) - unpackSize, u);
@@ -198,7 +207,7 @@ static SRes Lzma2EncInt_EncodeSubblock(CLzma2EncInt *p, Byte *outBuf,
     size_t destPos = 0;
     const UInt32 u = unpackSize - 1;
     const UInt32 pm = (UInt32)(packSize - 1);
-    const unsigned mode = (p->srcPos == 0) ? 3 : (p->needInitState ? (p->needInitProp ? 2 : 1) : 0);
+    const unsigned mode = p->needInitDic ? 3 : (p->needInitState ? (p->needInitProp ? 2 : 1) : 0);
 
     PRF(printf("               "));
 
@@ -211,6 +220,7 @@ static SRes Lzma2EncInt_EncodeSubblock(CLzma2EncInt *p, Byte *outBuf,
     if (p->needInitProp)
       outBuf[destPos++] = p->propsByte;
     
+    p->needInitDic = False;
     p->needInitProp = False;
     p->needInitState = False;
     destPos += packSize;
@@ -235,6 +245,8 @@ void Lzma2EncProps_Init(CLzma2EncProps *p)
   p->numBlockThreads_Reduced = -1;
   p->numBlockThreads_Max = -1;
   p->numTotalThreads = -1;
+  p->numaMode = 0;
+  p->blockOverlap = 0;
 }
 
 void Lzma2EncProps_Normalize(CLzma2EncProps *p)
@@ -286,8 +298,10 @@ void Lzma2EncProps_Normalize(CLzma2EncProps *p)
 
   fileSize = p->lzmaProps.reduceSize;
 
+  /* in blockOverlap mode the dictionary also contains the data of previous blocks */
   if (   p->blockSize != LZMA2_ENC_PROPS_BLOCK_SIZE_SOLID
       && p->blockSize != LZMA2_ENC_PROPS_BLOCK_SIZE_AUTO
+      && !p->blockOverlap
       && (p->blockSize < fileSize || fileSize == (UInt64)(Int64)-1))
     p->lzmaProps.reduceSize = p->blockSize;
 
@@ -396,7 +410,10 @@ CLzma2EncHandle Lzma2Enc_Create(ISzAllocPtr alloc, ISzAllocPtr allocBig)
   {
     unsigned i;
     for (i = 0; i < MTCODER_THREADS_MAX; i++)
+    {
       p->coders[i].enc = NULL;
+      p->coders[i].numaNode = -1;
+    }
   }
   
   #ifndef Z7_ST
@@ -494,6 +511,9 @@ Byte Lzma2Enc_WriteProperties(CLzma2EncHandle p)
 }
 
 
+/* if (inPrefixSize != 0), (inData) is preceded by (inPrefixSize) bytes of input data,
+   and (inPos) is the position of (inData) in stream */
+
 static SRes Lzma2Enc_EncodeMt1(
     CLzma2Enc *me,
     CLzma2EncInt *p,
@@ -501,6 +521,7 @@ static SRes Lzma2Enc_EncodeMt1(
     Byte *outBuf, size_t *outBufSize,
     ISeqInStreamPtr inStream,
     const Byte *inData, size_t inDataSize,
+    UInt32 inPrefixSize, UInt64 inPos,
     int finished,
     ICompressProgressPtr progress)
 {
@@ -547,7 +568,7 @@ static SRes Lzma2Enc_EncodeMt1(
     SRes res = SZ_OK;
     SizeT inSizeCur = 0;
 
-    Lzma2EncInt_InitBlock(p);
+    Lzma2EncInt_InitBlock(p, inPrefixSize == 0 || unpackTotal != 0);
     
     LimitedSeqInStream_Init(&limitedInStream);
     limitedInStream.limit = me->props.blockSize;
@@ -580,11 +601,23 @@ static SRes Lzma2Enc_EncodeMt1(
     
       // LzmaEnc_SetDataSize(p->enc, inSizeCur);
       
-      RINOK(LzmaEnc_MemPrepare(p->enc,
-          inData + (size_t)unpackTotal, inSizeCur,
-          LZMA2_KEEP_WINDOW_SIZE,
-          me->alloc,
-          me->allocBig))
+      if (!p->needInitDic)
+      {
+        RINOK(LzmaEnc_MemPrepare_WithPrefix(p->enc,
+            inData - inPrefixSize, inPrefixSize, inSizeCur,
+            inPos,
+            LZMA2_KEEP_WINDOW_SIZE,
+            me->alloc,
+            me->allocBig))
+      }
+      else
+      {
+        RINOK(LzmaEnc_MemPrepare(p->enc,
+            inData + (size_t)unpackTotal, inSizeCur,
+            LZMA2_KEEP_WINDOW_SIZE,
+            me->alloc,
+            me->allocBig))
+      }
     }
 
     for (;;)
@@ -679,10 +712,15 @@ static SRes Lzma2Enc_MtCallback_Code(void *p, unsigned coderIndex, unsigned outB
   progressThunk.inSize = 0;
   progressThunk.outSize = 0;
 
+  // the match finder threads of coder are bound to NUMA node of coder thread
+  me->coders[coderIndex].numaNode = MtCoder_GetNumaNode(&me->mtCoder, coderIndex);
+
   res = Lzma2Enc_EncodeMt1(me,
       &me->coders[coderIndex],
       NULL, dest, &destSize,
       NULL, src, srcSize,
+      (UInt32)MtCoder_GetPrefixSize(&me->mtCoder, coderIndex),
+      MtCoder_GetBlockPos(&me->mtCoder, coderIndex),
       finished,
       &progressThunk.vt);
 
@@ -771,6 +809,14 @@ SRes Lzma2Enc_Encode2(CLzma2EncHandle p,
     if (p->mtCoder.blockSize != p->props.blockSize)
       return SZ_ERROR_PARAM; /* SZ_ERROR_MEM */
 
+    p->mtCoder.prefixSize = 0;
+    if (p->props.blockOverlap)
+    {
+      p->mtCoder.prefixSize = p->props.lzmaProps.dictSize;
+      if (p->mtCoder.prefixSize + p->mtCoder.blockSize < p->mtCoder.blockSize)
+        return SZ_ERROR_PARAM; /* SZ_ERROR_MEM */
+    }
+
     {
       const size_t destBlockSize = p->mtCoder.blockSize + (p->mtCoder.blockSize >> 10) + 16;
       if (destBlockSize < p->mtCoder.blockSize)
@@ -782,6 +828,7 @@ SRes Lzma2Enc_Encode2(CLzma2EncHandle p,
 
     p->mtCoder.numThreadsMax = (unsigned)p->props.numBlockThreads_Max;
     p->mtCoder.expectedDataSize = p->expectedDataSize;
+    p->mtCoder.numaMode = (p->props.numaMode > 0);
     
     {
       const SRes res = MtCoder_Code(&p->mtCoder);
@@ -798,6 +845,7 @@ SRes Lzma2Enc_Encode2(CLzma2EncHandle p,
       &p->coders[0],
       outStream, outBuf, outBufSize,
       inStream, inData, inDataSize,
+      0, 0,
       True, /* finished */
       progress);
 }
@@ -18,6 +18,12 @@ typedef struct
   int numBlockThreads_Reduced;
   int numBlockThreads_Max;
   int numTotalThreads;
+  int numaMode; /* 0 - default; 1 - block coder threads and their match finder threads
+                   are bound to NUMA nodes, and their buffers are allocated in local memory of node */
+  int blockOverlap; /* 0 - default: each block is encoded with dictionary reset;
+                       1 - block coder inserts the end of preceding input data (up to dictSize)
+                           to match finder, and block is encoded with state reset without dictionary reset.
+                           Such stream can't be decoded in multiple threads. */
 } CLzma2EncProps;
 
 void Lzma2EncProps_Init(CLzma2EncProps *p);
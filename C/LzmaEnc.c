@@ -26,6 +26,8 @@ SRes LzmaEnc_PrepareForLzma2(CLzmaEncHandle p, ISeqInStreamPtr inStream, UInt32
     ISzAllocPtr alloc, ISzAllocPtr allocBig);
 SRes LzmaEnc_MemPrepare(CLzmaEncHandle p, const Byte *src, SizeT srcLen,
     UInt32 keepWindowSize, ISzAllocPtr alloc, ISzAllocPtr allocBig);
+SRes LzmaEnc_MemPrepare_WithPrefix(CLzmaEncHandle p, const Byte *src, UInt32 prefixSize, SizeT srcLen,
+    UInt64 startPos, UInt32 keepWindowSize, ISzAllocPtr alloc, ISzAllocPtr allocBig);
 SRes LzmaEnc_CodeOneMemBlock(CLzmaEncHandle p, BoolInt reInit,
     Byte *dest, size_t *destLen, UInt32 desiredPackSize, UInt32 *unpackSize);
 const Byte *LzmaEnc_GetCurBuf(CLzmaEncHandle p);
@@ -63,6 +65,7 @@ void LzmaEncProps_Init(CLzmaEncProps *p)
   p->numHashOutBits = 0;
   p->writeEndMark = 0;
   p->affinity = 0;
+  p->numaNode = -1;
 }
 
 void LzmaEncProps_Normalize(CLzmaEncProps *p)
@@ -416,6 +419,7 @@ struct CLzmaEnc
   BoolInt needInit;
   // BoolInt _maxMode;
 
+  UInt32 prefixSize; /* the size of preceding data that must be inserted to match finder after Init() */
   UInt64 nowPos64;
   
   unsigned matchPriceCount;
@@ -598,6 +602,8 @@ SRes LzmaEnc_SetProps(CLzmaEncHandle p, const CLzmaEncProps *props2)
   p->multiThread = (props.numThreads > 1);
   p->matchFinderMt.btSync.affinity =
   p->matchFinderMt.hashSync.affinity = props.affinity;
+  p->matchFinderMt.btSync.numaNode =
+  p->matchFinderMt.hashSync.numaNode = props.numaNode;
   #endif
 
   return SZ_OK;
@@ -2392,6 +2398,11 @@ static SRes LzmaEnc_CodeOneBlock(CLzmaEnc *p, UInt32 maxPackSize, UInt32 maxUnpa
     }
     #endif
     p->matchFinder.Init(p->matchFinderObj);
+    if (p->prefixSize != 0)
+    {
+      p->matchFinder.Skip(p->matchFinderObj, p->prefixSize);
+      p->prefixSize = 0;
+    }
     p->needInit = 0;
   }
 
@@ -2858,6 +2869,7 @@ static SRes LzmaEnc_AllocAndInit(CLzmaEnc *p, UInt32 keepWindowSize, ISzAllocPtr
 
   p->finished = False;
   p->result = SZ_OK;
+  p->prefixSize = 0;
   p->nowPos64 = 0;
   p->needInit = 1;
   RINOK(LzmaEnc_Alloc(p, keepWindowSize, alloc, allocBig))
@@ -2897,6 +2909,27 @@ SRes LzmaEnc_MemPrepare(CLzmaEncHandle p,
   return LzmaEnc_AllocAndInit(p, keepWindowSize, alloc, allocBig);
 }
 
+/*
+  (src) contains (prefixSize) bytes of preceding data and (srcLen) bytes of data for encoding.
+  The preceding data is inserted to match finder, so the encoder can use it as dictionary.
+  (startPos) is the position of data in stream after last dictionary reset in decoder.
+  It's used for (lp) and (pb) contexts, and (startPos != 0) is required, if (prefixSize != 0).
+*/
+SRes LzmaEnc_MemPrepare_WithPrefix(CLzmaEncHandle p,
+    const Byte *src, UInt32 prefixSize, SizeT srcLen,
+    UInt64 startPos,
+    UInt32 keepWindowSize,
+    ISzAllocPtr alloc, ISzAllocPtr allocBig)
+{
+  // GET_CLzmaEnc_p
+  MatchFinder_SET_DIRECT_INPUT_BUF(&MFB, src, prefixSize + srcLen)
+  LzmaEnc_SetDataSize(p, prefixSize + srcLen);
+  RINOK(LzmaEnc_AllocAndInit(p, keepWindowSize, alloc, allocBig))
+  p->prefixSize = prefixSize;
+  p->nowPos64 = startPos;
+  return SZ_OK;
+}
+
 void LzmaEnc_Finish(CLzmaEncHandle p)
 {
   #ifndef Z7_ST
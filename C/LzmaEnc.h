@@ -27,8 +27,7 @@ typedef struct
   UInt32 mc;       /* 1 <= mc <= (1 << 30), default = 32 */
   unsigned writeEndMark;  /* 0 - do not write EOPM, 1 - write EOPM, default = 0 */
   int numThreads;  /* 1 or 2, default = 2 */
-
-  // int _pad;
+  int numaNode;    /* (-1) - default; (>= 0) - match finder threads are bound to that NUMA node */
 
   UInt64 reduceSize; /* estimated size of data that will be compressed. default = (UInt64)(Int64)-1.
                         Encoder uses this value to reduce dictionary size */
@@ -3,6 +3,8 @@
 
 #include "Precomp.h"
 
+#include <string.h>
+
 #include "MtCoder.h"
 
 #ifndef Z7_ST
@@ -45,8 +47,25 @@ static SRes MtCoderThread_CreateAndStart(CMtCoderThread *t)
   if (wres == 0)
   {
     t->stop = False;
-    if (!Thread_WasCreated(&t->thread))
-      wres = Thread_Create(&t->thread, ThreadFunc, t);
+    if (!PoolThread_WasCreated(&t->thread))
+    {
+      const CMtCoder *mtc = t->mtCoder;
+      t->numaNode = -1;
+      if (mtc->numNumaNodes > 1)
+      {
+        /* the buffers of coder will be allocated by that thread,
+           so the memory will be local for the node (first-touch policy) */
+        CCpuSet cpuSet;
+        const unsigned node = t->index % mtc->numNumaNodes;
+        if (Numa_GetNodeCpuSet(node, &cpuSet))
+        {
+          t->numaNode = (int)node;
+          wres = PoolThread_Create_With_CpuSet(&t->thread, ThreadFunc, t, &cpuSet);
+        }
+      }
+      if (t->numaNode < 0)
+        wres = PoolThread_Create(&t->thread, ThreadFunc, t);
+    }
     if (wres == 0)
       wres = Event_Set(&t->startEvent);
   }
@@ -58,11 +77,11 @@ static SRes MtCoderThread_CreateAndStart(CMtCoderThread *t)
 
 static void MtCoderThread_Destruct(CMtCoderThread *t)
 {
-  if (Thread_WasCreated(&t->thread))
+  if (PoolThread_WasCreated(&t->thread))
   {
     t->stop = 1;
     Event_Set(&t->startEvent);
-    Thread_Wait_Close(&t->thread);
+    PoolThread_Wait_Close(&t->thread);
   }
 
   Event_Close(&t->startEvent);
@@ -116,19 +135,29 @@ static SRes ThreadFunc2(CMtCoderThread *t)
     if (res == SZ_OK)
     {
       size = mtc->blockSize;
+      t->inPos = mtc->readProcessed;
+      t->inPrefixSize = mtc->prefixSize;
+      if (t->inPrefixSize > mtc->readProcessed)
+        t->inPrefixSize = (size_t)mtc->readProcessed;
       if (mtc->inStream)
       {
         if (!t->inBuf)
         {
-          t->inBuf = (Byte *)ISzAlloc_Alloc(mtc->allocBig, mtc->blockSize);
+          t->inBuf = (Byte *)ISzAlloc_Alloc(mtc->allocBig, mtc->prefixSize + mtc->blockSize);
           if (!t->inBuf)
             res = SZ_ERROR_MEM;
         }
         if (res == SZ_OK)
         {
-          res = SeqInStream_ReadMax(mtc->inStream, t->inBuf, &size);
+          Byte *buf = t->inBuf + mtc->prefixSize;
+          /* the previous block can be in (t->inBuf) or in (inBuf) of another thread.
+             Another thread doesn't change its (inBuf) until it gets (readEvent) */
+          if (t->inPrefixSize != 0)
+            memmove(buf - t->inPrefixSize, mtc->prevBlockEnd - t->inPrefixSize, t->inPrefixSize);
+          res = SeqInStream_ReadMax(mtc->inStream, buf, &size);
           readProcessed = mtc->readProcessed + size;
           mtc->readProcessed = readProcessed;
+          mtc->prevBlockEnd = buf + size;
         }
         if (res != SZ_OK)
         {
@@ -212,7 +241,7 @@ static SRes ThreadFunc2(CMtCoderThread *t)
       CriticalSection_Leave(&mtc->cs);
       
       res = mtc->mtCallback->Code(mtc->mtCallbackObject, t->index, bufIndex,
-          mtc->inStream ? t->inBuf : inData, size, finished);
+          mtc->inStream ? t->inBuf + mtc->prefixSize : inData, size, finished);
       
       // MtProgress_Reinit(&mtc->mtProgress, t->index);
 
@@ -345,8 +374,11 @@ void MtCoder_Construct(CMtCoder *p)
   unsigned i;
   
   p->blockSize = 0;
+  p->prefixSize = 0;
   p->numThreadsMax = 0;
   p->expectedDataSize = (UInt64)(Int64)-1;
+  p->numaMode = False;
+  p->numNumaNodes = 0;
 
   p->inStream = NULL;
   p->inData = NULL;
@@ -359,6 +391,7 @@ void MtCoder_Construct(CMtCoder *p)
   p->mtCallbackObject = NULL;
 
   p->allocatedBufsSize = 0;
+  p->prevBlockEnd = NULL;
 
   Event_Construct(&p->readEvent);
   Semaphore_Construct(&p->blocksSemaphore);
@@ -369,9 +402,12 @@ void MtCoder_Construct(CMtCoder *p)
     t->mtCoder = p;
     t->index = i;
     t->inBuf = NULL;
+    t->inPrefixSize = 0;
+    t->inPos = 0;
     t->stop = False;
+    t->numaNode = -1;
     Event_Construct(&t->startEvent);
-    Thread_CONSTRUCT(&t->thread)
+    PoolThread_CONSTRUCT(&t->thread)
   }
 
   #ifdef MTCODER_USE_WRITE_THREAD
@@ -422,15 +458,12 @@ void MtCoder_Destruct(CMtCoder *p)
 }
 
 
-SRes MtCoder_Code(CMtCoder *p)
+static SRes MtCoder_Code2(CMtCoder *p, unsigned numThreads)
 {
-  unsigned numThreads = p->numThreadsMax;
   unsigned numBlocksMax;
   unsigned i;
   SRes res = SZ_OK;
 
-  if (numThreads > MTCODER_THREADS_MAX)
-    numThreads = MTCODER_THREADS_MAX;
   numBlocksMax = MTCODER_GET_NUM_BLOCKS_FROM_THREADS(numThreads);
   
   if (p->blockSize < ((UInt32)1 << 26)) numBlocksMax++;
@@ -440,7 +473,7 @@ SRes MtCoder_Code(CMtCoder *p)
   if (numBlocksMax > MTCODER_BLOCKS_MAX)
     numBlocksMax = MTCODER_BLOCKS_MAX;
 
-  if (p->blockSize != p->allocatedBufsSize)
+  if (p->prefixSize + p->blockSize != p->allocatedBufsSize)
   {
     for (i = 0; i < MTCODER_THREADS_MAX; i++)
     {
@@ -451,7 +484,7 @@ SRes MtCoder_Code(CMtCoder *p)
         t->inBuf = NULL;
       }
     }
-    p->allocatedBufsSize = p->blockSize;
+    p->allocatedBufsSize = p->prefixSize + p->blockSize;
   }
 
   p->readRes = SZ_OK;
@@ -478,6 +511,7 @@ SRes MtCoder_Code(CMtCoder *p)
   p->freeBlockHead = 0;
 
   p->readProcessed = 0;
+  p->prevBlockEnd = NULL;
   p->blockIndex = 0;
   p->numBlocksMax = numBlocksMax;
   p->stopReading = False;
@@ -493,6 +527,10 @@ SRes MtCoder_Code(CMtCoder *p)
   p->numStartedThreadsLimit = numThreads;
   p->numStartedThreads = 0;
 
+  p->numNumaNodes = 0;
+  if (p->numaMode)
+    p->numNumaNodes = Numa_GetNumNodes();
+
   // for (i = 0; i < numThreads; i++)
   {
     CMtCoderThread *nextThread = &p->threads[p->numStartedThreads++];
@@ -566,6 +604,20 @@ SRes MtCoder_Code(CMtCoder *p)
   return res;
 }
 
+
+SRes MtCoder_Code(CMtCoder *p)
+{
+  unsigned numThreads = p->numThreadsMax;
+  SRes res;
+  if (numThreads > MTCODER_THREADS_MAX)
+    numThreads = MTCODER_THREADS_MAX;
+  // we limit the number of threads, if there is process-wide limit in thread pool
+  numThreads = (unsigned)ThreadPool_ReserveThreads(numThreads);
+  res = MtCoder_Code2(p, numThreads);
+  ThreadPool_ReleaseThreads(numThreads);
+  return res;
+}
+
 #endif
 
 #undef RINOK_THREAD
@@ -48,10 +48,13 @@ typedef struct
   struct CMtCoder_ *mtCoder;
   unsigned index;
   int stop;
+  int numaNode; /* NUMA node of thread, or (-1), if the thread is not bound to node */
   Byte *inBuf;
+  size_t inPrefixSize; /* size of preceding data before current block */
+  UInt64 inPos;        /* position of current block in input data */
 
   CAutoResetEvent startEvent;
-  CThread thread;
+  CPoolThread thread;
 } CMtCoderThread;
 
 
@@ -76,8 +79,10 @@ typedef struct CMtCoder_
   /* input variables */
   
   size_t blockSize;        /* size of input block */
+  size_t prefixSize;       /* max size of preceding input data that is kept before each block */
   unsigned numThreadsMax;
   UInt64 expectedDataSize;
+  BoolInt numaMode;        /* the threads are bound to NUMA nodes in round-robin order */
 
   ISeqInStreamPtr inStream;
   const Byte *inData;
@@ -93,6 +98,7 @@ typedef struct CMtCoder_
   /* internal variables */
   
   size_t allocatedBufsSize;
+  const Byte *prevBlockEnd;
 
   CAutoResetEvent readEvent;
   CSemaphore blocksSemaphore;
@@ -112,6 +118,7 @@ typedef struct CMtCoder_
 
   unsigned numStartedThreadsLimit;
   unsigned numStartedThreads;
+  unsigned numNumaNodes;
 
   unsigned numBlocksMax;
   unsigned blockIndex;
@@ -132,6 +139,16 @@ void MtCoder_Construct(CMtCoder *p);
 void MtCoder_Destruct(CMtCoder *p);
 SRes MtCoder_Code(CMtCoder *p);
 
+/* it can be called from (Code) callback to get NUMA node of coder thread:
+   the callback can bind its helper threads to same node */
+#define MtCoder_GetNumaNode(p, coderIndex)  ((p)->threads[coderIndex].numaNode)
+
+/* if (prefixSize != 0), the (Code) callback can read (MtCoder_GetPrefixSize()) bytes
+   of preceding input data before (src) block.
+   MtCoder_GetBlockPos() returns the position of (src) block in input data */
+#define MtCoder_GetPrefixSize(p, coderIndex)  ((p)->threads[coderIndex].inPrefixSize)
+#define MtCoder_GetBlockPos(p, coderIndex)  ((p)->threads[coderIndex].inPos)
+
 
 #endif
 
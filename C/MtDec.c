@@ -116,9 +116,9 @@ static SRes MtDecThread_CreateAndStart(CMtDecThread *t)
   // wres = 17; // for test
   if (wres == 0)
   {
-    if (Thread_WasCreated(&t->thread))
+    if (PoolThread_WasCreated(&t->thread))
       return SZ_OK;
-    wres = Thread_Create(&t->thread, MtDec_ThreadFunc, t);
+    wres = PoolThread_Create(&t->thread, MtDec_ThreadFunc, t);
     if (wres == 0)
       return SZ_OK;
   }
@@ -145,11 +145,11 @@ void MtDecThread_FreeInBufs(CMtDecThread *t)
 
 static void MtDecThread_CloseThread(CMtDecThread *t)
 {
-  if (Thread_WasCreated(&t->thread))
+  if (PoolThread_WasCreated(&t->thread))
   {
     Event_Set(&t->canWrite); /* we can disable it. There are no threads waiting canWrite in normal cases */
     Event_Set(&t->canRead);
-    Thread_Wait_Close(&t->thread);
+    PoolThread_Wait_Close(&t->thread);
   }
 
   Event_Close(&t->canRead);
@@ -968,7 +968,7 @@ void MtDec_Construct(CMtDec *p)
     t->inBuf = NULL;
     Event_Construct(&t->canRead);
     Event_Construct(&t->canWrite);
-    Thread_CONSTRUCT(&t->thread)
+    PoolThread_CONSTRUCT(&t->thread)
   }
 
   // Event_Construct(&p->finishedEvent);
@@ -1004,41 +1004,12 @@ void MtDec_Destruct(CMtDec *p)
 }
 
 
-SRes MtDec_Code(CMtDec *p)
+static SRes MtDec_Code2(CMtDec *p, unsigned numThreads)
 {
   unsigned i;
 
-  p->inProcessed = 0;
-
-  p->blockIndex = 1; // it must be larger than not_defined index (0)
-  p->isAllocError = False;
-  p->overflow = False;
-  p->threadingErrorSRes = SZ_OK;
-
-  p->needContinue = True;
-
-  p->readWasFinished = False;
-  p->needInterrupt = False;
-  p->interruptIndex = (UInt64)(Int64)-1;
-
-  p->readProcessed = 0;
-  p->readRes = SZ_OK;
-  p->codeRes = SZ_OK;
-  p->wasInterrupted = False;
-
-  p->crossStart = 0;
-  p->crossEnd = 0;
-
-  p->filledThreadStart = 0;
-  p->numFilledThreads = 0;
-
-  {
-    unsigned numThreads = p->numThreadsMax;
-    if (numThreads > MTDEC_THREADS_MAX)
-      numThreads = MTDEC_THREADS_MAX;
-    p->numStartedThreads_Limit = numThreads;
-    p->numStartedThreads = 0;
-  }
+  p->numStartedThreads_Limit = numThreads;
+  p->numStartedThreads = 0;
 
   if (p->inBufSize != p->allocatedBufsSize)
   {
@@ -1109,6 +1080,47 @@ SRes MtDec_Code(CMtDec *p)
   }
 }
 
+
+SRes MtDec_Code(CMtDec *p)
+{
+  unsigned numThreads;
+  SRes res;
+
+  p->inProcessed = 0;
+
+  p->blockIndex = 1; // it must be larger than not_defined index (0)
+  p->isAllocError = False;
+  p->overflow = False;
+  p->threadingErrorSRes = SZ_OK;
+
+  p->needContinue = True;
+
+  p->readWasFinished = False;
+  p->needInterrupt = False;
+  p->interruptIndex = (UInt64)(Int64)-1;
+
+  p->readProcessed = 0;
+  p->readRes = SZ_OK;
+  p->codeRes = SZ_OK;
+  p->wasInterrupted = False;
+
+  p->crossStart = 0;
+  p->crossEnd = 0;
+
+  p->filledThreadStart = 0;
+  p->numFilledThreads = 0;
+
+  numThreads = p->numThreadsMax;
+  if (numThreads > MTDEC_THREADS_MAX)
+    numThreads = MTDEC_THREADS_MAX;
+  /* we limit the number of threads, if there is process-wide limit in thread pool.
+     Note: the caller thread is used as first thread here. */
+  numThreads = (unsigned)ThreadPool_ReserveThreads(numThreads);
+  res = MtDec_Code2(p, numThreads);
+  ThreadPool_ReleaseThreads(numThreads);
+  return res;
+}
+
 #endif
 
 #undef PRF
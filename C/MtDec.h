@@ -47,7 +47,7 @@ typedef struct
   size_t inDataSize_Start; // size of input data in start block
   UInt64 inDataSize;       // total size of input data in all blocks
 
-  CThread thread;
+  CPoolThread thread;
   CAutoResetEvent canRead;
   CAutoResetEvent canWrite;
   void  *allocaPtr;
@@ -0,0 +1,360 @@
+/* Sha512.c -- SHA-512 Hash
+2026-10-18 : yhnmj6666/7z contributors : Public domain
+This code is based on public domain code from Wei Dai's Crypto++ library. */
+
+#include "Precomp.h"
+
+#include <string.h>
+
+#include "CpuArch.h"
+#include "RotateDefs.h"
+#include "Sha512.h"
+
+#ifdef MY_CPU_X86_OR_AMD64
+  #ifdef _MSC_VER
+    #if _MSC_VER >= 1800
+      #define Z7_COMPILER_SHA512_SUPPORTED
+    #endif
+  #elif defined(__clang__)
+    #if (__clang_major__ >= 4) // fix that check
+      #define Z7_COMPILER_SHA512_SUPPORTED
+    #endif
+  #elif defined(__GNUC__)
+    #if (__GNUC__ >= 5) // fix that check
+      #define Z7_COMPILER_SHA512_SUPPORTED
+    #endif
+  #elif defined(__INTEL_COMPILER)
+    #if (__INTEL_COMPILER >= 1800) // fix that check
+      #define Z7_COMPILER_SHA512_SUPPORTED
+    #endif
+  #endif
+#elif defined(MY_CPU_ARM64)
+  #if defined(__clang__)
+    #if (__clang_major__ >= 13) // fix that check
+      #define Z7_COMPILER_SHA512_SUPPORTED
+    #endif
+  #elif defined(__GNUC__)
+    #if (__GNUC__ >= 9) // fix that check
+      #define Z7_COMPILER_SHA512_SUPPORTED
+    #endif
+  #endif
+#endif
+
+void Z7_FASTCALL Sha512_UpdateBlocks(UInt64 state[8], const Byte *data, size_t numBlocks);
+
+#ifdef Z7_COMPILER_SHA512_SUPPORTED
+  void Z7_FASTCALL Sha512_UpdateBlocks_HW(UInt64 state[8], const Byte *data, size_t numBlocks);
+
+  static SHA512_FUNC_UPDATE_BLOCKS g_SHA512_FUNC_UPDATE_BLOCKS = Sha512_UpdateBlocks;
+  static SHA512_FUNC_UPDATE_BLOCKS g_SHA512_FUNC_UPDATE_BLOCKS_HW;
+
+  #define SHA512_UPDATE_BLOCKS(p) p->func_UpdateBlocks
+#else
+  #define SHA512_UPDATE_BLOCKS(p) Sha512_UpdateBlocks
+#endif
+
+
+BoolInt Sha512_SetFunction(CSha512 *p, unsigned algo)
+{
+  SHA512_FUNC_UPDATE_BLOCKS func = Sha512_UpdateBlocks;
+
+  #ifdef Z7_COMPILER_SHA512_SUPPORTED
+    if (algo != SHA512_ALGO_SW)
+    {
+      if (algo == SHA512_ALGO_DEFAULT)
+        func = g_SHA512_FUNC_UPDATE_BLOCKS;
+      else
+      {
+        if (algo != SHA512_ALGO_HW)
+          return False;
+        func = g_SHA512_FUNC_UPDATE_BLOCKS_HW;
+        if (!func)
+          return False;
+      }
+    }
+  #else
+    if (algo > 1)
+      return False;
+  #endif
+
+  p->func_UpdateBlocks = func;
+  return True;
+}
+
+
+void Sha512_InitState(CSha512 *p, unsigned digestSize)
+{
+  p->count = 0;
+  if (digestSize == SHA512_384_DIGEST_SIZE)
+  {
+    p->state[0] = UINT64_CONST(0xcbbb9d5dc1059ed8);
+    p->state[1] = UINT64_CONST(0x629a292a367cd507);
+    p->state[2] = UINT64_CONST(0x9159015a3070dd17);
+    p->state[3] = UINT64_CONST(0x152fecd8f70e5939);
+    p->state[4] = UINT64_CONST(0x67332667ffc00b31);
+    p->state[5] = UINT64_CONST(0x8eb44a8768581511);
+    p->state[6] = UINT64_CONST(0xdb0c2e0d64f98fa7);
+    p->state[7] = UINT64_CONST(0x47b5481dbefa4fa4);
+  }
+  else
+  {
+    p->state[0] = UINT64_CONST(0x6a09e667f3bcc908);
+    p->state[1] = UINT64_CONST(0xbb67ae8584caa73b);
+    p->state[2] = UINT64_CONST(0x3c6ef372fe94f82b);
+    p->state[3] = UINT64_CONST(0xa54ff53a5f1d36f1);
+    p->state[4] = UINT64_CONST(0x510e527fade682d1);
+    p->state[5] = UINT64_CONST(0x9b05688c2b3e6c1f);
+    p->state[6] = UINT64_CONST(0x1f83d9abfb41bd6b);
+    p->state[7] = UINT64_CONST(0x5be0cd19137e2179);
+  }
+}
+
+void Sha512_Init(CSha512 *p, unsigned digestSize)
+{
+  p->func_UpdateBlocks =
+  #ifdef Z7_COMPILER_SHA512_SUPPORTED
+      g_SHA512_FUNC_UPDATE_BLOCKS;
+  #else
+      NULL;
+  #endif
+  Sha512_InitState(p, digestSize);
+}
+
+#define S0(x) (Z7_ROTR64(x,28) ^ Z7_ROTR64(x,34) ^ Z7_ROTR64(x,39))
+#define S1(x) (Z7_ROTR64(x,14) ^ Z7_ROTR64(x,18) ^ Z7_ROTR64(x,41))
+#define s0(x) (Z7_ROTR64(x, 1) ^ Z7_ROTR64(x, 8) ^ (x >> 7))
+#define s1(x) (Z7_ROTR64(x,19) ^ Z7_ROTR64(x,61) ^ (x >> 6))
+
+#define Ch(x,y,z) (z^(x&(y^z)))
+#define Maj(x,y,z) ((x&y)|(z&(x|y)))
+
+
+#define W_PRE(i)  (W[i] = GetBe64(data + (size_t)(i) * 8))
+
+#define w(i)  W[(i) & 15]
+#define W_MAIN(i)  (w(i) += s1(w((i)-2)) + w((i)-7) + s0(w((i)-15)))
+
+#define T8( a,b,c,d,e,f,g,h, wx, i) \
+    h += S1(e) + Ch(e,f,g) + K[(i)+(size_t)(j)] + wx(i); \
+    d += h; \
+    h += S0(a) + Maj(a, b, c); \
+
+#define R8( wx, i) \
+    T8 ( a,b,c,d,e,f,g,h, wx, i  ) \
+    T8 ( h,a,b,c,d,e,f,g, wx, i+1) \
+    T8 ( g,h,a,b,c,d,e,f, wx, i+2) \
+    T8 ( f,g,h,a,b,c,d,e, wx, i+3) \
+    T8 ( e,f,g,h,a,b,c,d, wx, i+4) \
+    T8 ( d,e,f,g,h,a,b,c, wx, i+5) \
+    T8 ( c,d,e,f,g,h,a,b, wx, i+6) \
+    T8 ( b,c,d,e,f,g,h,a, wx, i+7) \
+
+// static
+extern MY_ALIGN(64)
+const UInt64 SHA512_K_ARRAY[80];
+
+MY_ALIGN(64)
+const UInt64 SHA512_K_ARRAY[80] = {
+  UINT64_CONST(0x428a2f98d728ae22), UINT64_CONST(0x7137449123ef65cd),
+  UINT64_CONST(0xb5c0fbcfec4d3b2f), UINT64_CONST(0xe9b5dba58189dbbc),
+  UINT64_CONST(0x3956c25bf348b538), UINT64_CONST(0x59f111f1b605d019),
+  UINT64_CONST(0x923f82a4af194f9b), UINT64_CONST(0xab1c5ed5da6d8118),
+  UINT64_CONST(0xd807aa98a3030242), UINT64_CONST(0x12835b0145706fbe),
+  UINT64_CONST(0x243185be4ee4b28c), UINT64_CONST(0x550c7dc3d5ffb4e2),
+  UINT64_CONST(0x72be5d74f27b896f), UINT64_CONST(0x80deb1fe3b1696b1),
+  UINT64_CONST(0x9bdc06a725c71235), UINT64_CONST(0xc19bf174cf692694),
+  UINT64_CONST(0xe49b69c19ef14ad2), UINT64_CONST(0xefbe4786384f25e3),
+  UINT64_CONST(0x0fc19dc68b8cd5b5), UINT64_CONST(0x240ca1cc77ac9c65),
+  UINT64_CONST(0x2de92c6f592b0275), UINT64_CONST(0x4a7484aa6ea6e483),
+  UINT64_CONST(0x5cb0a9dcbd41fbd4), UINT64_CONST(0x76f988da831153b5),
+  UINT64_CONST(0x983e5152ee66dfab), UINT64_CONST(0xa831c66d2db43210),
+  UINT64_CONST(0xb00327c898fb213f), UINT64_CONST(0xbf597fc7beef0ee4),
+  UINT64_CONST(0xc6e00bf33da88fc2), UINT64_CONST(0xd5a79147930aa725),
+  UINT64_CONST(0x06ca6351e003826f), UINT64_CONST(0x142929670a0e6e70),
+  UINT64_CONST(0x27b70a8546d22ffc), UINT64_CONST(0x2e1b21385c26c926),
+  UINT64_CONST(0x4d2c6dfc5ac42aed), UINT64_CONST(0x53380d139d95b3df),
+  UINT64_CONST(0x650a73548baf63de), UINT64_CONST(0x766a0abb3c77b2a8),
+  UINT64_CONST(0x81c2c92e47edaee6), UINT64_CONST(0x92722c851482353b),
+  UINT64_CONST(0xa2bfe8a14cf10364), UINT64_CONST(0xa81a664bbc423001),
+  UINT64_CONST(0xc24b8b70d0f89791), UINT64_CONST(0xc76c51a30654be30),
+  UINT64_CONST(0xd192e819d6ef5218), UINT64_CONST(0xd69906245565a910),
+  UINT64_CONST(0xf40e35855771202a), UINT64_CONST(0x106aa07032bbd1b8),
+  UINT64_CONST(0x19a4c116b8d2d0c8), UINT64_CONST(0x1e376c085141ab53),
+  UINT64_CONST(0x2748774cdf8eeb99), UINT64_CONST(0x34b0bcb5e19b48a8),
+  UINT64_CONST(0x391c0cb3c5c95a63), UINT64_CONST(0x4ed8aa4ae3418acb),
+  UINT64_CONST(0x5b9cca4f7763e373), UINT64_CONST(0x682e6ff3d6b2b8a3),
+  UINT64_CONST(0x748f82ee5defb2fc), UINT64_CONST(0x78a5636f43172f60),
+  UINT64_CONST(0x84c87814a1f0ab72), UINT64_CONST(0x8cc702081a6439ec),
+  UINT64_CONST(0x90befffa23631e28), UINT64_CONST(0xa4506cebde82bde9),
+  UINT64_CONST(0xbef9a3f7b2c67915), UINT64_CONST(0xc67178f2e372532b),
+  UINT64_CONST(0xca273eceea26619c), UINT64_CONST(0xd186b8c721c0c207),
+  UINT64_CONST(0xeada7dd6cde0eb1e), UINT64_CONST(0xf57d4f7fee6ed178),
+  UINT64_CONST(0x06f067aa72176fba), UINT64_CONST(0x0a637dc5a2c898a6),
+  UINT64_CONST(0x113f9804bef90dae), UINT64_CONST(0x1b710b35131c471b),
+  UINT64_CONST(0x28db77f523047d84), UINT64_CONST(0x32caab7b40c72493),
+  UINT64_CONST(0x3c9ebe0a15c9bebc), UINT64_CONST(0x431d67c49c100d4c),
+  UINT64_CONST(0x4cc5d4becb3e42b6), UINT64_CONST(0x597f299cfc657e2a),
+  UINT64_CONST(0x5fcb6fab3ad6faec), UINT64_CONST(0x6c44198c4a475817)
+};
+
+#define K SHA512_K_ARRAY
+
+
+Z7_NO_INLINE
+void Z7_FASTCALL Sha512_UpdateBlocks(UInt64 state[8], const Byte *data, size_t numBlocks)
+{
+  UInt64 W[16];
+  unsigned j;
+  UInt64 a,b,c,d,e,f,g,h;
+
+  a = state[0];
+  b = state[1];
+  c = state[2];
+  d = state[3];
+  e = state[4];
+  f = state[5];
+  g = state[6];
+  h = state[7];
+
+  while (numBlocks)
+  {
+    j = 0;
+    R8( W_PRE, 0)
+    R8( W_PRE, 8)
+
+    for (j = 16; j < 80; j += 16)
+    {
+      R8( W_MAIN, 0)
+      R8( W_MAIN, 8)
+    }
+
+    a += state[0]; state[0] = a;
+    b += state[1]; state[1] = b;
+    c += state[2]; state[2] = c;
+    d += state[3]; state[3] = d;
+    e += state[4]; state[4] = e;
+    f += state[5]; state[5] = f;
+    g += state[6]; state[6] = g;
+    h += state[7]; state[7] = h;
+
+    data += SHA512_BLOCK_SIZE;
+    numBlocks--;
+  }
+
+  /* Wipe variables */
+  /* memset(W, 0, sizeof(W)); */
+}
+
+#undef K
+
+#define Sha512_UpdateBlock(p) SHA512_UPDATE_BLOCKS(p)(p->state, p->buffer, 1)
+
+void Sha512_Update(CSha512 *p, const Byte *data, size_t size)
+{
+  if (size == 0)
+    return;
+
+  {
+    unsigned pos = (unsigned)p->count & (SHA512_BLOCK_SIZE - 1);
+    unsigned num;
+
+    p->count += size;
+
+    num = SHA512_BLOCK_SIZE - pos;
+    if (num > size)
+    {
+      memcpy(p->buffer + pos, data, size);
+      return;
+    }
+
+    if (pos != 0)
+    {
+      size -= num;
+      memcpy(p->buffer + pos, data, num);
+      data += num;
+      Sha512_UpdateBlock(p);
+    }
+  }
+  {
+    size_t numBlocks = size >> 7;
+    SHA512_UPDATE_BLOCKS(p)(p->state, data, numBlocks);
+    size &= SHA512_BLOCK_SIZE - 1;
+    if (size == 0)
+      return;
+    data += (numBlocks << 7);
+    memcpy(p->buffer, data, size);
+  }
+}
+
+
+void Sha512_Final(CSha512 *p, Byte *digest, unsigned digestSize)
+{
+  unsigned pos = (unsigned)p->count & (SHA512_BLOCK_SIZE - 1);
+  unsigned i;
+
+  p->buffer[pos++] = 0x80;
+
+  if (pos > (SHA512_BLOCK_SIZE - 16))
+  {
+    while (pos != SHA512_BLOCK_SIZE) { p->buffer[pos++] = 0; }
+    Sha512_UpdateBlock(p);
+    pos = 0;
+  }
+
+  memset(&p->buffer[pos], 0, (SHA512_BLOCK_SIZE - 16) - pos);
+
+  {
+    // the bit length is 128-bit big-endian number
+    const UInt64 numBits = (p->count << 3);
+    const UInt32 numBitsHigh = (UInt32)(p->count >> 61);
+    SetBe32(p->buffer + SHA512_BLOCK_SIZE - 16, 0)
+    SetBe32(p->buffer + SHA512_BLOCK_SIZE - 12, numBitsHigh)
+    SetBe32(p->buffer + SHA512_BLOCK_SIZE -  8, (UInt32)(numBits >> 32))
+    SetBe32(p->buffer + SHA512_BLOCK_SIZE -  4, (UInt32)(numBits))
+  }
+
+  Sha512_UpdateBlock(p);
+
+  for (i = 0; i < digestSize; i += 8)
+  {
+    const UInt64 v = p->state[i / 8];
+    SetBe32(digest + i    , (UInt32)(v >> 32))
+    SetBe32(digest + i + 4, (UInt32)(v))
+  }
+
+  Sha512_InitState(p, digestSize);
+}
+
+
+void Sha512Prepare(void)
+{
+  #ifdef Z7_COMPILER_SHA512_SUPPORTED
+  SHA512_FUNC_UPDATE_BLOCKS f, f_hw;
+  f = Sha512_UpdateBlocks;
+  f_hw = NULL;
+  #ifdef MY_CPU_X86_OR_AMD64
+  if (CPU_IsSupported_AVX2())
+  #else
+  if (CPU_IsSupported_SHA512())
+  #endif
+  {
+    // printf("\n========== HW SHA512 ======== \n");
+    f = f_hw = Sha512_UpdateBlocks_HW;
+  }
+  g_SHA512_FUNC_UPDATE_BLOCKS    = f;
+  g_SHA512_FUNC_UPDATE_BLOCKS_HW = f_hw;
+  #endif
+}
+
+#undef S0
+#undef S1
+#undef s0
+#undef s1
+#undef Ch
+#undef Maj
+#undef W_MAIN
+#undef W_PRE
+#undef w
+#undef T8
+#undef R8
+#undef Z7_COMPILER_SHA512_SUPPORTED
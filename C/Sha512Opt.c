@@ -0,0 +1,375 @@
+/* Sha512Opt.c -- SHA-512 optimized code for AVX2 and SHA-512 hardware instructions
+2026-10-18 : yhnmj6666/7z contributors : Public domain */
+
+#include "Precomp.h"
+#include "Compiler.h"
+#include "CpuArch.h"
+#include "RotateDefs.h"
+#include "Sha512.h"
+
+// K array must be aligned for 32-bytes at least.
+extern
+MY_ALIGN(64)
+const UInt64 SHA512_K_ARRAY[80];
+
+#define K SHA512_K_ARRAY
+
+#ifdef MY_CPU_X86_OR_AMD64
+  #if defined(__INTEL_COMPILER) && (__INTEL_COMPILER >= 1600) // fix that check
+      #define USE_HW_SHA512
+  #elif defined(Z7_LLVM_CLANG_VERSION)  && (Z7_LLVM_CLANG_VERSION  >= 30800) \
+     || defined(Z7_APPLE_CLANG_VERSION) && (Z7_APPLE_CLANG_VERSION >= 50100) \
+     || defined(Z7_GCC_VERSION)         && (Z7_GCC_VERSION         >= 40900)
+      #define USE_HW_SHA512
+      #if !defined(_INTEL_COMPILER)
+      // icc defines __GNUC__, but icc doesn't support __attribute__(__target__)
+      #if !defined(__AVX2__)
+        #define ATTRIB_SHA512 __attribute__((__target__("avx2")))
+      #endif
+      #endif
+  #elif defined(_MSC_VER)
+    #if (_MSC_VER >= 1800)
+      #define USE_HW_SHA512
+    #endif
+  #endif
+
+#ifdef USE_HW_SHA512
+
+// #pragma message("Sha512 AVX2")
+
+#include <immintrin.h>
+
+/*
+x86/x64 CPUs have no SHA-512 instructions in common use.
+So we use AVX2 for message schedule calculation:
+  each 256-bit register contains W[t] values for 4 different blocks.
+  After message schedule for 4 blocks we run scalar rounds
+  that read precalculated (W[t] + K[t]) values.
+  The message schedule is about one third of work in SHA-512 code.
+*/
+
+#define SHA512_NUM_LANES  4
+
+#define V_ROR(x, n)  _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+
+#define V_s0(x)  _mm256_xor_si256(_mm256_xor_si256(V_ROR(x, 1), V_ROR(x, 8)), _mm256_srli_epi64(x, 7))
+#define V_s1(x)  _mm256_xor_si256(_mm256_xor_si256(V_ROR(x,19), V_ROR(x,61)), _mm256_srli_epi64(x, 6))
+
+#define S0(x) (Z7_ROTR64(x,28) ^ Z7_ROTR64(x,34) ^ Z7_ROTR64(x,39))
+#define S1(x) (Z7_ROTR64(x,14) ^ Z7_ROTR64(x,18) ^ Z7_ROTR64(x,41))
+
+#define Ch(x,y,z) (z^(x&(y^z)))
+#define Maj(x,y,z) ((x&y)|(z&(x|y)))
+
+#define T8( a,b,c,d,e,f,g,h, i) \
+    h += S1(e) + Ch(e,f,g) + wk[((i) + (size_t)(t)) * SHA512_NUM_LANES]; \
+    d += h; \
+    h += S0(a) + Maj(a, b, c); \
+
+#define R8(i) \
+    T8 ( a,b,c,d,e,f,g,h, i  ) \
+    T8 ( h,a,b,c,d,e,f,g, i+1) \
+    T8 ( g,h,a,b,c,d,e,f, i+2) \
+    T8 ( f,g,h,a,b,c,d,e, i+3) \
+    T8 ( e,f,g,h,a,b,c,d, i+4) \
+    T8 ( d,e,f,g,h,a,b,c, i+5) \
+    T8 ( c,d,e,f,g,h,a,b, i+6) \
+    T8 ( b,c,d,e,f,g,h,a, i+7) \
+
+#ifdef ATTRIB_SHA512
+ATTRIB_SHA512
+#endif
+void Z7_FASTCALL Sha512_UpdateBlocks_HW(UInt64 state[8], const Byte *data, size_t numBlocks);
+#ifdef ATTRIB_SHA512
+ATTRIB_SHA512
+#endif
+void Z7_FASTCALL Sha512_UpdateBlocks_HW(UInt64 state[8], const Byte *data, size_t numBlocks)
+{
+  MY_ALIGN(32)
+  UInt64 wkBuf[80 * SHA512_NUM_LANES];
+  const __m256i mask = _mm256_setr_epi8(
+      7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+      7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+  while (numBlocks)
+  {
+    __m256i W[16];
+    const Byte *blocks[SHA512_NUM_LANES];
+    unsigned numLanes = SHA512_NUM_LANES;
+    unsigned t;
+    unsigned lane;
+
+    if (numLanes > numBlocks)
+      numLanes = (unsigned)numBlocks;
+    for (lane = 0; lane < SHA512_NUM_LANES; lane++)
+      blocks[lane] = data + (size_t)(lane < numLanes ? lane : numLanes - 1) * SHA512_BLOCK_SIZE;
+
+    for (t = 0; t < 16; t += 4)
+    {
+      // 4x4 transpose: (W[t + i]) gets i-th word from each of 4 blocks
+      const __m256i r0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(const void *)(blocks[0] + t * 8)), mask);
+      const __m256i r1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(const void *)(blocks[1] + t * 8)), mask);
+      const __m256i r2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(const void *)(blocks[2] + t * 8)), mask);
+      const __m256i r3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(const void *)(blocks[3] + t * 8)), mask);
+      const __m256i t0 = _mm256_unpacklo_epi64(r0, r1);
+      const __m256i t1 = _mm256_unpackhi_epi64(r0, r1);
+      const __m256i t2 = _mm256_unpacklo_epi64(r2, r3);
+      const __m256i t3 = _mm256_unpackhi_epi64(r2, r3);
+      W[t    ] = _mm256_permute2x128_si256(t0, t2, 0x20);
+      W[t + 1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+      W[t + 2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+      W[t + 3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+    }
+
+    for (t = 0; t < 80; t++)
+    {
+      __m256i w;
+      if (t < 16)
+        w = W[t];
+      else
+      {
+        w = _mm256_add_epi64(
+            _mm256_add_epi64(W[t & 15], V_s0(W[(t - 15) & 15])),
+            _mm256_add_epi64(W[(t - 7) & 15], V_s1(W[(t - 2) & 15])));
+        W[t & 15] = w;
+      }
+      _mm256_store_si256((__m256i *)(void *)(wkBuf + (size_t)t * SHA512_NUM_LANES),
+          _mm256_add_epi64(w, _mm256_set1_epi64x((Int64)K[t])));
+    }
+
+    for (lane = 0; lane < numLanes; lane++)
+    {
+      const UInt64 *wk = wkBuf + lane;
+      UInt64 a,b,c,d,e,f,g,h;
+
+      a = state[0];
+      b = state[1];
+      c = state[2];
+      d = state[3];
+      e = state[4];
+      f = state[5];
+      g = state[6];
+      h = state[7];
+
+      for (t = 0; t < 80; t += 8)
+      {
+        R8(0)
+      }
+
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+      state[4] += e;
+      state[5] += f;
+      state[6] += g;
+      state[7] += h;
+    }
+
+    data += (size_t)numLanes * SHA512_BLOCK_SIZE;
+    numBlocks -= numLanes;
+  }
+}
+
+#endif // USE_HW_SHA512
+
+#elif defined(MY_CPU_ARM64)
+
+  #if defined(__clang__)
+    #if (__clang_major__ >= 13) // fix that check
+      #define USE_HW_SHA512
+    #endif
+  #elif defined(__GNUC__)
+    #if (__GNUC__ >= 9) // fix that check
+      #define USE_HW_SHA512
+    #endif
+  #endif
+
+#ifdef USE_HW_SHA512
+
+// #pragma message("=== Sha512 HW === ")
+
+#if defined(__clang__)
+  #define ATTRIB_SHA512 __attribute__((__target__("sha3")))
+#else
+  #define ATTRIB_SHA512 __attribute__((__target__("arch=armv8.2-a+sha3")))
+#endif
+
+#include <arm_neon.h>
+
+typedef uint64x2_t v128_64;
+
+#ifdef MY_CPU_BE
+  #define MY_rev64_for_LE(x)
+#else
+  #define MY_rev64_for_LE(x) x = vreinterpretq_u64_u8(vrev64q_u8(vreinterpretq_u8_u64(x)))
+#endif
+
+#define LOAD_128(_p)  vld1q_u64((const UInt64 *)(const void *)(_p))
+#define STORE_128(_p, _v)  vst1q_u64((UInt64 *)(void *)(_p), _v)
+
+#define LOAD_SHUFFLE(m, k) \
+    m = LOAD_128((data + (k) * 16)); \
+    MY_rev64_for_LE(m); \
+
+/*
+  registers contain pairs of state words: ab = {a, b}, cd = {c, d}, ...
+  m[i] contains message words {W[t + i * 2], W[t + i * 2 + 1]}.
+  R2() does 2 rounds, and it updates m[k] to the values for (t + 16), if (sched != 0).
+*/
+
+#define R2(k, sched) \
+    { \
+      v128_64 x, y; \
+      x = vaddq_u64(m ## k, LOAD_128(K + t + (k) * 2)); \
+      x = vaddq_u64(vextq_u64(x, x, 1), gh); \
+      x = vsha512hq_u64(x, vextq_u64(ef, gh, 1), vextq_u64(cd, ef, 1)); \
+      y = vsha512h2q_u64(x, cd, ab); \
+      gh = ef; \
+      ef = vaddq_u64(cd, x); \
+      cd = ab; \
+      ab = y; \
+      if (sched) \
+        m ## k = vsha512su1q_u64(vsha512su0q_u64(m ## k, m ## k ## _1), \
+            m ## k ## _7, vextq_u64(m ## k ## _4, m ## k ## _5, 1)); \
+    }
+
+#define m0_1 m1
+#define m0_4 m4
+#define m0_5 m5
+#define m0_7 m7
+#define m1_1 m2
+#define m1_4 m5
+#define m1_5 m6
+#define m1_7 m0
+#define m2_1 m3
+#define m2_4 m6
+#define m2_5 m7
+#define m2_7 m1
+#define m3_1 m4
+#define m3_4 m7
+#define m3_5 m0
+#define m3_7 m2
+#define m4_1 m5
+#define m4_4 m0
+#define m4_5 m1
+#define m4_7 m3
+#define m5_1 m6
+#define m5_4 m1
+#define m5_5 m2
+#define m5_7 m4
+#define m6_1 m7
+#define m6_4 m2
+#define m6_5 m3
+#define m6_7 m5
+#define m7_1 m0
+#define m7_4 m3
+#define m7_5 m4
+#define m7_7 m6
+
+#define R16(sched) \
+    R2(0, sched) R2(1, sched) R2(2, sched) R2(3, sched) \
+    R2(4, sched) R2(5, sched) R2(6, sched) R2(7, sched) \
+
+
+ATTRIB_SHA512
+void Z7_FASTCALL Sha512_UpdateBlocks_HW(UInt64 state[8], const Byte *data, size_t numBlocks);
+ATTRIB_SHA512
+void Z7_FASTCALL Sha512_UpdateBlocks_HW(UInt64 state[8], const Byte *data, size_t numBlocks)
+{
+  v128_64 ab, cd, ef, gh;
+
+  if (numBlocks == 0)
+    return;
+
+  ab = LOAD_128(&state[0]);
+  cd = LOAD_128(&state[2]);
+  ef = LOAD_128(&state[4]);
+  gh = LOAD_128(&state[6]);
+
+  do
+  {
+    v128_64 ab_save, cd_save, ef_save, gh_save;
+    v128_64 m0, m1, m2, m3, m4, m5, m6, m7;
+    unsigned t;
+
+    LOAD_SHUFFLE (m0, 0)
+    LOAD_SHUFFLE (m1, 1)
+    LOAD_SHUFFLE (m2, 2)
+    LOAD_SHUFFLE (m3, 3)
+    LOAD_SHUFFLE (m4, 4)
+    LOAD_SHUFFLE (m5, 5)
+    LOAD_SHUFFLE (m6, 6)
+    LOAD_SHUFFLE (m7, 7)
+
+    ab_save = ab;
+    cd_save = cd;
+    ef_save = ef;
+    gh_save = gh;
+
+    for (t = 0; t < 64; t += 16)
+    {
+      R16(1)
+    }
+    R16(0)
+
+    ab = vaddq_u64(ab, ab_save);
+    cd = vaddq_u64(cd, cd_save);
+    ef = vaddq_u64(ef, ef_save);
+    gh = vaddq_u64(gh, gh_save);
+
+    data += SHA512_BLOCK_SIZE;
+  }
+  while (--numBlocks);
+
+  STORE_128(&state[0], ab);
+  STORE_128(&state[2], cd);
+  STORE_128(&state[4], ef);
+  STORE_128(&state[6], gh);
+}
+
+#endif // USE_HW_SHA512
+
+#endif // MY_CPU_ARM64
+
+
+#ifndef USE_HW_SHA512
+
+// #error Stop_Compiling_UNSUPPORTED_SHA512
+// #include <stdlib.h>
+
+// #include "Sha512.h"
+void Z7_FASTCALL Sha512_UpdateBlocks(UInt64 state[8], const Byte *data, size_t numBlocks);
+
+#pragma message("Sha512 HW-SW stub was used")
+
+void Z7_FASTCALL Sha512_UpdateBlocks_HW(UInt64 state[8], const Byte *data, size_t numBlocks);
+void Z7_FASTCALL Sha512_UpdateBlocks_HW(UInt64 state[8], const Byte *data, size_t numBlocks)
+{
+  Sha512_UpdateBlocks(state, data, numBlocks);
+  /*
+  UNUSED_VAR(state);
+  UNUSED_VAR(data);
+  UNUSED_VAR(numBlocks);
+  exit(1);
+  return;
+  */
+}
+
+#endif
+
+
+#undef K
+#undef S0
+#undef S1
+#undef Ch
+#undef Maj
+#undef T8
+#undef R8
+#undef R2
+#undef R16
+#undef V_ROR
+#undef V_s0
+#undef V_s1
+#undef ATTRIB_SHA512
+#undef USE_HW_SHA512
@@ -11,6 +11,8 @@
 
 #include "Threads.h"
 
+#include <stdlib.h>
+
 static WRes GetError(void)
 {
   const DWORD res = GetLastError();
@@ -217,6 +219,7 @@ WRes CriticalSection_Init(CCriticalSection *p)
 #include <string.h>
 #ifdef Z7_AFFINITY_SUPPORTED
 // #include <sched.h>
+#include <stdio.h>
 #endif
 
 
@@ -318,6 +321,100 @@ WRes Thread_Create_With_Affinity(CThread *p, THREAD_FUNC_TYPE func, LPVOID param
 }
 
 
+#ifdef Z7_AFFINITY_SUPPORTED
+
+#define NUMA_SYS_PATH  "/sys/devices/system/node/"
+
+/* it reads the list of numbers like "0-3,8-11" from sysfs file to (cpuSet).
+   returns the number of items in list */
+static unsigned Numa_ReadList(const char *path, CCpuSet *cpuSet)
+{
+  char buf[1 << 12];
+  const char *s = buf;
+  unsigned num = 0;
+  size_t size;
+  FILE *f;
+
+  CpuSet_Zero(cpuSet);
+  f = fopen(path, "r");
+  if (!f)
+    return 0;
+  size = fread(buf, 1, sizeof(buf) - 1, f);
+  fclose(f);
+  buf[size] = 0;
+
+  for (;;)
+  {
+    char *end;
+    unsigned long v1, v2;
+    v1 = strtoul(s, &end, 10);
+    if (end == s)
+      break;
+    s = end;
+    v2 = v1;
+    if (*s == '-')
+    {
+      s++;
+      v2 = strtoul(s, &end, 10);
+      if (end == s || v2 < v1)
+        return 0;
+      s = end;
+    }
+    for (; v1 <= v2 && v1 < CPU_SETSIZE; v1++)
+    {
+      CpuSet_Set(cpuSet, v1);
+      num++;
+    }
+    if (*s != ',')
+      break;
+    s++;
+  }
+  return num;
+}
+
+
+UInt32 Numa_GetNumNodes(void)
+{
+  CCpuSet nodes;
+  return Numa_ReadList(NUMA_SYS_PATH "online", &nodes);
+}
+
+
+BoolInt Numa_GetNodeCpuSet(UInt32 nodeIndex, CCpuSet *cpuSet)
+{
+  CCpuSet nodes;
+  CCpuSet allowed;
+  char path[128];
+  unsigned i;
+
+  if (Numa_ReadList(NUMA_SYS_PATH "online", &nodes) == 0)
+    return False;
+  // the numbers of online nodes can be non-contiguous
+  for (i = 0; i < CPU_SETSIZE; i++)
+    if (CpuSet_IsSet(&nodes, i))
+    {
+      if (nodeIndex == 0)
+        break;
+      nodeIndex--;
+    }
+  if (i == CPU_SETSIZE)
+    return False;
+  snprintf(path, sizeof(path), NUMA_SYS_PATH "node%u/cpulist", i);
+  if (Numa_ReadList(path, cpuSet) == 0)
+    return False;
+  // we exclude the CPUs that are not allowed by affinity mask of current thread
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+  {
+    CPU_AND(cpuSet, cpuSet, &allowed);
+    if (CPU_COUNT(cpuSet) == 0)
+      return False;
+  }
+  return True;
+}
+
+#endif // Z7_AFFINITY_SUPPORTED
+
+
 WRes Thread_Close(CThread *p)
 {
   // Print("Thread_Close")
@@ -560,3 +657,256 @@ WRes AutoResetEvent_OptCreate_And_Reset(CAutoResetEvent *p)
 
 #undef PRF
 #undef Print
+
+
+// ---------- Shared thread pool ----------
+
+typedef struct CThreadPoolWorker_
+{
+  CThread thread;
+  CAutoResetEvent startEvent;
+  CAutoResetEvent finishedEvent;
+  THREAD_FUNC_TYPE func;
+  LPVOID param;
+  BoolInt exit;
+  struct CThreadPoolWorker_ *next;
+} CThreadPoolWorker;
+
+static CThreadPoolWorker *g_ThreadPool_Idle;
+static UInt32 g_ThreadPool_NumIdle;
+static UInt32 g_ThreadPool_NumIdleMax;
+static UInt32 g_ThreadPool_NumThreadsMax;
+static UInt32 g_ThreadPool_NumBusy;
+
+#ifdef _WIN32
+
+#define THREAD_POOL_ERROR_MEM  ERROR_NOT_ENOUGH_MEMORY
+
+static LONG volatile g_ThreadPool_CS_State;
+static CCriticalSection g_ThreadPool_CS;
+
+static void ThreadPool_Lock(void)
+{
+  if (g_ThreadPool_CS_State != 2)
+  {
+    if (InterlockedCompareExchange(&g_ThreadPool_CS_State, 1, 0) == 0)
+    {
+      InitializeCriticalSection(&g_ThreadPool_CS);
+      InterlockedExchange(&g_ThreadPool_CS_State, 2);
+    }
+    else
+      while (g_ThreadPool_CS_State != 2)
+        Sleep(0);
+  }
+  EnterCriticalSection(&g_ThreadPool_CS);
+}
+
+#else
+
+#define THREAD_POOL_ERROR_MEM  ENOMEM
+
+static CCriticalSection g_ThreadPool_CS = { PTHREAD_MUTEX_INITIALIZER };
+
+#define ThreadPool_Lock()  CriticalSection_Enter(&g_ThreadPool_CS)
+
+#endif
+
+#define ThreadPool_Unlock()  CriticalSection_Leave(&g_ThreadPool_CS)
+
+
+static THREAD_FUNC_DECL ThreadPoolWorker_Func(void *pp)
+{
+  CThreadPoolWorker *w = (CThreadPoolWorker *)pp;
+  for (;;)
+  {
+    if (Event_Wait(&w->startEvent) != 0 || w->exit)
+      return THREAD_FUNC_RET_ZERO;
+    w->func(w->param);
+    if (Event_Set(&w->finishedEvent) != 0)
+      return THREAD_FUNC_RET_ZERO;
+  }
+}
+
+
+static void ThreadPoolWorker_Free(CThreadPoolWorker *w)
+{
+  if (Thread_WasCreated(&w->thread))
+  {
+    w->exit = True;
+    Event_Set(&w->startEvent);
+    Thread_Wait_Close(&w->thread);
+  }
+  Event_Close(&w->startEvent);
+  Event_Close(&w->finishedEvent);
+  free(w);
+}
+
+
+static WRes ThreadPoolWorker_Create(CThreadPoolWorker **res)
+{
+  WRes wres;
+  CThreadPoolWorker *w = (CThreadPoolWorker *)malloc(sizeof(CThreadPoolWorker));
+  *res = NULL;
+  if (!w)
+    return THREAD_POOL_ERROR_MEM;
+  Thread_CONSTRUCT(&w->thread)
+  Event_Construct(&w->startEvent);
+  Event_Construct(&w->finishedEvent);
+  w->exit = False;
+  wres = AutoResetEvent_CreateNotSignaled(&w->startEvent);
+  if (wres == 0)
+    wres = AutoResetEvent_CreateNotSignaled(&w->finishedEvent);
+  if (wres == 0)
+    wres = Thread_Create(&w->thread, ThreadPoolWorker_Func, w);
+  if (wres != 0)
+  {
+    ThreadPoolWorker_Free(w);
+    return wres;
+  }
+  *res = w;
+  return 0;
+}
+
+
+WRes PoolThread_Create(CPoolThread *p, THREAD_FUNC_TYPE func, LPVOID param)
+{
+  CThreadPoolWorker *w;
+  UInt32 numIdleMax;
+  {
+    ThreadPool_Lock();
+    w = g_ThreadPool_Idle;
+    if (w)
+    {
+      g_ThreadPool_Idle = w->next;
+      g_ThreadPool_NumIdle--;
+    }
+    numIdleMax = g_ThreadPool_NumIdleMax;
+    ThreadPool_Unlock();
+  }
+  if (!w)
+  {
+    if (numIdleMax == 0)
+      return Thread_Create(&p->_thread, func, param);
+    {
+      const WRes wres = ThreadPoolWorker_Create(&w);
+      if (wres != 0)
+        return wres;
+    }
+  }
+  w->func = func;
+  w->param = param;
+  w->next = NULL;
+  p->_worker = w;
+  return Event_Set(&w->startEvent);
+}
+
+
+WRes PoolThread_Create_With_Affinity(CPoolThread *p, THREAD_FUNC_TYPE func, LPVOID param, CAffinityMask affinity)
+{
+  return Thread_Create_With_Affinity(&p->_thread, func, param, affinity);
+}
+
+
+WRes PoolThread_Create_With_CpuSet(CPoolThread *p, THREAD_FUNC_TYPE func, LPVOID param, const CCpuSet *cpuSet)
+{
+  return Thread_Create_With_CpuSet(&p->_thread, func, param, cpuSet);
+}
+
+
+WRes PoolThread_Wait_Close(CPoolThread *p)
+{
+  CThreadPoolWorker *w = p->_worker;
+  WRes wres;
+  if (!w)
+    return Thread_Wait_Close(&p->_thread);
+  p->_worker = NULL;
+  wres = Event_Wait(&w->finishedEvent);
+  if (wres == 0)
+  {
+    BoolInt wasAdded = False;
+    ThreadPool_Lock();
+    if (g_ThreadPool_NumIdle < g_ThreadPool_NumIdleMax)
+    {
+      w->next = g_ThreadPool_Idle;
+      g_ThreadPool_Idle = w;
+      g_ThreadPool_NumIdle++;
+      wasAdded = True;
+    }
+    ThreadPool_Unlock();
+    if (wasAdded)
+      return 0;
+  }
+  ThreadPoolWorker_Free(w);
+  return wres;
+}
+
+
+void ThreadPool_Set(UInt32 numThreadsMax, UInt32 numIdleThreadsMax)
+{
+  CThreadPoolWorker *list = NULL;
+  ThreadPool_Lock();
+  g_ThreadPool_NumThreadsMax = numThreadsMax;
+  g_ThreadPool_NumIdleMax = numIdleThreadsMax;
+  while (g_ThreadPool_NumIdle > numIdleThreadsMax)
+  {
+    CThreadPoolWorker *w = g_ThreadPool_Idle;
+    g_ThreadPool_Idle = w->next;
+    g_ThreadPool_NumIdle--;
+    w->next = list;
+    list = w;
+  }
+  ThreadPool_Unlock();
+  // we close the threads without lock
+  while (list)
+  {
+    CThreadPoolWorker *next = list->next;
+    ThreadPoolWorker_Free(list);
+    list = next;
+  }
+}
+
+
+UInt32 ThreadPool_ReserveThreads(UInt32 numThreads)
+{
+  ThreadPool_Lock();
+  if (g_ThreadPool_NumThreadsMax != 0)
+  {
+    UInt32 rem = 0;
+    if (g_ThreadPool_NumBusy < g_ThreadPool_NumThreadsMax)
+      rem = g_ThreadPool_NumThreadsMax - g_ThreadPool_NumBusy;
+    if (numThreads > rem)
+      numThreads = rem;
+    if (numThreads == 0)
+      numThreads = 1;
+  }
+  g_ThreadPool_NumBusy += numThreads;
+  ThreadPool_Unlock();
+  return numThreads;
+}
+
+
+void ThreadPool_ReleaseThreads(UInt32 numThreads)
+{
+  ThreadPool_Lock();
+  if (numThreads > g_ThreadPool_NumBusy)
+    numThreads = g_ThreadPool_NumBusy;
+  g_ThreadPool_NumBusy -= numThreads;
+  ThreadPool_Unlock();
+}
+
+
+#ifndef Z7_AFFINITY_SUPPORTED
+
+UInt32 Numa_GetNumNodes(void)
+{
+  return 0;
+}
+
+BoolInt Numa_GetNodeCpuSet(UInt32 nodeIndex, CCpuSet *cpuSet)
+{
+  UNUSED_VAR(nodeIndex)
+  UNUSED_VAR(cpuSet)
+  return False;
+}
+
+#endif
@@ -137,6 +137,13 @@ WRes Thread_Wait_Close(CThread *p);
 WRes Thread_Create_With_CpuSet(CThread *p, THREAD_FUNC_TYPE func, LPVOID param, const CCpuSet *cpuSet);
 #endif
 
+/* NUMA topology. It's supported only in Linux (from /sys/devices/system/node).
+   Numa_GetNumNodes() returns the number of online NUMA nodes, or 0, if there is no such information.
+   Numa_GetNodeCpuSet() returns the CPUs of node with index (nodeIndex) in the list of online nodes,
+     that are allowed by affinity mask of current thread. */
+UInt32 Numa_GetNumNodes(void);
+BoolInt Numa_GetNodeCpuSet(UInt32 nodeIndex, CCpuSet *cpuSet);
+
 
 #ifdef _WIN32
 
@@ -235,6 +242,44 @@ LONG InterlockedIncrement(LONG volatile *addend);
 
 WRes AutoResetEvent_OptCreate_And_Reset(CAutoResetEvent *p);
 
+
+/* ---------- Shared thread pool ----------
+  CPoolThread is a replacement for CThread for long-living worker threads
+  of multithreaded coders (MtCoder, MtDec, LzFindMt, CVirtThread).
+  PoolThread_Wait_Close() waits for (func) finishing, and then it returns
+  the system thread to the process-wide list of idle threads,
+  and PoolThread_Create() takes the thread from that list instead of creating new one.
+  So the application that codes many small streams doesn't pay for thread creation
+  for each stream.
+  The pool is disabled by default (numIdleThreadsMax == 0):
+  then CPoolThread works as CThread.
+
+  ThreadPool_ReserveThreads(numThreads) is used by the coders that can change
+  the number of threads: it returns the number of threads (1 <= ret <= numThreads)
+  that can be used for new coding operation, if (numThreadsMax != 0) was set,
+  so the total number of busy threads in process doesn't exceed (numThreadsMax).
+  The caller must call ThreadPool_ReleaseThreads(ret) after coding. */
+
+typedef struct
+{
+  CThread _thread;  // it's used, if the thread was created without pool
+  struct CThreadPoolWorker_ *_worker;
+} CPoolThread;
+
+#define PoolThread_CONSTRUCT(p)   { Thread_CONSTRUCT(&(p)->_thread)  (p)->_worker = NULL; }
+#define PoolThread_WasCreated(p)  (Thread_WasCreated(&(p)->_thread) || (p)->_worker != NULL)
+WRes PoolThread_Create(CPoolThread *p, THREAD_FUNC_TYPE func, LPVOID param);
+// the thread with affinity is not shared
+WRes PoolThread_Create_With_Affinity(CPoolThread *p, THREAD_FUNC_TYPE func, LPVOID param, CAffinityMask affinity);
+WRes PoolThread_Create_With_CpuSet(CPoolThread *p, THREAD_FUNC_TYPE func, LPVOID param, const CCpuSet *cpuSet);
+WRes PoolThread_Wait_Close(CPoolThread *p);
+
+/* (numThreadsMax == 0) : no limit for the number of busy threads.
+   (numIdleThreadsMax == 0) : the pool is disabled, and all idle threads are closed. */
+void ThreadPool_Set(UInt32 numThreadsMax, UInt32 numIdleThreadsMax);
+UInt32 ThreadPool_ReserveThreads(UInt32 numThreads);
+void ThreadPool_ReleaseThreads(UInt32 numThreads);
+
 EXTERN_C_END
 
 #endif
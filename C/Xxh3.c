@@ -0,0 +1,632 @@
+/* Xxh3.c -- XXH3-128 hash calculation
+Copyright (C) 2012-2023 Yann Collet
+Modifications: 2026-10-18 : yhnmj6666/7z contributors
+
+BSD 2-Clause License (https://www.opensource.org/licenses/bsd-license.php)
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following disclaimer
+      in the documentation and/or other materials provided with the
+      distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This is a port of the xxHash reference code (https://github.com/Cyan4973/xxHash). */
+
+#include "Precomp.h"
+
+#include <string.h>
+
+#include "Compiler.h"
+#include "CpuArch.h"
+#include "RotateDefs.h"
+#include "Xxh3.h"
+
+#if defined(_MSC_VER) && defined(MY_CPU_AMD64) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#define Z7_XXH_PRIME32_1  0x9E3779B1
+#define Z7_XXH_PRIME32_2  0x85EBCA77
+#define Z7_XXH_PRIME32_3  0xC2B2AE3D
+
+#define Z7_XXH_PRIME64_1  UINT64_CONST(0x9E3779B185EBCA87)
+#define Z7_XXH_PRIME64_2  UINT64_CONST(0xC2B2AE3D27D4EB4F)
+#define Z7_XXH_PRIME64_3  UINT64_CONST(0x165667B19E3779F9)
+#define Z7_XXH_PRIME64_4  UINT64_CONST(0x85EBCA77C2B2AE63)
+#define Z7_XXH_PRIME64_5  UINT64_CONST(0x27D4EB2F165667C5)
+
+#define Z7_XXH_PRIME_MX1  UINT64_CONST(0x165667919E3779F9)
+#define Z7_XXH_PRIME_MX2  UINT64_CONST(0x9FB21C651E98DF25)
+
+#define XXH3_SECRET_SIZE  192
+// the number of stripes in block
+#define XXH3_NUM_STRIPES  ((XXH3_SECRET_SIZE - XXH3_STRIPE_SIZE) / 8)
+#define XXH3_MIDSIZE_MAX  240
+
+// the default secret
+static const Byte k_Xxh3_Secret[XXH3_SECRET_SIZE] =
+{
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+  0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+  0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+  0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+  0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+  0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+  0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+  0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+  0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+  0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+  0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+  0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+#define SEC64(offset)  GetUi64(k_Xxh3_Secret + (offset))
+#define SEC32(offset)  GetUi32(k_Xxh3_Secret + (offset))
+
+
+// it returns low 64 bits of (a * b), and it writes high 64 bits to (*high)
+
+static UInt64 Xxh3_Mul128(UInt64 a, UInt64 b, UInt64 *high)
+{
+#if defined(__SIZEOF_INT128__)
+  const unsigned __int128 m = (unsigned __int128)a * b;
+  *high = (UInt64)(m >> 64);
+  return (UInt64)m;
+#elif defined(_MSC_VER) && defined(MY_CPU_AMD64) && !defined(__clang__)
+  return _umul128(a, b, high);
+#else
+  const UInt64 lo_lo = (UInt64)(UInt32)a * (UInt32)b;
+  const UInt64 hi_lo = (a >> 32) * (UInt32)b;
+  const UInt64 lo_hi = (UInt64)(UInt32)a * (b >> 32);
+  const UInt64 hi_hi = (a >> 32) * (b >> 32);
+  const UInt64 cross = (lo_lo >> 32) + (UInt32)hi_lo + lo_hi;
+  *high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  return (cross << 32) | (UInt32)lo_lo;
+#endif
+}
+
+static UInt64 Xxh3_Mul128_Fold64(UInt64 a, UInt64 b)
+{
+  UInt64 high;
+  const UInt64 low = Xxh3_Mul128(a, b, &high);
+  return low ^ high;
+}
+
+static UInt64 Xxh64_Avalanche(UInt64 h)
+{
+  h ^= h >> 33;
+  h *= Z7_XXH_PRIME64_2;
+  h ^= h >> 29;
+  h *= Z7_XXH_PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+static UInt64 Xxh3_Avalanche(UInt64 h)
+{
+  h ^= h >> 37;
+  h *= Z7_XXH_PRIME_MX1;
+  h ^= h >> 32;
+  return h;
+}
+
+static UInt64 Xxh3_Mix16(const Byte *data, unsigned secretOffset)
+{
+  return Xxh3_Mul128_Fold64(
+      GetUi64(data)     ^ SEC64(secretOffset),
+      GetUi64(data + 8) ^ SEC64(secretOffset + 8));
+}
+
+
+typedef struct
+{
+  UInt64 low;
+  UInt64 high;
+} CXxh3_128;
+
+static void Xxh3_Mix32(CXxh3_128 *acc, const Byte *data1, const Byte *data2, unsigned secretOffset)
+{
+  acc->low  += Xxh3_Mix16(data1, secretOffset);
+  acc->low  ^= GetUi64(data2) + GetUi64(data2 + 8);
+  acc->high += Xxh3_Mix16(data2, secretOffset + 16);
+  acc->high ^= GetUi64(data1) + GetUi64(data1 + 8);
+}
+
+
+// (size <= 16)
+
+static void Xxh3_128_Small(const Byte *data, unsigned size, CXxh3_128 *h)
+{
+  if (size > 8)
+  {
+    UInt64 hi = GetUi64(data + size - 8);
+    UInt64 mhigh, mlow, high;
+    mlow = Xxh3_Mul128(GetUi64(data) ^ hi ^ (SEC64(32) ^ SEC64(40)), Z7_XXH_PRIME64_1, &mhigh);
+    mlow += (UInt64)(size - 1) << 54;
+    hi ^= SEC64(48) ^ SEC64(56);
+    mhigh += hi + (UInt64)(UInt32)hi * (Z7_XXH_PRIME32_2 - 1);
+    mlow ^= Z7_BSWAP64(mhigh);
+    h->low = Xxh3_Mul128(mlow, Z7_XXH_PRIME64_2, &high);
+    high += mhigh * Z7_XXH_PRIME64_2;
+    h->low = Xxh3_Avalanche(h->low);
+    h->high = Xxh3_Avalanche(high);
+  }
+  else if (size >= 4)
+  {
+    const UInt64 v = GetUi32(data) + ((UInt64)GetUi32(data + size - 4) << 32);
+    UInt64 high;
+    UInt64 low = Xxh3_Mul128(v ^ (SEC64(16) ^ SEC64(24)), Z7_XXH_PRIME64_1 + ((UInt64)size << 2), &high);
+    high += low << 1;
+    low ^= high >> 3;
+    low ^= low >> 35;
+    low *= Z7_XXH_PRIME_MX2;
+    low ^= low >> 28;
+    h->low = low;
+    h->high = Xxh3_Avalanche(high);
+  }
+  else if (size != 0)
+  {
+    const UInt32 lo =
+          ((UInt32)data[0] << 16)
+        | ((UInt32)data[size >> 1] << 24)
+        | (UInt32)data[size - 1]
+        | ((UInt32)size << 8);
+    const UInt32 hi = rotlFixed(Z7_BSWAP32(lo), 13);
+    h->low  = Xxh64_Avalanche(lo ^ (UInt64)(SEC32(0) ^ SEC32(4)));
+    h->high = Xxh64_Avalanche(hi ^ (UInt64)(SEC32(8) ^ SEC32(12)));
+  }
+  else
+  {
+    h->low  = Xxh64_Avalanche(SEC64(64) ^ SEC64(72));
+    h->high = Xxh64_Avalanche(SEC64(80) ^ SEC64(88));
+  }
+}
+
+
+static void Xxh3_128_Mid_Final(CXxh3_128 *acc, unsigned size, CXxh3_128 *h)
+{
+  const UInt64 low = acc->low + acc->high;
+  const UInt64 high = acc->low * Z7_XXH_PRIME64_1
+      + acc->high * Z7_XXH_PRIME64_4
+      + (UInt64)size * Z7_XXH_PRIME64_2;
+  h->low = Xxh3_Avalanche(low);
+  h->high = (UInt64)0 - Xxh3_Avalanche(high);
+}
+
+
+// (16 < size <= XXH3_MIDSIZE_MAX)
+
+static void Xxh3_128_Mid(const Byte *data, unsigned size, CXxh3_128 *h)
+{
+  CXxh3_128 acc;
+  acc.low = (UInt64)size * Z7_XXH_PRIME64_1;
+  acc.high = 0;
+  if (size <= 128)
+  {
+    if (size > 32)
+    {
+      if (size > 64)
+      {
+        if (size > 96)
+          Xxh3_Mix32(&acc, data + 48, data + size - 64, 96);
+        Xxh3_Mix32(&acc, data + 32, data + size - 48, 64);
+      }
+      Xxh3_Mix32(&acc, data + 16, data + size - 32, 32);
+    }
+    Xxh3_Mix32(&acc, data, data + size - 16, 0);
+  }
+  else
+  {
+    const unsigned numRounds = size / 32;
+    unsigned i;
+    for (i = 0; i < 4; i++)
+      Xxh3_Mix32(&acc, data + 32 * i, data + 32 * i + 16, 32 * i);
+    acc.low = Xxh3_Avalanche(acc.low);
+    acc.high = Xxh3_Avalanche(acc.high);
+    for (i = 4; i < numRounds; i++)
+      Xxh3_Mix32(&acc, data + 32 * i, data + 32 * i + 16, 3 + 32 * (i - 4));
+    // the last bytes
+    Xxh3_Mix32(&acc, data + size - 16, data + size - 32, 136 - 17 - 16);
+  }
+  Xxh3_128_Mid_Final(&acc, size, h);
+}
+
+
+/* ---------- accumulation of long data ---------- */
+
+static void Z7_FASTCALL Xxh3_Accumulate(UInt64 *acc, const Byte *data, const Byte *secret, size_t numStripes)
+{
+  for (; numStripes != 0; numStripes--)
+  {
+    unsigned i;
+    for (i = 0; i < 8; i++)
+    {
+      const UInt64 v = GetUi64(data + i * 8);
+      const UInt64 k = v ^ GetUi64(secret + i * 8);
+      acc[i ^ 1] += v;
+      acc[i] += (UInt64)(UInt32)k * (k >> 32);
+    }
+    data += XXH3_STRIPE_SIZE;
+    secret += 8;
+  }
+}
+
+
+#if defined(MY_CPU_X86_OR_AMD64)
+  #if defined(Z7_LLVM_CLANG_VERSION)  && (Z7_LLVM_CLANG_VERSION  >= 30100) \
+     || defined(Z7_APPLE_CLANG_VERSION) && (Z7_APPLE_CLANG_VERSION >= 40000) \
+     || defined(Z7_GCC_VERSION)         && (Z7_GCC_VERSION         >= 40900)
+      #define Z7_XXH3_USE_SSE2
+      #define Z7_XXH3_USE_AVX2
+      #if !defined(__SSE2__)
+        #define ATTRIB_SSE2  __attribute__((__target__("sse2")))
+      #endif
+      #if !defined(__AVX2__)
+        #define ATTRIB_AVX2  __attribute__((__target__("avx2")))
+      #endif
+  #elif defined(_MSC_VER)
+    #if (_MSC_VER >= 1300)
+      #define Z7_XXH3_USE_SSE2
+    #endif
+    #if (_MSC_VER >= 1800)
+      #define Z7_XXH3_USE_AVX2
+    #endif
+  #endif
+#elif defined(MY_CPU_ARM64) && defined(MY_CPU_LE)
+  #if defined(__clang__) || defined(__GNUC__) || defined(_MSC_VER) && (_MSC_VER >= 1910)
+    // NEON is always supported in arm64
+    #define Z7_XXH3_USE_NEON
+  #endif
+#endif
+
+#ifndef ATTRIB_SSE2
+  #define ATTRIB_SSE2
+#endif
+#ifndef ATTRIB_AVX2
+  #define ATTRIB_AVX2
+#endif
+
+#if defined(Z7_XXH3_USE_SSE2) || defined(Z7_XXH3_USE_AVX2)
+#include <immintrin.h>
+#endif
+
+#ifdef Z7_XXH3_USE_NEON
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #include <arm64_neon.h>
+  #else
+    #include <arm_neon.h>
+  #endif
+#endif
+
+
+/* The vector code keeps (acc) in registers while it processes the stripes.
+   Each 64-bit lane (i) of product is (k[i].lo32 * k[i].hi32),
+   and the data for (acc[i ^ 1]) is the data with swapped 64-bit lanes. */
+
+#ifdef Z7_XXH3_USE_SSE2
+
+static
+ATTRIB_SSE2
+void Z7_FASTCALL Xxh3_Accumulate_SSE2(UInt64 *acc, const Byte *data, const Byte *secret, size_t numStripes)
+{
+  __m128i a0, a1, a2, a3;
+  if (numStripes == 0)
+    return;
+  a0 = _mm_loadu_si128((const __m128i *)(const void *)(acc));
+  a1 = _mm_loadu_si128((const __m128i *)(const void *)(acc + 2));
+  a2 = _mm_loadu_si128((const __m128i *)(const void *)(acc + 4));
+  a3 = _mm_loadu_si128((const __m128i *)(const void *)(acc + 6));
+  do
+  {
+    #define XXH3_SSE2_ACC(a, i) \
+    { \
+      const __m128i d = _mm_loadu_si128((const __m128i *)(const void *)(data + (i) * 16)); \
+      const __m128i k = _mm_xor_si128(d, _mm_loadu_si128((const __m128i *)(const void *)(secret + (i) * 16))); \
+      a = _mm_add_epi64(a, _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2))); \
+      a = _mm_add_epi64(a, _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)))); \
+    }
+    XXH3_SSE2_ACC(a0, 0)
+    XXH3_SSE2_ACC(a1, 1)
+    XXH3_SSE2_ACC(a2, 2)
+    XXH3_SSE2_ACC(a3, 3)
+    #undef XXH3_SSE2_ACC
+    data += XXH3_STRIPE_SIZE;
+    secret += 8;
+  }
+  while (--numStripes);
+  _mm_storeu_si128((__m128i *)(void *)(acc),     a0);
+  _mm_storeu_si128((__m128i *)(void *)(acc + 2), a1);
+  _mm_storeu_si128((__m128i *)(void *)(acc + 4), a2);
+  _mm_storeu_si128((__m128i *)(void *)(acc + 6), a3);
+}
+
+#endif // Z7_XXH3_USE_SSE2
+
+
+#ifdef Z7_XXH3_USE_AVX2
+
+static
+ATTRIB_AVX2
+void Z7_FASTCALL Xxh3_Accumulate_AVX2(UInt64 *acc, const Byte *data, const Byte *secret, size_t numStripes)
+{
+  __m256i a0, a1;
+  if (numStripes == 0)
+    return;
+  a0 = _mm256_loadu_si256((const __m256i *)(const void *)(acc));
+  a1 = _mm256_loadu_si256((const __m256i *)(const void *)(acc + 4));
+  do
+  {
+    #define XXH3_AVX2_ACC(a, i) \
+    { \
+      const __m256i d = _mm256_loadu_si256((const __m256i *)(const void *)(data + (i) * 32)); \
+      const __m256i k = _mm256_xor_si256(d, _mm256_loadu_si256((const __m256i *)(const void *)(secret + (i) * 32))); \
+      a = _mm256_add_epi64(a, _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2))); \
+      a = _mm256_add_epi64(a, _mm256_mul_epu32(k, _mm256_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)))); \
+    }
+    XXH3_AVX2_ACC(a0, 0)
+    XXH3_AVX2_ACC(a1, 1)
+    #undef XXH3_AVX2_ACC
+    data += XXH3_STRIPE_SIZE;
+    secret += 8;
+  }
+  while (--numStripes);
+  _mm256_storeu_si256((__m256i *)(void *)(acc),     a0);
+  _mm256_storeu_si256((__m256i *)(void *)(acc + 4), a1);
+}
+
+#endif // Z7_XXH3_USE_AVX2
+
+
+#ifdef Z7_XXH3_USE_NEON
+
+static void Z7_FASTCALL Xxh3_Accumulate_NEON(UInt64 *acc, const Byte *data, const Byte *secret, size_t numStripes)
+{
+  uint64x2_t a[4];
+  unsigned i;
+  if (numStripes == 0)
+    return;
+  for (i = 0; i < 4; i++)
+    a[i] = vld1q_u64(acc + i * 2);
+  do
+  {
+    for (i = 0; i < 4; i++)
+    {
+      const uint64x2_t d = vreinterpretq_u64_u8(vld1q_u8(data + i * 16));
+      const uint64x2_t k = veorq_u64(d, vreinterpretq_u64_u8(vld1q_u8(secret + i * 16)));
+      a[i] = vaddq_u64(a[i], vextq_u64(d, d, 1));
+      a[i] = vmlal_u32(a[i], vmovn_u64(k), vshrn_n_u64(k, 32));
+    }
+    data += XXH3_STRIPE_SIZE;
+    secret += 8;
+  }
+  while (--numStripes);
+  for (i = 0; i < 4; i++)
+    vst1q_u64(acc + i * 2, a[i]);
+}
+
+#endif // Z7_XXH3_USE_NEON
+
+
+#define XXH3_NUM_ALGOS (XXH3_ALGO_AVX2 + 1)
+
+// (g_Xxh3_Funcs[i] == NULL) means that the algo is not supported
+static XXH3_FUNC_ACCUMULATE g_Xxh3_Funcs[XXH3_NUM_ALGOS] =
+  { Xxh3_Accumulate, Xxh3_Accumulate, NULL, NULL };
+static unsigned g_Xxh3_DefaultAlgo = XXH3_ALGO_SW;
+
+
+BoolInt Xxh3_SetFunction(CXxh3 *p, unsigned algo)
+{
+  if (algo >= XXH3_NUM_ALGOS)
+    return False;
+  if (algo == XXH3_ALGO_DEFAULT)
+    algo = g_Xxh3_DefaultAlgo;
+  if (!g_Xxh3_Funcs[algo])
+    return False;
+  p->func_Accumulate = g_Xxh3_Funcs[algo];
+  return True;
+}
+
+
+void Xxh3_InitState(CXxh3 *p)
+{
+  p->numStripes = 0;
+  p->bufSize = 0;
+  p->count = 0;
+  p->acc[0] = Z7_XXH_PRIME32_3;
+  p->acc[1] = Z7_XXH_PRIME64_1;
+  p->acc[2] = Z7_XXH_PRIME64_2;
+  p->acc[3] = Z7_XXH_PRIME64_3;
+  p->acc[4] = Z7_XXH_PRIME64_4;
+  p->acc[5] = Z7_XXH_PRIME32_2;
+  p->acc[6] = Z7_XXH_PRIME64_5;
+  p->acc[7] = Z7_XXH_PRIME32_1;
+}
+
+void Xxh3_Init(CXxh3 *p)
+{
+  Xxh3_SetFunction(p, XXH3_ALGO_DEFAULT);
+  Xxh3_InitState(p);
+}
+
+
+static void Xxh3_Scramble(UInt64 *acc)
+{
+  unsigned i;
+  for (i = 0; i < 8; i++)
+  {
+    UInt64 a = acc[i];
+    a ^= a >> 47;
+    a ^= SEC64(XXH3_SECRET_SIZE - XXH3_STRIPE_SIZE + i * 8);
+    acc[i] = a * Z7_XXH_PRIME32_1;
+  }
+}
+
+
+/* it processes the stripes of data.
+   The accumulators are scrambled after each block of (XXH3_NUM_STRIPES) stripes. */
+
+static void Xxh3_ProcessStripes(XXH3_FUNC_ACCUMULATE func, UInt64 *acc,
+    unsigned *numStripesInBlock, const Byte *data, size_t numStripes)
+{
+  unsigned pos = *numStripesInBlock;
+  while (numStripes != 0)
+  {
+    size_t cur = XXH3_NUM_STRIPES - pos;
+    if (cur > numStripes)
+      cur = numStripes;
+    func(acc, data, k_Xxh3_Secret + pos * 8, cur);
+    data += cur * XXH3_STRIPE_SIZE;
+    numStripes -= cur;
+    pos += (unsigned)cur;
+    if (pos == XXH3_NUM_STRIPES)
+    {
+      Xxh3_Scramble(acc);
+      pos = 0;
+    }
+  }
+  *numStripesInBlock = pos;
+}
+
+
+/* We don't process the last stripe of stream in Xxh3_Update(),
+   because the last stripe is processed in special way in Xxh3_128_Final().
+   So (buf) always contains 1 or more bytes of stream, if (count != 0). */
+
+void Xxh3_Update(CXxh3 *p, const Byte *data, size_t size)
+{
+  unsigned pos;
+  if (size == 0)
+    return;
+  p->count += size;
+  pos = p->bufSize;
+  if (size <= XXH3_BUF_SIZE - pos)
+  {
+    memcpy(p->buf + pos, data, size);
+    p->bufSize = pos + (unsigned)size;
+    return;
+  }
+  if (pos != 0)
+  {
+    const unsigned rem = XXH3_BUF_SIZE - pos;
+    memcpy(p->buf + pos, data, rem);
+    data += rem;
+    size -= rem;
+    // there is more data after (buf). So we can process all stripes in (buf)
+    Xxh3_ProcessStripes(p->func_Accumulate, p->acc, &p->numStripes, p->buf, XXH3_BUF_SIZE / XXH3_STRIPE_SIZE);
+    memcpy(p->lastStripe, p->buf + XXH3_BUF_SIZE - XXH3_STRIPE_SIZE, XXH3_STRIPE_SIZE);
+  }
+  if (size > XXH3_BUF_SIZE)
+  {
+    // we keep from 1 to XXH3_STRIPE_SIZE bytes for (buf)
+    const size_t numStripes = (size - 1) / XXH3_STRIPE_SIZE;
+    const size_t processed = numStripes * XXH3_STRIPE_SIZE;
+    Xxh3_ProcessStripes(p->func_Accumulate, p->acc, &p->numStripes, data, numStripes);
+    memcpy(p->lastStripe, data + processed - XXH3_STRIPE_SIZE, XXH3_STRIPE_SIZE);
+    data += processed;
+    size -= processed;
+  }
+  memcpy(p->buf, data, size);
+  p->bufSize = (unsigned)size;
+}
+
+
+static UInt64 Xxh3_MergeAccs(const UInt64 *acc, unsigned secretOffset, UInt64 v)
+{
+  unsigned i;
+  for (i = 0; i < 4; i++)
+    v += Xxh3_Mul128_Fold64(
+        acc[i * 2]     ^ SEC64(secretOffset + i * 16),
+        acc[i * 2 + 1] ^ SEC64(secretOffset + i * 16 + 8));
+  return Xxh3_Avalanche(v);
+}
+
+
+void Xxh3_128_Final(const CXxh3 *p, Byte *digest)
+{
+  CXxh3_128 h;
+  if (p->count <= XXH3_MIDSIZE_MAX)
+  {
+    // all data is in (buf)
+    if (p->count <= 16)
+      Xxh3_128_Small(p->buf, (unsigned)p->count, &h);
+    else
+      Xxh3_128_Mid(p->buf, (unsigned)p->count, &h);
+  }
+  else
+  {
+    UInt64 acc[8];
+    unsigned numStripesInBlock = p->numStripes;
+    const unsigned size = p->bufSize;
+    const Byte *lastStripe;
+    Byte temp[XXH3_STRIPE_SIZE];
+    memcpy(acc, p->acc, sizeof(acc));
+    Xxh3_ProcessStripes(p->func_Accumulate, acc, &numStripesInBlock, p->buf, (size - 1) / XXH3_STRIPE_SIZE);
+    if (size >= XXH3_STRIPE_SIZE)
+      lastStripe = p->buf + size - XXH3_STRIPE_SIZE;
+    else
+    {
+      const unsigned rem = XXH3_STRIPE_SIZE - size;
+      memcpy(temp, p->lastStripe + XXH3_STRIPE_SIZE - rem, rem);
+      memcpy(temp + rem, p->buf, size);
+      lastStripe = temp;
+    }
+    p->func_Accumulate(acc, lastStripe, k_Xxh3_Secret + XXH3_SECRET_SIZE - XXH3_STRIPE_SIZE - 7, 1);
+    h.low = Xxh3_MergeAccs(acc, 11, p->count * Z7_XXH_PRIME64_1);
+    h.high = Xxh3_MergeAccs(acc, XXH3_SECRET_SIZE - XXH3_STRIPE_SIZE - 11, ~(p->count * Z7_XXH_PRIME64_2));
+  }
+  SetBe32(digest,      (UInt32)(h.high >> 32))
+  SetBe32(digest + 4,  (UInt32)h.high)
+  SetBe32(digest + 8,  (UInt32)(h.low >> 32))
+  SetBe32(digest + 12, (UInt32)h.low)
+}
+
+
+void Xxh3Prepare(void)
+{
+  unsigned algo = XXH3_ALGO_SW;
+  #ifdef MY_CPU_X86_OR_AMD64
+    #ifdef Z7_XXH3_USE_SSE2
+    #ifdef MY_CPU_X86
+    if (CPU_IsSupported_SSE2())
+    #endif
+    {
+      g_Xxh3_Funcs[XXH3_ALGO_SSE2] = Xxh3_Accumulate_SSE2;
+      algo = XXH3_ALGO_SSE2;
+    }
+    #endif
+    #ifdef Z7_XXH3_USE_AVX2
+    if (CPU_IsSupported_AVX2())
+    {
+      g_Xxh3_Funcs[XXH3_ALGO_AVX2] = Xxh3_Accumulate_AVX2;
+      algo = XXH3_ALGO_AVX2;
+    }
+    #endif
+  #elif defined(Z7_XXH3_USE_NEON)
+    g_Xxh3_Funcs[XXH3_ALGO_SSE2] = Xxh3_Accumulate_NEON;
+    algo = XXH3_ALGO_SSE2;
+  #endif
+  g_Xxh3_DefaultAlgo = algo;
+}
+
+#undef SEC64
+#undef SEC32
+#undef ATTRIB_SSE2
+#undef ATTRIB_AVX2
@@ -0,0 +1,95 @@
+/* Xxh3.h -- XXH3-128 hash calculation
+Copyright (C) 2012-2023 Yann Collet
+Modifications: 2026-10-18 : yhnmj6666/7z contributors
+
+BSD 2-Clause License (https://www.opensource.org/licenses/bsd-license.php)
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following disclaimer
+      in the documentation and/or other materials provided with the
+      distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This is a port of the xxHash reference code (https://github.com/Cyan4973/xxHash). */
+
+#ifndef ZIP7_INC_XXH3_H
+#define ZIP7_INC_XXH3_H
+
+#include "7zTypes.h"
+
+EXTERN_C_BEGIN
+
+#define XXH3_128_DIGEST_SIZE  16
+
+#define XXH3_STRIPE_SIZE      64
+#define XXH3_BUF_SIZE         (XXH3_STRIPE_SIZE * 4)
+
+/*
+XXH3_FUNC_ACCUMULATE:
+  it processes (numStripes) stripes of (XXH3_STRIPE_SIZE) bytes from (data).
+  The secret for stripe (i) starts from (secret + i * 8).
+*/
+
+typedef void (Z7_FASTCALL *XXH3_FUNC_ACCUMULATE)(UInt64 *acc, const Byte *data, const Byte *secret, size_t numStripes);
+
+typedef struct
+{
+  XXH3_FUNC_ACCUMULATE func_Accumulate;
+  unsigned numStripes;  // the number of processed stripes in current block
+  unsigned bufSize;
+  UInt64 count;
+  UInt64 acc[8];
+  // the last stripe of processed data, if (buf) contains less than one stripe
+  Byte lastStripe[XXH3_STRIPE_SIZE];
+  Byte buf[XXH3_BUF_SIZE];
+} CXxh3;
+
+#define XXH3_ALGO_DEFAULT 0
+#define XXH3_ALGO_SW      1
+#define XXH3_ALGO_SSE2    2  // SSE2 in x86/x64 or NEON in arm64
+#define XXH3_ALGO_AVX2    3
+
+/*
+Xxh3_SetFunction()
+return:
+  0 - (algo) value is not supported, and func_Accumulate was not changed
+  1 - func_Accumulate was set according (algo) value.
+*/
+
+BoolInt Xxh3_SetFunction(CXxh3 *p, unsigned algo);
+
+void Xxh3_InitState(CXxh3 *p);
+void Xxh3_Init(CXxh3 *p);
+void Xxh3_Update(CXxh3 *p, const Byte *data, size_t size);
+
+/* Xxh3_128_Final() writes the digest in canonical (big-endian) form:
+   high 64-bit part and then low 64-bit part. It doesn't change the state. */
+void Xxh3_128_Final(const CXxh3 *p, Byte *digest);
+
+/*
+call Xxh3Prepare() once at program start.
+It prepares all supported implementations, and detects the fastest implementation.
+*/
+
+void Xxh3Prepare(void);
+
+EXTERN_C_END
+
+#endif
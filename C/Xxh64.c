@@ -0,0 +1,204 @@
+/* Xxh64.c -- XXH64 hash calculation
+Copyright (C) 2012-2023 Yann Collet
+Modifications: 2026-10-18 : yhnmj6666/7z contributors
+
+BSD 2-Clause License (https://www.opensource.org/licenses/bsd-license.php)
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following disclaimer
+      in the documentation and/or other materials provided with the
+      distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This is a port of the xxHash reference code (https://github.com/Cyan4973/xxHash). */
+
+#include "Precomp.h"
+
+#include <string.h>
+
+#include "CpuArch.h"
+#include "RotateDefs.h"
+#include "Xxh64.h"
+
+#define Z7_XXH_PRIME64_1  UINT64_CONST(0x9E3779B185EBCA87)
+#define Z7_XXH_PRIME64_2  UINT64_CONST(0xC2B2AE3D27D4EB4F)
+#define Z7_XXH_PRIME64_3  UINT64_CONST(0x165667B19E3779F9)
+#define Z7_XXH_PRIME64_4  UINT64_CONST(0x85EBCA77C2B2AE63)
+#define Z7_XXH_PRIME64_5  UINT64_CONST(0x27D4EB2F165667C5)
+
+void Xxh64_Init(CXxh64 *p)
+{
+  const UInt64 seed = 0;
+  p->v[0] = seed + Z7_XXH_PRIME64_1 + Z7_XXH_PRIME64_2;
+  p->v[1] = seed + Z7_XXH_PRIME64_2;
+  p->v[2] = seed;
+  p->v[3] = seed - Z7_XXH_PRIME64_1;
+}
+
+#define Z7_XXH64_ROUND(acc, input) \
+  { acc += (input) * Z7_XXH_PRIME64_2; \
+    acc = Z7_ROTL64(acc, 31); \
+    acc *= Z7_XXH_PRIME64_1; }
+
+void Xxh64_Update(CXxh64 *p, const void *_data, size_t size)
+{
+  const Byte *data = (const Byte *)_data;
+  UInt64 v0, v1, v2, v3;
+  if (size < Z7_XXH64_BLOCK_SIZE)
+    return;
+  v0 = p->v[0];
+  v1 = p->v[1];
+  v2 = p->v[2];
+  v3 = p->v[3];
+  {
+    const Byte *lim = data + (size & ~(size_t)(Z7_XXH64_BLOCK_SIZE - 1));
+    do
+    {
+      Z7_XXH64_ROUND(v0, GetUi64(data))
+      Z7_XXH64_ROUND(v1, GetUi64(data + 8))
+      Z7_XXH64_ROUND(v2, GetUi64(data + 16))
+      Z7_XXH64_ROUND(v3, GetUi64(data + 24))
+      data += Z7_XXH64_BLOCK_SIZE;
+    }
+    while (data != lim);
+  }
+  p->v[0] = v0;
+  p->v[1] = v1;
+  p->v[2] = v2;
+  p->v[3] = v3;
+}
+
+
+static UInt64 Xxh64_Merge(UInt64 h, UInt64 v)
+{
+  UInt64 acc = 0;
+  Z7_XXH64_ROUND(acc, v)
+  h ^= acc;
+  return h * Z7_XXH_PRIME64_1 + Z7_XXH_PRIME64_4;
+}
+
+
+UInt64 Xxh64_Digest(const CXxh64 *p, const void *_data, UInt64 count)
+{
+  const Byte *data = (const Byte *)_data;
+  UInt64 h;
+  unsigned rem;
+  if (count >= Z7_XXH64_BLOCK_SIZE)
+  {
+    const UInt64 v0 = p->v[0];
+    const UInt64 v1 = p->v[1];
+    const UInt64 v2 = p->v[2];
+    const UInt64 v3 = p->v[3];
+    h = Z7_ROTL64(v0, 1) + Z7_ROTL64(v1, 7) + Z7_ROTL64(v2, 12) + Z7_ROTL64(v3, 18);
+    h = Xxh64_Merge(h, v0);
+    h = Xxh64_Merge(h, v1);
+    h = Xxh64_Merge(h, v2);
+    h = Xxh64_Merge(h, v3);
+  }
+  else
+    h = p->v[2] + Z7_XXH_PRIME64_5;
+
+  h += count;
+  rem = (unsigned)count & (Z7_XXH64_BLOCK_SIZE - 1);
+
+  for (; rem >= 8; rem -= 8, data += 8)
+  {
+    UInt64 k = 0;
+    Z7_XXH64_ROUND(k, GetUi64(data))
+    h ^= k;
+    h = Z7_ROTL64(h, 27) * Z7_XXH_PRIME64_1 + Z7_XXH_PRIME64_4;
+  }
+  if (rem >= 4)
+  {
+    h ^= (UInt64)GetUi32(data) * Z7_XXH_PRIME64_1;
+    h = Z7_ROTL64(h, 23) * Z7_XXH_PRIME64_2 + Z7_XXH_PRIME64_3;
+    data += 4;
+    rem -= 4;
+  }
+  for (; rem != 0; rem--)
+  {
+    h ^= (UInt64)*data++ * Z7_XXH_PRIME64_5;
+    h = Z7_ROTL64(h, 11) * Z7_XXH_PRIME64_1;
+  }
+
+  h ^= h >> 33;
+  h *= Z7_XXH_PRIME64_2;
+  h ^= h >> 29;
+  h *= Z7_XXH_PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+
+void Xxh64State_Init(CXxh64State *p)
+{
+  p->count = 0;
+  Xxh64_Init(&p->main);
+}
+
+
+void Xxh64State_Update(CXxh64State *p, const void *_data, size_t size)
+{
+  const Byte *data = (const Byte *)_data;
+  unsigned pos;
+  if (size == 0)
+    return;
+  pos = (unsigned)p->count & (Z7_XXH64_BLOCK_SIZE - 1);
+  p->count += size;
+  if (pos != 0)
+  {
+    unsigned rem = Z7_XXH64_BLOCK_SIZE - pos;
+    if (rem > size)
+      rem = (unsigned)size;
+    memcpy(p->buf.buf + pos, data, rem);
+    data += rem;
+    size -= rem;
+    pos += rem;
+    if (pos != Z7_XXH64_BLOCK_SIZE)
+      return;
+    Xxh64_Update(&p->main, p->buf.buf, Z7_XXH64_BLOCK_SIZE);
+  }
+  {
+    const size_t size2 = size & ~(size_t)(Z7_XXH64_BLOCK_SIZE - 1);
+    Xxh64_Update(&p->main, data, size2);
+    data += size2;
+    size -= size2;
+  }
+  if (size != 0)
+    memcpy(p->buf.buf, data, size);
+}
+
+
+UInt64 Xxh64State_Digest(const CXxh64State *p)
+{
+  return Xxh64_Digest(&p->main, p->buf.buf, p->count);
+}
+
+
+UInt64 Xxh64_Calc(const void *data, size_t size)
+{
+  CXxh64 x;
+  const size_t size2 = size & ~(size_t)(Z7_XXH64_BLOCK_SIZE - 1);
+  Xxh64_Init(&x);
+  Xxh64_Update(&x, data, size2);
+  return Xxh64_Digest(&x, (const Byte *)data + size2, size);
+}
+
+#undef Z7_XXH64_ROUND
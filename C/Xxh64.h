@@ -0,0 +1,79 @@
+/* Xxh64.h -- XXH64 hash calculation
+Copyright (C) 2012-2023 Yann Collet
+Modifications: 2026-10-18 : yhnmj6666/7z contributors
+
+BSD 2-Clause License (https://www.opensource.org/licenses/bsd-license.php)
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following disclaimer
+      in the documentation and/or other materials provided with the
+      distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+This is a port of the xxHash reference code (https://github.com/Cyan4973/xxHash). */
+
+#ifndef ZIP7_INC_XXH64_H
+#define ZIP7_INC_XXH64_H
+
+#include "7zTypes.h"
+
+EXTERN_C_BEGIN
+
+#define Z7_XXH64_BLOCK_SIZE  (4 * 8)
+
+typedef struct
+{
+  UInt64 v[4];
+} CXxh64;
+
+void Xxh64_Init(CXxh64 *p);
+
+/* Xxh64_Update() processes only full 32-byte blocks: (size) must be multiple of 32 */
+void Xxh64_Update(CXxh64 *p, const void *data, size_t size);
+
+/*
+Xxh64_Digest():
+  (data, count) : the tail of the stream that was not processed by Xxh64_Update().
+    (count & 31) bytes are processed from (data).
+    (count) : the total size of the stream.
+*/
+UInt64 Xxh64_Digest(const CXxh64 *p, const void *data, UInt64 count);
+
+
+typedef struct
+{
+  UInt64 count;
+  CXxh64 main;
+  union
+  {
+    UInt64 u64[4];
+    Byte buf[Z7_XXH64_BLOCK_SIZE];
+  } buf;
+} CXxh64State;
+
+void Xxh64State_Init(CXxh64State *p);
+void Xxh64State_Update(CXxh64State *p, const void *data, size_t size);
+UInt64 Xxh64State_Digest(const CXxh64State *p);
+
+UInt64 Xxh64_Calc(const void *data, size_t size);
+
+EXTERN_C_END
+
+#endif
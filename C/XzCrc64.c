@@ -5,6 +5,7 @@
 
 #include "XzCrc64.h"
 #include "CpuArch.h"
+#include "CrcFold.h"
 
 #define kCrc64Poly UINT64_CONST(0xC96C5795D7870F42)
 
@@ -20,11 +21,43 @@
   UInt64 Z7_FASTCALL XzCrc64UpdateT4(UInt64 v, const void *data, size_t size, const UInt64 *table);
 #endif
 
-typedef UInt64 (Z7_FASTCALL *CRC64_FUNC)(UInt64 v, const void *data, size_t size, const UInt64 *table);
-
-static CRC64_FUNC g_Crc64Update;
+extern
+CRC64_FUNC g_Crc64UpdateT4;
+CRC64_FUNC g_Crc64UpdateT4;
+extern
+CRC64_FUNC g_Crc64UpdateFold;
+CRC64_FUNC g_Crc64UpdateFold;
+extern
+CRC64_FUNC g_Crc64Update;
+CRC64_FUNC g_Crc64Update;
 UInt64 g_Crc64Table[256 * CRC64_NUM_TABLES];
 
+#ifdef MY_CPU_LE
+
+#define CRC64_FOLD_MIN_SIZE  (CRC_FOLD_BLOCK_SIZE * 4)
+
+static CRC_FOLD_FUNC g_Crc64Fold;
+static UInt64 g_Crc64FoldConsts[CRC_FOLD_NUM_CONSTS];
+
+static UInt64 Z7_FASTCALL XzCrc64UpdateFold(UInt64 v, const void *data, size_t size, const UInt64 *table)
+{
+  if (size >= CRC64_FOLD_MIN_SIZE)
+  {
+    MY_ALIGN(16)
+    UInt64 rem[2];
+    const size_t numBlocks = size / CRC_FOLD_BLOCK_SIZE;
+    rem[0] = v;
+    rem[1] = 0;
+    g_Crc64Fold(rem, (const Byte *)data, numBlocks, g_Crc64FoldConsts);
+    v = XzCrc64UpdateT4(0, rem, sizeof(rem), table);
+    data = (const Byte *)data + numBlocks * CRC_FOLD_BLOCK_SIZE;
+    size &= CRC_FOLD_BLOCK_SIZE - 1;
+  }
+  return XzCrc64UpdateT4(v, data, size, table);
+}
+
+#endif
+
 UInt64 Z7_FASTCALL Crc64Update(UInt64 v, const void *data, size_t size)
 {
   return g_Crc64Update(v, data, size, g_Crc64Table);
@@ -54,14 +87,22 @@ void Z7_FASTCALL Crc64GenerateTable(void)
   
   #ifdef MY_CPU_LE
 
+  g_Crc64UpdateT4 = XzCrc64UpdateT4;
   g_Crc64Update = XzCrc64UpdateT4;
+  g_Crc64Fold = CrcFold_GetFunc();
+  if (g_Crc64Fold)
+  {
+    CrcFold_GenerateConsts(g_Crc64FoldConsts, kCrc64Poly, 64);
+    g_Crc64UpdateFold = XzCrc64UpdateFold;
+    g_Crc64Update = XzCrc64UpdateFold;
+  }
 
   #else
   {
     #ifndef MY_CPU_BE
     UInt32 k = 1;
     if (*(const Byte *)&k == 1)
-      g_Crc64Update = XzCrc64UpdateT4;
+      g_Crc64UpdateT4 = XzCrc64UpdateT4;
     else
     #endif
     {
@@ -70,8 +111,9 @@ void Z7_FASTCALL Crc64GenerateTable(void)
         const UInt64 x = g_Crc64Table[(size_t)i - 256];
         g_Crc64Table[i] = Z7_BSWAP64(x);
       }
-      g_Crc64Update = XzCrc64UpdateT1_BeT4;
+      g_Crc64UpdateT4 = XzCrc64UpdateT1_BeT4;
     }
+    g_Crc64Update = g_Crc64UpdateT4;
   }
   #endif
 }
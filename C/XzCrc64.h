@@ -21,6 +21,8 @@ void Z7_FASTCALL Crc64GenerateTable(void);
 UInt64 Z7_FASTCALL Crc64Update(UInt64 crc, const void *data, size_t size);
 UInt64 Z7_FASTCALL Crc64Calc(const void *data, size_t size);
 
+typedef UInt64 (Z7_FASTCALL *CRC64_FUNC)(UInt64 v, const void *data, size_t size, const UInt64 *table);
+
 EXTERN_C_END
 
 #endif
@@ -680,6 +680,7 @@ typedef struct
 {
   CLzma2EncHandle lzma2;
   CSeqInFilter filter;
+  int numaNode; /* it overrides (lzmaProps.numaNode), if (numaNode >= 0) */
 
   #ifdef USE_SUBBLOCK
   CSbEncInStream sb;
@@ -690,6 +691,7 @@ typedef struct
 static void Lzma2WithFilters_Construct(CLzma2WithFilters *p)
 {
   p->lzma2 = NULL;
+  p->numaNode = -1;
   SeqInFilter_Construct(&p->filter);
 
   #ifdef USE_SUBBLOCK
@@ -765,7 +767,12 @@ static SRes Xz_CompressBlock(
   
   RINOK(Lzma2WithFilters_Create(lzmaf, alloc, allocBig))
   
-  RINOK(Lzma2Enc_SetProps(lzmaf->lzma2, &props->lzma2Props))
+  {
+    CLzma2EncProps lzma2Props = props->lzma2Props;
+    if (lzmaf->numaNode >= 0)
+      lzma2Props.lzmaProps.numaNode = lzmaf->numaNode;
+    RINOK(Lzma2Enc_SetProps(lzmaf->lzma2, &lzma2Props))
+  }
   
   // XzBlock_ClearFlags(&block)
   XzBlock_ClearFlags_SetNumFilters(&block, 1 + (fp ? 1 : 0))
@@ -1111,6 +1118,9 @@ static SRes XzEnc_MtCallback_Code(void *pp, unsigned coderIndex, unsigned outBuf
     CXzEncBlockInfo blockSizes;
     int inStreamFinished;
 
+    // the match finder threads of coder are bound to NUMA node of coder thread
+    me->lzmaf_Items[coderIndex].numaNode = MtCoder_GetNumaNode(&me->mtCoder, coderIndex);
+
     res = Xz_CompressBlock(
         &me->lzmaf_Items[coderIndex],
         
@@ -1231,6 +1241,7 @@ SRes XzEnc_Encode(CXzEncHandle p, ISeqOutStreamPtr outStream, ISeqInStreamPtr in
 
     p->mtCoder.numThreadsMax = (unsigned)props->numBlockThreads_Max;
     p->mtCoder.expectedDataSize = p->expectedDataSize;
+    p->mtCoder.numaMode = (props->lzma2Props.numaMode > 0);
     
     RINOK(MtCoder_Code(&p->mtCoder))
   }
@@ -0,0 +1,1457 @@
+/* ZstdDec.c -- Zstandard decoder
+2026-10-18 : yhnmj6666/7z contributors : Public domain
+This code is written from the Zstandard format specification (RFC 8878). */
+
+#include "Precomp.h"
+
+#include <string.h>
+
+#include "CpuArch.h"
+#include "Xxh64.h"
+#include "ZstdDec.h"
+
+#ifdef MY_CPU_64BIT
+  #define kWindowSizeMax  ((UInt64)1 << 31)
+#else
+  #define kWindowSizeMax  ((UInt64)1 << 27)
+#endif
+
+#define kBlockSizeMax  ZSTD_BLOCK_SIZE_MAX
+
+#define kHufLogMax   12
+#define kLL_LogMax    9
+#define kOF_LogMax    8
+#define kML_LogMax    9
+#define kLL_SymMax   35
+#define kOF_SymMax   31
+#define kML_SymMax   52
+#define kFseLogMax    9
+
+#define kWeightsLogMax  6
+#define kWeightsSymMax 12
+
+static const UInt32 k_LL_Base[kLL_SymMax + 1] =
+{
+    0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+   16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096,
+   8192, 16384, 32768, 65536
+};
+
+static const Byte k_LL_Bits[kLL_SymMax + 1] =
+{
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9,10,11,12,
+  13,14,15,16
+};
+
+static const UInt32 k_ML_Base[kML_SymMax + 1] =
+{
+    3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+   19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+   35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+   4099, 8195, 16387, 32771, 65539
+};
+
+static const Byte k_ML_Bits[kML_SymMax + 1] =
+{
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9,10,11,
+  12,13,14,15,16
+};
+
+static const Int16 k_LL_Predef[kLL_SymMax + 1] =
+{
+  4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+  2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+ -1,-1,-1,-1
+};
+
+static const Int16 k_ML_Predef[kML_SymMax + 1] =
+{
+  1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,-1,-1,
+ -1,-1,-1,-1,-1
+};
+
+static const Int16 k_OF_Predef[29] =
+{
+  1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,-1,-1,-1,-1,-1
+};
+
+#define kLL_PredefLog 6
+#define kML_PredefLog 6
+#define kOF_PredefLog 5
+
+
+static unsigned GetHighBit32(UInt32 v)
+{
+  unsigned i = 0;
+  while (v >>= 1)
+    i++;
+  return i;
+}
+
+
+/* ---------- backward bit stream ---------- */
+
+/*
+  The stream is read from the end to the start.
+  (pos) is the number of unread bits. The bits below the start of stream
+  are read as zeros, and (pos < 0) means that the stream was overread.
+  The reader can access up to 8 bytes after the end of stream.
+*/
+
+typedef struct
+{
+  const Byte *buf;
+  ptrdiff_t pos;
+} CBitsBack;
+
+static SRes BitsBack_Init(CBitsBack *b, const Byte *buf, size_t size)
+{
+  unsigned last;
+  if (size == 0)
+    return SZ_ERROR_DATA;
+  last = buf[size - 1];
+  if (last == 0)
+    return SZ_ERROR_DATA;
+  b->buf = buf;
+  b->pos = (ptrdiff_t)((size - 1) * 8 + GetHighBit32(last));
+  return SZ_OK;
+}
+
+static UInt32 BitsBack_PeekSlow(const CBitsBack *b, unsigned numBits)
+{
+  const ptrdiff_t pos = b->pos;
+  if (pos <= 0)
+    return 0;
+  return (UInt32)((GetUi64(b->buf) & (((UInt64)1 << pos) - 1)) << (numBits - (unsigned)pos));
+}
+
+Z7_FORCE_INLINE
+static UInt32 BitsBack_Peek(const CBitsBack *b, unsigned numBits)
+{
+  const ptrdiff_t pos = b->pos - (ptrdiff_t)numBits;
+  if (pos >= 0)
+    return (UInt32)(GetUi64(b->buf + ((size_t)pos >> 3)) >> ((unsigned)pos & 7))
+        & (UInt32)(((UInt64)1 << numBits) - 1);
+  return BitsBack_PeekSlow(b, numBits);
+}
+
+Z7_FORCE_INLINE
+static UInt32 BitsBack_Read(CBitsBack *b, unsigned numBits)
+{
+  const UInt32 v = BitsBack_Peek(b, numBits);
+  b->pos -= (ptrdiff_t)numBits;
+  return v;
+}
+
+
+/* ---------- FSE tables ---------- */
+
+typedef struct
+{
+  UInt32 base;
+  Byte numAddBits;
+  Byte numBits;
+  UInt16 next;
+} CSeqEntry;
+
+typedef struct
+{
+  Byte sym;
+  Byte numBits;
+  UInt16 next;
+} CFseEntry;
+
+#define kNCountBufSize 128
+
+/* reads FSE normalized counts. It returns the number of processed bytes or 0 for error */
+
+static size_t Fse_ReadNCount(Int16 *norm, unsigned *numSymbols, unsigned *tableLog,
+    unsigned maxSym, unsigned maxLog, const Byte *src, size_t srcSize)
+{
+  Byte buf[kNCountBufSize + 8];
+  size_t pos;
+  unsigned log, numBits, sym;
+  Int32 remaining, threshold;
+  BoolInt prev0;
+  {
+    const size_t size = srcSize < kNCountBufSize ? srcSize : kNCountBufSize;
+    memcpy(buf, src, size);
+    memset(buf + size, 0, sizeof(buf) - size);
+  }
+  memset(norm, 0, (maxSym + 1) * sizeof(norm[0]));
+
+  #define NCOUNT_PEEK(n)  ((GetUi32(buf + (pos >> 3)) >> (pos & 7)) & (((UInt32)1 << (n)) - 1))
+
+  pos = 0;
+  log = (unsigned)NCOUNT_PEEK(4) + 5;
+  pos += 4;
+  if (log > maxLog)
+    return 0;
+  remaining = ((Int32)1 << log) + 1;
+  threshold = (Int32)1 << log;
+  numBits = log + 1;
+  sym = 0;
+  prev0 = False;
+
+  while (remaining > 1)
+  {
+    Int32 count, max;
+    UInt32 v;
+    if (pos > kNCountBufSize * 8)
+      return 0;
+    if (prev0)
+    {
+      for (;;)
+      {
+        const unsigned rep = (unsigned)NCOUNT_PEEK(2);
+        pos += 2;
+        sym += rep;
+        if (rep != 3)
+          break;
+        if (sym > maxSym || pos > kNCountBufSize * 8)
+          return 0;
+      }
+    }
+    if (sym > maxSym)
+      return 0;
+    max = (2 * threshold - 1) - remaining;
+    v = NCOUNT_PEEK(numBits);
+    if ((Int32)(v & (UInt32)(threshold - 1)) < max)
+    {
+      count = (Int32)(v & (UInt32)(threshold - 1));
+      pos += numBits - 1;
+    }
+    else
+    {
+      count = (Int32)(v & (UInt32)(2 * threshold - 1));
+      if (count >= threshold)
+        count -= max;
+      pos += numBits;
+    }
+    count--;
+    remaining -= count < 0 ? -count : count;
+    norm[sym++] = (Int16)count;
+    prev0 = (count == 0);
+    if (remaining < 1)
+      return 0;
+    while (remaining < threshold)
+    {
+      numBits--;
+      threshold >>= 1;
+    }
+  }
+
+  #undef NCOUNT_PEEK
+
+  pos = (pos + 7) >> 3;
+  if (pos > srcSize || pos > kNCountBufSize)
+    return 0;
+  *numSymbols = sym;
+  *tableLog = log;
+  return pos;
+}
+
+
+/* it fills (tableSymbol) and it initializes (symbolNext) */
+
+static void Fse_Spread(Byte *tableSymbol, UInt16 *symbolNext,
+    const Int16 *norm, unsigned numSymbols, unsigned tableLog)
+{
+  const unsigned size = (unsigned)1 << tableLog;
+  const unsigned mask = size - 1;
+  const unsigned step = (size >> 1) + (size >> 3) + 3;
+  unsigned high = size - 1;
+  unsigned pos = 0;
+  unsigned s;
+  for (s = 0; s < numSymbols; s++)
+  {
+    if (norm[s] == -1)
+    {
+      tableSymbol[high--] = (Byte)s;
+      symbolNext[s] = 1;
+    }
+    else
+      symbolNext[s] = (UInt16)norm[s];
+  }
+  for (s = 0; s < numSymbols; s++)
+  {
+    int i;
+    for (i = 0; i < norm[s]; i++)
+    {
+      tableSymbol[pos] = (Byte)s;
+      do
+        pos = (pos + step) & mask;
+      while (pos > high);
+    }
+  }
+}
+
+
+#define SEQ_TABLE_OF  0
+#define SEQ_TABLE_LL  1
+#define SEQ_TABLE_ML  2
+
+static void Seq_BuildEntry(CSeqEntry *e, unsigned sym, unsigned type)
+{
+  if (type == SEQ_TABLE_OF)
+  {
+    e->base = (UInt32)1 << sym;
+    e->numAddBits = (Byte)sym;
+  }
+  else if (type == SEQ_TABLE_LL)
+  {
+    e->base = k_LL_Base[sym];
+    e->numAddBits = k_LL_Bits[sym];
+  }
+  else
+  {
+    e->base = k_ML_Base[sym];
+    e->numAddBits = k_ML_Bits[sym];
+  }
+}
+
+static void Seq_BuildTable(CSeqEntry *table, const Int16 *norm,
+    unsigned numSymbols, unsigned tableLog, unsigned type)
+{
+  Byte tableSymbol[1 << kFseLogMax];
+  UInt16 symbolNext[kML_SymMax + 1];
+  const unsigned size = (unsigned)1 << tableLog;
+  unsigned i;
+  Fse_Spread(tableSymbol, symbolNext, norm, numSymbols, tableLog);
+  for (i = 0; i < size; i++)
+  {
+    CSeqEntry *e = &table[i];
+    const unsigned sym = tableSymbol[i];
+    const unsigned next = symbolNext[sym]++;
+    const unsigned numBits = tableLog - GetHighBit32(next);
+    e->numBits = (Byte)numBits;
+    e->next = (UInt16)((next << numBits) - size);
+    Seq_BuildEntry(e, sym, type);
+  }
+}
+
+/* (sum of probabilities == table size) and (Fse_Spread() finishes at pos 0) are guaranteed by
+   Fse_ReadNCount(), so we don't check it here */
+
+static void Fse_BuildTable(CFseEntry *table, const Int16 *norm,
+    unsigned numSymbols, unsigned tableLog)
+{
+  Byte tableSymbol[1 << kWeightsLogMax];
+  UInt16 symbolNext[kWeightsSymMax + 1];
+  const unsigned size = (unsigned)1 << tableLog;
+  unsigned i;
+  Fse_Spread(tableSymbol, symbolNext, norm, numSymbols, tableLog);
+  for (i = 0; i < size; i++)
+  {
+    CFseEntry *e = &table[i];
+    const unsigned sym = tableSymbol[i];
+    const unsigned next = symbolNext[sym]++;
+    const unsigned numBits = tableLog - GetHighBit32(next);
+    e->sym = (Byte)sym;
+    e->numBits = (Byte)numBits;
+    e->next = (UInt16)((next << numBits) - size);
+  }
+}
+
+
+/* ---------- decoder object ---------- */
+
+#define ZSTD2_STATE_SIGNATURE     0
+#define ZSTD2_STATE_SKIP_DATA     1
+#define ZSTD2_STATE_BLOCK_HEADER  2
+#define ZSTD2_STATE_BLOCK_DATA    3
+#define ZSTD2_STATE_CHECKSUM      4
+#define ZSTD2_STATE_WRONG         5
+
+#define ZSTD_BLOCK_RLE         1
+#define ZSTD_BLOCK_COMPRESSED  2
+
+#define kWinExtraMin  ((size_t)1 << 20)
+
+struct CZstdDec
+{
+  ISzAllocPtr alloc_Small;
+  ISzAllocPtr alloc_Big;
+
+  unsigned state;
+  unsigned tempSize;
+  unsigned blockType;
+  BoolInt lastBlock;
+  UInt32 blockSize;
+  UInt32 blockMax;
+  size_t blockFilled;
+  UInt64 skipRem;
+  UInt64 frameOut;
+  CZstdFrameHeader frame;
+
+  Byte *win;
+  size_t winSize;
+  size_t winPos;
+  size_t winAlloc_Size;
+  Byte *winAlloc;
+  BoolInt winStream;    /* window data can be shifted */
+  Byte *extBuf;
+  size_t extSize;
+
+  UInt32 reps[3];
+  BoolInt hufValid;
+  unsigned hufLog;
+  const CSeqEntry *llTab;
+  const CSeqEntry *ofTab;
+  const CSeqEntry *mlTab;
+  unsigned llLog;
+  unsigned ofLog;
+  unsigned mlLog;
+
+  CXxh64State xxh;
+  CZstdDecInfo info;
+
+  Byte temp[32];
+  UInt16 hufTable[1 << kHufLogMax];
+  CSeqEntry llTable[1 << kLL_LogMax];
+  CSeqEntry ofTable[1 << kOF_LogMax];
+  CSeqEntry mlTable[1 << kML_LogMax];
+  CSeqEntry llPredef[1 << kLL_PredefLog];
+  CSeqEntry ofPredef[1 << kOF_PredefLog];
+  CSeqEntry mlPredef[1 << kML_PredefLog];
+  Byte inBlock[kBlockSizeMax + ZSTD_DEC_BUF_SLACK];
+  Byte litBuf[kBlockSizeMax + ZSTD_DEC_BUF_SLACK];
+};
+
+
+CZstdDecHandle ZstdDec_Create(ISzAllocPtr alloc_Small, ISzAllocPtr alloc_Big)
+{
+  CZstdDec *p = (CZstdDec *)ISzAlloc_Alloc(alloc_Small, sizeof(CZstdDec));
+  if (!p)
+    return NULL;
+  p->alloc_Small = alloc_Small;
+  p->alloc_Big = alloc_Big;
+  p->winAlloc = NULL;
+  p->winAlloc_Size = 0;
+  p->extBuf = NULL;
+  p->extSize = 0;
+  Seq_BuildTable(p->llPredef, k_LL_Predef, Z7_ARRAY_SIZE(k_LL_Predef), kLL_PredefLog, SEQ_TABLE_LL);
+  Seq_BuildTable(p->ofPredef, k_OF_Predef, Z7_ARRAY_SIZE(k_OF_Predef), kOF_PredefLog, SEQ_TABLE_OF);
+  Seq_BuildTable(p->mlPredef, k_ML_Predef, Z7_ARRAY_SIZE(k_ML_Predef), kML_PredefLog, SEQ_TABLE_ML);
+  ZstdDec_Init(p);
+  return p;
+}
+
+
+static void ZstdDec_FreeWindow(CZstdDec *p)
+{
+  ISzAlloc_Free(p->alloc_Big, p->winAlloc);
+  p->winAlloc = NULL;
+  p->winAlloc_Size = 0;
+}
+
+
+void ZstdDec_Destroy(CZstdDecHandle p)
+{
+  if (!p)
+    return;
+  ZstdDec_FreeWindow(p);
+  ISzAlloc_Free(p->alloc_Small, p);
+}
+
+
+void ZstdDec_Init(CZstdDecHandle p)
+{
+  p->state = ZSTD2_STATE_SIGNATURE;
+  p->tempSize = 0;
+  p->win = NULL;
+  p->winSize = 0;
+  p->winPos = 0;
+  memset(&p->info, 0, sizeof(p->info));
+  p->info.contentSize_Defined_All = True;
+  p->info.checksum_Defined_All = True;
+}
+
+
+void ZstdDec_SetOutBuf(CZstdDecHandle p, Byte *buf, size_t bufSize)
+{
+  p->extBuf = buf;
+  p->extSize = buf ? bufSize : 0;
+}
+
+
+BoolInt ZstdDec_IsBetweenFrames(const CZstdDecHandle p)
+{
+  return (p->state == ZSTD2_STATE_SIGNATURE && p->tempSize == 0);
+}
+
+
+BoolInt ZstdDec_GetFrameContentSize(const CZstdDecHandle p, UInt64 *size)
+{
+  if (p->state != ZSTD2_STATE_BLOCK_HEADER
+      && p->state != ZSTD2_STATE_BLOCK_DATA
+      && p->state != ZSTD2_STATE_CHECKSUM)
+    return False;
+  if (p->frame.contentSize == (UInt64)(Int64)-1)
+    return False;
+  *size = p->frame.contentSize;
+  return True;
+}
+
+
+const CZstdDecInfo *ZstdDec_GetInfo(const CZstdDecHandle p)
+{
+  return &p->info;
+}
+
+
+/* ---------- frame header ---------- */
+
+unsigned ZstdDec_ReadFrameHeader(const Byte *data, size_t size, CZstdFrameHeader *h)
+{
+  unsigned fhd, headerSize, pos;
+  unsigned fcsSize, didSize;
+  {
+    size_t i;
+    for (i = 0; i < 4 && i < size; i++)
+      if (data[i] != (Byte)(ZSTD_SIGNATURE >> (i * 8)))
+        return 0;
+  }
+  if (size < 5)
+    return 5;
+  fhd = data[4];
+  if (fhd & 8) // reserved bit
+    return 0;
+  {
+    const unsigned fcsFlag = fhd >> 6;
+    h->singleSegment = (fhd >> 5) & 1;
+    h->checksumFlag = (fhd >> 2) & 1;
+    didSize = (unsigned)((0x4210 >> ((fhd & 3) * 4)) & 0xF);
+    fcsSize = (fcsFlag == 0) ? (unsigned)h->singleSegment : ((unsigned)1 << fcsFlag);
+  }
+  headerSize = 5 + (h->singleSegment ? 0u : 1u) + didSize + fcsSize;
+  if (size < headerSize)
+    return headerSize;
+  h->headerSize = headerSize;
+  pos = 5;
+  h->windowSize = 0;
+  if (!h->singleSegment)
+  {
+    const unsigned wd = data[pos++];
+    const unsigned windowLog = 10 + (wd >> 3);
+    const UInt64 windowBase = (UInt64)1 << windowLog;
+    h->windowSize = windowBase + (windowBase >> 3) * (wd & 7);
+  }
+  {
+    UInt32 dictId = 0;
+    unsigned i;
+    for (i = 0; i < didSize; i++)
+      dictId |= (UInt32)data[pos + i] << (i * 8);
+    h->dictId = dictId;
+    pos += didSize;
+  }
+  {
+    UInt64 fcs = (UInt64)(Int64)-1;
+    if (fcsSize == 1)
+      fcs = data[pos];
+    else if (fcsSize == 2)
+      fcs = (UInt64)GetUi16(data + pos) + 256;
+    else if (fcsSize == 4)
+      fcs = GetUi32(data + pos);
+    else if (fcsSize == 8)
+      fcs = GetUi64(data + pos);
+    h->contentSize = fcs;
+  }
+  if (h->singleSegment)
+    h->windowSize = h->contentSize;
+  return headerSize;
+}
+
+
+SRes ZstdDec_ParseFrame(const Byte *data, size_t size, UInt64 *frameSize, CZstdFrameHeader *h)
+{
+  size_t pos;
+  *frameSize = 0;
+  if (size < 4)
+    return SZ_ERROR_INPUT_EOF;
+  if ((GetUi32(data) & ZSTD_SIGNATURE_SKIP_MASK) == ZSTD_SIGNATURE_SKIP)
+  {
+    if (size < 8)
+      return SZ_ERROR_INPUT_EOF;
+    h->headerSize = 8;
+    h->contentSize = (UInt64)(Int64)-1;
+    h->windowSize = 0;
+    h->dictId = 0;
+    h->checksumFlag = False;
+    h->singleSegment = False;
+    *frameSize = (UInt64)8 + GetUi32(data + 4);
+    return SZ_OK;
+  }
+  pos = ZstdDec_ReadFrameHeader(data, size, h);
+  if (pos == 0)
+    return SZ_ERROR_NO_ARCHIVE;
+  if (pos > size)
+    return SZ_ERROR_INPUT_EOF;
+  for (;;)
+  {
+    UInt32 bh, blockSize;
+    unsigned type;
+    if (size - pos < 3)
+      return SZ_ERROR_INPUT_EOF;
+    bh = GetUi16(data + pos) | ((UInt32)data[pos + 2] << 16);
+    pos += 3;
+    type = (unsigned)(bh >> 1) & 3;
+    blockSize = bh >> 3;
+    if (type == 3 || blockSize > kBlockSizeMax)
+      return SZ_ERROR_DATA;
+    if (type == ZSTD_BLOCK_RLE)
+      blockSize = 1;
+    if (size - pos < blockSize)
+      return SZ_ERROR_INPUT_EOF;
+    pos += blockSize;
+    if (bh & 1)
+      break;
+  }
+  if (h->checksumFlag)
+  {
+    if (size - pos < 4)
+      return SZ_ERROR_INPUT_EOF;
+    pos += 4;
+  }
+  *frameSize = pos;
+  return SZ_OK;
+}
+
+
+/* ---------- literals ---------- */
+
+static SRes Huf_ReadTable(CZstdDec *p, const Byte *src, size_t srcSize, size_t *processed)
+{
+  Byte weights[256];
+  unsigned numWeights;
+  unsigned rankStats[kHufLogMax + 1];
+  unsigned headerByte;
+  size_t hSize;
+
+  if (srcSize == 0)
+    return SZ_ERROR_DATA;
+  headerByte = src[0];
+  if (headerByte >= 128)
+  {
+    unsigned i;
+    numWeights = headerByte - 127;
+    hSize = (numWeights + 1) >> 1;
+    if (srcSize - 1 < hSize)
+      return SZ_ERROR_DATA;
+    for (i = 0; i < numWeights; i += 2)
+    {
+      const unsigned b = src[1 + (i >> 1)];
+      weights[i] = (Byte)(b >> 4);
+      weights[i + 1] = (Byte)(b & 15);
+    }
+  }
+  else
+  {
+    Int16 norm[kWeightsSymMax + 1];
+    CFseEntry table[1 << kWeightsLogMax];
+    unsigned numSymbols, tableLog;
+    size_t ncSize;
+    CBitsBack b;
+    unsigned st1, st2;
+
+    hSize = headerByte;
+    if (hSize == 0 || srcSize - 1 < hSize)
+      return SZ_ERROR_DATA;
+    ncSize = Fse_ReadNCount(norm, &numSymbols, &tableLog, kWeightsSymMax, kWeightsLogMax, src + 1, hSize);
+    if (ncSize == 0)
+      return SZ_ERROR_DATA;
+    Fse_BuildTable(table, norm, numSymbols, tableLog);
+    RINOK(BitsBack_Init(&b, src + 1 + ncSize, hSize - ncSize))
+    st1 = BitsBack_Read(&b, tableLog);
+    st2 = BitsBack_Read(&b, tableLog);
+    numWeights = 0;
+    for (;;)
+    {
+      const CFseEntry *e;
+      if (numWeights > 255 - 2)
+        return SZ_ERROR_DATA;
+      e = &table[st1];
+      weights[numWeights++] = e->sym;
+      st1 = e->next + BitsBack_Read(&b, e->numBits);
+      if (b.pos < 0)
+      {
+        weights[numWeights++] = table[st2].sym;
+        break;
+      }
+      e = &table[st2];
+      weights[numWeights++] = e->sym;
+      st2 = e->next + BitsBack_Read(&b, e->numBits);
+      if (b.pos < 0)
+      {
+        weights[numWeights++] = table[st1].sym;
+        break;
+      }
+    }
+  }
+
+  *processed = 1 + hSize;
+
+  {
+    UInt32 weightTotal = 0;
+    unsigned i, tableLog;
+    memset(rankStats, 0, sizeof(rankStats));
+    for (i = 0; i < numWeights; i++)
+    {
+      const unsigned w = weights[i];
+      if (w > kHufLogMax)
+        return SZ_ERROR_DATA;
+      rankStats[w]++;
+      if (w != 0)
+        weightTotal += (UInt32)1 << (w - 1);
+    }
+    if (weightTotal == 0)
+      return SZ_ERROR_DATA;
+    tableLog = GetHighBit32(weightTotal) + 1;
+    if (tableLog > kHufLogMax)
+      return SZ_ERROR_DATA;
+    {
+      const UInt32 rest = ((UInt32)1 << tableLog) - weightTotal;
+      const unsigned lastWeight = GetHighBit32(rest) + 1;
+      if (rest != ((UInt32)1 << (lastWeight - 1)))
+        return SZ_ERROR_DATA;
+      weights[numWeights++] = (Byte)lastWeight;
+      rankStats[lastWeight]++;
+    }
+    if (rankStats[1] < 2 || (rankStats[1] & 1))
+      return SZ_ERROR_DATA;
+
+    {
+      UInt32 rankStart[kHufLogMax + 1];
+      UInt32 next = 0;
+      unsigned w;
+      for (w = 1; w <= tableLog; w++)
+      {
+        rankStart[w] = next;
+        next += (UInt32)rankStats[w] << (w - 1);
+      }
+      for (i = 0; i < numWeights; i++)
+      {
+        w = weights[i];
+        if (w != 0)
+        {
+          const UInt32 len = (UInt32)1 << (w - 1);
+          const UInt16 v = (UInt16)(((tableLog + 1 - w) << 8) | i);
+          UInt16 *t = p->hufTable + rankStart[w];
+          UInt32 k;
+          for (k = 0; k < len; k++)
+            t[k] = v;
+          rankStart[w] += len;
+        }
+      }
+    }
+    p->hufLog = tableLog;
+  }
+  return SZ_OK;
+}
+
+
+static SRes Huf_DecodeStream(const UInt16 *table, unsigned tableLog,
+    const Byte *src, size_t srcSize, Byte *dest, size_t destSize)
+{
+  CBitsBack b;
+  Byte *lim = dest + destSize;
+  RINOK(BitsBack_Init(&b, src, srcSize))
+  for (; dest != lim; dest++)
+  {
+    const unsigned e = table[BitsBack_Peek(&b, tableLog)];
+    *dest = (Byte)e;
+    b.pos -= (ptrdiff_t)(e >> 8);
+  }
+  return (b.pos == 0) ? SZ_OK : SZ_ERROR_DATA;
+}
+
+
+static SRes ZstdDec_DecodeLiterals(CZstdDec *p, const Byte *src, size_t srcSize,
+    const Byte **lits, size_t *litSize, size_t *processed)
+{
+  const unsigned b0 = src[0];
+  const unsigned type = b0 & 3;
+  const unsigned sizeFormat = (b0 >> 2) & 3;
+  size_t regen;
+
+  if (type < 2)
+  {
+    unsigned lhSize;
+    if ((sizeFormat & 1) == 0)
+    {
+      lhSize = 1;
+      regen = b0 >> 3;
+    }
+    else
+    {
+      lhSize = sizeFormat == 1 ? 2 : 3;
+      if (srcSize < lhSize)
+        return SZ_ERROR_DATA;
+      regen = (b0 >> 4) + ((size_t)src[1] << 4);
+      if (lhSize == 3)
+        regen += (size_t)src[2] << 12;
+    }
+    if (regen > p->blockMax)
+      return SZ_ERROR_DATA;
+    if (type == 0)
+    {
+      if (srcSize - lhSize < regen)
+        return SZ_ERROR_DATA;
+      *lits = src + lhSize;
+      *processed = lhSize + regen;
+    }
+    else
+    {
+      if (srcSize - lhSize < 1)
+        return SZ_ERROR_DATA;
+      memset(p->litBuf, src[lhSize], regen);
+      *lits = p->litBuf;
+      *processed = lhSize + 1;
+    }
+    *litSize = regen;
+    return SZ_OK;
+  }
+  {
+    unsigned lhSize;
+    size_t cSize;
+    BoolInt singleStream = False;
+    if (srcSize < 5)
+      return SZ_ERROR_DATA;
+    {
+      const UInt32 lhc = GetUi32(src);
+      if (sizeFormat < 2)
+      {
+        singleStream = (sizeFormat == 0);
+        lhSize = 3;
+        regen = (lhc >> 4) & 0x3FF;
+        cSize = (lhc >> 14) & 0x3FF;
+      }
+      else if (sizeFormat == 2)
+      {
+        lhSize = 4;
+        regen = (lhc >> 4) & 0x3FFF;
+        cSize = lhc >> 18;
+      }
+      else
+      {
+        lhSize = 5;
+        regen = (lhc >> 4) & 0x3FFFF;
+        cSize = (lhc >> 22) + ((size_t)src[4] << 10);
+      }
+    }
+    if (regen > p->blockMax || cSize > srcSize - lhSize)
+      return SZ_ERROR_DATA;
+    *processed = lhSize + cSize;
+    src += lhSize;
+    if (type == 2)
+    {
+      size_t treeSize;
+      p->hufValid = False;
+      RINOK(Huf_ReadTable(p, src, cSize, &treeSize))
+      p->hufValid = True;
+      src += treeSize;
+      cSize -= treeSize;
+    }
+    else if (!p->hufValid)
+      return SZ_ERROR_DATA;
+
+    *lits = p->litBuf;
+    *litSize = regen;
+    if (singleStream)
+      return Huf_DecodeStream(p->hufTable, p->hufLog, src, cSize, p->litBuf, regen);
+    {
+      const size_t segSize = (regen + 3) / 4;
+      size_t sizes[4];
+      unsigned i;
+      Byte *dest = p->litBuf;
+      if (cSize < 6 + 3 || segSize * 3 > regen)
+        return SZ_ERROR_DATA;
+      sizes[0] = GetUi16(src);
+      sizes[1] = GetUi16(src + 2);
+      sizes[2] = GetUi16(src + 4);
+      src += 6;
+      cSize -= 6;
+      {
+        const size_t sum = sizes[0] + sizes[1] + sizes[2];
+        if (sum >= cSize)
+          return SZ_ERROR_DATA;
+        sizes[3] = cSize - sum;
+      }
+      for (i = 0; i < 4; i++)
+      {
+        const size_t destSize = (i == 3) ? regen - segSize * 3 : segSize;
+        RINOK(Huf_DecodeStream(p->hufTable, p->hufLog, src, sizes[i], dest, destSize))
+        src += sizes[i];
+        dest += destSize;
+      }
+    }
+  }
+  return SZ_OK;
+}
+
+
+/* ---------- sequences ---------- */
+
+static SRes ZstdDec_ReadSeqTable(CZstdDec *p, unsigned mode, unsigned type,
+    const Byte *src, size_t srcSize, size_t *processed)
+{
+  const CSeqEntry **tab;
+  unsigned *log;
+  CSeqEntry *table;
+  unsigned maxSym, maxLog;
+
+  if (type == SEQ_TABLE_LL)
+  {
+    tab = &p->llTab;  log = &p->llLog;  table = p->llTable;
+    maxSym = kLL_SymMax;  maxLog = kLL_LogMax;
+  }
+  else if (type == SEQ_TABLE_OF)
+  {
+    tab = &p->ofTab;  log = &p->ofLog;  table = p->ofTable;
+    maxSym = kOF_SymMax;  maxLog = kOF_LogMax;
+  }
+  else
+  {
+    tab = &p->mlTab;  log = &p->mlLog;  table = p->mlTable;
+    maxSym = kML_SymMax;  maxLog = kML_LogMax;
+  }
+  *processed = 0;
+
+  if (mode == 0) // predefined
+  {
+    if (type == SEQ_TABLE_LL)
+    {
+      *tab = p->llPredef;
+      *log = kLL_PredefLog;
+    }
+    else if (type == SEQ_TABLE_OF)
+    {
+      *tab = p->ofPredef;
+      *log = kOF_PredefLog;
+    }
+    else
+    {
+      *tab = p->mlPredef;
+      *log = kML_PredefLog;
+    }
+    return SZ_OK;
+  }
+  if (mode == 1) // RLE
+  {
+    unsigned sym;
+    if (srcSize < 1)
+      return SZ_ERROR_DATA;
+    sym = src[0];
+    if (sym > maxSym)
+      return SZ_ERROR_DATA;
+    Seq_BuildEntry(table, sym, type);
+    table->numBits = 0;
+    table->next = 0;
+    *tab = table;
+    *log = 0;
+    *processed = 1;
+    return SZ_OK;
+  }
+  if (mode == 2) // FSE compressed
+  {
+    Int16 norm[kML_SymMax + 1];
+    unsigned numSymbols, tableLog;
+    const size_t size = Fse_ReadNCount(norm, &numSymbols, &tableLog, maxSym, maxLog, src, srcSize);
+    *tab = NULL;
+    if (size == 0)
+      return SZ_ERROR_DATA;
+    Seq_BuildTable(table, norm, numSymbols, tableLog, type);
+    *tab = table;
+    *log = tableLog;
+    *processed = size;
+    return SZ_OK;
+  }
+  // repeat mode
+  return *tab ? SZ_OK : SZ_ERROR_DATA;
+}
+
+
+static SRes ZstdDec_DecodeBlock(CZstdDec *p, const Byte *src, size_t srcSize, size_t *outSize)
+{
+  const Byte *lits;
+  size_t litSize;
+  UInt32 numSeqs;
+  Byte *dest = p->win + p->winPos;
+  Byte *destLim;
+  *outSize = 0;
+  {
+    size_t rem = p->winSize - p->winPos;
+    if (rem > p->blockMax)
+      rem = p->blockMax;
+    destLim = dest + rem;
+  }
+  if (srcSize == 0)
+    return SZ_ERROR_DATA;
+  {
+    size_t processed;
+    RINOK(ZstdDec_DecodeLiterals(p, src, srcSize, &lits, &litSize, &processed))
+    src += processed;
+    srcSize -= processed;
+  }
+  if (srcSize == 0)
+    return SZ_ERROR_DATA;
+  {
+    const unsigned b0 = src[0];
+    if (b0 < 128)
+    {
+      numSeqs = b0;
+      src++;
+      srcSize--;
+    }
+    else if (b0 < 255)
+    {
+      if (srcSize < 2)
+        return SZ_ERROR_DATA;
+      numSeqs = ((UInt32)(b0 - 128) << 8) + src[1];
+      src += 2;
+      srcSize -= 2;
+    }
+    else
+    {
+      if (srcSize < 3)
+        return SZ_ERROR_DATA;
+      numSeqs = (UInt32)GetUi16(src + 1) + 0x7F00;
+      src += 3;
+      srcSize -= 3;
+    }
+  }
+
+  if (numSeqs == 0)
+  {
+    if (srcSize != 0 || litSize > (size_t)(destLim - dest))
+      return SZ_ERROR_DATA;
+    memcpy(dest, lits, litSize);
+    *outSize = litSize;
+    return SZ_OK;
+  }
+
+  {
+    unsigned modes;
+    if (srcSize < 1)
+      return SZ_ERROR_DATA;
+    modes = src[0];
+    src++;
+    srcSize--;
+    if (modes & 3)
+      return SZ_ERROR_DATA;
+    {
+      size_t processed;
+      RINOK(ZstdDec_ReadSeqTable(p, modes >> 6, SEQ_TABLE_LL, src, srcSize, &processed))
+      src += processed;
+      srcSize -= processed;
+      RINOK(ZstdDec_ReadSeqTable(p, (modes >> 4) & 3, SEQ_TABLE_OF, src, srcSize, &processed))
+      src += processed;
+      srcSize -= processed;
+      RINOK(ZstdDec_ReadSeqTable(p, (modes >> 2) & 3, SEQ_TABLE_ML, src, srcSize, &processed))
+      src += processed;
+      srcSize -= processed;
+    }
+  }
+
+  {
+    CBitsBack b;
+    const CSeqEntry *llTab = p->llTab;
+    const CSeqEntry *ofTab = p->ofTab;
+    const CSeqEntry *mlTab = p->mlTab;
+    const Byte *litLim = lits + litSize;
+    const Byte *winStart = p->win;
+    Byte *destStart = dest;
+    UInt32 rep0 = p->reps[0];
+    UInt32 rep1 = p->reps[1];
+    UInt32 rep2 = p->reps[2];
+    unsigned stLL, stOF, stML;
+
+    RINOK(BitsBack_Init(&b, src, srcSize))
+    stLL = BitsBack_Read(&b, p->llLog);
+    stOF = BitsBack_Read(&b, p->ofLog);
+    stML = BitsBack_Read(&b, p->mlLog);
+
+    for (;;)
+    {
+      const CSeqEntry *eLL = llTab + stLL;
+      const CSeqEntry *eOF = ofTab + stOF;
+      const CSeqEntry *eML = mlTab + stML;
+      UInt32 offset, ml, ll;
+
+      offset = eOF->base + BitsBack_Read(&b, eOF->numAddBits);
+      ml = eML->base + BitsBack_Read(&b, eML->numAddBits);
+      ll = eLL->base + BitsBack_Read(&b, eLL->numAddBits);
+
+      if (offset > 3)
+      {
+        rep2 = rep1;
+        rep1 = rep0;
+        rep0 = offset - 3;
+      }
+      else
+      {
+        if (ll == 0)
+          offset++;
+        if (offset != 1)
+        {
+          UInt32 v;
+          if (offset == 2)
+            v = rep1;
+          else
+          {
+            v = (offset == 3) ? rep2 : rep0 - 1;
+            if (v == 0)
+              return SZ_ERROR_DATA;
+            rep2 = rep1;
+          }
+          rep1 = rep0;
+          rep0 = v;
+        }
+      }
+
+      if (ll > (size_t)(litLim - lits)
+          || (size_t)ll + ml > (size_t)(destLim - dest))
+        return SZ_ERROR_DATA;
+      memcpy(dest, lits, ll);
+      dest += ll;
+      lits += ll;
+      if (rep0 > (size_t)(dest - winStart))
+        return SZ_ERROR_DATA;
+      {
+        const Byte *s = dest - rep0;
+        Byte *lim = dest + ml;
+        if (rep0 >= 8)
+        {
+          do
+          {
+            SetUi64(dest, GetUi64(s))
+            dest += 8;
+            s += 8;
+          }
+          while (dest < lim);
+        }
+        else
+        {
+          do
+            *dest++ = *s++;
+          while (dest != lim);
+        }
+        dest = lim;
+      }
+
+      if (--numSeqs == 0)
+        break;
+      stLL = eLL->next + BitsBack_Read(&b, eLL->numBits);
+      stML = eML->next + BitsBack_Read(&b, eML->numBits);
+      stOF = eOF->next + BitsBack_Read(&b, eOF->numBits);
+    }
+
+    if (b.pos != 0)
+      return SZ_ERROR_DATA;
+    p->reps[0] = rep0;
+    p->reps[1] = rep1;
+    p->reps[2] = rep2;
+    {
+      const size_t rem = (size_t)(litLim - lits);
+      if (rem > (size_t)(destLim - dest))
+        return SZ_ERROR_DATA;
+      memcpy(dest, lits, rem);
+      dest += rem;
+    }
+    *outSize = (size_t)(dest - destStart);
+  }
+  return SZ_OK;
+}
+
+
+/* ---------- stream decoding ---------- */
+
+static SRes ZstdDec_StartFrame(CZstdDec *p)
+{
+  const CZstdFrameHeader *h = &p->frame;
+  UInt64 need;
+
+  if (h->dictId != 0 || h->windowSize > kWindowSizeMax)
+    return SZ_ERROR_UNSUPPORTED;
+
+  p->blockMax = (h->windowSize < kBlockSizeMax) ? (UInt32)h->windowSize : kBlockSizeMax;
+  p->reps[0] = 1;
+  p->reps[1] = 4;
+  p->reps[2] = 8;
+  p->hufValid = False;
+  p->llTab = NULL;
+  p->ofTab = NULL;
+  p->mlTab = NULL;
+  p->frameOut = 0;
+  p->winPos = 0;
+  Xxh64State_Init(&p->xxh);
+
+  if (p->info.windowSize_Max < h->windowSize)
+    p->info.windowSize_Max = h->windowSize;
+  if (h->contentSize == (UInt64)(Int64)-1)
+    p->info.contentSize_Defined_All = False;
+  else
+    p->info.contentSize_Total += h->contentSize;
+  if (!h->checksumFlag)
+    p->info.checksum_Defined_All = False;
+
+  if (p->extBuf)
+  {
+    p->win = p->extBuf;
+    p->winSize = p->extSize;
+    p->winStream = False;
+    return SZ_OK;
+  }
+
+  {
+    size_t extra = (size_t)h->windowSize;
+    if (extra < kWinExtraMin)
+      extra = kWinExtraMin;
+    need = h->windowSize + extra + kBlockSizeMax;
+  }
+  p->winStream = True;
+  if (h->contentSize != (UInt64)(Int64)-1 && h->contentSize <= need)
+  {
+    need = h->contentSize;
+    p->winStream = False;
+  }
+  if (need > (size_t)0 - 1 - ZSTD_DEC_BUF_SLACK)
+    return SZ_ERROR_MEM;
+  if (!p->winAlloc || p->winAlloc_Size < need)
+  {
+    ZstdDec_FreeWindow(p);
+    p->winAlloc = (Byte *)ISzAlloc_Alloc(p->alloc_Big, (size_t)need + ZSTD_DEC_BUF_SLACK);
+    if (!p->winAlloc)
+      return SZ_ERROR_MEM;
+    p->winAlloc_Size = (size_t)need;
+  }
+  p->win = p->winAlloc;
+  p->winSize = p->winAlloc_Size;
+  return SZ_OK;
+}
+
+
+static void ZstdDec_PrepareWindow(CZstdDec *p)
+{
+  if (p->winStream && p->winSize - p->winPos < kBlockSizeMax)
+  {
+    size_t keep = (size_t)p->frame.windowSize;
+    if (keep > p->winPos)
+      keep = p->winPos;
+    memmove(p->win, p->win + p->winPos - keep, keep);
+    p->winPos = keep;
+  }
+}
+
+
+#define ZSTD_DEC_RETURN(st) \
+  { s->status = st; \
+    p->info.inProcessed += s->inPos - inPosStart; \
+    return SZ_OK; }
+
+#define ZSTD_DEC_RETURN_ERROR(res) \
+  { p->info.inProcessed += s->inPos - inPosStart; \
+    return res; }
+
+SRes ZstdDec_Decode(CZstdDecHandle p, CZstdDecState *s)
+{
+  const size_t inPosStart = s->inPos;
+  s->outBuf = NULL;
+  s->outSize = 0;
+
+  for (;;)
+  {
+    const size_t avail = s->inLim - s->inPos;
+
+    if (p->state == ZSTD2_STATE_WRONG)
+      ZSTD_DEC_RETURN(ZSTD_STATUS_WRONG_SIGNATURE)
+
+    if (p->state == ZSTD2_STATE_SIGNATURE)
+    {
+      unsigned need;
+      if (p->tempSize < 4)
+        need = 4;
+      else if ((GetUi32(p->temp) & ZSTD_SIGNATURE_SKIP_MASK) == ZSTD_SIGNATURE_SKIP)
+        need = 8;
+      else
+      {
+        need = ZstdDec_ReadFrameHeader(p->temp, p->tempSize, &p->frame);
+        if (need == 0)
+        {
+          p->state = ZSTD2_STATE_WRONG;
+          continue;
+        }
+      }
+      if (p->tempSize < need)
+      {
+        size_t cur = need - p->tempSize;
+        if (avail == 0)
+          ZSTD_DEC_RETURN(ZSTD_STATUS_NEEDS_MORE_INPUT)
+        if (cur > avail)
+          cur = avail;
+        memcpy(p->temp + p->tempSize, s->inBuf + s->inPos, cur);
+        p->tempSize += (unsigned)cur;
+        s->inPos += cur;
+        continue;
+      }
+      p->tempSize = 0;
+      if (need == 8)
+      {
+        p->skipRem = GetUi32(p->temp + 4);
+        p->state = ZSTD2_STATE_SKIP_DATA;
+        continue;
+      }
+      {
+        const SRes res = ZstdDec_StartFrame(p);
+        if (res != SZ_OK)
+          ZSTD_DEC_RETURN_ERROR(res)
+      }
+      p->state = ZSTD2_STATE_BLOCK_HEADER;
+      continue;
+    }
+
+    if (p->state == ZSTD2_STATE_SKIP_DATA)
+    {
+      size_t cur = avail;
+      if (cur > p->skipRem)
+        cur = (size_t)p->skipRem;
+      s->inPos += cur;
+      p->skipRem -= cur;
+      if (p->skipRem != 0)
+        ZSTD_DEC_RETURN(ZSTD_STATUS_NEEDS_MORE_INPUT)
+      p->info.num_SkipFrames++;
+      p->info.inProcessed_Frames = p->info.inProcessed + (s->inPos - inPosStart);
+      p->state = ZSTD2_STATE_SIGNATURE;
+      ZSTD_DEC_RETURN(ZSTD_STATUS_FRAME_FINISHED)
+    }
+
+    if (p->state == ZSTD2_STATE_BLOCK_HEADER)
+    {
+      UInt32 bh;
+      if (p->tempSize < 3)
+      {
+        size_t cur = 3 - p->tempSize;
+        if (avail == 0)
+          ZSTD_DEC_RETURN(ZSTD_STATUS_NEEDS_MORE_INPUT)
+        if (cur > avail)
+          cur = avail;
+        memcpy(p->temp + p->tempSize, s->inBuf + s->inPos, cur);
+        p->tempSize += (unsigned)cur;
+        s->inPos += cur;
+        continue;
+      }
+      p->tempSize = 0;
+      bh = GetUi16(p->temp) | ((UInt32)p->temp[2] << 16);
+      p->lastBlock = (BoolInt)(bh & 1);
+      p->blockType = (unsigned)(bh >> 1) & 3;
+      p->blockSize = bh >> 3;
+      if (p->blockType == 3 || p->blockSize > p->blockMax)
+        ZSTD_DEC_RETURN_ERROR(SZ_ERROR_DATA)
+      p->blockFilled = 0;
+      p->state = ZSTD2_STATE_BLOCK_DATA;
+      continue;
+    }
+
+    if (p->state == ZSTD2_STATE_BLOCK_DATA)
+    {
+      const size_t need = (p->blockType == ZSTD_BLOCK_RLE) ? 1 : p->blockSize;
+      const Byte *src;
+      size_t outSize;
+      Byte *dest;
+
+      if (p->blockFilled == 0 && avail >= need + 8)
+      {
+        src = s->inBuf + s->inPos;
+        s->inPos += need;
+      }
+      else
+      {
+        size_t cur = need - p->blockFilled;
+        if (cur > avail)
+          cur = avail;
+        memcpy(p->inBlock + p->blockFilled, s->inBuf + s->inPos, cur);
+        p->blockFilled += cur;
+        s->inPos += cur;
+        if (p->blockFilled != need)
+          ZSTD_DEC_RETURN(ZSTD_STATUS_NEEDS_MORE_INPUT)
+        src = p->inBlock;
+      }
+
+      ZstdDec_PrepareWindow(p);
+      dest = p->win + p->winPos;
+
+      if (p->blockType == ZSTD_BLOCK_COMPRESSED)
+      {
+        const SRes res = ZstdDec_DecodeBlock(p, src, need, &outSize);
+        if (res != SZ_OK)
+          ZSTD_DEC_RETURN_ERROR(res)
+      }
+      else
+      {
+        outSize = p->blockSize;
+        if (outSize > p->winSize - p->winPos)
+          ZSTD_DEC_RETURN_ERROR(SZ_ERROR_DATA)
+        if (p->blockType == ZSTD_BLOCK_RLE)
+          memset(dest, src[0], outSize);
+        else
+          memcpy(dest, src, outSize);
+      }
+
+      p->winPos += outSize;
+      p->frameOut += outSize;
+      p->info.num_Blocks++;
+      p->info.outProcessed += outSize;
+      if (p->frame.checksumFlag && !s->disableHash)
+        Xxh64State_Update(&p->xxh, dest, outSize);
+
+      p->state = ZSTD2_STATE_BLOCK_HEADER;
+      if (p->lastBlock)
+      {
+        if (p->frame.contentSize != (UInt64)(Int64)-1
+            && p->frame.contentSize != p->frameOut)
+          ZSTD_DEC_RETURN_ERROR(SZ_ERROR_DATA)
+        p->state = ZSTD2_STATE_CHECKSUM;
+      }
+      if (outSize != 0)
+      {
+        s->outBuf = dest;
+        s->outSize = outSize;
+        ZSTD_DEC_RETURN(ZSTD_STATUS_OUT_BLOCK)
+      }
+      continue;
+    }
+
+    // (p->state == ZSTD2_STATE_CHECKSUM)
+    {
+      if (p->frame.checksumFlag)
+      {
+        if (p->tempSize < 4)
+        {
+          size_t cur = 4 - p->tempSize;
+          if (avail == 0)
+            ZSTD_DEC_RETURN(ZSTD_STATUS_NEEDS_MORE_INPUT)
+          if (cur > avail)
+            cur = avail;
+          memcpy(p->temp + p->tempSize, s->inBuf + s->inPos, cur);
+          p->tempSize += (unsigned)cur;
+          s->inPos += cur;
+          continue;
+        }
+        p->tempSize = 0;
+        if (!s->disableHash)
+          if (GetUi32(p->temp) != (UInt32)Xxh64State_Digest(&p->xxh))
+            ZSTD_DEC_RETURN_ERROR(SZ_ERROR_CRC)
+      }
+      p->info.num_DataFrames++;
+      p->info.inProcessed_Frames = p->info.inProcessed + (s->inPos - inPosStart);
+      p->state = ZSTD2_STATE_SIGNATURE;
+      ZSTD_DEC_RETURN(ZSTD_STATUS_FRAME_FINISHED)
+    }
+  }
+}
@@ -0,0 +1,133 @@
+/* ZstdDec.h -- Zstandard decoder
+2026-10-18 : yhnmj6666/7z contributors : Public domain */
+
+#ifndef ZIP7_INC_ZSTD_DEC_H
+#define ZIP7_INC_ZSTD_DEC_H
+
+#include "7zTypes.h"
+
+EXTERN_C_BEGIN
+
+#define ZSTD_SIGNATURE       0xFD2FB528
+#define ZSTD_SIGNATURE_SKIP  0x184D2A50
+#define ZSTD_SIGNATURE_SKIP_MASK  0xFFFFFFF0
+
+#define ZSTD_BLOCK_SIZE_MAX  ((UInt32)1 << 17)
+
+/* the decoder can read or write up to (ZSTD_DEC_BUF_SLACK) bytes after the end of
+   data in output buffer. So any output buffer must be allocated with such slack. */
+#define ZSTD_DEC_BUF_SLACK   32
+
+typedef struct CZstdDec CZstdDec;
+typedef CZstdDec * CZstdDecHandle;
+
+CZstdDecHandle ZstdDec_Create(ISzAllocPtr alloc_Small, ISzAllocPtr alloc_Big);
+void ZstdDec_Destroy(CZstdDecHandle p);
+
+typedef enum
+{
+  ZSTD_STATUS_NEEDS_MORE_INPUT,    /* input buffer was processed, and decoder needs more input */
+  ZSTD_STATUS_OUT_BLOCK,           /* a block was decoded: (outSize) bytes are available at (outBuf) */
+  ZSTD_STATUS_FRAME_FINISHED,      /* data frame or skippable frame was finished */
+  ZSTD_STATUS_WRONG_SIGNATURE      /* the data at frame start position is not zstd frame */
+} EZstdDecStatus;
+
+typedef struct
+{
+  /* in */
+  const Byte *inBuf;
+  size_t inLim;
+  BoolInt disableHash;   /* don't check content checksum */
+
+  /* in/out */
+  size_t inPos;
+
+  /* out */
+  EZstdDecStatus status;
+  const Byte *outBuf;    /* for ZSTD_STATUS_OUT_BLOCK */
+  size_t outSize;        /* for ZSTD_STATUS_OUT_BLOCK */
+} CZstdDecState;
+
+typedef struct
+{
+  UInt64 num_DataFrames;
+  UInt64 num_SkipFrames;
+  UInt64 num_Blocks;
+  UInt64 inProcessed;         /* total number of processed input bytes */
+  UInt64 inProcessed_Frames;  /* number of input bytes in finished frames */
+  UInt64 outProcessed;
+  UInt64 windowSize_Max;      /* maximum window size in decoded frames */
+  BoolInt contentSize_Defined_All;   /* all data frames have content size field */
+  UInt64 contentSize_Total;
+  BoolInt checksum_Defined_All;      /* all data frames have checksum field */
+} CZstdDecInfo;
+
+/* ZstdDec_Init() prepares the decoder for new stream that can contain several frames */
+void ZstdDec_Init(CZstdDecHandle p);
+
+/*
+ZstdDec_Decode() processes input data (inBuf + inPos ... inBuf + inLim).
+It returns after each decoded block, so the caller must consume output data
+(outBuf, outSize) before next call.
+
+returns:
+  SZ_OK             - no error. See (status).
+  SZ_ERROR_DATA     - data error
+  SZ_ERROR_CRC      - content checksum error
+  SZ_ERROR_UNSUPPORTED - unsupported feature (dictionary, too big window)
+  SZ_ERROR_MEM      - memory allocation error
+*/
+SRes ZstdDec_Decode(CZstdDecHandle p, CZstdDecState *s);
+
+/* (True), if the decoder is at the start of new frame and there are no pending input bytes */
+BoolInt ZstdDec_IsBetweenFrames(const CZstdDecHandle p);
+
+/* (True), if the decoder is inside the data frame that has frame content size field */
+BoolInt ZstdDec_GetFrameContentSize(const CZstdDecHandle p, UInt64 *size);
+
+const CZstdDecInfo *ZstdDec_GetInfo(const CZstdDecHandle p);
+
+/*
+ZstdDec_SetOutBuf() sets external output buffer for next frame:
+  the decoder writes all data of frame to that buffer, and it doesn't use internal window.
+  (bufSize) doesn't include ZSTD_DEC_BUF_SLACK.
+  (buf == NULL) : return to internal window mode.
+*/
+void ZstdDec_SetOutBuf(CZstdDecHandle p, Byte *buf, size_t bufSize);
+
+
+/* ---------- frame parsing ---------- */
+
+typedef struct
+{
+  UInt64 contentSize;    /* (UInt64)(Int64)-1, if not defined */
+  UInt64 windowSize;
+  UInt32 dictId;
+  unsigned headerSize;   /* including signature */
+  BoolInt checksumFlag;
+  BoolInt singleSegment;
+} CZstdFrameHeader;
+
+/*
+ZstdDec_ReadFrameHeader() parses the header of zstd data frame.
+returns:
+  (0)          : it's not zstd data frame
+  (headerSize) : if ((size >= headerSize)), header was parsed to (h)
+                 if ((size < headerSize)), more data is required
+*/
+unsigned ZstdDec_ReadFrameHeader(const Byte *data, size_t size, CZstdFrameHeader *h);
+
+/*
+ZstdDec_ParseFrame() finds the end of zstd frame (data frame or skippable frame)
+  without decoding.
+returns:
+  SZ_OK             - frame was found. (*frameSize) contains the size of frame.
+  SZ_ERROR_INPUT_EOF - more data is required to find the end of frame.
+  SZ_ERROR_DATA     - data error.
+  SZ_ERROR_NO_ARCHIVE - it's not zstd frame.
+*/
+SRes ZstdDec_ParseFrame(const Byte *data, size_t size, UInt64 *frameSize, CZstdFrameHeader *h);
+
+EXTERN_C_END
+
+#endif
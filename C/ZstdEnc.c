@@ -0,0 +1,2049 @@
+/* ZstdEnc.c -- Zstandard encoder
+2026-10-18 : yhnmj6666/7z contributors : Public domain
+This code is written from the Zstandard format specification (RFC 8878). */
+
+#include "Precomp.h"
+
+#include <string.h>
+
+#include "CpuArch.h"
+#include "HuffEnc.h"
+#include "Xxh64.h"
+#include "ZstdDec.h"
+#include "ZstdEnc.h"
+
+#ifndef Z7_ST
+#include "MtCoder.h"
+#else
+#define MTCODER_THREADS_MAX 1
+#endif
+
+#define kBlockSizeMax  ZSTD_BLOCK_SIZE_MAX
+#define kSeqsMax       (kBlockSizeMax / 3 + 4)
+#define kBlockBufSize  (kBlockSizeMax * 4 + (1 << 10))
+#define kInBufPad      16
+
+#define kSearchStrength  8
+
+#define kLL_SymMax   35
+#define kOF_SymMax   31
+#define kML_SymMax   52
+#define kLL_LogMax    9
+#define kOF_LogMax    8
+#define kML_LogMax    9
+#define kFseLogMax    9
+#define kFseSymMax   63
+
+#define kLL_PredefLog 6
+#define kML_PredefLog 6
+#define kOF_PredefLog 5
+#define kOF_PredefSymMax 28
+
+#define kHufLogMax  11
+#define kHufWeightsLogMax 6
+
+#define STRAT_FAST    0
+#define STRAT_GREEDY  1
+#define STRAT_LAZY    2
+#define STRAT_LAZY2   3
+
+typedef struct
+{
+  Byte windowLog;
+  Byte hashLog;
+  Byte chainLog;
+  Byte searchLog;
+  Byte minMatch;
+  Byte strategy;
+} CZstdLevelParams;
+
+static const CZstdLevelParams k_Levels[ZSTD_ENC_LEVEL_MAX] =
+{
+  { 19, 16,  0,  0, 6, STRAT_FAST },
+  { 20, 17,  0,  0, 5, STRAT_FAST },
+  { 21, 17, 16,  1, 5, STRAT_GREEDY },
+  { 21, 18, 17,  2, 5, STRAT_GREEDY },
+  { 21, 18, 18,  3, 5, STRAT_GREEDY },
+  { 21, 19, 18,  3, 5, STRAT_LAZY },
+  { 21, 20, 19,  4, 5, STRAT_LAZY },
+  { 21, 20, 19,  4, 5, STRAT_LAZY2 },
+  { 22, 21, 20,  4, 5, STRAT_LAZY2 },
+  { 22, 22, 21,  5, 5, STRAT_LAZY2 },
+  { 22, 22, 21,  6, 5, STRAT_LAZY2 },
+  { 22, 23, 22,  6, 5, STRAT_LAZY2 },
+  { 22, 22, 22,  7, 5, STRAT_LAZY2 },
+  { 22, 23, 23,  7, 5, STRAT_LAZY2 },
+  { 22, 23, 23,  8, 5, STRAT_LAZY2 },
+  { 22, 22, 22,  8, 4, STRAT_LAZY2 },
+  { 23, 22, 23,  8, 4, STRAT_LAZY2 },
+  { 23, 22, 23,  9, 4, STRAT_LAZY2 },
+  { 23, 22, 24,  9, 4, STRAT_LAZY2 },
+  { 25, 23, 25,  9, 4, STRAT_LAZY2 },
+  { 26, 24, 26, 10, 4, STRAT_LAZY2 },
+  { 27, 25, 27, 10, 4, STRAT_LAZY2 }
+};
+
+static const UInt32 k_LL_Base[kLL_SymMax + 1] =
+{
+    0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+   16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096,
+   8192, 16384, 32768, 65536
+};
+
+static const Byte k_LL_Bits[kLL_SymMax + 1] =
+{
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9,10,11,12,
+  13,14,15,16
+};
+
+static const UInt32 k_ML_Base[kML_SymMax + 1] =
+{
+    3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+   19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+   35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+   4099, 8195, 16387, 32771, 65539
+};
+
+static const Byte k_ML_Bits[kML_SymMax + 1] =
+{
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9,10,11,
+  12,13,14,15,16
+};
+
+static const Int16 k_LL_Predef[kLL_SymMax + 1] =
+{
+  4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+  2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+ -1,-1,-1,-1
+};
+
+static const Int16 k_ML_Predef[kML_SymMax + 1] =
+{
+  1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,-1,-1,
+ -1,-1,-1,-1,-1
+};
+
+static const Int16 k_OF_Predef[kOF_PredefSymMax + 1] =
+{
+  1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,-1,-1,-1,-1,-1
+};
+
+
+static unsigned GetHighBit32(UInt32 v)
+{
+  unsigned i = 0;
+  while (v >>= 1)
+    i++;
+  return i;
+}
+
+/* it returns log2(v) * 256 */
+
+static UInt32 Log2_Fix8(UInt32 v)
+{
+  const unsigned hb = GetHighBit32(v);
+  UInt32 m = (UInt32)(((UInt64)v << 16) >> hb); /* [1 << 16, 2 << 16) */
+  UInt32 res = 0;
+  unsigned i;
+  for (i = 0; i < 8; i++)
+  {
+    m = (UInt32)(((UInt64)m * m) >> 16);
+    res <<= 1;
+    if (m >= ((UInt32)2 << 16))
+    {
+      m >>= 1;
+      res |= 1;
+    }
+  }
+  return ((UInt32)hb << 8) | res;
+}
+
+
+/* ---------- properties ---------- */
+
+void ZstdEncProps_Init(CZstdEncProps *p)
+{
+  p->level = ZSTD_ENC_LEVEL_DEFAULT;
+  p->windowLog = 0;
+  p->nbWorkers = 0;
+  p->jobSize = 0;
+  p->checksumFlag = 1;
+  p->expectedDataSize = (UInt64)(Int64)-1;
+}
+
+void ZstdEncProps_Normalize(CZstdEncProps *p)
+{
+  if (p->level < ZSTD_ENC_LEVEL_MIN)
+    p->level = ZSTD_ENC_LEVEL_DEFAULT;
+  if (p->level > ZSTD_ENC_LEVEL_MAX)
+    p->level = ZSTD_ENC_LEVEL_MAX;
+  if (p->windowLog == 0)
+    p->windowLog = k_Levels[(unsigned)p->level - 1].windowLog;
+  if (p->windowLog < ZSTD_ENC_WINDOW_LOG_MIN)
+    p->windowLog = ZSTD_ENC_WINDOW_LOG_MIN;
+  if (p->windowLog > ZSTD_ENC_WINDOW_LOG_MAX)
+    p->windowLog = ZSTD_ENC_WINDOW_LOG_MAX;
+  if (p->nbWorkers > MY_ZSTDMT_NBWORKERS_MAX)
+    p->nbWorkers = MY_ZSTDMT_NBWORKERS_MAX;
+}
+
+void ZstdEncProps_NormalizeFull(CZstdEncProps *p)
+{
+  ZstdEncProps_Normalize(p);
+  if (p->expectedDataSize != (UInt64)(Int64)-1)
+  {
+    while (p->windowLog > ZSTD_ENC_WINDOW_LOG_MIN
+        && ((UInt64)1 << (p->windowLog - 1)) >= p->expectedDataSize)
+      p->windowLog--;
+  }
+  if (p->jobSize == 0)
+  {
+    p->jobSize = (UInt64)1 << (p->windowLog + 2);
+    if (p->jobSize < ZSTD_ENC_JOB_SIZE_MIN)
+      p->jobSize = ZSTD_ENC_JOB_SIZE_MIN;
+  }
+  if (p->jobSize < ZSTD_ENC_JOB_SIZE_MIN)
+    p->jobSize = ZSTD_ENC_JOB_SIZE_MIN;
+  if (p->jobSize > ZSTD_ENC_JOB_SIZE_MAX)
+    p->jobSize = ZSTD_ENC_JOB_SIZE_MAX;
+}
+
+
+static void ZstdEncProps_GetParams(const CZstdEncProps *p, CZstdLevelParams *par)
+{
+  *par = k_Levels[(unsigned)p->level - 1];
+  par->windowLog = (Byte)p->windowLog;
+  if (par->hashLog > par->windowLog + 1)
+    par->hashLog = (Byte)(par->windowLog + 1);
+  if (par->chainLog > par->windowLog + 1)
+    par->chainLog = (Byte)(par->windowLog + 1);
+}
+
+
+static UInt64 ZstdEnc_GetCoderMemUsage(const CZstdLevelParams *par)
+{
+  UInt64 size = (UInt64)4 << par->hashLog;
+  if (par->strategy != STRAT_FAST)
+    size += (UInt64)4 << par->chainLog;
+  size += kBlockSizeMax * 2 + kSeqsMax * (12 + 3) + kBlockBufSize;
+  return size;
+}
+
+
+UInt64 ZstdEncProps_GetMemUsage(const CZstdEncProps *props)
+{
+  CZstdEncProps p = *props;
+  CZstdLevelParams par;
+  UInt64 coderSize;
+  ZstdEncProps_NormalizeFull(&p);
+  ZstdEncProps_GetParams(&p, &par);
+  coderSize = ZstdEnc_GetCoderMemUsage(&par);
+  if (p.nbWorkers == 0)
+    return coderSize + ((UInt64)1 << p.windowLog) + p.jobSize;
+  #ifndef Z7_ST
+  {
+    const UInt64 numBlocks = MTCODER_GET_NUM_BLOCKS_FROM_THREADS(p.nbWorkers);
+    return (coderSize + p.jobSize) * p.nbWorkers
+        + (p.jobSize + (p.jobSize >> 10) + (1 << 12)) * numBlocks;
+  }
+  #else
+    return coderSize + p.jobSize * 2;
+  #endif
+}
+
+
+UInt32 ZstdEncProps_GetNumThreads_for_MemUsageLimit(const CZstdEncProps *props,
+    UInt64 memLimit, UInt32 numThreads)
+{
+  CZstdEncProps p = *props;
+  if (numThreads > MY_ZSTDMT_NBWORKERS_MAX)
+    numThreads = MY_ZSTDMT_NBWORKERS_MAX;
+  for (; numThreads > 1; numThreads--)
+  {
+    p.nbWorkers = numThreads;
+    if (ZstdEncProps_GetMemUsage(&p) <= memLimit)
+      break;
+  }
+  if (numThreads < 1)
+    numThreads = 1;
+  return numThreads;
+}
+
+
+/* ---------- bit writer ---------- */
+
+typedef struct
+{
+  Byte *buf;
+  UInt64 acc;
+  unsigned num;
+} CBitW;
+
+#define BitW_Init(w, dest) { (w)->buf = (dest); (w)->acc = 0; (w)->num = 0; }
+
+/* (v < (1 << numBits)), (numBits <= 32) */
+
+Z7_FORCE_INLINE
+static void BitW_Add(CBitW *w, UInt32 v, unsigned numBits)
+{
+  w->acc |= (UInt64)v << w->num;
+  w->num += numBits;
+  if (w->num >= 32)
+  {
+    SetUi32(w->buf, (UInt32)w->acc)
+    w->buf += 4;
+    w->acc >>= 32;
+    w->num -= 32;
+  }
+}
+
+/* it writes end marker bit and it returns the end of data */
+
+static Byte *BitW_Close(CBitW *w)
+{
+  Byte *buf;
+  BitW_Add(w, 1, 1);
+  buf = w->buf;
+  while (w->num != 0)
+  {
+    *buf++ = (Byte)w->acc;
+    w->acc >>= 8;
+    w->num = (w->num > 8) ? w->num - 8 : 0;
+  }
+  return buf;
+}
+
+
+/* ---------- FSE encoding ---------- */
+
+typedef struct
+{
+  Int32 deltaFindState;
+  UInt32 deltaNbBits;
+} CFseSymTT;
+
+typedef struct
+{
+  unsigned tableLog;
+  UInt16 stateTable[1 << kFseLogMax];
+  CFseSymTT symTT[kFseSymMax + 1];
+} CFseCTable;
+
+
+static void FseC_Build(CFseCTable *ct, const Int16 *norm, unsigned numSymbols, unsigned tableLog)
+{
+  const unsigned size = (unsigned)1 << tableLog;
+  const unsigned mask = size - 1;
+  const unsigned step = (size >> 1) + (size >> 3) + 3;
+  unsigned high = size - 1;
+  unsigned cumul[kFseSymMax + 2];
+  Byte tableSymbol[1 << kFseLogMax];
+  unsigned s, u, pos;
+  Int32 total;
+
+  ct->tableLog = tableLog;
+  cumul[0] = 0;
+  for (s = 0; s < numSymbols; s++)
+  {
+    if (norm[s] == -1)
+    {
+      cumul[s + 1] = cumul[s] + 1;
+      tableSymbol[high--] = (Byte)s;
+    }
+    else
+      cumul[s + 1] = cumul[s] + (unsigned)norm[s];
+  }
+  pos = 0;
+  for (s = 0; s < numSymbols; s++)
+  {
+    int i;
+    for (i = 0; i < norm[s]; i++)
+    {
+      tableSymbol[pos] = (Byte)s;
+      do
+        pos = (pos + step) & mask;
+      while (pos > high);
+    }
+  }
+  for (u = 0; u < size; u++)
+  {
+    s = tableSymbol[u];
+    ct->stateTable[cumul[s]++] = (UInt16)(size + u);
+  }
+  total = 0;
+  for (s = 0; s < numSymbols; s++)
+  {
+    CFseSymTT *tt = &ct->symTT[s];
+    const int n = norm[s];
+    if (n == 0)
+    {
+      tt->deltaNbBits = ((tableLog + 1) << 16) - size;
+      tt->deltaFindState = 0;
+    }
+    else if (n == -1 || n == 1)
+    {
+      tt->deltaNbBits = (tableLog << 16) - size;
+      tt->deltaFindState = total - 1;
+      total++;
+    }
+    else
+    {
+      const unsigned maxBitsOut = tableLog - GetHighBit32((UInt32)n - 1);
+      const UInt32 minStatePlus = (UInt32)n << maxBitsOut;
+      tt->deltaNbBits = ((UInt32)maxBitsOut << 16) - minStatePlus;
+      tt->deltaFindState = total - n;
+      total += n;
+    }
+  }
+}
+
+
+Z7_FORCE_INLINE
+static UInt32 FseC_InitState(const CFseCTable *ct, unsigned sym)
+{
+  const CFseSymTT *tt = &ct->symTT[sym];
+  const UInt32 numBits = (tt->deltaNbBits + (1 << 15)) >> 16;
+  const UInt32 value = (numBits << 16) - tt->deltaNbBits;
+  return ct->stateTable[(Int32)(value >> numBits) + tt->deltaFindState];
+}
+
+Z7_FORCE_INLINE
+static void FseC_Encode(CBitW *w, const CFseCTable *ct, UInt32 *state, unsigned sym)
+{
+  const CFseSymTT *tt = &ct->symTT[sym];
+  const UInt32 st = *state;
+  const unsigned numBits = (unsigned)((st + tt->deltaNbBits) >> 16);
+  BitW_Add(w, st & (((UInt32)1 << numBits) - 1), numBits);
+  *state = ct->stateTable[(Int32)(st >> numBits) + tt->deltaFindState];
+}
+
+#define FseC_Flush(w, ct, state)  BitW_Add(w, (state) & (((UInt32)1 << (ct)->tableLog) - 1), (ct)->tableLog)
+
+
+static unsigned Fse_OptimalTableLog(unsigned maxLog, UInt32 total, unsigned maxSym)
+{
+  const unsigned maxBitsSrc = (total > 4) ? GetHighBit32(total - 1) - 2 : 0;
+  const unsigned minBitsSrc = GetHighBit32(total) + 1;
+  const unsigned minBitsSym = GetHighBit32(maxSym) + 2;
+  const unsigned minBits = (minBitsSrc < minBitsSym) ? minBitsSrc : minBitsSym;
+  unsigned log = maxLog;
+  if (log > maxBitsSrc)
+    log = maxBitsSrc;
+  if (log < minBits)
+    log = minBits;
+  if (log < 5)
+    log = 5;
+  if (log > maxLog)
+    log = maxLog;
+  return log;
+}
+
+
+/* all used symbols get (norm >= 1). (total >= 2) and at least 2 symbols are used */
+
+static void Fse_Normalize(Int16 *norm, unsigned tableLog, const UInt32 *counts, UInt32 total, unsigned maxSym)
+{
+  const UInt32 size = (UInt32)1 << tableLog;
+  UInt32 sum = 0;
+  unsigned s, largest = 0;
+  UInt32 largestCount = 0;
+  for (s = 0; s <= maxSym; s++)
+  {
+    const UInt32 c = counts[s];
+    UInt32 v = 0;
+    if (c != 0)
+    {
+      v = (UInt32)(((UInt64)c * size + (total >> 1)) / total);
+      if (v == 0)
+        v = 1;
+      if (c > largestCount)
+      {
+        largestCount = c;
+        largest = s;
+      }
+    }
+    norm[s] = (Int16)v;
+    sum += v;
+  }
+  if (sum < size)
+    norm[largest] = (Int16)(norm[largest] + (Int16)(size - sum));
+  while (sum > size)
+  {
+    unsigned best = 0;
+    int bestVal = 1;
+    for (s = 0; s <= maxSym; s++)
+      if (norm[s] > bestVal)
+      {
+        bestVal = norm[s];
+        best = s;
+      }
+    norm[best]--;
+    sum--;
+  }
+}
+
+
+/* it returns the number of written bytes */
+
+static size_t Fse_WriteNCount(Byte *dest, const Int16 *norm, unsigned maxSym, unsigned tableLog)
+{
+  CBitW w;
+  const Int32 size = (Int32)1 << tableLog;
+  Int32 remaining = size + 1;
+  Int32 threshold = size;
+  unsigned numBits = tableLog + 1;
+  unsigned sym = 0;
+  BoolInt prev0 = False;
+
+  BitW_Init(&w, dest)
+  BitW_Add(&w, tableLog - 5, 4);
+
+  while (sym <= maxSym && remaining > 1)
+  {
+    if (prev0)
+    {
+      unsigned start = sym;
+      while (sym <= maxSym && norm[sym] == 0)
+        sym++;
+      while (sym >= start + 24)
+      {
+        start += 24;
+        BitW_Add(&w, 0xFFFF, 16);
+      }
+      while (sym >= start + 3)
+      {
+        start += 3;
+        BitW_Add(&w, 3, 2);
+      }
+      BitW_Add(&w, sym - start, 2);
+    }
+    {
+      Int32 count = norm[sym++];
+      const Int32 max = (2 * threshold - 1) - remaining;
+      remaining -= count < 0 ? -count : count;
+      count++;
+      if (count >= threshold)
+        count += max;
+      BitW_Add(&w, (UInt32)count, numBits - (count < max ? 1 : 0));
+      prev0 = (count == 1);
+      while (remaining < threshold)
+      {
+        numBits--;
+        threshold >>= 1;
+      }
+    }
+  }
+  {
+    Byte *buf = w.buf;
+    while (w.num != 0)
+    {
+      *buf++ = (Byte)w.acc;
+      w.acc >>= 8;
+      w.num = (w.num > 8) ? w.num - 8 : 0;
+    }
+    return (size_t)(buf - dest);
+  }
+}
+
+
+/* it returns the estimated cost in (bits * 256) */
+
+static UInt64 Fse_GetCost(const UInt32 *counts, unsigned maxSym, const Int16 *norm, unsigned tableLog)
+{
+  UInt64 cost = 0;
+  unsigned s;
+  for (s = 0; s <= maxSym; s++)
+  {
+    const UInt32 c = counts[s];
+    if (c != 0)
+    {
+      const int n = norm[s];
+      if (n == 0)
+        return (UInt64)(Int64)-1;
+      cost += (UInt64)c * (((UInt32)tableLog << 8) - Log2_Fix8(n < 0 ? 1 : (UInt32)n));
+    }
+  }
+  return cost;
+}
+
+
+/* ---------- coder ---------- */
+
+typedef struct
+{
+  UInt32 litLen;
+  UInt32 matchLen;
+  UInt32 offValue;
+} CZstdSeq;
+
+typedef struct
+{
+  CZstdLevelParams par;
+  UInt32 windowSize;
+  UInt32 nextToUpdate;
+  UInt32 reps[3];
+
+  UInt32 *hashTable;
+  UInt32 *chainTable;
+  unsigned hashLog_Alloc;
+  unsigned chainLog_Alloc;
+
+  CZstdSeq *seqs;
+  UInt32 numSeqs;
+  Byte *lits;
+  size_t numLits;
+  Byte *codes;     /* ll codes, ml codes, of codes */
+  Byte *blockBuf;
+  Byte *outBlock;
+
+  Byte llCodeTable[64];
+  Byte mlCodeTable[128];
+  CFseCTable llPredef;
+  CFseCTable mlPredef;
+  CFseCTable ofPredef;
+  CFseCTable ctLL;
+  CFseCTable ctML;
+  CFseCTable ctOF;
+} CZstdEncCoder;
+
+
+static void ZstdEncCoder_Construct(CZstdEncCoder *c)
+{
+  unsigned i, code;
+  c->hashTable = NULL;
+  c->chainTable = NULL;
+  c->hashLog_Alloc = 0;
+  c->chainLog_Alloc = 0;
+  c->seqs = NULL;
+  c->lits = NULL;
+  c->codes = NULL;
+  c->blockBuf = NULL;
+  c->outBlock = NULL;
+  c->llPredef.tableLog = 0;
+
+  for (i = 0, code = 0; i < 64; i++)
+  {
+    while (code < kLL_SymMax && k_LL_Base[code + 1] <= i)
+      code++;
+    c->llCodeTable[i] = (Byte)code;
+  }
+  for (i = 0, code = 0; i < 128; i++)
+  {
+    while (code < kML_SymMax && k_ML_Base[code + 1] - 3 <= i)
+      code++;
+    c->mlCodeTable[i] = (Byte)code;
+  }
+}
+
+
+static void ZstdEncCoder_Free(CZstdEncCoder *c, ISzAllocPtr alloc, ISzAllocPtr allocBig)
+{
+  ISzAlloc_Free(allocBig, c->hashTable);
+  ISzAlloc_Free(allocBig, c->chainTable);
+  ISzAlloc_Free(alloc, c->seqs);
+  ISzAlloc_Free(alloc, c->lits);
+  ISzAlloc_Free(alloc, c->codes);
+  ISzAlloc_Free(alloc, c->blockBuf);
+  ISzAlloc_Free(alloc, c->outBlock);
+  c->hashTable = NULL;
+  c->chainTable = NULL;
+  c->hashLog_Alloc = 0;
+  c->chainLog_Alloc = 0;
+  c->seqs = NULL;
+  c->lits = NULL;
+  c->codes = NULL;
+  c->blockBuf = NULL;
+  c->outBlock = NULL;
+}
+
+
+static SRes ZstdEncCoder_Alloc(CZstdEncCoder *c, const CZstdLevelParams *par,
+    ISzAllocPtr alloc, ISzAllocPtr allocBig)
+{
+  c->par = *par;
+  c->windowSize = (UInt32)1 << par->windowLog;
+  if (!c->seqs)
+  {
+    c->seqs = (CZstdSeq *)ISzAlloc_Alloc(alloc, kSeqsMax * sizeof(CZstdSeq));
+    c->lits = (Byte *)ISzAlloc_Alloc(alloc, kBlockSizeMax + kInBufPad);
+    c->codes = (Byte *)ISzAlloc_Alloc(alloc, kSeqsMax * 3);
+    c->blockBuf = (Byte *)ISzAlloc_Alloc(alloc, kBlockBufSize);
+    c->outBlock = (Byte *)ISzAlloc_Alloc(alloc, kBlockSizeMax + kInBufPad);
+    if (!c->seqs || !c->lits || !c->codes || !c->blockBuf || !c->outBlock)
+      return SZ_ERROR_MEM;
+  }
+  if (c->hashLog_Alloc != par->hashLog)
+  {
+    ISzAlloc_Free(allocBig, c->hashTable);
+    c->hashLog_Alloc = 0;
+    c->hashTable = (UInt32 *)ISzAlloc_Alloc(allocBig, (size_t)sizeof(UInt32) << par->hashLog);
+    if (!c->hashTable)
+      return SZ_ERROR_MEM;
+    c->hashLog_Alloc = par->hashLog;
+  }
+  if (par->strategy != STRAT_FAST && c->chainLog_Alloc != par->chainLog)
+  {
+    ISzAlloc_Free(allocBig, c->chainTable);
+    c->chainLog_Alloc = 0;
+    c->chainTable = (UInt32 *)ISzAlloc_Alloc(allocBig, (size_t)sizeof(UInt32) << par->chainLog);
+    if (!c->chainTable)
+      return SZ_ERROR_MEM;
+    c->chainLog_Alloc = par->chainLog;
+  }
+  if (c->llPredef.tableLog == 0)
+  {
+    FseC_Build(&c->llPredef, k_LL_Predef, kLL_SymMax + 1, kLL_PredefLog);
+    FseC_Build(&c->mlPredef, k_ML_Predef, kML_SymMax + 1, kML_PredefLog);
+    FseC_Build(&c->ofPredef, k_OF_Predef, kOF_PredefSymMax + 1, kOF_PredefLog);
+  }
+  return SZ_OK;
+}
+
+
+static void ZstdEncCoder_InitFrame(CZstdEncCoder *c)
+{
+  c->reps[0] = 1;
+  c->reps[1] = 4;
+  c->reps[2] = 8;
+}
+
+
+#define kHashPrime32  2654435761U
+#define kHashPrime5   UINT64_CONST(889523592379)
+#define kHashPrime6   UINT64_CONST(227718039650203)
+
+Z7_FORCE_INLINE
+static UInt32 Hash_Calc(const Byte *p, unsigned hashLog, unsigned mls)
+{
+  if (mls == 4)
+    return (GetUi32(p) * kHashPrime32) >> (32 - hashLog);
+  if (mls == 5)
+    return (UInt32)(((GetUi64(p) << 24) * kHashPrime5) >> (64 - hashLog));
+  return (UInt32)(((GetUi64(p) << 16) * kHashPrime6) >> (64 - hashLog));
+}
+
+
+/* it prepares the match finder for new job.
+   (buf) contains (prefixSize) bytes of history data */
+
+static void ZstdEncCoder_StartJob(CZstdEncCoder *c, const Byte *buf, size_t prefixSize)
+{
+  memset(c->hashTable, 0, (size_t)sizeof(UInt32) << c->par.hashLog);
+  c->nextToUpdate = 0;
+  if (c->par.strategy == STRAT_FAST && prefixSize >= 8)
+  {
+    UInt32 *hashTable = c->hashTable;
+    const unsigned hashLog = c->par.hashLog;
+    const unsigned mls = c->par.minMatch;
+    const UInt32 lim = (UInt32)prefixSize - 8;
+    UInt32 i;
+    for (i = 0; i < lim; i += 2)
+      hashTable[Hash_Calc(buf + i, hashLog, mls)] = i;
+  }
+}
+
+
+static size_t Match_Count(const Byte *p, const Byte *m, const Byte *lim)
+{
+  const Byte *start = p;
+  while (p + 8 <= lim)
+  {
+    UInt64 diff = GetUi64(p) ^ GetUi64(m);
+    if (diff != 0)
+    {
+      #if defined(__GNUC__) || defined(__clang__)
+        p += (unsigned)__builtin_ctzll(diff) >> 3;
+      #else
+        while ((diff & 0xFF) == 0)
+        {
+          diff >>= 8;
+          p++;
+        }
+      #endif
+      return (size_t)(p - start);
+    }
+    p += 8;
+    m += 8;
+  }
+  while (p < lim && *p == *m)
+  {
+    p++;
+    m++;
+  }
+  return (size_t)(p - start);
+}
+
+
+static void ZstdEncCoder_StoreSeq(CZstdEncCoder *c, const Byte *lits, size_t litLen,
+    UInt32 offset, size_t matchLen)
+{
+  UInt32 *reps = c->reps;
+  CZstdSeq *seq = &c->seqs[c->numSeqs++];
+  UInt32 ov;
+  memcpy(c->lits + c->numLits, lits, litLen);
+  c->numLits += litLen;
+  seq->litLen = (UInt32)litLen;
+  seq->matchLen = (UInt32)matchLen;
+
+  if (litLen != 0)
+  {
+    if (offset == reps[0])
+    {
+      seq->offValue = 1;
+      return;
+    }
+    if (offset == reps[1])
+    {
+      reps[1] = reps[0];
+      reps[0] = offset;
+      seq->offValue = 2;
+      return;
+    }
+    ov = (offset == reps[2]) ? 3 : offset + 3;
+  }
+  else
+  {
+    if (offset == reps[1])
+    {
+      reps[1] = reps[0];
+      reps[0] = offset;
+      seq->offValue = 1;
+      return;
+    }
+    if (offset == reps[2])
+      ov = 2;
+    else if (offset == reps[0] - 1)
+      ov = 3;
+    else
+      ov = offset + 3;
+  }
+  reps[2] = reps[1];
+  reps[1] = reps[0];
+  reps[0] = offset;
+  seq->offValue = ov;
+}
+
+
+/* ---------- match finders ---------- */
+
+static void ZstdEnc_CompressBlock_Fast(CZstdEncCoder *c, const Byte *base, UInt32 blockStart, UInt32 blockEnd)
+{
+  UInt32 *hashTable = c->hashTable;
+  const unsigned hashLog = c->par.hashLog;
+  const unsigned mls = c->par.minMatch;
+  const UInt32 windowSize = c->windowSize;
+  const Byte *istart = base + blockStart;
+  const Byte *iend = base + blockEnd;
+  const Byte *ilimit = iend - 8;
+  const Byte *ip = istart;
+  const Byte *anchor = istart;
+
+  ip += (ip == base);
+
+  while (ip < ilimit)
+  {
+    const UInt32 cur = (UInt32)(ip - base);
+    const UInt32 h = Hash_Calc(ip, hashLog, mls);
+    const UInt32 matchIndex = hashTable[h];
+    const UInt32 rep0 = c->reps[0];
+    size_t len;
+    hashTable[h] = cur;
+
+    if (rep0 <= cur + 1 && GetUi32(ip + 1) == GetUi32(ip + 1 - rep0))
+    {
+      len = Match_Count(ip + 5, ip + 5 - rep0, iend) + 4;
+      ip++;
+      ZstdEncCoder_StoreSeq(c, anchor, (size_t)(ip - anchor), rep0, len);
+    }
+    else if (matchIndex < cur
+        && cur - matchIndex <= windowSize
+        && GetUi32(base + matchIndex) == GetUi32(ip))
+    {
+      const Byte *m = base + matchIndex;
+      len = Match_Count(ip + 4, m + 4, iend) + 4;
+      while (ip > anchor && m > base && ip[-1] == m[-1])
+      {
+        ip--;
+        m--;
+        len++;
+      }
+      ZstdEncCoder_StoreSeq(c, anchor, (size_t)(ip - anchor), cur - matchIndex, len);
+    }
+    else
+    {
+      ip += ((size_t)(ip - anchor) >> kSearchStrength) + 1;
+      continue;
+    }
+
+    ip += len;
+    anchor = ip;
+
+    if (ip <= ilimit)
+    {
+      hashTable[Hash_Calc(base + cur + 2, hashLog, mls)] = cur + 2;
+      hashTable[Hash_Calc(ip - 2, hashLog, mls)] = (UInt32)(ip - 2 - base);
+      for (;;)
+      {
+        const UInt32 rep1 = c->reps[1];
+        if (ip > ilimit
+            || rep1 > (UInt32)(ip - base)
+            || GetUi32(ip) != GetUi32(ip - rep1))
+          break;
+        len = Match_Count(ip + 4, ip + 4 - rep1, iend) + 4;
+        hashTable[Hash_Calc(ip, hashLog, mls)] = (UInt32)(ip - base);
+        ZstdEncCoder_StoreSeq(c, anchor, 0, rep1, len);
+        ip += len;
+        anchor = ip;
+      }
+    }
+  }
+
+  {
+    const size_t rem = (size_t)(iend - anchor);
+    memcpy(c->lits + c->numLits, anchor, rem);
+    c->numLits += rem;
+  }
+}
+
+
+/* it returns the length of the longest match or 0 */
+
+static size_t Hc_FindBestMatch(CZstdEncCoder *c, const Byte *base, const Byte *ip, const Byte *iend, UInt32 *offsetRes)
+{
+  UInt32 *hashTable = c->hashTable;
+  UInt32 *chainTable = c->chainTable;
+  const unsigned hashLog = c->par.hashLog;
+  const unsigned mls = c->par.minMatch;
+  const UInt32 chainSize = (UInt32)1 << c->par.chainLog;
+  const UInt32 chainMask = chainSize - 1;
+  const UInt32 cur = (UInt32)(ip - base);
+  UInt32 minIndex;
+  UInt32 matchIndex;
+  unsigned numAttempts = (unsigned)1 << c->par.searchLog;
+  size_t bestLen = mls - 1;
+
+  {
+    UInt32 idx = c->nextToUpdate;
+    for (; idx <= cur; idx++)
+    {
+      const UInt32 h = Hash_Calc(base + idx, hashLog, mls);
+      chainTable[idx & chainMask] = hashTable[h];
+      hashTable[h] = idx;
+    }
+    c->nextToUpdate = cur + 1;
+  }
+
+  minIndex = (cur > c->windowSize) ? cur - c->windowSize : 0;
+  if (cur >= chainSize && minIndex < cur - chainSize + 1)
+    minIndex = cur - chainSize + 1;
+  matchIndex = chainTable[cur & chainMask];
+
+  while (matchIndex >= minIndex && matchIndex < cur && numAttempts != 0)
+  {
+    const Byte *m = base + matchIndex;
+    numAttempts--;
+    if (m[bestLen] == ip[bestLen])
+    {
+      const size_t len = Match_Count(ip, m, iend);
+      if (len > bestLen)
+      {
+        bestLen = len;
+        *offsetRes = cur - matchIndex;
+        if (ip + len == iend)
+          break;
+      }
+    }
+    {
+      const UInt32 next = chainTable[matchIndex & chainMask];
+      if (next >= matchIndex)
+        break;
+      matchIndex = next;
+    }
+  }
+  return (bestLen >= mls) ? bestLen : 0;
+}
+
+
+static void ZstdEnc_CompressBlock_Lazy(CZstdEncCoder *c, const Byte *base,
+    UInt32 blockStart, UInt32 blockEnd, unsigned depth)
+{
+  const Byte *istart = base + blockStart;
+  const Byte *iend = base + blockEnd;
+  const Byte *ilimit = iend - 8;
+  const Byte *ip = istart;
+  const Byte *anchor = istart;
+
+  ip += (ip == base);
+
+  while (ip < ilimit)
+  {
+    size_t matchLen = 0;
+    UInt32 offset = 0;
+    const Byte *start = ip + 1;
+
+    {
+      const UInt32 rep0 = c->reps[0];
+      if (rep0 <= (UInt32)(ip + 1 - base) && GetUi32(ip + 1) == GetUi32(ip + 1 - rep0))
+      {
+        matchLen = Match_Count(ip + 5, ip + 5 - rep0, iend) + 4;
+        offset = rep0;
+      }
+    }
+    if (depth == 0 && matchLen != 0)
+      goto store;
+    {
+      UInt32 off2 = 0;
+      const size_t len2 = Hc_FindBestMatch(c, base, ip, iend, &off2);
+      if (len2 > matchLen)
+      {
+        matchLen = len2;
+        offset = off2;
+        start = ip;
+      }
+    }
+    if (matchLen < 4)
+    {
+      ip += ((size_t)(ip - anchor) >> kSearchStrength) + 1;
+      continue;
+    }
+
+    if (depth >= 1)
+    while (ip < ilimit)
+    {
+      const UInt32 rep0 = c->reps[0];
+      ip++;
+      if (offset != rep0
+          && rep0 <= (UInt32)(ip - base)
+          && GetUi32(ip) == GetUi32(ip - rep0))
+      {
+        const size_t repLen = Match_Count(ip + 4, ip + 4 - rep0, iend) + 4;
+        const int gain2 = (int)(repLen * 3);
+        const int gain1 = (int)(matchLen * 3) - (int)GetHighBit32(offset + 1) + 1;
+        if (gain2 > gain1)
+        {
+          matchLen = repLen;
+          offset = rep0;
+          start = ip;
+        }
+      }
+      {
+        UInt32 off2 = 0;
+        const size_t len2 = Hc_FindBestMatch(c, base, ip, iend, &off2);
+        if (len2 >= 4)
+        {
+          const int gain2 = (int)(len2 * 4) - (int)GetHighBit32(off2 + 1);
+          const int gain1 = (int)(matchLen * 4) - (int)GetHighBit32(offset + 1) + 4;
+          if (gain2 > gain1)
+          {
+            matchLen = len2;
+            offset = off2;
+            start = ip;
+            continue;
+          }
+        }
+      }
+      if (depth == 2 && ip < ilimit)
+      {
+        const UInt32 rep0b = c->reps[0];
+        ip++;
+        if (offset != rep0b
+            && rep0b <= (UInt32)(ip - base)
+            && GetUi32(ip) == GetUi32(ip - rep0b))
+        {
+          const size_t repLen = Match_Count(ip + 4, ip + 4 - rep0b, iend) + 4;
+          const int gain2 = (int)(repLen * 4);
+          const int gain1 = (int)(matchLen * 4) - (int)GetHighBit32(offset + 1) + 1;
+          if (gain2 > gain1)
+          {
+            matchLen = repLen;
+            offset = rep0b;
+            start = ip;
+          }
+        }
+        {
+          UInt32 off2 = 0;
+          const size_t len2 = Hc_FindBestMatch(c, base, ip, iend, &off2);
+          if (len2 >= 4)
+          {
+            const int gain2 = (int)(len2 * 4) - (int)GetHighBit32(off2 + 1);
+            const int gain1 = (int)(matchLen * 4) - (int)GetHighBit32(offset + 1) + 7;
+            if (gain2 > gain1)
+            {
+              matchLen = len2;
+              offset = off2;
+              start = ip;
+              continue;
+            }
+          }
+        }
+      }
+      break;
+    }
+
+    if (offset != c->reps[0])
+    {
+      while (start > anchor
+          && (UInt32)(start - base) > offset
+          && start[-1] == *(start - 1 - offset))
+      {
+        start--;
+        matchLen++;
+      }
+    }
+
+  store:
+    ZstdEncCoder_StoreSeq(c, anchor, (size_t)(start - anchor), offset, matchLen);
+    ip = start + matchLen;
+    anchor = ip;
+
+    for (;;)
+    {
+      const UInt32 rep1 = c->reps[1];
+      size_t len;
+      if (ip > ilimit
+          || rep1 > (UInt32)(ip - base)
+          || GetUi32(ip) != GetUi32(ip - rep1))
+        break;
+      len = Match_Count(ip + 4, ip + 4 - rep1, iend) + 4;
+      ZstdEncCoder_StoreSeq(c, anchor, 0, rep1, len);
+      ip += len;
+      anchor = ip;
+    }
+  }
+
+  {
+    const size_t rem = (size_t)(iend - anchor);
+    memcpy(c->lits + c->numLits, anchor, rem);
+    c->numLits += rem;
+  }
+}
+
+
+/* ---------- literals ---------- */
+
+static size_t ZstdEnc_WriteLitHeader_Raw(Byte *dest, size_t size, unsigned type)
+{
+  if (size < 32)
+  {
+    dest[0] = (Byte)(type | (size << 3));
+    return 1;
+  }
+  if (size < (1 << 12))
+  {
+    SetUi16(dest, (UInt16)(type | (1 << 2) | (size << 4)))
+    return 2;
+  }
+  {
+    const UInt32 v = (UInt32)(type | (3 << 2) | (size << 4));
+    dest[0] = (Byte)v;
+    dest[1] = (Byte)(v >> 8);
+    dest[2] = (Byte)(v >> 16);
+    return 3;
+  }
+}
+
+
+static size_t ZstdEnc_WriteLitRaw(Byte *dest, const Byte *src, size_t size)
+{
+  const size_t h = ZstdEnc_WriteLitHeader_Raw(dest, size, 0);
+  memcpy(dest + h, src, size);
+  return h + size;
+}
+
+
+/* it writes Huffman tree description. It returns 0, if it's not possible */
+
+static size_t Huf_WriteWeights(Byte *dest, const Byte *weights, unsigned numWeights)
+{
+  UInt32 counts[kHufLogMax + 1];
+  unsigned i, maxW = 0;
+  size_t directSize = 0;
+
+  if (numWeights <= 128)
+    directSize = 1 + (numWeights + 1) / 2;
+
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < numWeights; i++)
+  {
+    const unsigned w = weights[i];
+    counts[w]++;
+    if (maxW < w)
+      maxW = w;
+  }
+
+  if (numWeights >= 2 && counts[weights[0]] != numWeights)
+  {
+    Int16 norm[kHufLogMax + 1];
+    CFseCTable ct;
+    const unsigned tableLog = Fse_OptimalTableLog(kHufWeightsLogMax, numWeights, maxW);
+    Byte *p = dest + 1;
+    size_t cSize;
+    Fse_Normalize(norm, tableLog, counts, numWeights, maxW);
+    p += Fse_WriteNCount(p, norm, maxW, tableLog);
+    FseC_Build(&ct, norm, maxW + 1, tableLog);
+    {
+      CBitW w;
+      UInt32 st1, st2;
+      const Byte *ip = weights + numWeights;
+      BitW_Init(&w, p)
+      if (numWeights & 1)
+      {
+        st1 = FseC_InitState(&ct, *--ip);
+        st2 = FseC_InitState(&ct, *--ip);
+        FseC_Encode(&w, &ct, &st1, *--ip);
+      }
+      else
+      {
+        st2 = FseC_InitState(&ct, *--ip);
+        st1 = FseC_InitState(&ct, *--ip);
+      }
+      while (ip != weights)
+      {
+        FseC_Encode(&w, &ct, &st2, *--ip);
+        FseC_Encode(&w, &ct, &st1, *--ip);
+      }
+      FseC_Flush(&w, &ct, st2);
+      FseC_Flush(&w, &ct, st1);
+      p = BitW_Close(&w);
+    }
+    cSize = (size_t)(p - (dest + 1));
+    if (cSize < 128 && (directSize == 0 || cSize + 1 < directSize))
+    {
+      dest[0] = (Byte)cSize;
+      return cSize + 1;
+    }
+  }
+
+  if (directSize == 0)
+    return 0;
+  dest[0] = (Byte)(127 + numWeights);
+  for (i = 0; i < numWeights; i += 2)
+  {
+    const unsigned w1 = (i + 1 < numWeights) ? weights[i + 1] : 0;
+    dest[1 + i / 2] = (Byte)((weights[i] << 4) | w1);
+  }
+  return directSize;
+}
+
+
+static size_t Huf_EncodeStream(Byte *dest, const Byte *src, size_t size,
+    const UInt16 *codes, const Byte *lens)
+{
+  CBitW w;
+  BitW_Init(&w, dest)
+  while (size != 0)
+  {
+    const unsigned sym = src[--size];
+    BitW_Add(&w, codes[sym], lens[sym]);
+  }
+  return (size_t)(BitW_Close(&w) - dest);
+}
+
+
+#define kLitHufMin 64
+
+static size_t ZstdEnc_CompressLiterals(CZstdEncCoder *c, Byte *dest)
+{
+  const Byte *src = c->lits;
+  const size_t size = c->numLits;
+  UInt32 counts[256];
+  unsigned maxSym = 0;
+  size_t i;
+
+  if (size < kLitHufMin)
+    return ZstdEnc_WriteLitRaw(dest, src, size);
+
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < size; i++)
+    counts[src[i]]++;
+  for (i = 0; i < 256; i++)
+    if (counts[i] != 0)
+      maxSym = (unsigned)i;
+  if (counts[src[0]] == size)
+  {
+    const size_t h = ZstdEnc_WriteLitHeader_Raw(dest, size, 1);
+    dest[h] = src[0];
+    return h + 1;
+  }
+
+  {
+    UInt32 temp[512];
+    Byte lens[256];
+    Byte weights[256];
+    UInt16 codes[256];
+    unsigned maxLen = 0;
+    size_t treeSize, cSize, lhSize;
+    BoolInt singleStream;
+    Byte *p;
+
+    Huffman_Generate(counts, temp, lens, maxSym + 1, kHufLogMax);
+    {
+      UInt32 kraft = 0;
+      unsigned s;
+      for (s = 0; s <= maxSym; s++)
+        if (maxLen < lens[s])
+          maxLen = lens[s];
+      for (s = 0; s <= maxSym; s++)
+      {
+        weights[s] = 0;
+        if (counts[s] != 0)
+        {
+          weights[s] = (Byte)(maxLen + 1 - lens[s]);
+          kraft += (UInt32)1 << (maxLen - lens[s]);
+        }
+        else
+          lens[s] = 0;
+      }
+      if (kraft != ((UInt32)1 << maxLen))
+        return ZstdEnc_WriteLitRaw(dest, src, size);
+    }
+    {
+      /* canonical codes in the order that is used by decoder */
+      UInt32 rankStart[kHufLogMax + 2];
+      UInt32 next = 0;
+      unsigned w, s;
+      for (w = 1; w <= maxLen; w++)
+      {
+        UInt32 num = 0;
+        for (s = 0; s <= maxSym; s++)
+          num += (weights[s] == w);
+        rankStart[w] = next;
+        next += num << (w - 1);
+      }
+      for (s = 0; s <= maxSym; s++)
+      {
+        w = weights[s];
+        if (w != 0)
+        {
+          codes[s] = (UInt16)(rankStart[w] >> (w - 1));
+          rankStart[w] += (UInt32)1 << (w - 1);
+        }
+      }
+    }
+
+    singleStream = (size < 1024);
+    lhSize = 5;
+    p = dest + lhSize;
+    treeSize = Huf_WriteWeights(p, weights, maxSym);
+    if (treeSize == 0)
+      return ZstdEnc_WriteLitRaw(dest, src, size);
+    p += treeSize;
+    if (singleStream)
+      p += Huf_EncodeStream(p, src, size, codes, lens);
+    else
+    {
+      const size_t segSize = (size + 3) / 4;
+      Byte *jump = p;
+      unsigned k;
+      p += 6;
+      for (k = 0; k < 4; k++)
+      {
+        const size_t cur = (k == 3) ? size - segSize * 3 : segSize;
+        const size_t sSize = Huf_EncodeStream(p, src + segSize * k, cur, codes, lens);
+        if (k != 3)
+        {
+          if (sSize > 0xFFFF)
+            return ZstdEnc_WriteLitRaw(dest, src, size);
+          SetUi16(jump + k * 2, (UInt16)sSize)
+        }
+        p += sSize;
+      }
+    }
+    cSize = (size_t)(p - (dest + lhSize));
+
+    if (singleStream && cSize >= 1024)
+      return ZstdEnc_WriteLitRaw(dest, src, size);
+
+    {
+      unsigned sizeFormat;
+      UInt64 lhc;
+      if (size < 1024 && cSize < 1024)
+      {
+        lhSize = 3;
+        sizeFormat = singleStream ? 0 : 1;
+      }
+      else if (size < (1 << 14) && cSize < (1 << 14))
+      {
+        lhSize = 4;
+        sizeFormat = 2;
+      }
+      else
+      {
+        lhSize = 5;
+        sizeFormat = 3;
+      }
+      if (cSize + lhSize >= size + ZstdEnc_WriteLitHeader_Raw(p, size, 0))
+        return ZstdEnc_WriteLitRaw(dest, src, size);
+      lhc = 2 | (sizeFormat << 2) | ((UInt64)size << 4)
+          | ((UInt64)cSize << (lhSize == 3 ? 14 : lhSize == 4 ? 18 : 22));
+      memmove(dest + lhSize, dest + 5, cSize);
+      for (i = 0; i < lhSize; i++)
+        dest[i] = (Byte)(lhc >> (i * 8));
+      return lhSize + cSize;
+    }
+  }
+}
+
+
+/* ---------- sequences ---------- */
+
+#define SEQ_MODE_PREDEF  0
+#define SEQ_MODE_RLE     1
+#define SEQ_MODE_FSE     2
+
+/* it selects encoding mode for one sequence type and it writes the table description.
+   it returns the number of written bytes */
+
+static size_t ZstdEnc_SelectSeqMode(const Byte *codes, UInt32 numSeqs,
+    unsigned maxSymAllowed, unsigned maxLog,
+    const Int16 *predefNorm, unsigned predefMaxSym, unsigned predefLog,
+    CFseCTable *ct, unsigned *modeRes, Byte *dest)
+{
+  UInt32 counts[kFseSymMax + 1];
+  unsigned maxSym = 0, s;
+  UInt32 i;
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < numSeqs; i++)
+    counts[codes[i]]++;
+  for (s = 0; s <= maxSymAllowed; s++)
+    if (counts[s] != 0)
+      maxSym = s;
+
+  if (counts[codes[0]] == numSeqs)
+  {
+    *modeRes = SEQ_MODE_RLE;
+    dest[0] = codes[0];
+    return 1;
+  }
+  {
+    UInt64 predefCost = (UInt64)(Int64)-1;
+    UInt64 fseCost;
+    Int16 norm[kFseSymMax + 1];
+    const unsigned tableLog = Fse_OptimalTableLog(maxLog, numSeqs, maxSym);
+    size_t headerSize;
+
+    if (maxSym <= predefMaxSym)
+      predefCost = Fse_GetCost(counts, maxSym, predefNorm, predefLog);
+    Fse_Normalize(norm, tableLog, counts, numSeqs, maxSym);
+    headerSize = Fse_WriteNCount(dest, norm, maxSym, tableLog);
+    fseCost = Fse_GetCost(counts, maxSym, norm, tableLog) + ((UInt64)headerSize << (3 + 8));
+    if (predefCost <= fseCost)
+    {
+      *modeRes = SEQ_MODE_PREDEF;
+      return 0;
+    }
+    FseC_Build(ct, norm, maxSym + 1, tableLog);
+    *modeRes = SEQ_MODE_FSE;
+    return headerSize;
+  }
+}
+
+
+static size_t ZstdEnc_CompressSeqs(CZstdEncCoder *c, Byte *dest)
+{
+  const UInt32 numSeqs = c->numSeqs;
+  Byte *p = dest;
+  Byte *llCodes = c->codes;
+  Byte *mlCodes = c->codes + kSeqsMax;
+  Byte *ofCodes = c->codes + kSeqsMax * 2;
+  const CZstdSeq *seqs = c->seqs;
+  unsigned llMode, ofMode, mlMode;
+  const CFseCTable *llCT, *ofCT, *mlCT;
+  Byte *modesPos;
+  UInt32 i;
+
+  if (numSeqs < 128)
+    *p++ = (Byte)numSeqs;
+  else if (numSeqs < 0x7F00)
+  {
+    *p++ = (Byte)((numSeqs >> 8) + 0x80);
+    *p++ = (Byte)numSeqs;
+  }
+  else
+  {
+    *p++ = 0xFF;
+    SetUi16(p, (UInt16)(numSeqs - 0x7F00))
+    p += 2;
+  }
+  if (numSeqs == 0)
+    return (size_t)(p - dest);
+
+  for (i = 0; i < numSeqs; i++)
+  {
+    const CZstdSeq *seq = &seqs[i];
+    const UInt32 ll = seq->litLen;
+    const UInt32 ml = seq->matchLen - 3;
+    llCodes[i] = (ll < 64) ? c->llCodeTable[ll] : (Byte)(GetHighBit32(ll) + 19);
+    mlCodes[i] = (ml < 128) ? c->mlCodeTable[ml] : (Byte)(GetHighBit32(ml) + 36);
+    ofCodes[i] = (Byte)GetHighBit32(seq->offValue);
+  }
+
+  modesPos = p++;
+  p += ZstdEnc_SelectSeqMode(llCodes, numSeqs, kLL_SymMax, kLL_LogMax,
+      k_LL_Predef, kLL_SymMax, kLL_PredefLog, &c->ctLL, &llMode, p);
+  p += ZstdEnc_SelectSeqMode(ofCodes, numSeqs, kOF_SymMax, kOF_LogMax,
+      k_OF_Predef, kOF_PredefSymMax, kOF_PredefLog, &c->ctOF, &ofMode, p);
+  p += ZstdEnc_SelectSeqMode(mlCodes, numSeqs, kML_SymMax, kML_LogMax,
+      k_ML_Predef, kML_SymMax, kML_PredefLog, &c->ctML, &mlMode, p);
+  *modesPos = (Byte)((llMode << 6) | (ofMode << 4) | (mlMode << 2));
+
+  llCT = (llMode == SEQ_MODE_PREDEF) ? &c->llPredef : &c->ctLL;
+  ofCT = (ofMode == SEQ_MODE_PREDEF) ? &c->ofPredef : &c->ctOF;
+  mlCT = (mlMode == SEQ_MODE_PREDEF) ? &c->mlPredef : &c->ctML;
+
+  {
+    CBitW w;
+    UInt32 stLL = 0, stOF = 0, stML = 0;
+    i = numSeqs - 1;
+    BitW_Init(&w, p)
+    if (mlMode != SEQ_MODE_RLE)  stML = FseC_InitState(mlCT, mlCodes[i]);
+    if (ofMode != SEQ_MODE_RLE)  stOF = FseC_InitState(ofCT, ofCodes[i]);
+    if (llMode != SEQ_MODE_RLE)  stLL = FseC_InitState(llCT, llCodes[i]);
+    for (;;)
+    {
+      const CZstdSeq *seq = &seqs[i];
+      const unsigned llCode = llCodes[i];
+      const unsigned mlCode = mlCodes[i];
+      const unsigned ofCode = ofCodes[i];
+      BitW_Add(&w, seq->litLen - k_LL_Base[llCode], k_LL_Bits[llCode]);
+      BitW_Add(&w, seq->matchLen - k_ML_Base[mlCode], k_ML_Bits[mlCode]);
+      BitW_Add(&w, seq->offValue - ((UInt32)1 << ofCode), ofCode);
+      if (i == 0)
+        break;
+      i--;
+      if (ofMode != SEQ_MODE_RLE)  FseC_Encode(&w, ofCT, &stOF, ofCodes[i]);
+      if (mlMode != SEQ_MODE_RLE)  FseC_Encode(&w, mlCT, &stML, mlCodes[i]);
+      if (llMode != SEQ_MODE_RLE)  FseC_Encode(&w, llCT, &stLL, llCodes[i]);
+    }
+    if (mlMode != SEQ_MODE_RLE)  FseC_Flush(&w, mlCT, stML);
+    if (ofMode != SEQ_MODE_RLE)  FseC_Flush(&w, ofCT, stOF);
+    if (llMode != SEQ_MODE_RLE)  FseC_Flush(&w, llCT, stLL);
+    p = BitW_Close(&w);
+  }
+  return (size_t)(p - dest);
+}
+
+
+/* it writes the block with block header to (dest).
+   (dest) must contain at least (blockSize + 3) bytes.
+   it returns the size of written data */
+
+static size_t ZstdEncCoder_EncodeBlock(CZstdEncCoder *c, const Byte *base,
+    UInt32 blockStart, UInt32 blockSize, BoolInt lastBlock, Byte *dest)
+{
+  const Byte *src = base + blockStart;
+  size_t size = 0;
+  unsigned type = 0;
+
+  if (blockSize != 0)
+  {
+    if (blockSize > 1 && src[0] == src[blockSize - 1]
+        && memcmp(src, src + 1, blockSize - 1) == 0)
+      type = 1;
+    else if (blockSize >= 32)
+    {
+      UInt32 repsSaved[3];
+      repsSaved[0] = c->reps[0];
+      repsSaved[1] = c->reps[1];
+      repsSaved[2] = c->reps[2];
+      c->numSeqs = 0;
+      c->numLits = 0;
+      if (c->par.strategy == STRAT_FAST)
+        ZstdEnc_CompressBlock_Fast(c, base, blockStart, blockStart + blockSize);
+      else
+        ZstdEnc_CompressBlock_Lazy(c, base, blockStart, blockStart + blockSize,
+            (unsigned)c->par.strategy - STRAT_GREEDY);
+      size = ZstdEnc_CompressLiterals(c, c->blockBuf);
+      size += ZstdEnc_CompressSeqs(c, c->blockBuf + size);
+      if (size < blockSize)
+        type = 2;
+      else
+      {
+        c->reps[0] = repsSaved[0];
+        c->reps[1] = repsSaved[1];
+        c->reps[2] = repsSaved[2];
+      }
+    }
+  }
+
+  {
+    const UInt32 bh = (UInt32)lastBlock | ((UInt32)type << 1)
+        | ((UInt32)(type == 2 ? size : blockSize) << 3);
+    dest[0] = (Byte)bh;
+    dest[1] = (Byte)(bh >> 8);
+    dest[2] = (Byte)(bh >> 16);
+  }
+  if (type == 0)
+  {
+    memcpy(dest + 3, src, blockSize);
+    return 3 + (size_t)blockSize;
+  }
+  if (type == 1)
+  {
+    dest[3] = src[0];
+    return 4;
+  }
+  memcpy(dest + 3, c->blockBuf, size);
+  return 3 + size;
+}
+
+
+/* ---------- frame ---------- */
+
+#define kFrameHeaderSizeMax 14
+
+static size_t ZstdEnc_WriteFrameHeader(Byte *dest, unsigned windowLog, UInt64 contentSize, BoolInt checksumFlag)
+{
+  size_t pos = 5;
+  unsigned fcsFlag = 0;
+  unsigned single = 0;
+  SetUi32(dest, ZSTD_SIGNATURE)
+  if (contentSize != (UInt64)(Int64)-1)
+  {
+    if (contentSize <= ((UInt64)1 << windowLog))
+      single = 1;
+    if (contentSize < 256)
+      fcsFlag = 0;
+    else if (contentSize < (1 << 16) + 256)
+      fcsFlag = 1;
+    else if (contentSize <= 0xFFFFFFFF)
+      fcsFlag = 2;
+    else
+      fcsFlag = 3;
+  }
+  dest[4] = (Byte)((fcsFlag << 6) | (single << 5) | ((unsigned)(checksumFlag ? 1 : 0) << 2));
+  if (!single)
+    dest[pos++] = (Byte)((windowLog - 10) << 3);
+  if (contentSize != (UInt64)(Int64)-1)
+  {
+    if (fcsFlag == 0)
+      dest[pos++] = (Byte)contentSize;
+    else if (fcsFlag == 1)
+    {
+      SetUi16(dest + pos, (UInt16)(contentSize - 256))
+      pos += 2;
+    }
+    else if (fcsFlag == 2)
+    {
+      SetUi32(dest + pos, (UInt32)contentSize)
+      pos += 4;
+    }
+    else
+    {
+      SetUi64(dest + pos, contentSize)
+      pos += 8;
+    }
+  }
+  return pos;
+}
+
+
+static UInt32 ZstdEnc_GetBlockSizeMax(unsigned windowLog, UInt64 contentSize)
+{
+  if (contentSize != (UInt64)(Int64)-1 && contentSize <= ((UInt64)1 << windowLog))
+    return kBlockSizeMax;
+  if (windowLog < 17)
+    return (UInt32)1 << windowLog;
+  return kBlockSizeMax;
+}
+
+
+struct CZstdEnc
+{
+  ISzAllocPtr alloc;
+  ISzAllocPtr allocBig;
+  CZstdEncProps props;
+  CZstdLevelParams par;
+  UInt64 expectedDataSize;
+
+  Byte *inBuf;
+  size_t inBufSize;
+
+  #ifndef Z7_ST
+  ISeqOutStreamPtr outStream;
+  UInt64 outWritten;
+  size_t outBufSize;   /* size of allocated outBufs[i] */
+  size_t outBufsDataSizes[MTCODER_BLOCKS_MAX];
+  BoolInt mtCoder_WasConstructed;
+  CMtCoder mtCoder;
+  Byte *outBufs[MTCODER_BLOCKS_MAX];
+  #endif
+
+  CZstdEncCoder coders[MTCODER_THREADS_MAX];
+};
+
+
+CZstdEncHandle ZstdEnc_Create(ISzAllocPtr alloc, ISzAllocPtr allocBig)
+{
+  CZstdEnc *p = (CZstdEnc *)ISzAlloc_Alloc(alloc, sizeof(CZstdEnc));
+  if (!p)
+    return NULL;
+  ZstdEncProps_Init(&p->props);
+  ZstdEncProps_Normalize(&p->props);
+  p->expectedDataSize = (UInt64)(Int64)-1;
+  p->alloc = alloc;
+  p->allocBig = allocBig;
+  p->inBuf = NULL;
+  p->inBufSize = 0;
+  {
+    unsigned i;
+    for (i = 0; i < MTCODER_THREADS_MAX; i++)
+      ZstdEncCoder_Construct(&p->coders[i]);
+  }
+  #ifndef Z7_ST
+  p->mtCoder_WasConstructed = False;
+  {
+    unsigned i;
+    for (i = 0; i < MTCODER_BLOCKS_MAX; i++)
+      p->outBufs[i] = NULL;
+    p->outBufSize = 0;
+  }
+  #endif
+  return p;
+}
+
+
+#ifndef Z7_ST
+
+static void ZstdEnc_FreeOutBufs(CZstdEnc *p)
+{
+  unsigned i;
+  for (i = 0; i < MTCODER_BLOCKS_MAX; i++)
+    if (p->outBufs[i])
+    {
+      ISzAlloc_Free(p->alloc, p->outBufs[i]);
+      p->outBufs[i] = NULL;
+    }
+  p->outBufSize = 0;
+}
+
+#endif
+
+
+void ZstdEnc_Destroy(CZstdEncHandle p)
+{
+  unsigned i;
+  for (i = 0; i < MTCODER_THREADS_MAX; i++)
+    ZstdEncCoder_Free(&p->coders[i], p->alloc, p->allocBig);
+
+  #ifndef Z7_ST
+  if (p->mtCoder_WasConstructed)
+  {
+    MtCoder_Destruct(&p->mtCoder);
+    p->mtCoder_WasConstructed = False;
+  }
+  ZstdEnc_FreeOutBufs(p);
+  #endif
+
+  ISzAlloc_Free(p->allocBig, p->inBuf);
+  ISzAlloc_Free(p->alloc, p);
+}
+
+
+SRes ZstdEnc_SetProps(CZstdEncHandle p, const CZstdEncProps *props)
+{
+  CZstdEncProps props2 = *props;
+  if (props2.level > ZSTD_ENC_LEVEL_MAX
+      || props2.windowLog > ZSTD_ENC_WINDOW_LOG_MAX
+      || (props2.windowLog != 0 && props2.windowLog < ZSTD_ENC_WINDOW_LOG_MIN))
+    return SZ_ERROR_PARAM;
+  ZstdEncProps_Normalize(&props2);
+  p->props = props2;
+  return SZ_OK;
+}
+
+
+void ZstdEnc_SetDataSize(CZstdEncHandle p, UInt64 expectedDataSize)
+{
+  p->expectedDataSize = expectedDataSize;
+}
+
+
+static SRes ZstdEnc_Progress(ICompressProgressPtr progress, UInt64 inSize, UInt64 outSize)
+{
+  if (progress && ICompressProgress_Progress(progress, inSize, outSize) != SZ_OK)
+    return SZ_ERROR_PROGRESS;
+  return SZ_OK;
+}
+
+
+#define WRITE_STREAM(data, size) \
+  if (ISeqOutStream_Write(outStream, data, size) != size) return SZ_ERROR_WRITE;
+
+static SRes ZstdEnc_EncodeSt(CZstdEnc *p, ISeqOutStreamPtr outStream,
+    ISeqInStreamPtr inStream, ICompressProgressPtr progress)
+{
+  CZstdEncCoder *c = &p->coders[0];
+  const unsigned windowLog = p->props.windowLog;
+  const size_t windowSize = (size_t)1 << windowLog;
+  const size_t jobSize = (size_t)p->props.jobSize;
+  const BoolInt checksumFlag = (p->props.checksumFlag != 0);
+  CXxh64State xxh;
+  UInt64 inTotal = 0;
+  UInt64 outTotal = 0;
+  size_t prefix = 0;
+  size_t size;
+  BoolInt eof;
+  UInt32 blockSizeMax;
+
+  RINOK(ZstdEncCoder_Alloc(c, &p->par, p->alloc, p->allocBig))
+  {
+    const size_t bufSize = windowSize + jobSize + kInBufPad;
+    if (!p->inBuf || p->inBufSize != bufSize)
+    {
+      ISzAlloc_Free(p->allocBig, p->inBuf);
+      p->inBufSize = 0;
+      p->inBuf = (Byte *)ISzAlloc_Alloc(p->allocBig, bufSize);
+      if (!p->inBuf)
+        return SZ_ERROR_MEM;
+      p->inBufSize = bufSize;
+    }
+  }
+
+  size = jobSize;
+  RINOK(SeqInStream_ReadMax(inStream, p->inBuf, &size))
+  eof = (size != jobSize);
+
+  {
+    Byte header[kFrameHeaderSizeMax];
+    const UInt64 contentSize = eof ? (UInt64)size : (UInt64)(Int64)-1;
+    const size_t headerSize = ZstdEnc_WriteFrameHeader(header, windowLog, contentSize, checksumFlag);
+    WRITE_STREAM(header, headerSize)
+    outTotal += headerSize;
+    blockSizeMax = ZstdEnc_GetBlockSizeMax(windowLog, contentSize);
+  }
+
+  Xxh64State_Init(&xxh);
+  ZstdEncCoder_InitFrame(c);
+
+  for (;;)
+  {
+    size_t pos = prefix;
+    const size_t end = prefix + size;
+    ZstdEncCoder_StartJob(c, p->inBuf, prefix);
+    memset(p->inBuf + end, 0, kInBufPad);
+
+    while (pos != end)
+    {
+      size_t rem = end - pos;
+      size_t outSize;
+      if (rem > blockSizeMax)
+        rem = blockSizeMax;
+      outSize = ZstdEncCoder_EncodeBlock(c, p->inBuf, (UInt32)pos, (UInt32)rem,
+          eof && pos + rem == end, c->outBlock);
+      WRITE_STREAM(c->outBlock, outSize)
+      pos += rem;
+      inTotal += rem;
+      outTotal += outSize;
+      RINOK(ZstdEnc_Progress(progress, inTotal, outTotal))
+    }
+
+    if (checksumFlag)
+      Xxh64State_Update(&xxh, p->inBuf + prefix, size);
+
+    if (eof)
+    {
+      if (size == 0)
+      {
+        /* empty last block */
+        const Byte b[3] = { 1, 0, 0 };
+        WRITE_STREAM(b, 3)
+      }
+      break;
+    }
+
+    {
+      size_t keep = end;
+      if (keep > windowSize)
+        keep = windowSize;
+      memmove(p->inBuf, p->inBuf + end - keep, keep);
+      prefix = keep;
+    }
+    size = jobSize;
+    RINOK(SeqInStream_ReadMax(inStream, p->inBuf + prefix, &size))
+    eof = (size != jobSize);
+  }
+
+  if (checksumFlag)
+  {
+    Byte b[4];
+    SetUi32(b, (UInt32)Xxh64State_Digest(&xxh))
+    WRITE_STREAM(b, 4)
+  }
+  return SZ_OK;
+}
+
+
+#ifndef Z7_ST
+
+/* it encodes the data as independent frame. (dest) must be large enough */
+
+static SRes ZstdEnc_EncodeFrame(CZstdEnc *p, CZstdEncCoder *c,
+    const Byte *src, size_t srcSize, Byte *dest, size_t *destSize,
+    ICompressProgressPtr progress)
+{
+  const unsigned windowLog = p->props.windowLog;
+  const UInt32 blockSizeMax = ZstdEnc_GetBlockSizeMax(windowLog, srcSize);
+  size_t outPos, pos;
+
+  outPos = ZstdEnc_WriteFrameHeader(dest, windowLog, srcSize, p->props.checksumFlag != 0);
+  ZstdEncCoder_InitFrame(c);
+  ZstdEncCoder_StartJob(c, src, 0);
+
+  pos = 0;
+  do
+  {
+    size_t rem = srcSize - pos;
+    if (rem > blockSizeMax)
+      rem = blockSizeMax;
+    outPos += ZstdEncCoder_EncodeBlock(c, src, (UInt32)pos, (UInt32)rem,
+        pos + rem == srcSize, dest + outPos);
+    pos += rem;
+    RINOK(ZstdEnc_Progress(progress, pos, outPos))
+  }
+  while (pos != srcSize);
+
+  if (p->props.checksumFlag)
+  {
+    SetUi32(dest + outPos, (UInt32)Xxh64_Calc(src, srcSize))
+    outPos += 4;
+  }
+  *destSize = outPos;
+  return SZ_OK;
+}
+
+
+static SRes ZstdEnc_MtCallback_Code(void *pp, unsigned coderIndex, unsigned outBufIndex,
+    const Byte *src, size_t srcSize, int finished)
+{
+  CZstdEnc *me = (CZstdEnc *)pp;
+  CZstdEncCoder *c = &me->coders[coderIndex];
+  size_t destSize = 0;
+  SRes res;
+  CMtProgressThunk progressThunk;
+  Byte *dest = me->outBufs[outBufIndex];
+
+  UNUSED_VAR(finished)
+
+  me->outBufsDataSizes[outBufIndex] = 0;
+  if (srcSize == 0)
+    return SZ_OK;
+
+  if (!dest)
+  {
+    dest = (Byte *)ISzAlloc_Alloc(me->alloc, me->outBufSize);
+    if (!dest)
+      return SZ_ERROR_MEM;
+    me->outBufs[outBufIndex] = dest;
+  }
+
+  RINOK(ZstdEncCoder_Alloc(c, &me->par, me->alloc, me->allocBig))
+
+  MtProgressThunk_CreateVTable(&progressThunk);
+  progressThunk.mtProgress = &me->mtCoder.mtProgress;
+  MtProgressThunk_INIT(&progressThunk)
+
+  res = ZstdEnc_EncodeFrame(me, c, src, srcSize, dest, &destSize, &progressThunk.vt);
+
+  me->outBufsDataSizes[outBufIndex] = destSize;
+  return res;
+}
+
+
+static SRes ZstdEnc_MtCallback_Write(void *pp, unsigned outBufIndex)
+{
+  CZstdEnc *me = (CZstdEnc *)pp;
+  const size_t size = me->outBufsDataSizes[outBufIndex];
+  if (size == 0)
+    return SZ_OK;
+  me->outWritten += size;
+  return ISeqOutStream_Write(me->outStream, me->outBufs[outBufIndex], size) == size ?
+      SZ_OK : SZ_ERROR_WRITE;
+}
+
+#endif
+
+
+SRes ZstdEnc_Encode(CZstdEncHandle p,
+    ISeqOutStreamPtr outStream,
+    ISeqInStreamPtr inStream,
+    ICompressProgressPtr progress)
+{
+  {
+    CZstdEncProps props = p->props;
+    props.expectedDataSize = p->expectedDataSize;
+    ZstdEncProps_NormalizeFull(&props);
+    p->props.windowLog = props.windowLog;
+    p->props.jobSize = props.jobSize;
+    ZstdEncProps_GetParams(&p->props, &p->par);
+  }
+
+  #ifndef Z7_ST
+
+  if (p->props.nbWorkers != 0)
+  {
+    IMtCoderCallback2 vt;
+
+    if (!p->mtCoder_WasConstructed)
+    {
+      p->mtCoder_WasConstructed = True;
+      MtCoder_Construct(&p->mtCoder);
+    }
+
+    vt.Code = ZstdEnc_MtCallback_Code;
+    vt.Write = ZstdEnc_MtCallback_Write;
+
+    p->outStream = outStream;
+    p->outWritten = 0;
+
+    p->mtCoder.allocBig = p->allocBig;
+    p->mtCoder.progress = progress;
+    p->mtCoder.inStream = inStream;
+    p->mtCoder.inData = NULL;
+    p->mtCoder.inDataSize = 0;
+    p->mtCoder.mtCallback = &vt;
+    p->mtCoder.mtCallbackObject = p;
+
+    p->mtCoder.blockSize = (size_t)p->props.jobSize;
+    if (p->mtCoder.blockSize != p->props.jobSize)
+      return SZ_ERROR_PARAM; /* SZ_ERROR_MEM */
+
+    {
+      const size_t blockSize = p->mtCoder.blockSize;
+      const size_t destBlockSize = blockSize + (blockSize / kBlockSizeMax + 1) * 3
+          + kFrameHeaderSizeMax + 4 + kInBufPad;
+      if (destBlockSize < blockSize)
+        return SZ_ERROR_PARAM;
+      if (p->outBufSize != destBlockSize)
+        ZstdEnc_FreeOutBufs(p);
+      p->outBufSize = destBlockSize;
+    }
+
+    p->mtCoder.numThreadsMax = (unsigned)p->props.nbWorkers;
+    p->mtCoder.expectedDataSize = p->expectedDataSize;
+
+    RINOK(MtCoder_Code(&p->mtCoder))
+    if (p->outWritten != 0)
+      return SZ_OK;
+    {
+      /* empty stream: we write one empty frame */
+      Byte frame[kFrameHeaderSizeMax + 3 + 4];
+      size_t size;
+      const Byte empty = 0;
+      RINOK(ZstdEncCoder_Alloc(&p->coders[0], &p->par, p->alloc, p->allocBig))
+      RINOK(ZstdEnc_EncodeFrame(p, &p->coders[0], &empty, 0, frame, &size, NULL))
+      WRITE_STREAM(frame, size)
+      return SZ_OK;
+    }
+  }
+
+  #endif
+
+  return ZstdEnc_EncodeSt(p, outStream, inStream, progress);
+}
@@ -0,0 +1,83 @@
+/* ZstdEnc.h -- Zstandard encoder
+2026-10-18 : yhnmj6666/7z contributors : Public domain */
+
+#ifndef ZIP7_INC_ZSTD_ENC_H
+#define ZIP7_INC_ZSTD_ENC_H
+
+#include "7zTypes.h"
+
+EXTERN_C_BEGIN
+
+#define ZSTD_ENC_LEVEL_MIN  1
+#define ZSTD_ENC_LEVEL_MAX  22
+#define ZSTD_ENC_LEVEL_DEFAULT  3
+
+#define ZSTD_ENC_WINDOW_LOG_MIN  10
+#define ZSTD_ENC_WINDOW_LOG_MAX  27
+
+/* the maximum number of threads (workers) in multithreaded mode */
+#ifdef Z7_ST
+  #define MY_ZSTDMT_NBWORKERS_MAX  1
+#else
+  #define MY_ZSTDMT_NBWORKERS_MAX  64
+#endif
+
+#define ZSTD_ENC_JOB_SIZE_MIN  ((UInt32)1 << 20)
+#define ZSTD_ENC_JOB_SIZE_MAX  ((UInt32)1 << 30)
+
+typedef struct
+{
+  int level;            /* [1, 22], default = 3 */
+  unsigned windowLog;   /* [10, 27], (0) : default for level */
+  UInt32 nbWorkers;     /* (0) : single-threaded mode : single frame
+                           (1 ... MY_ZSTDMT_NBWORKERS_MAX) : multithreaded mode :
+                             each job is encoded to independent frame */
+  UInt64 jobSize;       /* the size of input data for one job, (0) : default */
+  int checksumFlag;     /* (1) : write XXH64 content checksum (default) */
+  UInt64 expectedDataSize; /* (UInt64)(Int64)-1 : unknown */
+} CZstdEncProps;
+
+void ZstdEncProps_Init(CZstdEncProps *p);
+
+/* ZstdEncProps_Normalize() sets default values for the parameters of level */
+void ZstdEncProps_Normalize(CZstdEncProps *p);
+
+/* ZstdEncProps_NormalizeFull() also sets (jobSize) and reduces window via (expectedDataSize) */
+void ZstdEncProps_NormalizeFull(CZstdEncProps *p);
+
+/* ZstdEncProps_GetMemUsage() returns the estimated memory usage for normalized props */
+UInt64 ZstdEncProps_GetMemUsage(const CZstdEncProps *p);
+
+/* ZstdEncProps_GetNumThreads_for_MemUsageLimit()
+   returns the number of workers that is allowed by (memLimit),
+   (numThreads) is the maximum number of threads */
+UInt32 ZstdEncProps_GetNumThreads_for_MemUsageLimit(const CZstdEncProps *p,
+    UInt64 memLimit, UInt32 numThreads);
+
+
+/* ZstdEnc_* functions can return the following exit codes:
+SRes:
+  SZ_OK           - OK
+  SZ_ERROR_MEM    - Memory allocation error
+  SZ_ERROR_PARAM  - Incorrect paramater in props
+  SZ_ERROR_WRITE  - ISeqOutStream write callback error
+  SZ_ERROR_READ   - ISeqInStream read callback error
+  SZ_ERROR_PROGRESS - some break from progress callback
+  SZ_ERROR_THREAD - error in multithreading functions (only for Mt version)
+*/
+
+typedef struct CZstdEnc CZstdEnc;
+typedef CZstdEnc * CZstdEncHandle;
+
+CZstdEncHandle ZstdEnc_Create(ISzAllocPtr alloc, ISzAllocPtr allocBig);
+void ZstdEnc_Destroy(CZstdEncHandle p);
+SRes ZstdEnc_SetProps(CZstdEncHandle p, const CZstdEncProps *props);
+void ZstdEnc_SetDataSize(CZstdEncHandle p, UInt64 expectedDataSize);
+SRes ZstdEnc_Encode(CZstdEncHandle p,
+    ISeqOutStreamPtr outStream,
+    ISeqInStreamPtr inStream,
+    ICompressProgressPtr progress);
+
+EXTERN_C_END
+
+#endif
@@ -244,6 +244,8 @@ $O/LzmaAlone.o: LzmaAlone.cpp
 	$(CXX) $(CXXFLAGS) $<
 
 
+$O/Blake3Reg.o: ../../../Common/Blake3Reg.cpp
+	$(CXX) $(CXXFLAGS) $<
 $O/CommandLineParser.o: ../../../Common/CommandLineParser.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/CRC.o: ../../../Common/CRC.cpp
@@ -286,6 +288,10 @@ $O/Sha256Prepare.o: ../../../Common/Sha256Prepare.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/Sha256Reg.o: ../../../Common/Sha256Reg.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/Sha512Prepare.o: ../../../Common/Sha512Prepare.cpp
+	$(CXX) $(CXXFLAGS) $<
+$O/Sha512Reg.o: ../../../Common/Sha512Reg.cpp
+	$(CXX) $(CXXFLAGS) $<
 $O/StdInStream.o: ../../../Common/StdInStream.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/StdOutStream.o: ../../../Common/StdOutStream.cpp
@@ -304,6 +310,10 @@ $O/XzCrc64Init.o: ../../../Common/XzCrc64Init.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/XzCrc64Reg.o: ../../../Common/XzCrc64Reg.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/Xxh3Reg.o: ../../../Common/Xxh3Reg.cpp
+	$(CXX) $(CXXFLAGS) $<
+$O/Xxh64Reg.o: ../../../Common/Xxh64Reg.cpp
+	$(CXX) $(CXXFLAGS) $<
 
 
 
@@ -536,6 +546,8 @@ $O/XzHandler.o: ../../Archive/XzHandler.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/ZHandler.o: ../../Archive/ZHandler.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/ZstdHandler.o: ../../Archive/ZstdHandler.cpp
+	$(CXX) $(CXXFLAGS) $<
 
 
 $O/7zCompressionMode.o: ../../Archive/7z/7zCompressionMode.cpp
@@ -691,6 +703,8 @@ $O/Deflate64Register.o: ../../Compress/Deflate64Register.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/DeflateDecoder.o: ../../Compress/DeflateDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/DeflateDecoderMt.o: ../../Compress/DeflateDecoderMt.cpp
+	$(CXX) $(CXXFLAGS) $<
 $O/DeflateEncoder.o: ../../Compress/DeflateEncoder.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/DeflateRegister.o: ../../Compress/DeflateRegister.cpp
@@ -705,6 +719,10 @@ $O/ImplodeDecoder.o: ../../Compress/ImplodeDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/ImplodeHuffmanDecoder.o: ../../Compress/ImplodeHuffmanDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/LdmCoder.o: ../../Compress/LdmCoder.cpp
+	$(CXX) $(CXXFLAGS) $<
+$O/LdmRegister.o: ../../Compress/LdmRegister.cpp
+	$(CXX) $(CXXFLAGS) $<
 $O/LzfseDecoder.o: ../../Compress/LzfseDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/LzhDecoder.o: ../../Compress/LzhDecoder.cpp
@@ -759,6 +777,14 @@ $O/XzEncoder.o: ../../Compress/XzEncoder.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/ZDecoder.o: ../../Compress/ZDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
+$O/ZstdDecoder.o: ../../Compress/ZstdDecoder.cpp
+	$(CXX) $(CXXFLAGS) $<
+$O/ZstdEncoder.o: ../../Compress/ZstdEncoder.cpp
+	$(CXX) $(CXXFLAGS) $<
+$O/ZstdEncoderProps.o: ../../Compress/ZstdEncoderProps.cpp
+	$(CXX) $(CXXFLAGS) $<
+$O/ZstdRegister.o: ../../Compress/ZstdRegister.cpp
+	$(CXX) $(CXXFLAGS) $<
 $O/ZlibDecoder.o: ../../Compress/ZlibDecoder.cpp
 	$(CXX) $(CXXFLAGS) $<
 $O/ZlibEncoder.o: ../../Compress/ZlibEncoder.cpp
@@ -1095,6 +1121,8 @@ $O/7zBuf2.o: ../../../../C/7zBuf2.c
 	$(CC) $(CFLAGS) $<
 $O/7zCrc.o: ../../../../C/7zCrc.c
 	$(CC) $(CFLAGS) $<
+$O/CrcFold.o: ../../../../C/CrcFold.c
+	$(CC) $(CFLAGS) $<
 $O/7zDec.o: ../../../../C/7zDec.c
 	$(CC) $(CFLAGS) $<
 $O/7zFile.o: ../../../../C/7zFile.c
@@ -1111,6 +1139,8 @@ $O/Bcj2Enc.o: ../../../../C/Bcj2Enc.c
 	$(CC) $(CFLAGS) $<
 $O/Blake2s.o: ../../../../C/Blake2s.c
 	$(CC) $(CFLAGS) $<
+$O/Blake3.o: ../../../../C/Blake3.c
+	$(CC) $(CFLAGS) $<
 $O/Bra.o: ../../../../C/Bra.c
 	$(CC) $(CFLAGS) $<
 $O/Bra86.o: ../../../../C/Bra86.c
@@ -1175,6 +1205,10 @@ $O/Sha1.o: ../../../../C/Sha1.c
 	$(CC) $(CFLAGS) $<
 $O/Sha256.o: ../../../../C/Sha256.c
 	$(CC) $(CFLAGS) $<
+$O/Sha512.o: ../../../../C/Sha512.c
+	$(CC) $(CFLAGS) $<
+$O/Sha512Opt.o: ../../../../C/Sha512Opt.c
+	$(CC) $(CFLAGS) $<
 $O/Sort.o: ../../../../C/Sort.c
 	$(CC) $(CFLAGS) $<
 $O/SwapBytes.o: ../../../../C/SwapBytes.c
@@ -1189,6 +1223,14 @@ $O/XzEnc.o: ../../../../C/XzEnc.c
 	$(CC) $(CFLAGS) $<
 $O/XzIn.o: ../../../../C/XzIn.c
 	$(CC) $(CFLAGS) $<
+$O/Xxh3.o: ../../../../C/Xxh3.c
+	$(CC) $(CFLAGS) $<
+$O/Xxh64.o: ../../../../C/Xxh64.c
+	$(CC) $(CFLAGS) $<
+$O/ZstdDec.o: ../../../../C/ZstdDec.c
+	$(CC) $(CFLAGS) $<
+$O/ZstdEnc.o: ../../../../C/ZstdEnc.c
+	$(CC) $(CFLAGS) $<
 
 
 ifdef USE_ASM
@@ -397,6 +397,14 @@ HRESULT CDecoder::Decode(
         }
       }
     }
+    else
+    {
+      // the coder that follows multithreaded coder (LDM) also needs memory limit
+      Z7_DECL_CMyComPtr_QI_FROM(ICompressSetMemLimit,
+          setMemLimit, decoder)
+      if (setMemLimit)
+        RINOK(setMemLimit->SetMemLimit(memUsage))
+    }
     #endif
 
     {
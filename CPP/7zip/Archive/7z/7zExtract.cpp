@@ -3,10 +3,14 @@
 #include "StdAfx.h"
 
 #include "../../../../C/7zCrc.h"
+#include "../../../../C/CpuArch.h"
 
 #include "../../../Common/ComTry.h"
 
+#include "../../Common/LimitedStreams.h"
 #include "../../Common/ProgressUtils.h"
+#include "../../Common/StreamObjects.h"
+#include "../../Common/StreamUtils.h"
 
 #include "7zDecode.h"
 #include "7zHandler.h"
@@ -226,6 +230,747 @@ Z7_COM7F_IMF(CFolderOutStream::GetSubStreamSize(UInt64 subStream, UInt64 *value)
 */
 
 
+/*
+CDupOutStream writes the data of source files to duplicate files.
+It gets the unpacked data of the folder that contains the source files.
+The source files of duplicate files must be in increasing order in folder.
+If next duplicate file uses same source file, CDupOutStream keeps
+the data of source file in buffer, and it writes next duplicate file from buffer.
+*/
+
+static const UInt64 kDupBufSizeMax = (UInt64)1 << 26;
+
+Z7_CLASS_IMP_COM_1(
+  CDupOutStream
+  , ISequentialOutStream
+)
+  CMyComPtr<ISequentialOutStream> _stream;
+public:
+  bool TestMode;
+  bool CheckCrc;
+private:
+  bool _fileIsOpen;
+  bool _calcCrc;
+  bool _fillBuf;
+  UInt32 _crc;
+  UInt64 _rem;
+  UInt64 _pos;          // the position in unpacked data of folder
+  UInt32 _nextFile;     // the file in folder that starts at position (_nextFilePos)
+  UInt64 _nextFilePos;
+  UInt32 _bufSource;    // the source file that was written to (_buf)
+  size_t _bufSize;
+  CByteBuffer _buf;
+
+  const UInt32 *_indexes;
+  unsigned _numFiles;
+
+  UInt32 GetSource() const { return _db->DupSource.Vals[*_indexes]; }
+  UInt64 GetSourcePos(UInt32 src);
+  HRESULT OpenFile(bool isCorrupted = false);
+  HRESULT CloseFile_and_SetResult(Int32 res);
+  HRESULT CloseFile();
+  HRESULT WriteToFile(const void *data, UInt32 size, UInt32 &processed);
+  HRESULT ProcessFilesWithoutStream();
+
+public:
+  const CDbEx *_db;
+  CMyComPtr<IArchiveExtractCallback> ExtractCallback;
+
+  CDupOutStream():
+      TestMode(false),
+      CheckCrc(true)
+      {}
+
+  HRESULT Init(const UInt32 *indexes, unsigned numFiles);
+  HRESULT FlushCorrupted(Int32 callbackOperationResult);
+
+  bool WasWritingFinished() const { return _numFiles == 0; }
+};
+
+
+HRESULT CDupOutStream::Init(const UInt32 *indexes, unsigned numFiles)
+{
+  _indexes = indexes;
+  _numFiles = numFiles;
+  
+  _fileIsOpen = false;
+  _pos = 0;
+  _nextFile = _db->FolderStartFileIndex[_db->FileIndexToFolderIndexMap[GetSource()]];
+  _nextFilePos = 0;
+  _bufSource = (UInt32)(Int32)-1;
+  _bufSize = 0;
+  
+  return ProcessFilesWithoutStream();
+}
+
+UInt64 CDupOutStream::GetSourcePos(UInt32 src)
+{
+  for (; _nextFile < src; _nextFile++)
+    _nextFilePos += _db->Files[_nextFile].Size;
+  return _nextFilePos;
+}
+
+HRESULT CDupOutStream::OpenFile(bool isCorrupted)
+{
+  const UInt32 src = GetSource();
+  const CFileItem &fi = _db->Files[src];
+  Int32 askMode = TestMode ?
+      NExtract::NAskMode::kTest :
+      NExtract::NAskMode::kExtract;
+
+  if (isCorrupted && askMode == NExtract::NAskMode::kExtract)
+    askMode = NExtract::NAskMode::kTest;
+  
+  CMyComPtr<ISequentialOutStream> realOutStream;
+  RINOK(ExtractCallback->GetStream(*_indexes, &realOutStream, askMode))
+  
+  _stream = realOutStream;
+  _crc = CRC_INIT_VAL;
+  _calcCrc = (CheckCrc && fi.CrcDefined);
+
+  _fileIsOpen = true;
+  _rem = fi.Size;
+
+  _fillBuf = false;
+  if (!isCorrupted
+      && src != _bufSource
+      && _numFiles > 1
+      && _db->DupSource.Vals[_indexes[1]] == src
+      && fi.Size <= kDupBufSizeMax)
+  {
+    if (_buf.Size() < fi.Size)
+      _buf.Alloc((size_t)fi.Size);
+    _bufSource = src;
+    _bufSize = 0;
+    _fillBuf = true;
+  }
+  
+  if (askMode == NExtract::NAskMode::kExtract && !realOutStream)
+    askMode = NExtract::NAskMode::kSkip;
+  return ExtractCallback->PrepareOperation(askMode);
+}
+
+HRESULT CDupOutStream::CloseFile_and_SetResult(Int32 res)
+{
+  _stream.Release();
+  _fileIsOpen = false;
+  _indexes++;
+  _numFiles--;
+  return ExtractCallback->SetOperationResult(res);
+}
+
+HRESULT CDupOutStream::CloseFile()
+{
+  const CFileItem &fi = _db->Files[GetSource()];
+  return CloseFile_and_SetResult((!_calcCrc || fi.Crc == CRC_GET_DIGEST(_crc)) ?
+      NExtract::NOperationResult::kOK :
+      NExtract::NOperationResult::kCRCError);
+}
+
+HRESULT CDupOutStream::WriteToFile(const void *data, UInt32 size, UInt32 &processed)
+{
+  UInt32 cur = (size < _rem ? size : (UInt32)_rem);
+  HRESULT result = S_OK;
+  if (_stream)
+    result = _stream->Write(data, cur, &cur);
+  if (_calcCrc)
+    _crc = CrcUpdate(_crc, data, cur);
+  if (_fillBuf)
+  {
+    memcpy(_buf + _bufSize, data, cur);
+    _bufSize += cur;
+  }
+  _rem -= cur;
+  processed = cur;
+  return result;
+}
+
+// it writes the files that don't need new data from folder: empty files and files from buffer
+HRESULT CDupOutStream::ProcessFilesWithoutStream()
+{
+  while (_numFiles != 0)
+  {
+    const UInt32 src = GetSource();
+    const UInt64 size = _db->Files[src].Size;
+    if (size != 0 && (src != _bufSource || _bufSize != size))
+      break;
+    RINOK(OpenFile())
+    size_t pos = 0;
+    while (_rem != 0)
+    {
+      const UInt32 k_Step = (UInt32)1 << 20;
+      UInt32 cur = (_rem < k_Step ? (UInt32)_rem : k_Step);
+      RINOK(WriteToFile(_buf + pos, cur, cur))
+      if (cur == 0)
+        return E_FAIL;
+      pos += cur;
+    }
+    RINOK(CloseFile())
+  }
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CDupOutStream::Write(const void *data, UInt32 size, UInt32 *processedSize))
+{
+  if (processedSize)
+    *processedSize = 0;
+  
+  while (size != 0)
+  {
+    UInt32 cur;
+    
+    if (_fileIsOpen)
+    {
+      const HRESULT result = WriteToFile(data, size, cur);
+      if (processedSize)
+        *processedSize += cur;
+      data = (const Byte *)data + cur;
+      size -= cur;
+      _pos += cur;
+      if (_rem == 0)
+      {
+        RINOK(CloseFile())
+        RINOK(ProcessFilesWithoutStream())
+      }
+      RINOK(result)
+      if (cur == 0)
+        break;
+      continue;
+    }
+    
+    if (_numFiles == 0)
+      return k_My_HRESULT_WritingWasCut;
+
+    const UInt64 start = GetSourcePos(GetSource());
+    if (_pos > start)
+    {
+      // the data of source file was not buffered
+      RINOK(OpenFile(true))
+      RINOK(CloseFile_and_SetResult(NExtract::NOperationResult::kDataError))
+      RINOK(ProcessFilesWithoutStream())
+      continue;
+    }
+    if (_pos == start)
+    {
+      RINOK(OpenFile())
+      continue;
+    }
+    
+    // we skip the data before source file
+    cur = size;
+    if (cur > start - _pos)
+      cur = (UInt32)(start - _pos);
+    if (processedSize)
+      *processedSize += cur;
+    data = (const Byte *)data + cur;
+    size -= cur;
+    _pos += cur;
+  }
+  
+  return S_OK;
+}
+
+HRESULT CDupOutStream::FlushCorrupted(Int32 callbackOperationResult)
+{
+  while (_numFiles != 0)
+  {
+    if (_fileIsOpen)
+    {
+      RINOK(CloseFile_and_SetResult(callbackOperationResult))
+    }
+    else
+    {
+      RINOK(OpenFile(true))
+    }
+  }
+  return S_OK;
+}
+
+
+#ifndef Z7_SFX
+
+void CFolderCache::Delete(unsigned index)
+{
+  _size -= _items[index].Data.Size();
+  _items.Delete(index);
+}
+
+bool CFolderCache::FreeSpace(UInt64 size)
+{
+  if (size > MaxSize)
+    return false;
+  // we remove the least recently used items
+  while (_size > MaxSize - size)
+  {
+    unsigned best = 0;
+    for (unsigned i = 1; i < _items.Size(); i++)
+      if (_items[i].LastUse < _items[best].LastUse)
+        best = i;
+    Delete(best);
+  }
+  return true;
+}
+
+void CFolderCache::SetMaxSize(UInt64 maxSize)
+{
+  MaxSize = maxSize;
+  FreeSpace(0);
+}
+
+const CByteBuffer *CFolderCache::Find(CNum folderIndex)
+{
+  FOR_VECTOR (i, _items)
+  {
+    CFolderCacheItem &item = _items[i];
+    if (item.FolderIndex == folderIndex)
+    {
+      item.LastUse = ++_useCounter;
+      return &item.Data;
+    }
+  }
+  return NULL;
+}
+
+CByteBuffer *CFolderCache::AllocItem(CNum folderIndex, UInt64 size)
+{
+  DeleteItem(folderIndex);
+  if (size == 0 || size != (size_t)size || !FreeSpace(size))
+    return NULL;
+  CFolderCacheItem &item = _items.AddNew();
+  try
+  {
+    item.Data.Alloc((size_t)size);
+  }
+  catch(...)
+  {
+    _items.DeleteBack();
+    return NULL;
+  }
+  item.FolderIndex = folderIndex;
+  item.LastUse = ++_useCounter;
+  _size += size;
+  return &item.Data;
+}
+
+void CFolderCache::DeleteItem(CNum folderIndex)
+{
+  FOR_VECTOR (i, _items)
+    if (_items[i].FolderIndex == folderIndex)
+    {
+      Delete(i);
+      return;
+    }
+}
+
+bool CHandler::SetFolderCacheProperty(const UString &name, const PROPVARIANT &value, HRESULT &hres)
+{
+  hres = S_OK;
+  if (!name.IsPrefixedBy_Ascii_NoCase("cache"))
+    return false;
+  UInt64 v;
+  if (!ParseSizeString(name.Ptr(5), value, _memAvail, v))
+    hres = E_INVALIDARG;
+  else
+    _folderCache.SetMaxSize(v);
+  return true;
+}
+
+
+/* CFolderCacheOutStream copies the unpacked data of folder to the buffer of cache,
+   and it passes the data to (Stream). If (Stream) doesn't need more data,
+   it continues to fill the buffer, so the full folder can be stored in cache. */
+
+Z7_CLASS_IMP_COM_1(
+  CFolderCacheOutStream
+  , ISequentialOutStream
+)
+public:
+  CMyComPtr<ISequentialOutStream> Stream;
+  Byte *Buf;
+  size_t Size;
+  size_t Pos;
+};
+
+Z7_COM7F_IMF(CFolderCacheOutStream::Write(const void *data, UInt32 size, UInt32 *processedSize))
+{
+  if (processedSize)
+    *processedSize = 0;
+  size_t cur = Size - Pos;
+  if (cur > size)
+    cur = size;
+  memcpy(Buf + Pos, data, cur);
+  Pos += cur;
+  if (Stream)
+  {
+    const HRESULT res = WriteStream(Stream, data, size);
+    if (res == k_My_HRESULT_WritingWasCut)
+      Stream.Release();
+    else
+      RINOK(res)
+  }
+  if (processedSize)
+    *processedSize = size;
+  return S_OK;
+}
+
+#endif
+
+
+/* GetNumSolidFiles() returns the number of items from (indices), starting from item (i),
+   that can be extracted in one pass of folder decoding.
+   (unpackSize) is the size of data from the start of folder to the end of last such item.
+   (indices == NULL) means all files mode. */
+
+static UInt32 GetNumSolidFiles(const CDbEx &db, const UInt32 *indices, UInt32 numItems, UInt32 i, UInt64 &unpackSize)
+{
+  unpackSize = 0;
+  const UInt32 fileIndex = indices ? indices[i] : i;
+  const CNum folderIndex = db.FileIndexToFolderIndexMap[fileIndex];
+  if (folderIndex == kNumNoIndex)
+    return 1;
+  UInt32 nextFile = fileIndex + 1;
+  UInt32 k;
+  for (k = i + 1; k < numItems; k++)
+  {
+    const UInt32 fileIndex2 = indices ? indices[k] : k;
+    if (db.FileIndexToFolderIndexMap[fileIndex2] != folderIndex
+        || fileIndex2 < nextFile)
+      break;
+    nextFile = fileIndex2 + 1;
+  }
+  for (UInt32 f = db.FolderStartFileIndex[folderIndex]; f < nextFile; f++)
+    unpackSize += db.Files[f].Size;
+  return k - i;
+}
+
+
+/* GetNumDupFiles() returns the number of duplicate items from (indices), starting from item (i),
+   that can be extracted in one pass of decoding of the folder that contains source files.
+   (unpackSize) is the size of data from the start of folder to the end of last source file.
+   (dataSize) is the total size of data of these duplicate items. */
+
+static UInt32 GetNumDupFiles(const CDbEx &db, const UInt32 *indices, UInt32 numItems, UInt32 i,
+    UInt64 &unpackSize, UInt64 &dataSize)
+{
+  const UInt32 fileIndex = indices ? indices[i] : i;
+  UInt32 src = db.DupSource.Vals[fileIndex];
+  const CNum folderIndex = db.FileIndexToFolderIndexMap[src];
+  dataSize = db.Files[src].Size;
+  UInt32 k;
+  for (k = i + 1; k < numItems; k++)
+  {
+    const UInt32 fileIndex2 = indices ? indices[k] : k;
+    if (!db.IsItemDup(fileIndex2))
+      break;
+    const UInt32 src2 = db.DupSource.Vals[fileIndex2];
+    if (db.FileIndexToFolderIndexMap[src2] != folderIndex
+        || src2 < src
+        || (src2 == src && db.Files[src].Size > kDupBufSizeMax))
+      break;
+    src = src2;
+    dataSize += db.Files[src].Size;
+  }
+  unpackSize = 0;
+  for (UInt32 f = db.FolderStartFileIndex[folderIndex]; f <= src; f++)
+    unpackSize += db.Files[f].Size;
+  return k - i;
+}
+
+
+template <class TOutStream>
+static HRESULT SetFolderResult(TOutStream *folderOutStream,
+    IArchiveExtractCallbackMessage2 *callbackMessage,
+    CNum folderIndex, HRESULT result, bool dataAfterEnd_Error)
+{
+  if (result == S_FALSE || result == E_NOTIMPL || dataAfterEnd_Error)
+  {
+    const bool wasFinished = folderOutStream->WasWritingFinished();
+    
+    int resOp = NExtract::NOperationResult::kDataError;
+    
+    if (result != S_FALSE)
+    {
+      if (result == E_NOTIMPL)
+        resOp = NExtract::NOperationResult::kUnsupportedMethod;
+      else if (wasFinished && dataAfterEnd_Error)
+        resOp = NExtract::NOperationResult::kDataAfterEnd;
+    }
+    
+    RINOK(folderOutStream->FlushCorrupted(resOp))
+    
+    if (wasFinished)
+    {
+      // we don't show error, if it's after required files
+      if (/* !folderOutStream->ExtraWriteWasCut && */ callbackMessage)
+      {
+        RINOK(callbackMessage->ReportExtractResult(NEventIndexType::kBlockIndex, folderIndex, resOp))
+      }
+    }
+    return S_OK;
+  }
+  
+  if (result != S_OK)
+    return result;
+  
+  return folderOutStream->FlushCorrupted(NExtract::NOperationResult::kDataError);
+}
+
+
+#ifdef Z7_7Z_EXTRACT_MT
+
+/*
+In multithreaded mode Extract() unpacks several folders in parallel.
+CMtExtractor looks ahead in the list of items and it starts the jobs that
+unpack the folders to memory buffers. The main thread passes the data of
+each folder to CFolderOutStream in original order, so the order of calls
+of IArchiveExtractCallback is the same as in single-thread mode.
+The folder is unpacked by main thread without buffering, if it's encrypted
+or if its unpacked data and decoder don't fit into memory usage limit.
+*/
+
+static const UInt32 kNumMtExtractJobsMax = 64;
+
+// it returns the estimated size of memory that is allocated by decoders of folder
+static UInt64 GetFolderDecoderMemUsage(const CDbEx &db, CNum folderIndex)
+{
+  CFolder folder;
+  db.ParseFolderInfo(folderIndex, folder);
+  UInt64 mem = 0;
+  FOR_VECTOR (i, folder.Coders)
+  {
+    const CCoderInfo &coder = folder.Coders[i];
+    const Byte *props = coder.Props;
+    const size_t propsSize = coder.Props.Size();
+    UInt64 cur = (UInt64)1 << 22;
+    if ((coder.MethodID == k_LZMA || coder.MethodID == k_PPMD) && propsSize >= 5)
+      cur += GetUi32(props + 1);
+    else if (coder.MethodID == k_LZMA2 && propsSize >= 1)
+    {
+      const unsigned d = props[0];
+      cur += (d >= 40) ? (UInt32)0xFFFFFFFF : (UInt64)(2 | (d & 1)) << (d / 2 + 11);
+    }
+    else if (coder.MethodID == k_LDM && propsSize >= 1)
+    {
+      // LDM decoder allocates the window, but it's not larger than unpack size
+      const unsigned wlog = props[0];
+      const UInt64 unpackSize = db.CoderUnpackSizes[db.FoToCoderUnpackSizes[folderIndex] + i];
+      UInt64 win = (UInt64)1 << 16;
+      for (unsigned k = 16; k < wlog && k < 63 && win < unpackSize; k++)
+        win <<= 1;
+      cur += win;
+    }
+    mem += cur;
+  }
+  return mem;
+}
+
+
+class CExtractMtJob Z7_final: public CVirtThread
+{
+public:
+  CDecoder Decoder;
+  CMyComPtr<IInStream> InStream;
+  CBufPtrSeqOutStream *OutStreamSpec;
+  CMyComPtr<ISequentialOutStream> OutStream;
+  CByteBuffer Buf;
+
+  const CDbEx *Db;
+  CNum FolderIndex;
+  UInt32 ItemIndex;   // the first item of solid group in list of items
+  UInt64 UnpackSize;
+  UInt64 MemUsage;    // estimated memory usage of job
+  UInt32 NumThreads;
+  UInt64 DecoderMemLimit;
+
+  HRESULT Result;
+  bool DataAfterEnd_Error;
+
+  DECL_EXTERNAL_CODECS_LOC_VARS_DECL
+
+  CExtractMtJob(bool useMixerMT): Decoder(useMixerMT)
+  {
+    OutStreamSpec = new CBufPtrSeqOutStream;
+    OutStream = OutStreamSpec;
+  }
+  ~CExtractMtJob() Z7_DESTRUCTOR_override
+  {
+    /* WaitThreadFinish() will be called in ~CVirtThread().
+       But we need WaitThreadFinish() call before
+       destructors of this class members. */
+    CVirtThread::WaitThreadFinish();
+  }
+private:
+  virtual void Execute() Z7_override;
+};
+
+void CExtractMtJob::Execute()
+{
+  try
+  {
+    #ifndef Z7_NO_CRYPTO
+      // encrypted folders are not unpacked in jobs
+      ICryptoGetTextPassword *getTextPassword = NULL;
+      bool isEncrypted = false;
+      bool passwordIsDefined = false;
+      UString password;
+    #endif
+
+    DataAfterEnd_Error = false;
+    
+    Result = Decoder.Decode(
+        EXTERNAL_CODECS_LOC_VARS
+        InStream,
+        Db->ArcInfo.DataStartPosition,
+        *Db, FolderIndex,
+        &UnpackSize,
+        OutStream,
+        NULL, // compressProgress
+        NULL  // *inStreamMainRes
+        , DataAfterEnd_Error
+        Z7_7Z_DECODER_CRYPRO_VARS
+        , true, NumThreads, DecoderMemLimit
+        );
+  }
+  catch(...)
+  {
+    Result = E_FAIL;
+  }
+}
+
+
+class CMtExtractor
+{
+public:
+  NWindows::NSynchronization::CCriticalSection CS; // it locks the archive stream
+private:
+  CObjectVector<CExtractMtJob> _jobs;
+  unsigned _first;      // the oldest started job in ring of jobs
+  unsigned _numStarted;
+  UInt64 _memUsage;
+public:
+  CHandler *Handler;
+  const UInt32 *Indices; // NULL means all files mode
+  UInt32 NumItems;
+  UInt32 NextItem;       // the next item that was not checked for job
+  UInt32 NumJobs;        // (NumJobs == 0) means that multithreaded mode is disabled
+  UInt32 NumThreadsPerJob;
+  UInt64 MemLimit;
+  bool UseMixerMT;
+
+  CMtExtractor(): _first(0), _numStarted(0), _memUsage(0), NextItem(0), NumJobs(0) {}
+
+  // it starts new jobs, if there are free jobs and enough memory
+  HRESULT StartJobs();
+  // it returns (job == NULL), if there is no job for solid group that starts from (itemIndex)
+  HRESULT WaitJob(UInt32 itemIndex, CExtractMtJob *&job);
+  void ReleaseJob();
+};
+
+HRESULT CMtExtractor::StartJobs()
+{
+  const CDbEx &db = Handler->_db;
+  
+  while (NextItem < NumItems && _numStarted < NumJobs)
+  {
+    const UInt32 fileIndex = Indices ? Indices[NextItem] : NextItem;
+    const CNum folderIndex = db.FileIndexToFolderIndexMap[fileIndex];
+    UInt64 unpackSize;
+    const UInt32 numSolidFiles = GetNumSolidFiles(db, Indices, NumItems, NextItem, unpackSize);
+    
+    if (folderIndex != kNumNoIndex
+        && unpackSize != 0
+        && unpackSize == (size_t)unpackSize
+        && !Handler->IsFolderEncrypted(folderIndex))
+    {
+      const UInt64 mem = GetFolderDecoderMemUsage(db, folderIndex) + unpackSize;
+      if (mem <= MemLimit)
+      {
+        if (_memUsage + mem > MemLimit)
+          break; // we will wait for the release of previous jobs
+        
+        const unsigned jobIndex = (_first + _numStarted) % NumJobs;
+        if (jobIndex == _jobs.Size())
+        {
+          VECTOR_ADD_NEW_OBJECT(_jobs, CExtractMtJob(UseMixerMT))
+          CExtractMtJob &job = _jobs.Back();
+          job.Db = &db;
+          job.NumThreads = NumThreadsPerJob;
+          job.DecoderMemLimit = MemLimit / NumJobs;
+          #ifdef Z7_EXTERNAL_CODECS
+          job._externalCodecs = Handler->_externalCodecs.IsSet() ? &Handler->_externalCodecs : &g_ExternalCodecs;
+          #endif
+          CSharedInStream *streamSpec = new CSharedInStream;
+          job.InStream = streamSpec;
+          streamSpec->Stream = Handler->_inStream;
+          streamSpec->CS = &CS;
+          const WRes wres = job.Create();
+          if (wres != 0)
+            return HRESULT_FROM_WIN32(wres);
+        }
+        
+        CExtractMtJob &job = _jobs[jobIndex];
+        bool allocated = true;
+        try
+        {
+          job.Buf.Alloc((size_t)unpackSize);
+        }
+        catch(...)
+        {
+          job.Buf.Free();
+          allocated = false;
+        }
+        
+        if (allocated)
+        {
+          job.FolderIndex = folderIndex;
+          job.ItemIndex = NextItem;
+          job.UnpackSize = unpackSize;
+          job.MemUsage = mem;
+          job.OutStreamSpec->Init(job.Buf, (size_t)unpackSize);
+          const WRes wres = job.Start();
+          if (wres != 0)
+            return HRESULT_FROM_WIN32(wres);
+          _memUsage += mem;
+          _numStarted++;
+        }
+      }
+    }
+    
+    NextItem += numSolidFiles;
+  }
+  
+  return S_OK;
+}
+
+HRESULT CMtExtractor::WaitJob(UInt32 itemIndex, CExtractMtJob *&job)
+{
+  job = NULL;
+  if (_numStarted == 0)
+    return S_OK;
+  CExtractMtJob &first = _jobs[_first];
+  if (first.ItemIndex != itemIndex)
+    return S_OK;
+  const WRes wres = first.WaitExecuteFinish();
+  if (wres != 0)
+    return HRESULT_FROM_WIN32(wres);
+  job = &first;
+  return S_OK;
+}
+
+void CMtExtractor::ReleaseJob()
+{
+  // (_memUsage) doesn't include the buffers of released jobs,
+  // so we can't keep the buffer for next job
+  CExtractMtJob &job = _jobs[_first];
+  job.Buf.Free();
+  _memUsage -= job.MemUsage;
+  _first = (_first + 1) % NumJobs;
+  _numStarted--;
+}
+
+#endif
+
+
 Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     Int32 testModeSpec, IArchiveExtractCallback *extractCallbackSpec))
 {
@@ -248,6 +993,8 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
   if (numItems == 0)
     return S_OK;
 
+  UInt32 numSolidGroups = 0;
+
   {
     CNum prevFolder = kNumNoIndex;
     UInt32 nextFile = 0;
@@ -259,9 +1006,16 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
       const UInt32 fileIndex = allFilesMode ? i : indices[i];
       const CNum folderIndex = _db.FileIndexToFolderIndexMap[fileIndex];
       if (folderIndex == kNumNoIndex)
+      {
+        if (_db.IsItemDup(fileIndex))
+          importantTotalUnpacked += _db.Files[_db.DupSource.Vals[fileIndex]].Size;
         continue;
+      }
       if (folderIndex != prevFolder || fileIndex < nextFile)
+      {
         nextFile = _db.FolderStartFileIndex[folderIndex];
+        numSolidGroups++;
+      }
       for (CNum index = nextFile; index <= fileIndex; index++)
         importantTotalUnpacked += _db.Files[index].Size;
       nextFile = fileIndex + 1;
@@ -275,7 +1029,7 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
   CMyComPtr<ICompressProgressInfo> progress = lps;
   lps->Init(extractCallback, false);
 
-  CDecoder decoder(
+  const bool useMixerMT =
     #if !defined(USE_MIXER_MT)
       false
     #elif !defined(USE_MIXER_ST)
@@ -289,7 +1043,9 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     #else
       _useMultiThreadMixer
     #endif
-    );
+    ;
+
+  CDecoder decoder(useMixerMT);
 
   UInt64 curPacked, curUnpacked;
 
@@ -304,6 +1060,42 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
   folderOutStream->TestMode = (testModeSpec != 0);
   folderOutStream->CheckCrc = (_crcSize != 0);
 
+  CDupOutStream *dupOutStream = new CDupOutStream;
+  CMyComPtr<ISequentialOutStream> dupStream(dupOutStream);
+
+  dupOutStream->_db = &_db;
+  dupOutStream->ExtractCallback = extractCallback;
+  dupOutStream->TestMode = (testModeSpec != 0);
+  dupOutStream->CheckCrc = (_crcSize != 0);
+
+  CRecordVector<UInt32> dupIndexes;
+
+  CMyComPtr<IInStream> inStream = _inStream;
+
+  #ifdef Z7_7Z_EXTRACT_MT
+  CMtExtractor mt;
+  if (_numThreads > 1 && numSolidGroups > 1 && _folderCache.MaxSize == 0)
+  {
+    UInt32 numJobs = _numThreads;
+    if (numJobs > numSolidGroups)
+      numJobs = numSolidGroups;
+    if (numJobs > kNumMtExtractJobsMax)
+      numJobs = kNumMtExtractJobsMax;
+    mt.Handler = this;
+    mt.Indices = allFilesMode ? NULL : indices;
+    mt.NumItems = numItems;
+    mt.NumJobs = numJobs;
+    mt.NumThreadsPerJob = _numThreads / numJobs;
+    mt.MemLimit = _memUsage_Decompress;
+    mt.UseMixerMT = useMixerMT;
+    // main thread also reads the archive stream, when jobs are running
+    CSharedInStream *streamSpec = new CSharedInStream;
+    inStream = streamSpec;
+    streamSpec->Stream = _inStream;
+    streamSpec->CS = &mt.CS;
+  }
+  #endif
+
   for (UInt32 i = 0;; lps->OutSize += curUnpacked, lps->InSize += curPacked)
   {
     RINOK(lps->SetCur())
@@ -311,35 +1103,128 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     if (i >= numItems)
       break;
 
+    #ifdef Z7_7Z_EXTRACT_MT
+    if (mt.NumJobs != 0)
+    {
+      RINOK(mt.StartJobs())
+    }
+    #endif
+
     curUnpacked = 0;
     curPacked = 0;
 
     UInt32 fileIndex = allFilesMode ? i : indices[i];
     const CNum folderIndex = _db.FileIndexToFolderIndexMap[fileIndex];
 
+    if (folderIndex == kNumNoIndex && _db.IsItemDup(fileIndex))
+    {
+      // the data of duplicate files is unpacked from the folder that contains source files
+      UInt64 unpackSize;
+      const UInt32 numDupFiles = GetNumDupFiles(_db, allFilesMode ? NULL : indices, numItems, i,
+          unpackSize, curUnpacked);
+      dupIndexes.ClearAndSetSize(numDupFiles);
+      for (UInt32 k = 0; k < numDupFiles; k++)
+        dupIndexes[k] = allFilesMode ? i + k : indices[i + k];
+      i += numDupFiles;
+
+      const CNum srcFolderIndex = _db.FileIndexToFolderIndexMap[_db.DupSource.Vals[dupIndexes[0]]];
+      
+      RINOK(dupOutStream->Init(&dupIndexes[0], numDupFiles))
+      if (dupOutStream->WasWritingFinished())
+        continue;
+
+      #ifndef Z7_SFX
+      {
+        const CByteBuffer *srcFolder = _folderCache.Find(srcFolderIndex);
+        if (srcFolder)
+        {
+          const HRESULT result = WriteStream(dupStream, *srcFolder, srcFolder->Size());
+          if (result != k_My_HRESULT_WritingWasCut)
+            RINOK(result)
+          RINOK(dupOutStream->FlushCorrupted(NExtract::NOperationResult::kDataError))
+          continue;
+        }
+      }
+      #endif
+
+      #ifndef Z7_NO_CRYPTO
+      CMyComPtr<ICryptoGetTextPassword> getTextPassword;
+      if (extractCallback)
+        extractCallback.QueryInterface(IID_ICryptoGetTextPassword, &getTextPassword);
+      #endif
+
+      try
+      {
+        #ifndef Z7_NO_CRYPTO
+          bool isEncrypted = false;
+          bool passwordIsDefined = false;
+          UString_Wipe password;
+        #endif
+
+        bool dataAfterEnd_Error = false;
+
+        const HRESULT result = decoder.Decode(
+            EXTERNAL_CODECS_VARS
+            inStream,
+            _db.ArcInfo.DataStartPosition,
+            _db, srcFolderIndex,
+            &unpackSize,
+            dupStream,
+            progress,
+            NULL // *inStreamMainRes
+            , dataAfterEnd_Error
+            
+            Z7_7Z_DECODER_CRYPRO_VARS
+            #if !defined(Z7_ST)
+              , true, _numThreads, _memUsage_Decompress
+            #endif
+            );
+
+        RINOK(SetFolderResult(dupOutStream, callbackMessage, srcFolderIndex, result, dataAfterEnd_Error))
+        continue;
+      }
+      catch(...)
+      {
+        RINOK(dupOutStream->FlushCorrupted(NExtract::NOperationResult::kDataError))
+        throw;
+      }
+    }
+
     UInt32 numSolidFiles = 1;
 
+    #ifndef Z7_SFX
+    const CByteBuffer *cachedFolder = NULL;
+    size_t cachedOffset = 0;
+    #endif
+
     if (folderIndex != kNumNoIndex)
     {
       curPacked = _db.GetFolderFullPackSize(folderIndex);
-      UInt32 nextFile = fileIndex + 1;
+      #ifndef Z7_SFX
+      const UInt32 firstFileIndex = fileIndex;
+      #endif
       fileIndex = _db.FolderStartFileIndex[folderIndex];
-      UInt32 k;
-
-      for (k = i + 1; k < numItems; k++)
+      numSolidFiles = GetNumSolidFiles(_db, allFilesMode ? NULL : indices, numItems, i, curUnpacked);
+      
+      #ifndef Z7_SFX
+      cachedFolder = _folderCache.Find(folderIndex);
+      if (cachedFolder)
       {
-        const UInt32 fileIndex2 = allFilesMode ? k : indices[k];
-        if (_db.FileIndexToFolderIndexMap[fileIndex2] != folderIndex
-            || fileIndex2 < nextFile)
-          break;
-        nextFile = fileIndex2 + 1;
+        // we don't need to report the files before first required file
+        for (UInt32 k = fileIndex; k < firstFileIndex; k++)
+          cachedOffset += (size_t)_db.Files[k].Size;
+        fileIndex = firstFileIndex;
       }
-      
-      numSolidFiles = k - i;
-      
-      for (k = fileIndex; k < nextFile; k++)
-        curUnpacked += _db.Files[k].Size;
+      #endif
+    }
+
+    #ifdef Z7_7Z_EXTRACT_MT
+    CExtractMtJob *job = NULL;
+    if (mt.NumJobs != 0)
+    {
+      RINOK(mt.WaitJob(i, job))
     }
+    #endif
 
     {
       const HRESULT result = folderOutStream->Init(fileIndex,
@@ -353,6 +1238,10 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
 
     if (folderOutStream->WasWritingFinished())
     {
+      #ifdef Z7_7Z_EXTRACT_MT
+      if (job)
+        mt.ReleaseJob();
+      #endif
       // for debug: to test zero size stream unpacking
       // if (folderIndex == kNumNoIndex)  // enable this check for debug
       continue;
@@ -361,6 +1250,57 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     if (folderIndex == kNumNoIndex)
       return E_FAIL;
 
+    #ifndef Z7_SFX
+    if (cachedFolder)
+    {
+      const HRESULT result = WriteStream(outStream,
+          (const Byte *)*cachedFolder + cachedOffset,
+          cachedFolder->Size() - cachedOffset);
+      if (result != k_My_HRESULT_WritingWasCut)
+        RINOK(result)
+      RINOK(folderOutStream->FlushCorrupted(NExtract::NOperationResult::kDataError))
+      continue;
+    }
+    #endif
+
+    #ifdef Z7_7Z_EXTRACT_MT
+    if (job)
+    {
+      const HRESULT decodeRes = job->Result;
+      const bool dataAfterEnd_Error = job->DataAfterEnd_Error;
+      const HRESULT result = WriteStream(outStream, job->Buf, job->OutStreamSpec->GetPos());
+      mt.ReleaseJob();
+      if (result != k_My_HRESULT_WritingWasCut)
+        RINOK(result)
+      RINOK(SetFolderResult(folderOutStream, callbackMessage, folderIndex, decodeRes, dataAfterEnd_Error))
+      continue;
+    }
+    #endif
+    
+    #ifndef Z7_SFX
+    // we unpack full folder to cache, if the folder is not encrypted and it's not too big
+    CByteBuffer *cacheBuf = NULL;
+    CFolderCacheOutStream *cacheStreamSpec = NULL;
+    CMyComPtr<ISequentialOutStream> cacheStream;
+    UInt64 unpackSize = curUnpacked;
+    if (_folderCache.MaxSize != 0 && !IsFolderEncrypted(folderIndex))
+    {
+      unpackSize = _db.GetFolderUnpackSize(folderIndex);
+      cacheBuf = _folderCache.AllocItem(folderIndex, unpackSize);
+      if (cacheBuf)
+      {
+        cacheStreamSpec = new CFolderCacheOutStream;
+        cacheStream = cacheStreamSpec;
+        cacheStreamSpec->Stream = outStream;
+        cacheStreamSpec->Buf = *cacheBuf;
+        cacheStreamSpec->Size = cacheBuf->Size();
+        cacheStreamSpec->Pos = 0;
+      }
+      else
+        unpackSize = curUnpacked;
+    }
+    #endif
+
     #ifndef Z7_NO_CRYPTO
     CMyComPtr<ICryptoGetTextPassword> getTextPassword;
     if (extractCallback)
@@ -379,12 +1319,16 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
 
       const HRESULT result = decoder.Decode(
           EXTERNAL_CODECS_VARS
-          _inStream,
+          inStream,
           _db.ArcInfo.DataStartPosition,
           _db, folderIndex,
+          #ifndef Z7_SFX
+          &unpackSize,
+          cacheBuf ? (ISequentialOutStream *)cacheStream : (ISequentialOutStream *)outStream,
+          #else
           &curUnpacked,
-
           outStream,
+          #endif
           progress,
           NULL // *inStreamMainRes
           , dataAfterEnd_Error
@@ -395,41 +1339,24 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
           #endif
           );
 
-      if (result == S_FALSE || result == E_NOTIMPL || dataAfterEnd_Error)
+      #ifndef Z7_SFX
+      if (cacheBuf)
       {
-        const bool wasFinished = folderOutStream->WasWritingFinished();
-
-        int resOp = NExtract::NOperationResult::kDataError;
-        
-        if (result != S_FALSE)
-        {
-          if (result == E_NOTIMPL)
-            resOp = NExtract::NOperationResult::kUnsupportedMethod;
-          else if (wasFinished && dataAfterEnd_Error)
-            resOp = NExtract::NOperationResult::kDataAfterEnd;
-        }
-
-        RINOK(folderOutStream->FlushCorrupted(resOp))
-
-        if (wasFinished)
-        {
-          // we don't show error, if it's after required files
-          if (/* !folderOutStream->ExtraWriteWasCut && */ callbackMessage)
-          {
-            RINOK(callbackMessage->ReportExtractResult(NEventIndexType::kBlockIndex, folderIndex, resOp))
-          }
-        }
-        continue;
+        if (result != S_OK || dataAfterEnd_Error || cacheStreamSpec->Pos != cacheBuf->Size())
+          _folderCache.DeleteItem(folderIndex);
+        cacheBuf = NULL;
       }
-      
-      if (result != S_OK)
-        return result;
+      #endif
 
-      RINOK(folderOutStream->FlushCorrupted(NExtract::NOperationResult::kDataError))
+      RINOK(SetFolderResult(folderOutStream, callbackMessage, folderIndex, result, dataAfterEnd_Error))
       continue;
     }
     catch(...)
     {
+      #ifndef Z7_SFX
+      if (cacheBuf)
+        _folderCache.DeleteItem(folderIndex);
+      #endif
       RINOK(folderOutStream->FlushCorrupted(NExtract::NOperationResult::kDataError))
       // continue;
       // return E_FAIL;
@@ -442,4 +1369,292 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
   COM_TRY_END
 }
 
+
+
+#ifndef Z7_SFX
+
+/*
+GetStream() returns the stream for one file:
+  - if the folder is stored (Copy method), the stream reads the data
+    directly from archive, so random access is fast.
+  - in another case the stream reads from CFolderReader object of handler,
+    that decodes the folder in forward direction. The handler keeps the last
+    CFolderReader object, so the next call of GetStream() for next file in
+    same solid folder continues the decoding instead of restart of decoding.
+    Seek() back in decoded folder restarts the decoding from start of folder.
+*/
+
+Z7_CLASS_IMP_COM_0(
+  CFolderReader
+)
+public:
+  CDecoder Decoder;
+  CMyComPtr<ISequentialInStream> Stream; // stream of unpacked data of folder
+  CNum FolderIndex;
+  UInt64 Pos; // the position of (Stream) in unpacked data of folder
+  CByteBuffer SkipBuf;
+
+  CFolderReader(): Decoder(false), FolderIndex(kNumNoIndex), Pos(0) {}
+  void Reset()
+  {
+    Stream.Release();
+    FolderIndex = kNumNoIndex;
+  }
+};
+
+
+HRESULT CHandler::OpenFolderReader(CNum folderIndex)
+{
+  if (!_inStream || folderIndex >= _db.NumFolders)
+    return E_FAIL;
+  
+  if (!_folderReader)
+  {
+    _folderReader = new CFolderReader;
+    _folderReaderRef = (IUnknown *)_folderReader;
+  }
+  CFolderReader &fr = *_folderReader;
+  fr.Reset();
+    
+  CSharedInStream *sharedStreamSpec = new CSharedInStream;
+  CMyComPtr<IInStream> sharedStream = sharedStreamSpec;
+  sharedStreamSpec->Stream = _inStream;
+
+  #ifndef Z7_NO_CRYPTO
+    ICryptoGetTextPassword *getTextPassword = NULL;
+    bool isEncrypted = false;
+    bool passwordIsDefined = false;
+    UString_Wipe password;
+  #endif
+
+  bool dataAfterEnd_Error = false;
+
+  RINOK(fr.Decoder.Decode(
+      EXTERNAL_CODECS_VARS
+      sharedStream,
+      _db.ArcInfo.DataStartPosition,
+      _db, folderIndex,
+      NULL, // unpackSize : FULL unpack
+
+      NULL, // outStream
+      NULL, // compressProgress
+      &fr.Stream
+      , dataAfterEnd_Error
+      
+      Z7_7Z_DECODER_CRYPRO_VARS
+      #if !defined(Z7_ST)
+        , true, _numThreads, _memUsage_Decompress
+      #endif
+      ))
+  
+  if (!fr.Stream)
+    return E_FAIL;
+  fr.FolderIndex = folderIndex;
+  fr.Pos = 0;
+  return S_OK;
+}
+
+
+HRESULT CHandler::ReadFolder(CNum folderIndex, UInt64 pos, void *data, UInt32 size, UInt32 *processedSize)
+{
+  *processedSize = 0;
+  
+  if (!_folderReader
+      || _folderReader->FolderIndex != folderIndex
+      || _folderReader->Pos > pos)
+  {
+    RINOK(OpenFolderReader(folderIndex))
+  }
+  CFolderReader &fr = *_folderReader;
+
+  HRESULT res = S_OK;
+  
+  while (fr.Pos < pos)
+  {
+    const UInt32 kSkipBufSize = 1 << 16;
+    if (fr.SkipBuf.Size() == 0)
+      fr.SkipBuf.Alloc(kSkipBufSize);
+    UInt32 cur = kSkipBufSize;
+    if (cur > pos - fr.Pos)
+      cur = (UInt32)(pos - fr.Pos);
+    UInt32 processed = 0;
+    res = fr.Stream->Read(fr.SkipBuf, cur, &processed);
+    fr.Pos += processed;
+    if (res != S_OK || processed == 0)
+      break;
+  }
+  
+  if (res == S_OK && fr.Pos == pos)
+  {
+    res = fr.Stream->Read(data, size, processedSize);
+    fr.Pos += *processedSize;
+    if (res == S_OK && *processedSize != 0)
+      return S_OK;
+  }
+  
+  fr.Reset();
+  if (res == S_OK)
+    res = S_FALSE; // unexpected end of data
+  return res;
+}
+
+
+Z7_CLASS_IMP_IInStream(
+  CItemInStream
+)
+  UInt64 _virtPos;
+  UInt32 _crc;
+  UInt64 _crcPos; // the size of data at start of file that was processed by CRC calculation
+public:
+  UInt64 Size;
+  CNum FolderIndex;
+  UInt64 FolderPos; // the position of file data in unpacked folder
+  UInt64 PackPos;   // the position of file data in archive, if the folder is stored
+  bool IsStored;
+  bool CrcDefined;
+  UInt32 Crc;
+  
+  CHandler *_handlerSpec;
+  CMyComPtr<IUnknown> _handler;
+
+  CItemInStream(): _virtPos(0), _crc(CRC_INIT_VAL), _crcPos(0) {}
+};
+
+Z7_COM7F_IMF(CItemInStream::Read(void *data, UInt32 size, UInt32 *processedSize))
+{
+  if (processedSize)
+    *processedSize = 0;
+  if (_virtPos >= Size)
+    return S_OK;
+  {
+    const UInt64 rem = Size - _virtPos;
+    if (size > rem)
+      size = (UInt32)rem;
+  }
+  if (size == 0)
+    return S_OK;
+
+  UInt32 processed = 0;
+  HRESULT res;
+  
+  if (IsStored)
+  {
+    IInStream *stream = _handlerSpec->_inStream;
+    if (!stream)
+      return E_FAIL;
+    RINOK(InStream_SeekSet(stream, PackPos + _virtPos))
+    res = stream->Read(data, size, &processed);
+    if (res == S_OK && processed == 0)
+      res = S_FALSE; // unexpected end of archive
+  }
+  else
+    res = _handlerSpec->ReadFolder(FolderIndex, FolderPos + _virtPos, data, size, &processed);
+
+  if (_crcPos == _virtPos)
+  {
+    _crc = CrcUpdate(_crc, data, processed);
+    _crcPos += processed;
+  }
+  _virtPos += processed;
+  if (processedSize)
+    *processedSize = processed;
+  RINOK(res)
+  
+  if (CrcDefined && _crcPos == Size && CRC_GET_DIGEST(_crc) != Crc)
+    return S_FALSE; // CRC error
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CItemInStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPosition))
+{
+  switch (seekOrigin)
+  {
+    case STREAM_SEEK_SET: break;
+    case STREAM_SEEK_CUR: offset += _virtPos; break;
+    case STREAM_SEEK_END: offset += Size; break;
+    default: return STG_E_INVALIDFUNCTION;
+  }
+  if (offset < 0)
+    return HRESULT_WIN32_ERROR_NEGATIVE_SEEK;
+  _virtPos = (UInt64)offset;
+  if (newPosition)
+    *newPosition = (UInt64)offset;
+  return S_OK;
+}
+
+
+Z7_COM7F_IMF(CHandler::GetStream(UInt32 index, ISequentialInStream **stream))
+{
+  COM_TRY_BEGIN
+  
+  *stream = NULL;
+
+  if (index >= _db.Files.Size())
+    return E_INVALIDARG;
+  
+  if (_db.Files[index].IsDir || _db.IsItemAnti(index))
+    return S_FALSE;
+
+  // the stream of duplicate file reads the data of source file
+  index = _db.GetDataIndex(index);
+  const CFileItem &item = _db.Files[index];
+  
+  const CNum folderIndex = _db.FileIndexToFolderIndexMap[index];
+  
+  if (folderIndex == kNumNoIndex)
+  {
+    CBufInStream *streamSpec = new CBufInStream;
+    CMyComPtr<ISequentialInStream> streamTemp = streamSpec;
+    streamSpec->Init(NULL, 0);
+    *stream = streamTemp.Detach();
+    return S_OK;
+  }
+
+  if (IsFolderEncrypted(folderIndex))
+    return S_FALSE;
+
+  bool isStored;
+  {
+    CFolder folder;
+    _db.ParseFolderInfo(folderIndex, folder);
+    isStored =
+           folder.Coders.Size() == 1
+        && folder.Coders[0].MethodID == k_Copy
+        && folder.PackStreams.Size() == 1;
+  }
+
+  if (!isStored && (!_folderReader || _folderReader->FolderIndex != folderIndex))
+  {
+    // we check that the decoders of folder support the reading in pull mode
+    const HRESULT res = OpenFolderReader(folderIndex);
+    if (res == E_NOTIMPL)
+      return S_FALSE;
+    RINOK(res)
+  }
+
+  UInt64 folderPos = 0;
+  for (CNum i = _db.FolderStartFileIndex[folderIndex]; i < index; i++)
+    folderPos += _db.Files[i].Size;
+
+  CItemInStream *streamSpec = new CItemInStream;
+  CMyComPtr<ISequentialInStream> streamTemp = streamSpec;
+  
+  streamSpec->Size = item.Size;
+  streamSpec->FolderIndex = folderIndex;
+  streamSpec->FolderPos = folderPos;
+  streamSpec->IsStored = isStored;
+  streamSpec->PackPos = _db.GetFolderStreamPos(folderIndex, 0) + folderPos;
+  streamSpec->CrcDefined = item.CrcDefined;
+  streamSpec->Crc = item.Crc;
+  streamSpec->_handlerSpec = this;
+  streamSpec->_handler = (IInArchive *)this;
+
+  *stream = streamTemp.Detach();
+  return S_OK;
+  
+  COM_TRY_END
+}
+
+#endif
+
 }}
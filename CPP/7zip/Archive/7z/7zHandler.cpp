@@ -30,6 +30,10 @@ namespace N7z {
 
 CHandler::CHandler()
 {
+  #ifndef Z7_SFX
+  _folderReader = NULL;
+  #endif
+
   #ifndef Z7_NO_CRYPTO
   _isEncrypted = false;
   _passwordIsDefined = false;
@@ -43,6 +47,10 @@ CHandler::CHandler()
   _useMultiThreadMixer = true;
   #endif
   
+  #else
+
+  _appendMode = false;
+
   #endif
 }
 
@@ -219,12 +227,10 @@ Z7_COM7F_IMF(CHandler::GetArchiveProperty(PROPID propID, PROPVARIANT *value))
           GetStringForSizeValue(temp, pm.LzmaDic);
           s += temp;
         }
-        /*
         else if (id == k_ZSTD)
         {
           s += "ZSTD";
         }
-        */
         else
           AddMethodName(s, id);
       }
@@ -505,6 +511,12 @@ HRESULT CHandler::SetMethodToProp(CNum folderIndex, PROPVARIANT *prop) const
         }
       }
     }
+    else if (id64 == k_LDM)
+    {
+      name = "LDM";
+      if (propsSize == 1)
+        ConvertUInt32ToString(props[0], s);
+    }
     
     if (name)
     {
@@ -583,7 +595,7 @@ Z7_COM7F_IMF(CHandler::GetProperty(UInt32 index, PROPID propID, PROPVARIANT *val
     case kpidIsDir: PropVarEm_Set_Bool(value, item.IsDir); break;
     case kpidSize:
     {
-      PropVarEm_Set_UInt64(value, item.Size);
+      PropVarEm_Set_UInt64(value, _db.Files[_db.GetDataIndex(index2)].Size);
       // prop = ref2.Size;
       break;
     }
@@ -612,7 +624,14 @@ Z7_COM7F_IMF(CHandler::GetProperty(UInt32 index, PROPID propID, PROPVARIANT *val
     case kpidATime:  SetFileTimeProp_From_UInt64Def(value, _db.ATime, index2); break;
     case kpidMTime:  SetFileTimeProp_From_UInt64Def(value, _db.MTime, index2); break;
     case kpidAttrib:  if (_db.Attrib.ValidAndDefined(index2)) PropVarEm_Set_UInt32(value, _db.Attrib.Vals[index2]); break;
-    case kpidCRC:  if (item.CrcDefined) PropVarEm_Set_UInt32(value, item.Crc); break;
+    case kpidCRC:
+    {
+      const CFileItem &dataItem = _db.Files[_db.GetDataIndex(index2)];
+      if (dataItem.CrcDefined)
+        PropVarEm_Set_UInt32(value, dataItem.Crc);
+      break;
+    }
+    case kpidCopyLink:  if (_db.IsItemDup(index2)) return _db.GetPath_Prop(_db.DupSource.Vals[index2], value); break;
     case kpidEncrypted:  PropVarEm_Set_Bool(value, IsFolderEncrypted(_db.FileIndexToFolderIndexMap[index2])); break;
     case kpidIsAnti:  PropVarEm_Set_Bool(value, _db.IsItemAnti(index2)); break;
     /*
@@ -733,8 +752,16 @@ Z7_COM7F_IMF(CHandler::Open(IInStream *stream,
 Z7_COM7F_IMF(CHandler::Close())
 {
   COM_TRY_BEGIN
+  #ifndef Z7_SFX
+  _folderReaderRef.Release();
+  _folderReader = NULL;
+  _folderCache.Clear();
+  #endif
   _inStream.Release();
   _db.Clear();
+  #ifndef Z7_EXTRACT_ONLY
+  _appendMode = false;
+  #endif
   #ifndef Z7_NO_CRYPTO
   _isEncrypted = false;
   _passwordIsDefined = false;
@@ -753,6 +780,7 @@ Z7_COM7F_IMF(CHandler::SetProperties(const wchar_t * const *names, const PROPVAR
   
   InitCommon();
   _useMultiThreadMixer = true;
+  _folderCache.SetMaxSize(0);
 
   for (UInt32 i = 0; i < numProps; i++)
   {
@@ -777,6 +805,11 @@ Z7_COM7F_IMF(CHandler::SetProperties(const wchar_t * const *names, const PROPVAR
           RINOK(hres)
           continue;
         }
+        if (SetFolderCacheProperty(name, value, hres))
+        {
+          RINOK(hres)
+          continue;
+        }
       }
       return E_INVALIDARG;
     }
@@ -20,6 +20,11 @@
 
 #endif
 
+// multithreaded extraction of several folders in CHandler::Extract()
+#if !defined(Z7_ST) && !defined(Z7_SFX)
+  #define Z7_7Z_EXTRACT_MT
+#endif
+
 // #ifdef Z7_7Z_SET_PROPERTIES
 #include "../Common/HandlerOut.h"
 // #endif
@@ -30,6 +35,47 @@
 namespace NArchive {
 namespace N7z {
 
+#ifndef Z7_SFX
+
+class CFolderReader;
+#ifdef Z7_7Z_EXTRACT_MT
+class CMtExtractor;
+#endif
+
+/* CFolderCache keeps the unpacked data of recently decoded folders,
+   so repeated Extract() calls for files from same solid folder
+   don't restart the decoding of folder. (MaxSize == 0) disables the cache. */
+
+struct CFolderCacheItem
+{
+  CNum FolderIndex;
+  UInt64 LastUse;
+  CByteBuffer Data;
+};
+
+class CFolderCache
+{
+  CObjectVector<CFolderCacheItem> _items;
+  UInt64 _size;
+  UInt64 _useCounter;
+  
+  void Delete(unsigned index);
+  bool FreeSpace(UInt64 size);
+public:
+  UInt64 MaxSize;
+
+  CFolderCache(): _size(0), _useCounter(0), MaxSize(0) {}
+  void Clear() { _items.Clear(); _size = 0; }
+  void SetMaxSize(UInt64 maxSize);
+  
+  const CByteBuffer *Find(CNum folderIndex);
+  // it returns NULL, if the buffer of required size can't be allocated in cache
+  CByteBuffer *AllocItem(CNum folderIndex, UInt64 size);
+  void DeleteItem(CNum folderIndex);
+};
+
+#endif
+
 
 #ifndef Z7_EXTRACT_ONLY
 
@@ -43,6 +89,8 @@ public:
   bool _numSolidBytesDefined;
   bool _solidExtension;
   bool _useTypeSorting;
+  bool _useContentSorting;
+  bool _useDedup;
 
   bool _compressHeaders;
   bool _encryptHeadersSpecified;
@@ -83,12 +131,17 @@ class CHandler Z7_final:
   public IInArchive,
   public IArchiveGetRawProps,
   
+  #ifndef Z7_SFX
+  public IInArchiveGetStream,
+  #endif
+  
   #ifdef Z7_7Z_SET_PROPERTIES
   public ISetProperties,
   #endif
   
   #ifndef Z7_EXTRACT_ONLY
   public IOutArchive,
+  public IOutArchiveAppend,
   #endif
   
   Z7_PUBLIC_ISetCompressCodecsInfo_IFEC
@@ -103,11 +156,15 @@ class CHandler Z7_final:
 {
   Z7_COM_QI_BEGIN2(IInArchive)
   Z7_COM_QI_ENTRY(IArchiveGetRawProps)
+ #ifndef Z7_SFX
+  Z7_COM_QI_ENTRY(IInArchiveGetStream)
+ #endif
  #ifdef Z7_7Z_SET_PROPERTIES
   Z7_COM_QI_ENTRY(ISetProperties)
  #endif
  #ifndef Z7_EXTRACT_ONLY
   Z7_COM_QI_ENTRY(IOutArchive)
+  Z7_COM_QI_ENTRY(IOutArchiveAppend)
  #endif
   Z7_COM_QI_ENTRY_ISetCompressCodecsInfo_IFEC
   Z7_COM_QI_END
@@ -115,11 +172,15 @@ class CHandler Z7_final:
 
   Z7_IFACE_COM7_IMP(IInArchive)
   Z7_IFACE_COM7_IMP(IArchiveGetRawProps)
+ #ifndef Z7_SFX
+  Z7_IFACE_COM7_IMP(IInArchiveGetStream)
+ #endif
  #ifdef Z7_7Z_SET_PROPERTIES
   Z7_IFACE_COM7_IMP(ISetProperties)
  #endif
  #ifndef Z7_EXTRACT_ONLY
   Z7_IFACE_COM7_IMP(IOutArchive)
+  Z7_IFACE_COM7_IMP(IOutArchiveAppend)
  #endif
   DECL_ISetCompressCodecsInfo
 
@@ -145,6 +206,9 @@ private:
   
   CRecordVector<CBond2> _bonds;
 
+  // UpdateItems() writes new data after the end of opened archive in same file
+  bool _appendMode;
+
   HRESULT PropsMethod_To_FullMethod(CMethodFull &dest, const COneMethodInfo &m);
   HRESULT SetHeaderMethod(CCompressionMethodMode &headerMethod);
   HRESULT SetMainMethod(CCompressionMethodMode &method);
@@ -154,6 +218,21 @@ private:
   bool IsFolderEncrypted(CNum folderIndex) const;
   #ifndef Z7_SFX
 
+  // the state of folder decoding that is kept between GetStream() calls
+  CFolderReader *_folderReader;
+  CMyComPtr<IUnknown> _folderReaderRef;
+  
+  CFolderCache _folderCache;
+  // "cache" property: the memory budget for the cache of unpacked folders
+  bool SetFolderCacheProperty(const UString &name, const PROPVARIANT &value, HRESULT &hres);
+
+  friend class CItemInStream;
+ #ifdef Z7_7Z_EXTRACT_MT
+  friend class CMtExtractor;
+ #endif
+  HRESULT OpenFolderReader(CNum folderIndex);
+  HRESULT ReadFolder(CNum folderIndex, UInt64 pos, void *data, UInt32 size, UInt32 *processedSize);
+
   CRecordVector<UInt64> _fileInfoPopIDs;
   void FillPopIDs();
   void AddMethodName(AString &s, UInt64 id);
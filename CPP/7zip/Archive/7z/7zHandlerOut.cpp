@@ -6,9 +6,14 @@
 #include "../../../Common/StringToInt.h"
 #include "../../../Common/Wildcard.h"
 
+#include "../../Common/StreamUtils.h"
+
 #include "../Common/ItemNameUtils.h"
 #include "../Common/ParseProperties.h"
 
+#include "../../Compress/LdmCoder.h"
+#include "../../Compress/ZstdEncoderProps.h"
+
 #include "7zHandler.h"
 #include "7zOut.h"
 #include "7zUpdate.h"
@@ -112,6 +117,8 @@ HRESULT CHandler::SetMainMethod(CCompressionMethodMode &methodMode)
   const UInt64 kSolidBytes_Max = ((UInt64)1 << 32);
 
   bool needSolid = false;
+  // LDM keeps big window in memory, so other coders in chain can use less memory
+  UInt64 ldmMemUsage = 0;
   
   FOR_VECTOR (i, methods)
   {
@@ -148,18 +155,34 @@ HRESULT CHandler::SetMainMethod(CCompressionMethodMode &methodMode)
       case k_Deflate: dicSize = (UInt32)1 << 15; break;
       case k_Deflate64: dicSize = (UInt32)1 << 16; break;
       case k_BZip2: dicSize = oneMethodInfo.Get_BZip2_BlockSize(); break;
-      // case k_ZSTD: dicSize = 1 << 23; break;
+      case k_ZSTD: dicSize = 1 << 23; break;
+      case k_LDM:
+        if (!oneMethodInfo.Get_DicSize(dicSize))
+          dicSize = (UInt64)1 << NCompress::NLdm::kWindowLog_Default;
+        {
+          // the encoder rounds the window up to power of 2, and its hash table is (window / 16)
+          unsigned wlog = NCompress::NLdm::kWindowLog_Min;
+          while (wlog < NCompress::NLdm::kWindowLog_Max && ((UInt64)1 << wlog) < dicSize)
+            wlog++;
+          const UInt64 winSize = (UInt64)1 << wlog;
+          ldmMemUsage += winSize + (winSize >> 4);
+        }
+        break;
       default: continue;
     }
 
     UInt64 numSolidBytes;
 
-    /*
+    #ifndef Z7_ST
+    const UInt64 memUsageLimit =
+        methodMode.MemoryUsageLimit > ldmMemUsage ?
+        methodMode.MemoryUsageLimit - ldmMemUsage : 0;
+    #endif
+
     if (methodFull.Id == k_ZSTD)
     {
-      // continue;
       NCompress::NZstd::CEncoderProps encoderProps;
-      RINOK(oneMethodInfo.Set_PropsTo_zstd(encoderProps));
+      RINOK(encoderProps.SetFromMethodProps(oneMethodInfo))
       CZstdEncProps &zstdProps = encoderProps.EncProps;
       ZstdEncProps_NormalizeFull(&zstdProps);
       UInt64 cs = (UInt64)(zstdProps.jobSize);
@@ -171,7 +194,7 @@ HRESULT CHandler::SetMainMethod(CCompressionMethodMode &methodMode)
       if (numSolidBytes > kSolidBytes_Zstd_Max)
         numSolidBytes = kSolidBytes_Zstd_Max;
 
-      methodFull.Set_NumThreads = false; // we don't use ICompressSetCoderMt::SetNumberOfThreads() for LZMA2 encoder
+      methodFull.Set_NumThreads = false; // ZSTD encoder gets the number of threads via (NCoderPropID::kNumThreads)
 
       #ifndef Z7_ST
       if (!numThreads_WasSpecifiedInMethod
@@ -182,7 +205,7 @@ HRESULT CHandler::SetMainMethod(CCompressionMethodMode &methodMode)
         const UInt32 numThreads_Original = methodMode.NumThreads;
         const UInt32 numThreads_New = ZstdEncProps_GetNumThreads_for_MemUsageLimit(
             &zstdProps,
-            methodMode.MemoryUsageLimit,
+            memUsageLimit,
             numThreads_Original);
         if (numThreads_Original != numThreads_New)
         {
@@ -191,9 +214,7 @@ HRESULT CHandler::SetMainMethod(CCompressionMethodMode &methodMode)
       }
       #endif
     }
-    else
-    */
-    if (methodFull.Id == k_LZMA2)
+    else if (methodFull.Id == k_LZMA2)
     {
       // he we calculate default chunk Size for LZMA2 as defined in LZMA2 encoder code
       /* lzma2 code use dictionary up to fake 4 GiB to calculate ChunkSize.
@@ -251,7 +272,7 @@ HRESULT CHandler::SetMainMethod(CCompressionMethodMode &methodMode)
             if (cs < ((UInt32)1 << 22)) numPackChunks++;
             size += numPackChunks * cs;
             // printf("\nnumBlockThreads = %d, size = %d\n", (unsigned)(numBlockThreads), (unsigned)(size >> 20));
-            if (size <= methodMode.MemoryUsageLimit)
+            if (size <= memUsageLimit)
               break;
           }
 
@@ -266,6 +287,13 @@ HRESULT CHandler::SetMainMethod(CCompressionMethodMode &methodMode)
       }
       #endif
     }
+    else if (methodFull.Id == k_LDM)
+    {
+      // LDM finds repeats in whole window, so we want big solid blocks
+      numSolidBytes = dicSize << 2;
+      if (numSolidBytes < kSolidBytes_Max)
+        numSolidBytes = kSolidBytes_Max;
+    }
     else
     {
       numSolidBytes = (UInt64)dicSize << 7;
@@ -385,6 +413,29 @@ static int AddFolder(CObjectVector<CTreeFolder> &treeFolders, int cur, const USt
 }
 */
 
+Z7_COM7F_IMF(CHandler::SetAppendMode(Int32 appendMode))
+{
+  _appendMode = false;
+  if (appendMode == 0)
+    return S_OK;
+  /* new data will be written to the end of file. So archive must have no errors,
+     and there must be no additional data after the end of archive.
+     The header that we write requires that pack streams start just after start header. */
+  if (!_inStream || !_db.CanUpdate())
+    return S_FALSE;
+  if (_removeSfxBlock && _db.ArcInfo.StartPosition != 0)
+    return S_FALSE;
+  if (_db.NumPackStreams != 0
+      && _db.ArcInfo.DataStartPosition != _db.ArcInfo.StartPositionAfterHeader)
+    return S_FALSE;
+  UInt64 fileSize;
+  RINOK(InStream_GetSize_SeekToEnd(_inStream, fileSize))
+  if (fileSize != _db.ArcInfo.StartPosition + _db.PhySize)
+    return S_FALSE;
+  _appendMode = true;
+  return S_OK;
+}
+
 Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outStream, UInt32 numItems,
     IArchiveUpdateCallback *updateCallback))
 {
@@ -407,6 +458,8 @@ Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outStream, UInt32 numIt
 
   if (db && !db->CanUpdate())
     return E_NOTIMPL;
+  if (_appendMode && !db)
+    return E_FAIL;
 
   /*
   Z7_DECL_CMyComPtr_QI_FROM(
@@ -786,8 +839,11 @@ Z7_COM7F_IMF(CHandler::UpdateItems(ISequentialOutStream *outStream, UInt32 numIt
   options.NumSolidBytes = _numSolidBytes;
   options.SolidExtension = _solidExtension;
   options.UseTypeSorting = _useTypeSorting;
+  options.UseContentSorting = _useContentSorting;
+  options.UseDedup = _useDedup;
 
   options.RemoveSfxBlock = _removeSfxBlock;
+  options.AppendMode = _appendMode;
   // options.VolumeMode = _volumeMode;
 
   options.MultiThreadMixer = _useMultiThreadMixer;
@@ -858,6 +914,8 @@ void COutHandler::InitProps7z()
 
   InitSolid();
   _useTypeSorting = false;
+  _useContentSorting = false;
+  _useDedup = false;
 }
 
 void COutHandler::InitProps()
@@ -1003,6 +1061,8 @@ HRESULT COutHandler::SetProperty(const wchar_t *nameSpec, const PROPVARIANT &val
     if (name.IsEqualTo("mtf")) return PROPVARIANT_to_bool(value, _useMultiThreadMixer);
 
     if (name.IsEqualTo("qs")) return PROPVARIANT_to_bool(value, _useTypeSorting);
+    if (name.IsEqualTo("qc")) return PROPVARIANT_to_bool(value, _useContentSorting);
+    if (name.IsEqualTo("dd")) return PROPVARIANT_to_bool(value, _useDedup);
 
     // if (name.IsEqualTo("v"))  return PROPVARIANT_to_bool(value, _volumeMode);
   }
@@ -1014,6 +1074,7 @@ Z7_COM7F_IMF(CHandler::SetProperties(const wchar_t * const *names, const PROPVAR
   COM_TRY_BEGIN
   _bonds.Clear();
   InitProps();
+  _folderCache.SetMaxSize(0);
 
   for (UInt32 i = 0; i < numProps; i++)
   {
@@ -1046,6 +1107,15 @@ Z7_COM7F_IMF(CHandler::SetProperties(const wchar_t * const *names, const PROPVAR
       continue;
     }
 
+    {
+      HRESULT hres;
+      if (SetFolderCacheProperty(name, value, hres))
+      {
+        RINOK(hres)
+        continue;
+      }
+    }
+
     RINOK(SetProperty(name, value))
   }
 
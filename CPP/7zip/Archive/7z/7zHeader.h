@@ -88,11 +88,13 @@ namespace NID
     kEncodedHeader,
 
     kStartPos,
-    kDummy
+    kDummy,
 
     // kNtSecure,
     // kParent,
     // kIsAux
+
+    kDuplicate = 0x40
   };
 }
 
@@ -113,6 +115,9 @@ const UInt32 k_Deflate   = 0x40108;
 const UInt32 k_Deflate64 = 0x40109;
 const UInt32 k_BZip2     = 0x40202;
 
+// random ID (3F xx xx xx xx xx MM MM) as described in DOC/Methods.txt
+const UInt64 k_LDM = 0x3F9D4193CDC70001;
+
 const UInt32 k_BCJ   = 0x3030103;
 const UInt32 k_BCJ2  = 0x303011B;
 const UInt32 k_PPC   = 0x3030205;
@@ -123,8 +128,8 @@ const UInt32 k_SPARC = 0x3030805;
 
 const UInt32 k_AES   = 0x6F10701;
 
-// const UInt32 k_ZSTD = 0x4015D; // winzip zstd
-// 0x4F71101, 7z-zstd
+const UInt32 k_ZSTD  = 0x4F71101;
+// 0x4015D : winzip zstd
 
 static inline bool IsFilterMethod(UInt64 m)
 {
@@ -1333,6 +1333,15 @@ HRESULT CInArchive::ReadHeader(
         Read_UInt32_Vector(db.Attrib);
         break;
       }
+
+      case NID::kDuplicate:
+      {
+        ReadBoolVector2(numFiles, db.DupSource.Defs);
+        CStreamSwitch streamSwitch;
+        streamSwitch.Set(this, &dataVector);
+        Read_UInt32_Vector(db.DupSource);
+        break;
+      }
       
       /*
       case NID::kIsAux:
@@ -1451,7 +1460,14 @@ HRESULT CInArchive::ReadHeader(
 
   type = ReadID(); // Read (NID::kEnd) end of headers
 
-  if (numFiles - numEmptyStreams != unpackSizes.Size())
+  /* duplicate file has no stream, but it's not marked as empty stream.
+     So old versions that don't know (kDuplicate) report unsupported feature here. */
+  CNum numDupStreams = 0;
+  for (CNum i = 0; i < numFiles; i++)
+    if (db.IsItemDup(i) && !BoolVector_Item_IsValidAndTrue(emptyStreamVector, i))
+      numDupStreams++;
+
+  if (numFiles - numEmptyStreams - numDupStreams != unpackSizes.Size())
     ThrowUnsupported();
 
   CNum emptyFileIndex = 0;
@@ -1469,7 +1485,16 @@ HRESULT CInArchive::ReadHeader(
     CFileItem &file = db.Files[i];
     bool isAnti;
     file.Crc = 0;
-    if (!BoolVector_Item_IsValidAndTrue(emptyStreamVector, i))
+    const bool emptyStream = BoolVector_Item_IsValidAndTrue(emptyStreamVector, i);
+    if (!emptyStream && db.IsItemDup(i))
+    {
+      file.HasStream = false;
+      file.IsDir = false;
+      isAnti = false;
+      file.Size = 0;
+      file.CrcDefined = false;
+    }
+    else if (!emptyStream)
     {
       file.HasStream = true;
       file.IsDir = false;
@@ -1492,6 +1517,22 @@ HRESULT CInArchive::ReadHeader(
     if (numAntiItems != 0)
       db.IsAnti[i] = isAnti;
   }
+
+  /* duplicate file is stored as file without stream that refers to the file with data.
+     We ignore incorrect references. */
+  FOR_VECTOR (i, db.DupSource.Defs)
+  {
+    if (!db.DupSource.Defs[i])
+      continue;
+    const CFileItem &file = db.Files[i];
+    const UInt32 src = db.DupSource.Vals[i];
+    if (file.HasStream || file.IsDir || db.IsItemAnti(i)
+        || src >= numFiles || !db.Files[src].HasStream)
+    {
+      ThereIsHeaderError = true;
+      db.DupSource.Defs[i] = false;
+    }
+  }
   
   }
   
@@ -1669,23 +1710,35 @@ HRESULT CInArchive::ReadDatabase2(
     db.UnexpectedEnd = true;
     return S_FALSE;
   }
-  RINOK(_stream->Seek((Int64)nextHeaderOffset, STREAM_SEEK_CUR, NULL))
+  UInt64 headerPos;
+  RINOK(_stream->Seek((Int64)nextHeaderOffset, STREAM_SEEK_CUR, &headerPos))
 
   const size_t nextHeaderSize_t = (size_t)nextHeaderSize;
   if (nextHeaderSize_t != nextHeaderSize)
     return E_OUTOFMEMORY;
-  CByteBuffer buffer2(nextHeaderSize_t);
-
-  RINOK(ReadStream_FALSE(_stream, buffer2, nextHeaderSize_t))
+  
+  // if the stream is in memory (mapped file), we parse the header without copying
+  const Byte *headerData = InStream_GetDataPtr(_stream, headerPos, nextHeaderSize_t);
+  CByteBuffer buffer2;
+  if (headerData)
+  {
+    RINOK(_stream->Seek((Int64)nextHeaderSize, STREAM_SEEK_CUR, NULL))
+  }
+  else
+  {
+    buffer2.Alloc(nextHeaderSize_t);
+    RINOK(ReadStream_FALSE(_stream, buffer2, nextHeaderSize_t))
+    headerData = buffer2;
+  }
 
-  if (CrcCalc(buffer2, nextHeaderSize_t) != nextHeaderCRC)
+  if (CrcCalc(headerData, nextHeaderSize_t) != nextHeaderCRC)
     ThrowIncorrect();
 
   if (!db.StartHeaderWasRecovered)
     db.PhySizeWasConfirmed = true;
   
   CStreamSwitch streamSwitch;
-  streamSwitch.Set(this, buffer2);
+  streamSwitch.Set(this, headerData, nextHeaderSize_t, false);
   
   CObjectVector<CByteBuffer> dataVector;
   
@@ -117,6 +117,7 @@ struct CDatabase: public CFolders
   CUInt64DefVector StartPos;
   CUInt32DefVector Attrib;
   CBoolVector IsAnti;
+  CUInt32DefVector DupSource; // the index of file that contains the data of duplicate file
   /*
   CBoolVector IsAux;
   CByteBuffer SecureBuf;
@@ -149,6 +150,7 @@ struct CDatabase: public CFolders
     StartPos.Clear();
     Attrib.Clear();
     IsAnti.Clear();
+    DupSource.Clear();
     // IsAux.Clear();
   }
 
@@ -161,6 +163,9 @@ struct CDatabase: public CFolders
   }
   bool IsItemAnti(unsigned index) const { return (index < IsAnti.Size() && IsAnti[index]); }
   // bool IsItemAux(unsigned index) const { return (index < IsAux.Size() && IsAux[index]); }
+  bool IsItemDup(unsigned index) const { return DupSource.ValidAndDefined(index); }
+  // it returns the index of file that contains the data of item
+  unsigned GetDataIndex(unsigned index) const { return IsItemDup(index) ? (unsigned)DupSource.Vals[index] : index; }
 
   /*
   const void* GetName(unsigned index) const
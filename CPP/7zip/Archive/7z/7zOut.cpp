@@ -111,6 +111,20 @@ HRESULT COutArchive::Create_and_WriteStartPrefix(ISequentialOutStream *stream /*
   #endif
 }
 
+HRESULT COutArchive::Create_for_Append(ISequentialOutStream *stream, UInt64 signatureHeaderPos)
+{
+  Close();
+  #ifdef Z7_7Z_VOL
+  _endMarker = false;
+  #endif
+  SeqStream = stream;
+  SeqStream.QueryInterface(IID_IOutStream, &Stream);
+  if (!Stream)
+    return E_NOTIMPL;
+  _signatureHeaderPos = signatureHeaderPos;
+  return S_OK;
+}
+
 void COutArchive::Close()
 {
   SeqStream.Release();
@@ -605,12 +619,16 @@ void COutArchive::WriteHeader(
 
   {
     /* ---------- Empty Streams ---------- */
+    /* duplicate file has no stream, but we don't mark it as empty stream.
+       So old versions of 7-Zip can't open the archive with duplicate files
+       (the number of streams doesn't match the number of unpack sizes),
+       instead of extracting duplicate files as empty files. */
     CBoolVector emptyStreamVector;
     emptyStreamVector.ClearAndSetSize(db.Files.Size());
     unsigned numEmptyStreams = 0;
     {
       FOR_VECTOR (i, db.Files)
-        if (db.Files[i].HasStream)
+        if (db.Files[i].HasStream || db.IsItemDup(i))
           emptyStreamVector[i] = false;
         else
         {
@@ -632,7 +650,7 @@ void COutArchive::WriteHeader(
       FOR_VECTOR (i, db.Files)
       {
         const CFileItem &file = db.Files[i];
-        if (file.HasStream)
+        if (file.HasStream || db.IsItemDup(i))
           continue;
         emptyFileVector[cur] = !file.IsDir;
         if (!file.IsDir)
@@ -733,6 +751,21 @@ void COutArchive::WriteHeader(
     }
   }
 
+  {
+    /* ---------- Write DupSource ---------- */
+    const unsigned numDefined = BoolVector_CountSum(db.DupSource.Defs);
+    
+    if (numDefined != 0)
+    {
+      WriteAlignedBools(db.DupSource.Defs, numDefined, NID::kDuplicate, 2);
+      FOR_VECTOR (i, db.DupSource.Defs)
+      {
+        if (db.DupSource.Defs[i])
+          WriteUInt32(db.DupSource.Vals[i]);
+      }
+    }
+  }
+
   /*
   {
     // ---------- Write IsAux ----------
@@ -952,4 +985,10 @@ void CArchiveDatabaseOut::AddFile(const CFileItem &file, const CFileItem2 &file2
   Files.Add(file);
 }
 
+void CArchiveDatabaseOut::AddDupFile(const CFileItem &file, const CFileItem2 &file2, const UString &name, UInt32 sourceIndex)
+{
+  DupSource.SetItem(Files.Size(), true, sourceIndex);
+  AddFile(file, file2, name);
+}
+
 }}
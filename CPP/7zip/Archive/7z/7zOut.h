@@ -136,6 +136,7 @@ struct CArchiveDatabaseOut: public COutFolders
   CUInt64DefVector StartPos;
   CUInt32DefVector Attrib;
   CBoolVector IsAnti;
+  CUInt32DefVector DupSource;
 
   /*
   CBoolVector IsAux;
@@ -168,6 +169,7 @@ struct CArchiveDatabaseOut: public COutFolders
     StartPos.Clear();
     Attrib.Clear();
     IsAnti.Clear();
+    DupSource.Clear();
 
     /*
     IsAux.Clear();
@@ -191,6 +193,7 @@ struct CArchiveDatabaseOut: public COutFolders
     StartPos.ReserveDown();
     Attrib.ReserveDown();
     IsAnti.ReserveDown();
+    DupSource.ReserveDown();
 
     /*
     IsAux.ReserveDown();
@@ -215,10 +218,12 @@ struct CArchiveDatabaseOut: public COutFolders
         && MTime.CheckSize(size)
         && StartPos.CheckSize(size)
         && Attrib.CheckSize(size)
+        && DupSource.CheckSize(size)
         && (size == IsAnti.Size() || IsAnti.Size() == 0));
   }
 
   bool IsItemAnti(unsigned index) const { return (index < IsAnti.Size() && IsAnti[index]); }
+  bool IsItemDup(unsigned index) const { return DupSource.ValidAndDefined(index); }
   // bool IsItemAux(unsigned index) const { return (index < IsAux.Size() && IsAux[index]); }
 
   void SetItem_Anti(unsigned index, bool isAnti)
@@ -237,6 +242,8 @@ struct CArchiveDatabaseOut: public COutFolders
   */
 
   void AddFile(const CFileItem &file, const CFileItem2 &file2, const UString &name);
+  // it adds empty file that refers to the data of file (sourceIndex)
+  void AddDupFile(const CFileItem &file, const CFileItem2 &file2, const UString &name, UInt32 sourceIndex);
 };
 
 
@@ -312,6 +319,10 @@ public:
 
   COutArchive() { _outByte.Create(1 << 16); }
   HRESULT Create_and_WriteStartPrefix(ISequentialOutStream *stream /* , bool endMarker */);
+  /* it's used to write new data after the end of existing archive.
+     (stream) must be positioned at the end of archive.
+     WriteDatabase() will rewrite old start header at (signatureHeaderPos). */
+  HRESULT Create_for_Append(ISequentialOutStream *stream, UInt64 signatureHeaderPos);
   void Close();
   HRESULT WriteDatabase(
       DECL_EXTERNAL_CODECS_LOC_VARS
@@ -48,7 +48,8 @@ static const CPropMap kPropMap[] =
 
   { NID::kCRC, STAT_PROP2(kpidCRC, VT_UI4) },
   // { NID::kIsAux, STAT_PROP2(kpidIsAux, VT_BOOL) },
-  { NID::kAnti, STAT_PROP2(kpidIsAnti, VT_BOOL) }
+  { NID::kAnti, STAT_PROP2(kpidIsAnti, VT_BOOL) },
+  { NID::kDuplicate, STAT_PROP2(kpidCopyLink, VT_BSTR) }
 
   #ifndef Z7_SFX
   , { k_7z_id_Encrypted, STAT_PROP2(kpidEncrypted, VT_BOOL) }
@@ -3,7 +3,9 @@
 #include "StdAfx.h"
 
 #include "../../../../C/CpuArch.h"
+#include "../../../../C/Sha256.h"
 
+#include "../../../Common/MyBuffer2.h"
 #include "../../../Common/MyLinux.h"
 #include "../../../Common/StringToInt.h"
 #include "../../../Common/Wildcard.h"
@@ -965,10 +967,54 @@ static bool IsExt_ExeUnix_NumericAllowed(const UString &path)
 }
 
 
+/*
+  Content sketch is MinHash signature of file data (one permutation hashing):
+  each 8-byte shingle in the start of file is hashed,
+  and we keep the minimal hash for each of (kNumSketchHashes) hash ranges.
+  The probability that two sketches contain same value in some position
+  is close to Jaccard similarity of shingle sets of files.
+*/
+
+static const unsigned kNumSketchHashes_Log = 4;
+static const unsigned kNumSketchHashes = 1 << kNumSketchHashes_Log;
+static const UInt32 kSketchHash_Empty = (UInt32)0xFFFFFFFF;
+static const size_t kSketchBufSize = 1 << 16;
+
+struct CContentSketch
+{
+  UInt32 Hashes[kNumSketchHashes];
+
+  void Clear()
+  {
+    for (unsigned i = 0; i < kNumSketchHashes; i++)
+      Hashes[i] = kSketchHash_Empty;
+  }
+};
+
+static void CalcSketch(const Byte *p, size_t size, CContentSketch &sketch)
+{
+  sketch.Clear();
+  if (size < 8)
+    return;
+  const Byte *lim = p + size - 8;
+  for (; p <= lim; p++)
+  {
+    UInt64 h = GetUi64(p) * UINT64_CONST(0x9E3779B97F4A7C15);
+    h ^= h >> 29;
+    h *= UINT64_CONST(0xBF58476D1CE4E5B9);
+    const UInt32 h32 = (UInt32)(h >> 32);
+    UInt32 &m = sketch.Hashes[h32 >> (32 - kNumSketchHashes_Log)];
+    if (m > h32)
+      m = h32;
+  }
+}
+
+
 struct CAnalysis
 {
   CMyComPtr<IArchiveUpdateCallbackFile> Callback;
   CByteBuffer Buffer;
+  CByteBuffer SketchBuffer;
 
   bool ParseWav;
   bool ParseExe;
@@ -995,6 +1041,7 @@ struct CAnalysis
   {}
 
   HRESULT GetFilterGroup(UInt32 index, const CUpdateItem &ui, CFilterMode &filterMode);
+  HRESULT GetSketch(UInt32 index, const CUpdateItem &ui, CContentSketch &sketch);
 };
 
 static const size_t kAnalysisBufSize = 1 << 14;
@@ -1166,6 +1213,283 @@ HRESULT CAnalysis::GetFilterGroup(UInt32 index, const CUpdateItem &ui, CFilterMo
   return S_OK;
 }
 
+HRESULT CAnalysis::GetSketch(UInt32 index, const CUpdateItem &ui, CContentSketch &sketch)
+{
+  sketch.Clear();
+  if (!Callback || ui.Size < kNumSketchHashes * 8)
+    return S_OK;
+  if (SketchBuffer.Size() != kSketchBufSize)
+    SketchBuffer.Alloc(kSketchBufSize);
+  CMyComPtr<ISequentialInStream> stream;
+  HRESULT result = Callback->GetStream2(index, &stream, NUpdateNotifyOp::kAnalyze);
+  if (result == S_OK && stream)
+  {
+    size_t size = kSketchBufSize;
+    result = ReadStream(stream, SketchBuffer, &size);
+    stream.Release();
+    if (result == S_OK)
+      CalcSketch(SketchBuffer, size, sketch);
+  }
+  return S_OK;
+}
+
+
+/*
+  We use LSH (locality-sensitive hashing) with (kNumSketchBands) bands of sketch.
+  The files that have same values in all positions of some band are placed to one cluster.
+  The clusters are ordered by first file of cluster in original order,
+  and the files in cluster are stored in original order.
+*/
+
+static const unsigned kNumSketchBands = 4;
+static const unsigned kSketchBandSize = kNumSketchHashes / kNumSketchBands;
+
+struct CSketchBandRef
+{
+  UInt64 Key;
+  unsigned Item;
+};
+
+static int CompareSketchBandRefs(const CSketchBandRef *p1, const CSketchBandRef *p2, void * /* param */)
+{
+  RINOZ_COMP(p1->Key, p2->Key)
+  RINOZ_COMP(p1->Item, p2->Item)
+  return 0;
+}
+
+static unsigned FindClusterRoot(CRecordVector<unsigned> &parents, unsigned i)
+{
+  while (parents[i] != i)
+  {
+    parents[i] = parents[parents[i]];
+    i = parents[i];
+  }
+  return i;
+}
+
+static void ClusterSimilarItems(const CRecordVector<CContentSketch> &sketches, UInt32 *indices, unsigned numItems)
+{
+  CRecordVector<CSketchBandRef> refs;
+  refs.ClearAndReserve(numItems * kNumSketchBands);
+  unsigned i;
+  
+  for (i = 0; i < numItems; i++)
+  {
+    const CContentSketch &sketch = sketches[indices[i]];
+    for (unsigned b = 0; b < kNumSketchBands; b++)
+    {
+      const UInt32 *hashes = sketch.Hashes + b * kSketchBandSize;
+      UInt64 key = b;
+      unsigned k;
+      for (k = 0; k < kSketchBandSize; k++)
+      {
+        if (hashes[k] == kSketchHash_Empty)
+          break;
+        key = (key ^ hashes[k]) * UINT64_CONST(0x9E3779B97F4A7C15);
+        key ^= key >> 32;
+      }
+      if (k != kSketchBandSize)
+        continue;
+      CSketchBandRef ref;
+      ref.Key = key;
+      ref.Item = i;
+      refs.AddInReserved(ref);
+    }
+  }
+
+  if (refs.Size() < 2)
+    return;
+  refs.Sort(CompareSketchBandRefs, NULL);
+
+  CRecordVector<unsigned> parents;
+  parents.ClearAndSetSize(numItems);
+  for (i = 0; i < numItems; i++)
+    parents[i] = i;
+
+  bool wasMerged = false;
+  for (i = 1; i < refs.Size(); i++)
+  {
+    if (refs[i].Key != refs[i - 1].Key)
+      continue;
+    const unsigned r1 = FindClusterRoot(parents, refs[i - 1].Item);
+    const unsigned r2 = FindClusterRoot(parents, refs[i].Item);
+    if (r1 == r2)
+      continue;
+    // the root of cluster is the first item of cluster
+    if (r1 < r2)
+      parents[r2] = r1;
+    else
+      parents[r1] = r2;
+    wasMerged = true;
+  }
+
+  if (!wasMerged)
+    return;
+
+  // (next) and (last) are lists of items of clusters
+  CRecordVector<unsigned> next;
+  CRecordVector<unsigned> last;
+  next.ClearAndSetSize(numItems);
+  last.ClearAndSetSize(numItems);
+  for (i = 0; i < numItems; i++)
+  {
+    next[i] = (unsigned)(int)-1;
+    const unsigned r = FindClusterRoot(parents, i);
+    if (r != i)
+      next[last[r]] = i;
+    last[r] = i;
+  }
+
+  CObjArray<UInt32> temp(numItems);
+  unsigned numOut = 0;
+  for (i = 0; i < numItems; i++)
+  {
+    if (parents[i] != i)
+      continue;
+    for (unsigned k = i; k != (unsigned)(int)-1; k = next[k])
+      temp[numOut++] = indices[k];
+  }
+  for (i = 0; i < numItems; i++)
+    indices[i] = temp[i];
+}
+
+
+/*
+  Whole-file deduplication:
+  The new files that have same size are compared by SHA-256 digest of full data.
+  If the file has same data as some previous file, it's written as duplicate item
+  that refers to that previous file, and the data of duplicate file is not compressed.
+*/
+
+static const size_t kDigestBufSize = 1 << 20;
+
+struct CDupRef
+{
+  UInt64 Size;
+  unsigned Item;
+  bool DigestDefined;
+  Byte Digest[SHA256_DIGEST_SIZE];
+};
+
+static int CompareDupRefs(const CDupRef *p1, const CDupRef *p2, void * /* param */)
+{
+  RINOZ_COMP(p1->Size, p2->Size)
+  RINOZ_COMP(p1->DigestDefined, p2->DigestDefined)
+  if (p1->DigestDefined)
+  {
+    RINOZ(memcmp(p1->Digest, p2->Digest, SHA256_DIGEST_SIZE))
+  }
+  RINOZ_COMP(p1->Item, p2->Item)
+  return 0;
+}
+
+static HRESULT GetFileDigest(IArchiveUpdateCallbackFile *callback, UInt32 index, UInt64 fileSize,
+    CAlignedBuffer &buf, CDupRef &ref)
+{
+  if (buf.Size() != sizeof(CSha256) + kDigestBufSize)
+    buf.Alloc(sizeof(CSha256) + kDigestBufSize);
+  CSha256 *sha = (CSha256 *)(void *)(Byte *)buf;
+  Byte *data = (Byte *)buf + sizeof(CSha256);
+  
+  CMyComPtr<ISequentialInStream> stream;
+  const HRESULT result = callback->GetStream2(index, &stream, NUpdateNotifyOp::kAnalyze);
+  if (result != S_OK || !stream)
+    return S_OK;
+  
+  Sha256_Init(sha);
+  UInt64 total = 0;
+  for (;;)
+  {
+    size_t size = kDigestBufSize;
+    if (ReadStream(stream, data, &size) != S_OK)
+      return S_OK;
+    if (size == 0)
+      break;
+    Sha256_Update(sha, data, size);
+    total += size;
+  }
+  // the file could be changed after the scan of directory
+  if (total != fileSize)
+    return S_OK;
+  Sha256_Final(sha, ref.Digest);
+  ref.DigestDefined = true;
+  return S_OK;
+}
+
+struct CDupItemRef
+{
+  unsigned SourceIndex; // the index of source file in new archive
+  unsigned UpdateIndex;
+};
+
+static int CompareDupItemRefs(const CDupItemRef *p1, const CDupItemRef *p2, void * /* param */)
+{
+  RINOZ_COMP(p1->SourceIndex, p2->SourceIndex)
+  RINOZ_COMP(p1->UpdateIndex, p2->UpdateIndex)
+  return 0;
+}
+
+/* FindDuplicates() sets (dupSources[i]) to the index of source item for each duplicate item.
+   (dupSize) is the total size of duplicate items. */
+
+static HRESULT FindDuplicates(IArchiveUpdateCallbackFile *callback, CLocalProgress *lps,
+    const CObjectVector<CUpdateItem> &updateItems, CRecordVector<int> &dupSources, UInt64 &dupSize)
+{
+  dupSize = 0;
+  CRecordVector<CDupRef> refs;
+  unsigned i;
+  
+  for (i = 0; i < updateItems.Size(); i++)
+  {
+    const CUpdateItem &ui = updateItems[i];
+    if (!ui.NewData || !ui.HasStream())
+      continue;
+    CDupRef ref;
+    ref.Size = ui.Size;
+    ref.Item = i;
+    ref.DigestDefined = false;
+    refs.Add(ref);
+  }
+  
+  if (refs.Size() < 2)
+    return S_OK;
+  refs.Sort(CompareDupRefs, NULL);
+
+  // we read only the files that have same size as another file
+  CAlignedBuffer buf;
+  for (i = 0; i < refs.Size(); i++)
+  {
+    CDupRef &ref = refs[i];
+    if ((i == 0 || refs[i - 1].Size != ref.Size)
+        && (i + 1 == refs.Size() || refs[i + 1].Size != ref.Size))
+      continue;
+    RINOK(GetFileDigest(callback, ref.Item, ref.Size, buf, ref))
+    RINOK(lps->SetCur())
+  }
+  
+  refs.Sort(CompareDupRefs, NULL);
+  
+  // the source item is the first item with same data in original order
+  unsigned first = 0;
+  for (i = 1; i < refs.Size(); i++)
+  {
+    const CDupRef &ref = refs[i];
+    const CDupRef &src = refs[first];
+    if (ref.DigestDefined
+        && src.DigestDefined
+        && ref.Size == src.Size
+        && memcmp(ref.Digest, src.Digest, SHA256_DIGEST_SIZE) == 0)
+    {
+      dupSources[ref.Item] = (int)src.Item;
+      dupSize += ref.Size;
+    }
+    else
+      first = i;
+  }
+  return S_OK;
+}
+
+
 static inline void GetMethodFull(UInt64 methodID, UInt32 numStreams, CMethodFull &m)
 {
   m.Id = methodID;
@@ -1801,6 +2125,91 @@ static void GetFile(const CDatabase &inDb, unsigned index, CFileItem &file, CFil
   // file2.IsAux = inDb.IsItemAux(index);
 }
 
+// it adds the description of old folder (folderIndex) with old pack streams
+static void AddOldFolder(const CDbEx &db, unsigned folderIndex, CArchiveDatabaseOut &newDatabase)
+{
+  const unsigned folderIndex_New = newDatabase.Folders.Size();
+  CFolder &folder = newDatabase.Folders.AddNew();
+  // v23.01: we copy FolderCrc, if FolderCrc was used
+  if (db.FolderCRCs.ValidAndDefined(folderIndex))
+    newDatabase.FolderUnpackCRCs.SetItem(folderIndex_New,
+        true, db.FolderCRCs.Vals[folderIndex]);
+
+  db.ParseFolderInfo(folderIndex, folder);
+  const CNum startIndex = db.FoStartPackStreamIndex[folderIndex];
+  FOR_VECTOR (j, folder.PackStreams)
+  {
+    newDatabase.PackSizes.Add(db.GetStreamPackSize(startIndex + j));
+    // newDatabase.PackCRCsDefined.Add(db.PackCRCsDefined[startIndex + j]);
+    // newDatabase.PackCRCs.Add(db.PackCRCs[startIndex + j]);
+  }
+
+  size_t indexStart = db.FoToCoderUnpackSizes[folderIndex];
+  const size_t indexEnd = db.FoToCoderUnpackSizes[folderIndex + 1];
+  for (; indexStart < indexEnd; indexStart++)
+    newDatabase.CoderUnpackSizes.Add(db.CoderUnpackSizes[indexStart]);
+}
+
+// it adds old files that keep their data in old folder (folderIndex)
+static void AddOldFolderFiles(const CDbEx &db, unsigned folderIndex,
+    const CObjectVector<CUpdateItem> &updateItems,
+    const CIntArr &fileIndexToUpdateIndexMap,
+    CRecordVector<int> &newFileIndexes,
+    CArchiveDatabaseOut &newDatabase)
+{
+  const CNum numUnpackStreams = db.NumUnpackStreamsVector[folderIndex];
+  CNum indexInFolder = 0;
+  for (CNum fi = db.FolderStartFileIndex[folderIndex]; indexInFolder < numUnpackStreams; fi++)
+  {
+    if (db.Files[fi].HasStream)
+    {
+      indexInFolder++;
+      const int updateIndex = fileIndexToUpdateIndexMap[fi];
+      if (updateIndex >= 0)
+      {
+        const CUpdateItem &ui = updateItems[(unsigned)updateIndex];
+        if (ui.NewData)
+          continue;
+
+        UString name;
+        CFileItem file;
+        CFileItem2 file2;
+        /* (arcIndex != fi), if it's duplicate item that
+           takes the data of deleted source file (fi) */
+        const unsigned arcIndex = (unsigned)ui.IndexInArchive;
+        GetFile(db, arcIndex, file, file2);
+        if (arcIndex != fi)
+        {
+          const CFileItem &srcFile = db.Files[fi];
+          file.HasStream = true;
+          file.Size = srcFile.Size;
+          file.Crc = srcFile.Crc;
+          file.CrcDefined = srcFile.CrcDefined;
+        }
+
+        if (ui.NewProps)
+        {
+          UpdateItem_To_FileItem2(ui, file2);
+          file.IsDir = ui.IsDir;
+          name = ui.Name;
+        }
+        else
+          db.GetPath(arcIndex, name);
+
+        /*
+        file.Parent = ui.ParentFolderIndex;
+        if (ui.TreeFolderIndex >= 0)
+          treeFolderToArcIndex[ui.TreeFolderIndex] = newDatabase.Files.Size();
+        if (totalSecureDataSize != 0)
+          newDatabase.SecureIDs.Add(ui.SecureIndex);
+        */
+        newFileIndexes[(unsigned)updateIndex] = (int)newDatabase.Files.Size();
+        newDatabase.AddFile(file, file2, name);
+      }
+    }
+  }
+}
+
 HRESULT Update(
     DECL_EXTERNAL_CODECS_LOC_VARS
     IInStream *inStream,
@@ -1839,6 +2248,8 @@ HRESULT Update(
         outStream, seqOutStream)
     if (!outStream)
       return E_NOTIMPL;
+    if (options.AppendMode && !db)
+      return E_NOTIMPL;
     const UInt64 sfxBlockSize = (db && !options.RemoveSfxBlock) ?
         db->ArcInfo.StartPosition: 0;
     seqOutStream->QueryInterface(IID_IStreamSetRestriction, (void **)&v_StreamSetRestriction);
@@ -1850,14 +2261,23 @@ HRESULT Update(
           outStream ? offset + sfxBlockSize : 0,
           outStream ? offset + sfxBlockSize + k_StartHeadersRewriteSize : 0))
     }
+    if (options.AppendMode)
+    {
+      /* (seqOutStream) is the file of old archive (db) opened for writing.
+         The old data (including SFX stub) stays in place,
+         and we write new data after the end of old archive. */
+      RINOK(outStream->Seek((Int64)(db->ArcInfo.StartPosition + db->PhySize), STREAM_SEEK_SET, NULL))
+    }
     outStream.Release();
-    if (sfxBlockSize != 0)
+    if (sfxBlockSize != 0 && !options.AppendMode)
     {
       RINOK(WriteRange(inStream, seqOutStream, 0, sfxBlockSize, NULL))
     }
   }
 
   CIntArr fileIndexToUpdateIndexMap;
+  // (keepFolders[i] == true) : old folder (i) with all its files stays in place in append mode
+  CBoolArr keepFolders;
   UInt64 complexity = 0;
   UInt64 inSizeForReduce2 = 0;
 
@@ -1897,6 +2317,13 @@ HRESULT Update(
     for (i = 0; i < db->Files.Size(); i++)
       fileIndexToUpdateIndexMap[i] = -1;
 
+    if (options.AppendMode)
+    {
+      keepFolders.Alloc(db->NumFolders);
+      for (i = 0; i < db->NumFolders; i++)
+        keepFolders[i] = false;
+    }
+
     for (i = 0; i < updateItems.Size(); i++)
     {
       int index = updateItems[i].IndexInArchive;
@@ -1904,6 +2331,19 @@ HRESULT Update(
         fileIndexToUpdateIndexMap[(unsigned)index] = (int)i;
     }
 
+    /* If the source file of old duplicate item is deleted or replaced,
+       the duplicate item takes the data of that source file in old folder. */
+    for (i = 0; i < updateItems.Size(); i++)
+    {
+      const CUpdateItem &ui = updateItems[i];
+      if (ui.NewData || ui.IndexInArchive == -1 || !db->IsItemDup((unsigned)ui.IndexInArchive))
+        continue;
+      const UInt32 src = db->DupSource.Vals[(unsigned)ui.IndexInArchive];
+      const int srcUpdateIndex = fileIndexToUpdateIndexMap[src];
+      if (srcUpdateIndex < 0 || updateItems[(unsigned)srcUpdateIndex].NewData)
+        fileIndexToUpdateIndexMap[src] = (int)i;
+    }
+
     for (i = 0; i < db->NumFolders; i++)
     {
       CNum indexInFolder = 0;
@@ -1932,6 +2372,12 @@ HRESULT Update(
       if (numCopyItems == 0)
         continue;
 
+      if (options.AppendMode && numCopyItems == numUnpackStreams)
+      {
+        keepFolders[i] = true;
+        continue;
+      }
+
       CFolderRepack rep;
       rep.FolderIndex = i;
       rep.NumCopyFiles = numCopyItems;
@@ -2021,6 +2467,42 @@ HRESULT Update(
   }
   #endif
 
+  /* content sketches are used to place similar files together in solid blocks.
+     If (SolidExtension) mode is used, each extension is placed to separate solid block,
+     so we don't change the order of files in that mode. */
+  CRecordVector<CContentSketch> sketches;
+  const bool useContentSorting = options.UseContentSorting
+      && numSolidFiles > 1
+      && options.NumSolidBytes != 0
+      && !options.SolidExtension
+      && opCallback;
+  if (useContentSorting)
+    sketches.ClearAndSetSize(updateItems.Size());
+
+  // (dupSources[i] >= 0) means that new item (i) has same data as new item (dupSources[i])
+  CRecordVector<int> dupSources;
+  // (newFileIndexes[i]) is the index of item (i) with data in new archive
+  CRecordVector<int> newFileIndexes;
+  dupSources.ClearAndSetSize(updateItems.Size());
+  newFileIndexes.ClearAndSetSize(updateItems.Size());
+  {
+    FOR_VECTOR (i, dupSources)
+    {
+      dupSources[i] = -1;
+      newFileIndexes[i] = -1;
+    }
+  }
+  if (options.UseDedup && opCallback)
+  {
+    UInt64 dupSize;
+    RINOK(FindDuplicates(opCallback, lps, updateItems, dupSources, dupSize))
+    if (dupSize != 0 && complexity >= dupSize)
+    {
+      complexity -= dupSize;
+      RINOK(updateCallback->SetTotal(complexity))
+    }
+  }
+
   {
     CAnalysis analysis;
     // analysis.Need_ATime = options.Need_ATime;
@@ -2053,7 +2535,7 @@ HRESULT Update(
     FOR_VECTOR (i, updateItems)
     {
       const CUpdateItem &ui = updateItems[i];
-      if (!ui.NewData || !ui.HasStream())
+      if (!ui.NewData || !ui.HasStream() || dupSources[i] >= 0)
         continue;
 
       CFilterMode2 fm;
@@ -2069,6 +2551,11 @@ HRESULT Update(
         }
         */
       }
+      if (useContentSorting)
+      {
+        analysis.Callback = opCallback;
+        RINOK(analysis.GetSketch(i, ui, sketches[i]))
+      }
       fm.Encrypted = method.PasswordIsDefined;
 
       const unsigned groupIndex = GetGroup(filters, fm);
@@ -2115,7 +2602,14 @@ HRESULT Update(
   COutArchive archive;
   CArchiveDatabaseOut newDatabase;
 
-  RINOK(archive.Create_and_WriteStartPrefix(seqOutStream))
+  if (options.AppendMode)
+  {
+    RINOK(archive.Create_for_Append(seqOutStream, db->ArcInfo.StartPosition))
+  }
+  else
+  {
+    RINOK(archive.Create_and_WriteStartPrefix(seqOutStream))
+  }
 
   /*
   CIntVector treeFolderToArcIndex;
@@ -2176,7 +2670,9 @@ HRESULT Update(
         if (ui.HasStream())
           continue;
       }
-      else if (ui.IndexInArchive != -1 && db->Files[(unsigned)ui.IndexInArchive].HasStream)
+      else if (ui.IndexInArchive != -1
+          && (db->Files[(unsigned)ui.IndexInArchive].HasStream
+            || db->IsItemDup((unsigned)ui.IndexInArchive)))
         continue;
       /*
       if (ui.TreeFolderIndex >= 0)
@@ -2216,6 +2712,60 @@ HRESULT Update(
 
   lps->ProgressOffset = 0;
 
+  if (options.AppendMode)
+  {
+    // ---------- Keep old solid blocks in place ----------
+
+    /* Pack streams of old folders are not moved in append mode.
+       So we keep all old folders in the new database in original order.
+       The old folder without kept files stays as folder without files
+       (NumUnpackStreams == 0). The space of such folders is freed by next
+       update in usual mode. Partially used old folders are repacked to new folders. */
+    
+    for (unsigned folderIndex = 0; folderIndex < db->NumFolders; folderIndex++)
+    {
+      AddOldFolder(*db, folderIndex, newDatabase);
+      if (!keepFolders[folderIndex])
+      {
+        newDatabase.NumUnpackStreamsVector.Add(0);
+        continue;
+      }
+      if (opCallback)
+      {
+        RINOK(opCallback->ReportOperation(
+            NEventIndexType::kBlockIndex, (UInt32)folderIndex,
+            NUpdateNotifyOp::kReplicate))
+      }
+      newDatabase.NumUnpackStreamsVector.Add(db->NumUnpackStreamsVector[folderIndex]);
+      AddOldFolderFiles(*db, folderIndex, updateItems,
+          fileIndexToUpdateIndexMap, newFileIndexes, newDatabase);
+    }
+
+    /* The old headers are placed between the old pack streams and the new data.
+       We describe that area as additional "Copy" folder without files,
+       because the pack streams in 7z archive must be contiguous. */
+    UInt64 packEnd = db->ArcInfo.StartPositionAfterHeader;
+    if (db->NumPackStreams != 0)
+      packEnd = db->ArcInfo.DataStartPosition + db->PackPositions[db->NumPackStreams];
+    const UInt64 arcEnd = db->ArcInfo.StartPosition + db->PhySize;
+    if (arcEnd < packEnd)
+      return E_FAIL;
+    const UInt64 gapSize = arcEnd - packEnd;
+    if (gapSize != 0)
+    {
+      CFolder &folder = newDatabase.Folders.AddNew();
+      folder.Coders.SetSize(1);
+      CCoderInfo &coder = folder.Coders[0];
+      coder.MethodID = k_Copy;
+      coder.NumStreams = 1;
+      folder.PackStreams.SetSize(1);
+      folder.PackStreams[0] = 0;
+      newDatabase.PackSizes.Add(gapSize);
+      newDatabase.CoderUnpackSizes.Add(gapSize);
+      newDatabase.NumUnpackStreamsVector.Add(0);
+    }
+  }
+
   {
     // ---------- Sort Filters ----------
     FOR_VECTOR (i, filters)
@@ -2302,26 +2852,7 @@ HRESULT Update(
             db->GetFolderStreamPos(folderIndex, 0), packSize, progress))
         lps->ProgressOffset += packSize;
 
-        const unsigned folderIndex_New = newDatabase.Folders.Size();
-        CFolder &folder = newDatabase.Folders.AddNew();
-        // v23.01: we copy FolderCrc, if FolderCrc was used
-        if (db->FolderCRCs.ValidAndDefined(folderIndex))
-          newDatabase.FolderUnpackCRCs.SetItem(folderIndex_New,
-              true, db->FolderCRCs.Vals[folderIndex]);
-
-        db->ParseFolderInfo(folderIndex, folder);
-        const CNum startIndex = db->FoStartPackStreamIndex[folderIndex];
-        FOR_VECTOR (j, folder.PackStreams)
-        {
-          newDatabase.PackSizes.Add(db->GetStreamPackSize(startIndex + j));
-          // newDatabase.PackCRCsDefined.Add(db.PackCRCsDefined[startIndex + j]);
-          // newDatabase.PackCRCs.Add(db.PackCRCs[startIndex + j]);
-        }
-
-        size_t indexStart = db->FoToCoderUnpackSizes[folderIndex];
-        const size_t indexEnd = db->FoToCoderUnpackSizes[folderIndex + 1];
-        for (; indexStart < indexEnd; indexStart++)
-          newDatabase.CoderUnpackSizes.Add(db->CoderUnpackSizes[indexStart]);
+        AddOldFolder(*db, folderIndex, newDatabase);
       }
       else
       {
@@ -2557,45 +3088,8 @@ HRESULT Update(
       }
       
       newDatabase.NumUnpackStreamsVector.Add(rep.NumCopyFiles);
-      
-      CNum indexInFolder = 0;
-      for (CNum fi = db->FolderStartFileIndex[folderIndex]; indexInFolder < numUnpackStreams; fi++)
-      {
-        if (db->Files[fi].HasStream)
-        {
-          indexInFolder++;
-          const int updateIndex = fileIndexToUpdateIndexMap[fi];
-          if (updateIndex >= 0)
-          {
-            const CUpdateItem &ui = updateItems[(unsigned)updateIndex];
-            if (ui.NewData)
-              continue;
-
-            UString name;
-            CFileItem file;
-            CFileItem2 file2;
-            GetFile(*db, fi, file, file2);
-
-            if (ui.NewProps)
-            {
-              UpdateItem_To_FileItem2(ui, file2);
-              file.IsDir = ui.IsDir;
-              name = ui.Name;
-            }
-            else
-              db->GetPath(fi, name);
-
-            /*
-            file.Parent = ui.ParentFolderIndex;
-            if (ui.TreeFolderIndex >= 0)
-              treeFolderToArcIndex[ui.TreeFolderIndex] = newDatabase.Files.Size();
-            if (totalSecureDataSize != 0)
-              newDatabase.SecureIDs.Add(ui.SecureIndex);
-            */
-            newDatabase.AddFile(file, file2, name);
-          }
-        }
-      }
+      AddOldFolderFiles(*db, folderIndex, updateItems,
+          fileIndexToUpdateIndexMap, newFileIndexes, newDatabase);
     }
 
 
@@ -2637,6 +3131,9 @@ HRESULT Update(
       newDatabase.Files.Add(file);
       */
     }
+
+    if (useContentSorting)
+      ClusterSimilarItems(sketches, indices, numFiles);
     
     for (i = 0; i < numFiles;)
     {
@@ -2819,6 +3316,8 @@ HRESULT Update(
         */
 
         // numProcessedFiles++;
+        if (file.HasStream)
+          newFileIndexes[indices[i + subIndex]] = (int)newDatabase.Files.Size();
         newDatabase.AddFile(file, file2, name);
       }
 
@@ -2936,6 +3435,73 @@ HRESULT Update(
 
   RINOK(lps->SetCur())
 
+  {
+    /* ---------- Write duplicate files ---------- */
+    /* Duplicate items are sorted by source files,
+       so extraction can unpack the data of all these items in one pass. */
+    CRecordVector<CDupItemRef> dupRefs;
+    
+    FOR_VECTOR (i, updateItems)
+    {
+      const CUpdateItem &ui = updateItems[i];
+      int srcUpdateIndex = -1;
+      if (ui.NewData)
+        srcUpdateIndex = dupSources[i];
+      else if (ui.IndexInArchive != -1 && db->IsItemDup((unsigned)ui.IndexInArchive))
+      {
+        srcUpdateIndex = fileIndexToUpdateIndexMap[db->DupSource.Vals[(unsigned)ui.IndexInArchive]];
+        if (srcUpdateIndex == (int)i)
+          continue; // the item took the data of deleted source file
+        if (srcUpdateIndex < 0)
+          return E_FAIL;
+      }
+      if (srcUpdateIndex < 0)
+        continue;
+      const int srcIndex = newFileIndexes[(unsigned)srcUpdateIndex];
+      if (srcIndex < 0)
+      {
+        // the source file was not added to archive, if it was not opened
+        if (ui.NewData)
+          continue;
+        return E_FAIL;
+      }
+      CDupItemRef ref;
+      ref.SourceIndex = (unsigned)srcIndex;
+      ref.UpdateIndex = i;
+      dupRefs.Add(ref);
+    }
+    
+    dupRefs.Sort(CompareDupItemRefs, NULL);
+    
+    FOR_VECTOR (k, dupRefs)
+    {
+      const CDupItemRef &ref = dupRefs[k];
+      const CUpdateItem &ui = updateItems[ref.UpdateIndex];
+      CFileItem file;
+      CFileItem2 file2;
+      UString name;
+      if (ui.NewProps)
+      {
+        UpdateItem_To_FileItem(ui, file, file2);
+        name = ui.Name;
+      }
+      else
+      {
+        GetFile(*db, (unsigned)ui.IndexInArchive, file, file2);
+        db->GetPath((unsigned)ui.IndexInArchive, name);
+      }
+      file.HasStream = false;
+      file.IsDir = false;
+      file.Size = 0;
+      file.CrcDefined = false;
+      file.Crc = 0;
+      file2.IsAnti = false;
+      newDatabase.AddDupFile(file, file2, name, ref.SourceIndex);
+    }
+    
+    newDatabase.DupSource.if_NonEmpty_FillResedue_with_false(newDatabase.Files.Size());
+  }
+
   /*
   fileIndexToUpdateIndexMap.ClearAndFree();
   groups.ClearAndFree();
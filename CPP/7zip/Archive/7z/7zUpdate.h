@@ -99,8 +99,11 @@ struct CUpdateOptions
   bool SolidExtension;
   
   bool UseTypeSorting;
+  bool UseContentSorting; // place files with similar content together in solid blocks
+  bool UseDedup;          // store the data of identical files only once
   
   bool RemoveSfxBlock;
+  bool AppendMode;        // write new data after the end of old archive in same stream
   bool MultiThreadMixer;
 
   bool Need_CTime;
@@ -121,7 +124,10 @@ struct CUpdateOptions
       NumSolidBytes((UInt64)(Int64)(-1)),
       SolidExtension(false),
       UseTypeSorting(true),
+      UseContentSorting(false),
+      UseDedup(false),
       RemoveSfxBlock(false),
+      AppendMode(false),
       MultiThreadMixer(true),
       Need_CTime(false),
       Need_ATime(false),
@@ -824,6 +824,9 @@ HRESULT CMixerST::GetMainUnpackStream(
     ISequentialInStream * const *inStreams,
     ISequentialInStream **inStreamRes)
 {
+  // the binder streams can be set by previous call, if the mixer is reused
+  _binderStreams.Clear();
+  
   CMyComPtr<ISequentialInStream> seqInStream;
 
   RINOK(GetInStream2(inStreams, /* inSizes, */
@@ -109,7 +109,7 @@ STDAPI SetLargePageMode();
 STDAPI SetLargePageMode()
 {
   #if defined(Z7_LARGE_PAGES)
-  #ifdef _WIN32
+  #if defined(_WIN32) || defined(Z7_LARGE_PAGES_LINUX)
   SetLargePageSize();
   #endif
   #endif
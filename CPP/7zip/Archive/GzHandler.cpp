@@ -20,6 +20,9 @@
 
 #include "../Compress/CopyCoder.h"
 #include "../Compress/DeflateDecoder.h"
+#ifndef Z7_ST
+#include "../Compress/DeflateDecoderMt.h"
+#endif
 #include "../Compress/DeflateEncoder.h"
 
 #include "Common/HandlerOut.h"
@@ -673,6 +676,42 @@ Z7_COM7F_IMF(CHandler::Close())
   return S_OK;
 }
 
+#ifndef Z7_ST
+
+// it skips the data that was written already by multithreaded decoder
+
+Z7_CLASS_IMP_NOQIB_1(
+  COutStreamWithSkip
+  , ISequentialOutStream
+)
+  CMyComPtr<ISequentialOutStream> _stream;
+public:
+  UInt64 SkipSize;
+  void SetStream(ISequentialOutStream *stream) { _stream = stream; }
+};
+
+Z7_COM7F_IMF(COutStreamWithSkip::Write(const void *data, UInt32 size, UInt32 *processedSize))
+{
+  UInt32 skip = 0;
+  if (SkipSize != 0)
+  {
+    skip = size;
+    if (skip > SkipSize)
+      skip = (UInt32)SkipSize;
+    SkipSize -= skip;
+  }
+  UInt32 realProcessed = 0;
+  HRESULT res = S_OK;
+  if (size != skip)
+    res = _stream->Write((const Byte *)data + skip, size - skip, &realProcessed);
+  if (processedSize)
+    *processedSize = skip + realProcessed;
+  return res;
+}
+
+#endif
+
+
 Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     Int32 testMode, IArchiveExtractCallback *extractCallback))
 {
@@ -708,6 +747,38 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
   CMyComPtr<ICompressProgressInfo> progress = lps;
   lps->Init(extractCallback, true);
 
+  ISequentialOutStream *decoderOutStream = outStream;
+
+ #ifndef Z7_ST
+  NDecoder::CMtDecoder mtDecoder;
+  COutStreamWithSkip *skipStreamSpec = NULL;
+  CMyComPtr<ISequentialOutStream> skipStream;
+  bool useMt = false;
+  /* speculative multithreaded decoding is slower than single-threaded decoding
+     for some data (highly compressible data or data with many stored blocks).
+     So it's used only if the number of threads was set explicitly (-mmtN). */
+  if (_stream && _props._numThreads_WasForced)
+  {
+    UInt32 numThreads = _props._numThreads;
+    if (_props._memUsage_WasSet)
+    {
+      const UInt64 numThreads2 = _props._memUsage_Decompress / NDecoder::kMtMemUsagePerThread;
+      if (numThreads > numThreads2)
+        numThreads = (UInt32)numThreads2;
+    }
+    if (numThreads > 1)
+    {
+      useMt = true;
+      mtDecoder.NumThreads = numThreads;
+      skipStreamSpec = new COutStreamWithSkip;
+      skipStream = skipStreamSpec;
+      skipStreamSpec->SetStream(outStream);
+      skipStreamSpec->SkipSize = 0;
+      decoderOutStream = skipStream;
+    }
+  }
+ #endif
+
   bool needReadFirstItem = _needSeekToStart;
   
   if (_needSeekToStart)
@@ -723,6 +794,8 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
 
   bool firstItem = true;
 
+  // the offset in stream for the start of (_decoderSpec) input stream
+  UInt64 inBase = 0;
   UInt64 packSize = _decoderSpec->GetInputProcessedSize();
   // printf("\npackSize = %d", (unsigned)packSize);
 
@@ -760,7 +833,7 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
         break;
       }
 
-      if (packSize == _decoderSpec->GetStreamSize())
+      if (packSize == inBase + _decoderSpec->GetStreamSize())
       {
         result = S_OK;
         break;
@@ -779,29 +852,54 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     UInt64 startOffset = outStreamSpec->GetSize();
     outStreamSpec->InitCRC();
 
-    result = _decoderSpec->CodeResume(outStream, NULL, progress);
-
-    packSize = _decoderSpec->GetInputProcessedSize();
-    unpackedSize = outStreamSpec->GetSize();
-
-    if (result != S_OK && result != S_FALSE)
-      return result;
+    bool decoded = false;
 
-    if (_decoderSpec->InputEofError())
+   #ifndef Z7_ST
+    if (useMt)
     {
-      packSize = _decoderSpec->GetStreamSize();
-      _needMoreInput = true;
-      result = S_FALSE;
+      const UInt64 streamPos = inBase + _decoderSpec->GetInputProcessedSize();
+      RINOK(InStream_SeekSet(_stream, streamPos))
+      result = mtDecoder.Decode(_stream, outStream, progress);
+      if (result != S_OK && result != S_FALSE)
+        return result;
+      /* if multithreaded decoding has failed, we decode the stream again
+         in single-threaded mode to get the remaining data and exact error status. */
+      decoded = (result == S_OK);
+      skipStreamSpec->SkipSize = decoded ? 0 : mtDecoder.OutProcessed;
+      inBase = streamPos + (decoded ? mtDecoder.InProcessed : 0);
+      RINOK(InStream_SeekSet(_stream, inBase))
+      _decoderSpec->InitInStream(true);
+      packSize = inBase;
+      unpackedSize = outStreamSpec->GetSize();
     }
+   #endif
 
-    if (result != S_OK)
-      break;
+    if (!decoded)
+    {
+      result = _decoderSpec->CodeResume(decoderOutStream, NULL, progress);
+
+      packSize = inBase + _decoderSpec->GetInputProcessedSize();
+      unpackedSize = outStreamSpec->GetSize();
+
+      if (result != S_OK && result != S_FALSE)
+        return result;
+
+      if (_decoderSpec->InputEofError())
+      {
+        packSize = inBase + _decoderSpec->GetStreamSize();
+        _needMoreInput = true;
+        result = S_FALSE;
+      }
+
+      if (result != S_OK)
+        break;
+    }
 
     _decoderSpec->AlignToByte();
     
     result = item.ReadFooter1(_decoderSpec);
 
-    packSize = _decoderSpec->GetInputProcessedSize();
+    packSize = inBase + _decoderSpec->GetInputProcessedSize();
 
     if (result != S_OK && result != S_FALSE)
       return result;
@@ -985,11 +1083,42 @@ static HRESULT UpdateArchive(
 
   NEncoder::CCOMCoder *deflateEncoderSpec = new NEncoder::CCOMCoder;
   CMyComPtr<ICompressCoder> deflateEncoder = deflateEncoderSpec;
-  RINOK(props.SetCoderProps(deflateEncoderSpec, NULL))
-  RINOK(deflateEncoder->Code(crcStream, outStream, NULL, NULL, progress))
-
-  item.Crc = inStreamSpec->GetCRC();
-  unpackSizeReal = inStreamSpec->GetSize();
+  {
+    CMethodProps props2 = props;
+    #ifndef Z7_ST
+    if (props2.FindProp(NCoderPropID::kNumThreads) < 0)
+    {
+      UInt32 numThreads = props._numThreads;
+      if (numThreads > NEncoder::kNumThreadsMax)
+        numThreads = NEncoder::kNumThreadsMax;
+      if (numThreads > 1
+          && props._memUsage_WasSet
+          && !props._numThreads_WasForced)
+      {
+        const UInt64 numThreads64 = props._memUsage_Compress / NEncoder::kMtMemUsagePerThread;
+        if (numThreads > numThreads64)
+          numThreads = (UInt32)numThreads64;
+      }
+      props2.AddProp_NumThreads(numThreads);
+    }
+    #endif
+    RINOK(props2.SetCoderProps(deflateEncoderSpec, NULL))
+  }
+  #ifndef Z7_ST
+  // multithreaded encoder calculates CRC in the threads that encode the blocks
+  if (deflateEncoderSpec->IsMtMode())
+  {
+    RINOK(deflateEncoder->Code(fileInStream, outStream, NULL, NULL, progress))
+    item.Crc = deflateEncoderSpec->MtCrc;
+    unpackSizeReal = deflateEncoderSpec->MtInSize;
+  }
+  else
+  #endif
+  {
+    RINOK(deflateEncoder->Code(crcStream, outStream, NULL, NULL, progress))
+    item.Crc = inStreamSpec->GetCRC();
+    unpackSizeReal = inStreamSpec->GetSize();
+  }
   item.Size32 = (UInt32)unpackSizeReal;
   RINOK(item.WriteFooter(outStream))
   }
@@ -534,6 +534,28 @@ UpdateItems()
 Z7_IFACE_CONSTR_ARCHIVE(IOutArchive, 0xA0)
 
 
+/*
+IOutArchiveAppend::SetAppendMode()
+  The caller calls it after ISetProperties::SetProperties() and before UpdateItems()
+  for the handler that has opened archive.
+  (appendMode != 0) : the caller asks the handler to write only new data
+     after the end of opened archive. The caller will pass to UpdateItems()
+     the outStream of same archive file opened for writing (without truncation),
+     and the handler must not change the data of opened archive
+     except of small fixed-size start header.
+  (appendMode == 0) : the handler returns to usual mode.
+  Return:
+    S_OK    : the handler will append data to opened archive in UpdateItems().
+    S_FALSE : append mode is not supported for opened archive.
+              The caller must use usual update mode.
+*/
+
+#define Z7_IFACEM_IOutArchiveAppend(x) \
+  x(SetAppendMode(Int32 appendMode))
+
+Z7_IFACE_CONSTR_ARCHIVE(IOutArchiveAppend, 0xA1)
+
+
 /*
 ISetProperties::SetProperties()
   PROPVARIANT values[i].vt:
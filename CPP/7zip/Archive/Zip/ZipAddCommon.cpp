@@ -18,6 +18,7 @@
 #include "../../Compress/LzmaEncoder.h"
 #include "../../Compress/PpmdZip.h"
 #include "../../Compress/XzEncoder.h"
+#include "../../Compress/ZstdEncoder.h"
 
 #include "../Common/InStreamWithCRC.h"
 
@@ -174,6 +175,7 @@ HRESULT CAddCommon::Set_Pre_CompressionResult(bool inSeqMode, bool outSeqMode, U
     case NCompressionMethod::kXz   : ver = NCompressionMethod::kExtractVersion_Xz; break;
     case NCompressionMethod::kPPMd : ver = NCompressionMethod::kExtractVersion_PPMd; break;
     case NCompressionMethod::kBZip2: ver = NCompressionMethod::kExtractVersion_BZip2; break;
+    case NCompressionMethod::kZstdWz: ver = NCompressionMethod::kExtractVersion_Zstd; break;
     case NCompressionMethod::kLZMA :
     {
       ver = NCompressionMethod::kExtractVersion_LZMA;
@@ -375,6 +377,12 @@ HRESULT CAddCommon::Compress(
             NCompress::NXz::CEncoder *encoder = new NCompress::NXz::CEncoder();
             _compressEncoder = encoder;
           }
+          else if (method == NCompressionMethod::kZstdWz)
+          {
+            _compressExtractVersion = NCompressionMethod::kExtractVersion_Zstd;
+            NCompress::NZstd::CEncoder *encoder = new NCompress::NZstd::CEncoder();
+            _compressEncoder = encoder;
+          }
           else if (method == NCompressionMethod::kPPMd)
           {
             _compressExtractVersion = NCompressionMethod::kExtractVersion_PPMd;
@@ -16,6 +16,9 @@
 #include "../../Common/ProgressUtils.h"
 #include "../../Common/StreamObjects.h"
 #include "../../Common/StreamUtils.h"
+#ifndef Z7_ST
+#include "../../Common/VirtThread.h"
+#endif
 
 #include "../../Compress/CopyCoder.h"
 
@@ -34,6 +37,7 @@
 #include "../../Compress/PpmdZip.h"
 #include "../../Compress/ShrinkDecoder.h"
 #include "../../Compress/XzDecoder.h"
+#include "../../Compress/ZstdDecoder.h"
 
 #include "../../Crypto/WzAes.h"
 #include "../../Crypto/ZipCrypto.h"
@@ -1200,6 +1204,9 @@ HRESULT CZipDecoder::Decode(
     }
     else if (id == NFileHeader::NCompressionMethod::kXz)
       mi.Coder = new NCompress::NXz::CComDecoder;
+    else if (id == NFileHeader::NCompressionMethod::kZstdWz
+        || id == NFileHeader::NCompressionMethod::kZstdPk)
+      mi.Coder = new NCompress::NZstd::CDecoder;
     else if (id == NFileHeader::NCompressionMethod::kPPMd)
       mi.Coder = new NCompress::NPpmdZip::CDecoder(true);
     #ifdef SUPPORT_LZFSE
@@ -1595,6 +1602,233 @@ HRESULT CZipDecoder::Decode(
 }
 
 
+#ifndef Z7_ST
+
+/*
+In multithreaded mode Extract() decodes several items in parallel.
+CMtExtractor looks ahead in the list of items and it starts the jobs that
+decode the items to memory buffers. Each job uses own CZipDecoder object
+and it checks CRC of item. The main thread writes the data of each item to
+the stream from callback in original order, so the order of calls of
+IArchiveExtractCallback is the same as in single-thread mode.
+The item is decoded by main thread without buffering, if it's encrypted,
+if its data and decoder don't fit into memory usage limit,
+or if the job for that item has failed.
+*/
+
+static const UInt32 kNumMtExtractJobsMax = 64;
+
+// it returns the estimated size of memory that is allocated by decoder of item
+static UInt64 GetDecoderMemUsage(unsigned method)
+{
+  switch (method)
+  {
+    case NFileHeader::NCompressionMethod::kStore:
+    case NFileHeader::NCompressionMethod::kDeflate:
+    case NFileHeader::NCompressionMethod::kDeflate64:
+      return (UInt32)1 << 20;
+    case NFileHeader::NCompressionMethod::kBZip2:
+      return (UInt32)1 << 23;
+    default:
+      // the dictionary size for LZMA, PPMd, Xz and Zstd is stored in packed stream
+      return (UInt32)1 << 26;
+  }
+}
+
+
+class CExtractMtJob Z7_final: public CVirtThread
+{
+public:
+  CZipDecoder Decoder;
+  CBufPtrSeqOutStream *OutStreamSpec;
+  CMyComPtr<ISequentialOutStream> OutStream;
+  CByteBuffer Buf;
+
+  CInArchive *Archive;
+  CItemEx Item;       // the item with the fields from local header
+  UInt32 ItemIndex;   // the index in list of items
+  UInt64 MemUsage;    // estimated memory usage of job
+  UInt64 DecoderMemLimit;
+  bool HeadersError;
+
+  HRESULT Result;
+  Int32 OpRes;
+
+  DECL_EXTERNAL_CODECS_LOC_VARS_DECL
+
+  CExtractMtJob()
+  {
+    OutStreamSpec = new CBufPtrSeqOutStream;
+    OutStream = OutStreamSpec;
+  }
+  ~CExtractMtJob() Z7_DESTRUCTOR_override
+  {
+    /* WaitThreadFinish() will be called in ~CVirtThread().
+       But we need WaitThreadFinish() call before
+       destructors of this class members. */
+    CVirtThread::WaitThreadFinish();
+  }
+private:
+  virtual void Execute() Z7_override;
+};
+
+void CExtractMtJob::Execute()
+{
+  try
+  {
+    // encrypted items are not decoded in jobs, so (extractCallback) is not used
+    Result = Decoder.Decode(
+        EXTERNAL_CODECS_LOC_VARS
+        *Archive, Item, OutStream,
+        NULL, // extractCallback
+        NULL, // compressProgress
+        1, DecoderMemLimit,
+        OpRes);
+  }
+  catch(...)
+  {
+    Result = E_FAIL;
+  }
+}
+
+
+class CMtExtractor
+{
+public:
+  NWindows::NSynchronization::CCriticalSection CS; // it locks the archive stream
+private:
+  CObjectVector<CExtractMtJob> _jobs;
+  unsigned _first;      // the oldest started job in ring of jobs
+  unsigned _numStarted;
+  UInt64 _memUsage;
+public:
+  CInArchive *Archive;
+  const CObjectVector<CItemEx> *Items;
+  const UInt32 *Indices; // NULL means all files mode
+  UInt32 NumItems;
+  UInt32 NextItem;       // the next item that was not checked for job
+  UInt32 NumJobs;        // (NumJobs == 0) means that multithreaded mode is disabled
+  UInt64 MemLimit;
+
+  DECL_EXTERNAL_CODECS_LOC_VARS_DECL
+
+  CMtExtractor(): _first(0), _numStarted(0), _memUsage(0), Archive(NULL), NextItem(0), NumJobs(0) {}
+  ~CMtExtractor()
+  {
+    // we wait for the threads before (Archive->StreamCS) reset
+    _jobs.Clear();
+    if (Archive)
+      Archive->StreamCS = NULL;
+  }
+
+  // it starts new jobs, if there are free jobs and enough memory
+  HRESULT StartJobs();
+  // it returns (job == NULL), if there is no job for (itemIndex)
+  HRESULT WaitJob(UInt32 itemIndex, CExtractMtJob *&job);
+  void ReleaseJob();
+};
+
+HRESULT CMtExtractor::StartJobs()
+{
+  for (; NextItem < NumItems && _numStarted < NumJobs; NextItem++)
+  {
+    const CItemEx &item = (*Items)[Indices ? Indices[NextItem] : NextItem];
+    
+    if (item.IsDir()
+        || item.IsEncrypted()
+        || item.Size == 0
+        || item.Size != (size_t)item.Size
+        || !Archive->IsLocalOffsetOK(item))
+      continue;
+    
+    const UInt64 mem = GetDecoderMemUsage(item.Method) + item.Size;
+    if (mem > MemLimit)
+      continue;
+    if (_memUsage + mem > MemLimit)
+      break; // we will wait for the release of previous jobs
+    
+    const unsigned jobIndex = (_first + _numStarted) % NumJobs;
+    if (jobIndex == _jobs.Size())
+    {
+      CExtractMtJob &job = _jobs.AddNew();
+      job.Archive = Archive;
+      job.DecoderMemLimit = MemLimit / NumJobs;
+      #ifdef Z7_EXTERNAL_CODECS
+      job._externalCodecs = _externalCodecs;
+      #endif
+      const WRes wres = job.Create();
+      if (wres != 0)
+        return HRESULT_FROM_WIN32(wres);
+    }
+    
+    CExtractMtJob &job = _jobs[jobIndex];
+    job.Item = item;
+    job.HeadersError = false;
+    if (!item.FromLocal)
+    {
+      bool isAvail = true;
+      HRESULT hres;
+      {
+        NWindows::NSynchronization::CCriticalSectionLock lock(CS);
+        hres = Archive->Read_LocalItem_After_CdItem(job.Item, isAvail, job.HeadersError);
+      }
+      // the main thread will report the error for that item
+      if (hres != S_OK)
+        continue;
+    }
+    
+    bool allocated = true;
+    try
+    {
+      if (job.Buf.Size() < item.Size || job.Buf.Size() / 2 > item.Size)
+        job.Buf.Alloc((size_t)item.Size);
+    }
+    catch(...)
+    {
+      job.Buf.Free();
+      allocated = false;
+    }
+    if (!allocated)
+      continue;
+    
+    job.ItemIndex = NextItem;
+    job.MemUsage = mem;
+    job.OutStreamSpec->Init(job.Buf, (size_t)item.Size);
+    const WRes wres = job.Start();
+    if (wres != 0)
+      return HRESULT_FROM_WIN32(wres);
+    _memUsage += mem;
+    _numStarted++;
+  }
+  
+  return S_OK;
+}
+
+HRESULT CMtExtractor::WaitJob(UInt32 itemIndex, CExtractMtJob *&job)
+{
+  job = NULL;
+  if (_numStarted == 0)
+    return S_OK;
+  CExtractMtJob &first = _jobs[_first];
+  if (first.ItemIndex != itemIndex)
+    return S_OK;
+  const WRes wres = first.WaitExecuteFinish();
+  if (wres != 0)
+    return HRESULT_FROM_WIN32(wres);
+  job = &first;
+  return S_OK;
+}
+
+void CMtExtractor::ReleaseJob()
+{
+  _memUsage -= _jobs[_first].MemUsage;
+  _first = (_first + 1) % NumJobs;
+  _numStarted--;
+}
+
+#endif
+
+
 Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     Int32 testMode, IArchiveExtractCallback *extractCallback))
 {
@@ -1621,6 +1855,24 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
   CMyComPtr<ICompressProgressInfo> progress = lps;
   lps->Init(extractCallback, false);
 
+  #ifndef Z7_ST
+  CMtExtractor mt;
+  if (_props._numThreads > 1 && numItems > 1 && !m_Archive.IsMultiVol)
+  {
+    mt.Archive = &m_Archive;
+    mt.Items = &m_Items;
+    mt.Indices = allFilesMode ? NULL : indices;
+    mt.NumItems = numItems;
+    mt.NumJobs = MyMin(_props._numThreads, kNumMtExtractJobsMax);
+    mt.MemLimit = _props._memUsage_Decompress;
+    #ifdef Z7_EXTERNAL_CODECS
+    mt._externalCodecs = EXTERNAL_CODECS_VARS2;
+    #endif
+    // all reading from archive stream will be locked by (mt.CS)
+    m_Archive.StreamCS = &mt.CS;
+  }
+  #endif
+
   for (i = 0;; i++,
       lps->OutSize += cur_Unpacked,
       lps->InSize += cur_Packed)
@@ -1633,6 +1885,15 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     cur_Unpacked = item.Size;
     cur_Packed = item.PackSize;
 
+    #ifndef Z7_ST
+    CExtractMtJob *job = NULL;
+    if (mt.NumJobs != 0)
+    {
+      RINOK(mt.StartJobs())
+      RINOK(mt.WaitJob(i, job))
+    }
+    #endif
+
     const bool isLocalOffsetOK = m_Archive.IsLocalOffsetOK(item);
     const bool skip = !isLocalOffsetOK && !item.IsDir();
     const Int32 askMode = skip ?
@@ -1653,10 +1914,30 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
 
     bool headersError = false;
     
+    #ifndef Z7_ST
+    if (job)
+    {
+      // the job has read local header already
+      item = job->Item;
+      headersError = job->HeadersError;
+      if (!testMode && !realOutStream)
+      {
+        mt.ReleaseJob();
+        continue;
+      }
+    }
+    else
+    #endif
     if (!item.FromLocal)
     {
       bool isAvail = true;
-      const HRESULT hres = m_Archive.Read_LocalItem_After_CdItem(item, isAvail, headersError);
+      HRESULT hres;
+      {
+        #ifndef Z7_ST
+        NWindows::NSynchronization::CCriticalSectionLock lock(mt.CS);
+        #endif
+        hres = m_Archive.Read_LocalItem_After_CdItem(item, isAvail, headersError);
+      }
       if (hres == S_FALSE)
       {
         if (item.IsDir() || realOutStream || testMode)
@@ -1690,16 +1971,36 @@ Z7_COM7F_IMF(CHandler::Extract(const UInt32 *indices, UInt32 numItems,
     RINOK(extractCallback->PrepareOperation(askMode))
 
     Int32 res;
-    const HRESULT hres = myDecoder.Decode(
-        EXTERNAL_CODECS_VARS
-        m_Archive, item, realOutStream, extractCallback,
-        progress,
-        #ifndef Z7_ST
-        _props._numThreads, _props._memUsage_Decompress,
-        #endif
-        res);
     
-    RINOK(hres)
+    #ifndef Z7_ST
+    if (job && job->Result == S_OK)
+    {
+      res = job->OpRes;
+      HRESULT hres = S_OK;
+      if (realOutStream)
+        hres = WriteStream(realOutStream, job->Buf, job->OutStreamSpec->GetPos());
+      mt.ReleaseJob();
+      RINOK(hres)
+    }
+    else
+    #endif
+    {
+      #ifndef Z7_ST
+      // if the job has failed, we decode the item again to get exact error status
+      if (job)
+        mt.ReleaseJob();
+      #endif
+      const HRESULT hres = myDecoder.Decode(
+          EXTERNAL_CODECS_VARS
+          m_Archive, item, realOutStream, extractCallback,
+          progress,
+          #ifndef Z7_ST
+          _props._numThreads, _props._memUsage_Decompress,
+          #endif
+          res);
+      RINOK(hres)
+    }
+    
     realOutStream.Release();
     
     if (res == NExtract::NOperationResult::kOK && headersError)
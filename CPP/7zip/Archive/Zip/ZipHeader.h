@@ -80,6 +80,7 @@ namespace NFileHeader
     const Byte kExtractVersion_LZMA = 63;
     const Byte kExtractVersion_PPMd = 63;
     const Byte kExtractVersion_Xz = 20; // test it
+    const Byte kExtractVersion_Zstd = 63;
   }
 
   namespace NExtraID
@@ -11,6 +11,8 @@
 
 #include "../../../Windows/PropVariant.h"
 
+#include "../../Common/LimitedStreams.h"
+
 #include "../IArchive.h"
 
 #include "ZipIn.h"
@@ -295,7 +297,7 @@ HRESULT CInArchive::ReadFromCache(Byte *data, unsigned size, unsigned &processed
       unsigned cur = size;
       if (cur > avail)
         cur = (unsigned)avail;
-      memcpy(data, (const Byte *)Buffer + _bufPos, cur);
+      memcpy(data, (_mapData ? _mapData : (const Byte *)Buffer) + _bufPos, cur);
 
       data += cur;
       size -= cur;
@@ -886,6 +888,13 @@ return:
 
 HRESULT CInArchive::LookAhead(size_t minRequired)
 {
+  if (_mapData)
+  {
+    // the callers use (Buffer) directly, so we return to normal cached mode
+    RINOK(Seek_SavePos(GetVirtStreamPos()))
+    InitBuf();
+  }
+
   for (;;)
   {
     const size_t avail = GetAvail();
@@ -1739,6 +1748,7 @@ HRESULT CInArchive::FindCd(bool checkOffsetMode)
 
   RINOK(AllocateBuffer(kBufSizeMax))
 
+  InitBuf();
   RINOK(Seek_SavePos(endPos - bufSize))
 
   size_t processed = bufSize;
@@ -1889,6 +1899,21 @@ HRESULT CInArchive::TryReadCd(CObjectVector<CItemEx> &items, const CCdInfo &cdIn
   _inBufMode = true;
   _cnt = 0;
 
+  if (!IsMultiVol && (size_t)cdSize == cdSize)
+  {
+    /* if the stream is in memory (mapped file), we read
+       central directory from stream memory without copying */
+    const UInt64 pos = GetVirtStreamPos();
+    const Byte *p = InStream_GetDataPtr(Stream, pos, (size_t)cdSize);
+    if (p)
+    {
+      InitBuf();
+      RINOK(Seek_SavePos(pos + cdSize))
+      _mapData = p;
+      _bufCached = (size_t)cdSize;
+    }
+  }
+
   if (Callback)
   {
     RINOK(Callback->SetTotal(&cdInfo.NumEntries, IsMultiVol ? &Vols.TotalBytesSize : NULL))
@@ -1948,6 +1973,12 @@ HRESULT CInArchive::TryReadCd(CObjectVector<CItemEx> &items, const CCdInfo &cdIn
 
   CanStartNewVol = true;
 
+  if (_mapData)
+  {
+    RINOK(Seek_SavePos(GetVirtStreamPos()))
+    InitBuf();
+  }
+
   return (_cnt == cdSize) ? S_OK : S_FALSE;
 }
 
@@ -3459,6 +3490,18 @@ HRESULT CInArchive::GetItemStream(const CItemEx &item, bool seekPackData, CMyCom
     if (UseDisk_in_SingleVol && item.Disk != EcdVolIndex)
       return S_OK;
     pos = (UInt64)((Int64)pos + ArcInfo.Base);
+   #ifndef Z7_ST
+    if (StreamCS)
+    {
+      CSharedInStream *streamSpec = new CSharedInStream;
+      CMyComPtr<IInStream> inStream = streamSpec;
+      streamSpec->Stream = StreamRef;
+      streamSpec->CS = StreamCS;
+      RINOK(InStream_SeekSet(inStream, pos))
+      stream = inStream;
+      return S_OK;
+    }
+   #endif
     RINOK(InStream_SeekSet(StreamRef, pos))
     stream = StreamRef;
     return S_OK;
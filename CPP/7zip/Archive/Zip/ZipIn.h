@@ -6,6 +6,10 @@
 #include "../../../Common/MyBuffer2.h"
 #include "../../../Common/MyCom.h"
 
+#ifndef Z7_ST
+#include "../../../Windows/Synchronization.h"
+#endif
+
 #include "../../Common/StreamUtils.h"
 #include "../../IStream.h"
 
@@ -246,6 +250,7 @@ public:
 class CInArchive
 {
   CMidBuffer Buffer;
+  const Byte *_mapData; // if not NULL, the cached region is in memory of stream instead of (Buffer)
   size_t _bufPos;
   size_t _bufCached;
 
@@ -257,7 +262,7 @@ class CInArchive
 
   size_t GetAvail() const { return _bufCached - _bufPos; }
 
-  void InitBuf() { _bufPos = 0; _bufCached = 0; }
+  void InitBuf() { _mapData = NULL; _bufPos = 0; _bufCached = 0; }
   void DisableBufMode() { InitBuf(); _inBufMode = false; }
 
   void SkipLookahed(size_t skip)
@@ -356,8 +361,16 @@ public:
   bool Force_ReadLocals_Mode;
   bool Disable_VolsRead;
   bool Disable_FindMarker;
+
+ #ifndef Z7_ST
+  /* if (StreamCS) is set, GetItemStream() returns stream with own position
+     that locks (StreamCS) for each access to single-volume archive stream.
+     So item streams can be read from several threads. */
+  NWindows::NSynchronization::CCriticalSection *StreamCS;
+ #endif
  
   CInArchive():
+      _mapData(NULL),
       IsArcOpen(false),
       Stream(NULL),
       StartStream(NULL),
@@ -365,6 +378,9 @@ public:
       Force_ReadLocals_Mode(false),
       Disable_VolsRead(false),
       Disable_FindMarker(false)
+     #ifndef Z7_ST
+      , StreamCS(NULL)
+     #endif
       {}
 
   UInt64 GetPhySize() const
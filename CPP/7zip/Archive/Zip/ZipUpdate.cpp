@@ -30,7 +30,8 @@
 #include "../../Common/StreamUtils.h"
 
 #include "../../Compress/CopyCoder.h"
-// #include "../../Compress/ZstdEncoderProps.h"
+#include "../../Compress/DeflateEncoder.h"
+#include "../../Compress/ZstdEncoderProps.h"
 
 #include "ZipAddCommon.h"
 #include "ZipOut.h"
@@ -788,7 +789,6 @@ out:
    nt_Zip:  calculated number of ZIP threads
    returns: calculated number of ZSTD threads
 */
-/*
 static UInt32 CalcThreads_for_ZipZstd(CZstdEncProps *zstdProps,
     UInt64 memLimit, UInt32 totalThreads,
     UInt32 &nt_Zip)
@@ -814,16 +814,16 @@ static UInt32 CalcThreads_for_ZipZstd(CZstdEncProps *zstdProps,
 }
 
 
-static UInt32 SetZstdThreads(
+static HRESULT SetZstdThreads(
     const CCompressionMethodMode &options,
     COneMethodInfo *oneMethodMain,
-    UInt32 numThreads,
+    UInt32 &numThreads,
     UInt32 numZipThreads_limit,
     UInt64 numFilesToCompress,
     UInt64 numBytesToCompress)
 {
   NCompress::NZstd::CEncoderProps encoderProps;
-  RINOK(encoderProps.SetFromMethodProps(*oneMethodMain));
+  RINOK(encoderProps.SetFromMethodProps(*oneMethodMain))
   CZstdEncProps &zstdProps = encoderProps.EncProps;
   ZstdEncProps_NormalizeFull(&zstdProps);
   if (oneMethodMain->FindProp(NCoderPropID::kNumThreads) >= 0)
@@ -841,7 +841,7 @@ static UInt32 SetZstdThreads(
       if (numThreads > numZipThreads)
         numThreads = (UInt32)numZipThreads;
     }
-    return numThreads;
+    return S_OK;
   }
   {
     // threads for ZSTD are not fixed
@@ -880,16 +880,68 @@ static UInt32 SetZstdThreads(
     {
       t = CalcThreads_for_ZipZstd(&zstdProps,
           options._memUsage_Compress, numThreads, numZipThreads);
-      numThreads = numZipThreads;
     }
+    numThreads = numZipThreads;
     // we don't use (nbWorkers = 1) here
     if (t <= 1)
       t = 0;
     oneMethodMain->AddProp_NumThreads(t);
-    return numThreads;
+    return S_OK;
   }
 }
+
+
+/*
+Deflate encoder supports multithreaded mode for one file.
+in:
+   numThreads:  the total number of threads
+out:
+   numThreads:  the number of ZIP threads
 */
+static void SetDeflateThreads(
+    const CCompressionMethodMode &options,
+    COneMethodInfo *oneMethodMain,
+    UInt32 &numThreads,
+    UInt32 numZipThreads_limit,
+    UInt64 numFilesToCompress,
+    UInt64 numBytesToCompress)
+{
+  if (oneMethodMain->FindProp(NCoderPropID::kNumThreads) >= 0)
+  {
+    // threads for Deflate are fixed
+    const int t = oneMethodMain->Get_NumThreads();
+    if (t > 1)
+      numThreads /= (unsigned)t;
+    return;
+  }
+  if (numThreads <= numZipThreads_limit)
+    return;
+  // we use remaining threads for multithreaded encoding of each file
+  UInt32 t = numThreads / numZipThreads_limit;
+  {
+    const UInt64 averageSize = numBytesToCompress / numFilesToCompress;
+    const UInt64 averageNumberOfBlocks = averageSize / NCompress::NDeflate::NEncoder::kMtBlockSizeDefault + 1;
+    if (t > averageNumberOfBlocks)
+      t = (UInt32)averageNumberOfBlocks;
+  }
+  if (t <= 1)
+    return;
+  const UInt32 numZipThreads = numThreads / t;
+  if (options._memUsage_WasSet
+      && !options._numThreads_WasForced)
+  {
+    // (numZipThreads * t) deflate threads can work at same time
+    const UInt64 numThreads64 = options._memUsage_Compress / NCompress::NDeflate::NEncoder::kMtMemUsagePerThread;
+    if ((UInt64)numZipThreads * t > numThreads64)
+    {
+      t = (UInt32)(numThreads64 / numZipThreads);
+      if (t <= 1)
+        return;
+    }
+  }
+  oneMethodMain->AddProp_NumThreads(t);
+  numThreads = numZipThreads;
+}
 
 #endif
 
@@ -1044,8 +1096,7 @@ static HRESULT Update2(
 
   if (!mtMode)
   {
-    // if (oneMethodMain) {
-    /*
+    if (oneMethodMain)
     if (method == NFileHeader::NCompressionMethod::kZstdWz)
     {
       if (oneMethodMain->FindProp(NCoderPropID::kNumThreads) < 0)
@@ -1066,8 +1117,31 @@ static HRESULT Update2(
         oneMethodMain->AddProp_NumThreads(numThreads);
       }
     } // kZstdWz
-    */
-    // } // oneMethodMain
+
+    if (oneMethodMain)
+    if (   method == NFileHeader::NCompressionMethod::kDeflate
+        || method == NFileHeader::NCompressionMethod::kDeflate64)
+    {
+      if (oneMethodMain->FindProp(NCoderPropID::kNumThreads) < 0)
+      {
+        // numDeflateThreads was not forced in oneMethodMain
+        UInt32 numDeflateThreads = numThreads;
+        const UInt64 numBlocks = numBytesToCompress / NCompress::NDeflate::NEncoder::kMtBlockSizeDefault + 1;
+        if (numDeflateThreads > numBlocks)
+          numDeflateThreads = (UInt32)numBlocks;
+        if (numDeflateThreads > 1
+            && options._memUsage_WasSet
+            && !options._numThreads_WasForced)
+        {
+          const UInt64 numThreads64 = options._memUsage_Compress / NCompress::NDeflate::NEncoder::kMtMemUsagePerThread;
+          if (numDeflateThreads > numThreads64)
+            numDeflateThreads = (UInt32)numThreads64;
+        }
+        if (numDeflateThreads < 1)
+          numDeflateThreads = 1;
+        oneMethodMain->AddProp_NumThreads(numDeflateThreads);
+      }
+    } // kDeflate
 
     FOR_VECTOR (mi, options2._methods)
     {
@@ -1130,15 +1204,13 @@ static HRESULT Update2(
       }
       numThreads /= (unsigned)numXzThreads;
     }
-    /*
     else if (method == NFileHeader::NCompressionMethod::kZstdWz)
     {
-      numThreads = SetZstdThreads(options,
+      RINOK(SetZstdThreads(options,
           oneMethodMain, numThreads,
           numZipThreads_limit,
-          numFilesToCompress, numBytesToCompress);
+          numFilesToCompress, numBytesToCompress))
     }
-    */
     else if (
            method == NFileHeader::NCompressionMethod::kDeflate
         || method == NFileHeader::NCompressionMethod::kDeflate64
@@ -1158,6 +1230,10 @@ static HRESULT Update2(
         if (numThreads64 < numThreads)
           numThreads = (UInt32)numThreads64;
       }
+      if (method != NFileHeader::NCompressionMethod::kPPMd)
+        SetDeflateThreads(options, oneMethodMain,
+            numThreads, numZipThreads_limit,
+            numFilesToCompress, numBytesToCompress);
     }
     else if (method == NFileHeader::NCompressionMethod::kLZMA)
     {
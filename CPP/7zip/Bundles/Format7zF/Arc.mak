@@ -1,4 +1,5 @@
 COMMON_OBJS = \
+  $O\Blake3Reg.obj \
   $O\CRC.obj \
   $O\CrcReg.obj \
   $O\DynLimBuf.obj \
@@ -11,12 +12,16 @@ COMMON_OBJS = \
   $O\NewHandler.obj \
   $O\Sha1Reg.obj \
   $O\Sha256Reg.obj \
+  $O\Sha512Prepare.obj \
+  $O\Sha512Reg.obj \
   $O\StringConvert.obj \
   $O\StringToInt.obj \
   $O\UTFConvert.obj \
   $O\Wildcard.obj \
   $O\XzCrc64Init.obj \
   $O\XzCrc64Reg.obj \
+  $O\Xxh3Reg.obj \
+  $O\Xxh64Reg.obj \
 
 WIN_OBJS = \
   $O\FileDir.obj \
@@ -98,6 +103,7 @@ AR_OBJS = \
   $O\XarHandler.obj \
   $O\XzHandler.obj \
   $O\ZHandler.obj \
+  $O\ZstdHandler.obj \
 
 AR_COMMON_OBJS = \
   $O\CoderMixer2.obj \
@@ -200,10 +206,13 @@ COMPRESS_OBJS = \
   $O\CopyRegister.obj \
   $O\Deflate64Register.obj \
   $O\DeflateDecoder.obj \
+  $O\DeflateDecoderMt.obj \
   $O\DeflateEncoder.obj \
   $O\DeflateRegister.obj \
   $O\DeltaFilter.obj \
   $O\ImplodeDecoder.obj \
+  $O\LdmCoder.obj \
+  $O\LdmRegister.obj \
   $O\LzfseDecoder.obj \
   $O\LzhDecoder.obj \
   $O\Lzma2Decoder.obj \
@@ -233,6 +242,10 @@ COMPRESS_OBJS = \
   $O\ZlibDecoder.obj \
   $O\ZlibEncoder.obj \
   $O\ZDecoder.obj \
+  $O\ZstdDecoder.obj \
+  $O\ZstdEncoder.obj \
+  $O\ZstdEncoderProps.obj \
+  $O\ZstdRegister.obj \
 
 CRYPTO_OBJS = \
   $O\7zAes.obj \
@@ -257,6 +270,7 @@ C_OBJS = \
   $O\Bcj2.obj \
   $O\Bcj2Enc.obj \
   $O\Blake2s.obj \
+  $O\Blake3.obj \
   $O\Bra.obj \
   $O\Bra86.obj \
   $O\BraIA64.obj \
@@ -280,6 +294,8 @@ C_OBJS = \
   $O\Ppmd8.obj \
   $O\Ppmd8Dec.obj \
   $O\Ppmd8Enc.obj \
+  $O\Sha512.obj \
+  $O\Sha512Opt.obj \
   $O\Sort.obj \
   $O\SwapBytes.obj \
   $O\Threads.obj \
@@ -287,6 +303,10 @@ C_OBJS = \
   $O\XzDec.obj \
   $O\XzEnc.obj \
   $O\XzIn.obj \
+  $O\Xxh3.obj \
+  $O\Xxh64.obj \
+  $O\ZstdDec.obj \
+  $O\ZstdEnc.obj \
 
 !include "../../Aes.mak"
 !include "../../Crc.mak"
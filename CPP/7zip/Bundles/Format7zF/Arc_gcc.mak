@@ -40,6 +40,7 @@ endif
 
 
 COMMON_OBJS = \
+  $O/Blake3Reg.o \
   $O/CRC.o \
   $O/CrcReg.o \
   $O/DynLimBuf.o \
@@ -54,12 +55,16 @@ COMMON_OBJS = \
   $O/Sha1Reg.o \
   $O/Sha256Prepare.o \
   $O/Sha256Reg.o \
+  $O/Sha512Prepare.o \
+  $O/Sha512Reg.o \
   $O/StringConvert.o \
   $O/StringToInt.o \
   $O/UTFConvert.o \
   $O/Wildcard.o \
   $O/XzCrc64Init.o \
   $O/XzCrc64Reg.o \
+  $O/Xxh3Reg.o \
+  $O/Xxh64Reg.o \
 
 WIN_OBJS = \
   $O/FileDir.o \
@@ -135,6 +140,7 @@ AR_OBJS = \
   $O/XarHandler.o \
   $O/XzHandler.o \
   $O/ZHandler.o \
+  $O/ZstdHandler.o \
 
 AR_COMMON_OBJS = \
   $O/CoderMixer2.o \
@@ -242,10 +248,13 @@ COMPRESS_OBJS = \
   $O/CopyRegister.o \
   $O/Deflate64Register.o \
   $O/DeflateDecoder.o \
+  $O/DeflateDecoderMt.o \
   $O/DeflateEncoder.o \
   $O/DeflateRegister.o \
   $O/DeltaFilter.o \
   $O/ImplodeDecoder.o \
+  $O/LdmCoder.o \
+  $O/LdmRegister.o \
   $O/LzfseDecoder.o \
   $O/LzhDecoder.o \
   $O/Lzma2Decoder.o \
@@ -269,6 +278,10 @@ COMPRESS_OBJS = \
   $O/ZlibDecoder.o \
   $O/ZlibEncoder.o \
   $O/ZDecoder.o \
+  $O/ZstdDecoder.o \
+  $O/ZstdEncoder.o \
+  $O/ZstdEncoderProps.o \
+  $O/ZstdRegister.o \
 
 ifdef DISABLE_RAR
 DISABLE_RAR_COMPRESS=1
@@ -314,6 +327,7 @@ C_OBJS = \
   $O/Bcj2.o \
   $O/Bcj2Enc.o \
   $O/Blake2s.o \
+  $O/Blake3.o \
   $O/Bra.o \
   $O/Bra86.o \
   $O/BraIA64.o \
@@ -345,13 +359,20 @@ C_OBJS = \
   $O/XzCrc64Opt.o \
   $O/7zCrc.o \
   $O/7zCrcOpt.o \
+  $O/CrcFold.o \
   $O/Aes.o \
   $O/AesOpt.o \
   $O/Sha256.o \
   $O/Sha256Opt.o \
+  $O/Sha512.o \
+  $O/Sha512Opt.o \
   $O/Sha1.o \
   $O/Sha1Opt.o \
   $O/SwapBytes.o \
+  $O/Xxh3.o \
+  $O/Xxh64.o \
+  $O/ZstdDec.o \
+  $O/ZstdEnc.o \
 
 ARC_OBJS = \
   $(LZMA_DEC_OPT_OBJS) \
@@ -10,6 +10,7 @@
 #include <errno.h>
 #include <grp.h>
 #include <pwd.h>
+#include <sys/mman.h>
 
 // for major()/minor():
 #include <sys/types.h>
@@ -33,6 +34,12 @@
 
 #include "FileStreams.h"
 
+#ifdef Z7_FILE_STREAMS_USE_ASYNC
+#include "../../Common/MyBuffer.h"
+#include "../../Windows/Synchronization.h"
+#include "../../Windows/Thread.h"
+#endif
+
 static inline HRESULT GetLastError_HRESULT()
 {
   DWORD lastError = ::GetLastError();
@@ -53,6 +60,192 @@ static inline HRESULT ConvertBoolToHRESULT(bool result)
 static const UInt32 kClusterSize = 1 << 18;
 #endif
 
+
+#ifdef Z7_FILE_STREAMS_USE_ASYNC
+
+/*
+  CFileStreamAsync is the helper thread for read-ahead and write-behind modes.
+  There are two buffers. The helper thread reads or writes one buffer,
+  while the caller thread works with another buffer.
+  We use simple thread instead of io_uring / overlapped IO,
+  because it works with any type of files, including network shares.
+*/
+
+static const size_t kAsyncBufSize = (size_t)1 << 20;
+
+class CFileStreamAsync
+{
+  NWindows::CPoolThread _thread;
+  NWindows::NSynchronization::CAutoResetEvent _startEvent;
+  NWindows::NSynchronization::CAutoResetEvent _finishedEvent;
+  bool _exit;
+  bool _finished;
+
+  Byte *_threadBuf;
+  size_t _threadSize;
+
+  static THREAD_FUNC_DECL ThreadFunc(void *p);
+  void Execute();
+public:
+  NWindows::NFile::NIO::CInFile *InFile;
+  NWindows::NFile::NIO::COutFile *OutFile;
+
+  CByteBuffer Bufs[2];
+  unsigned BufIndex;    // the index of buffer that is used by caller
+  size_t Pos;
+  size_t Lim;
+  UInt64 StartPos;      // read-ahead: the position in file of (Bufs[BufIndex])
+
+  bool Busy;            // the request was sent to thread, and the result was not consumed
+  size_t ResSize;       // the result of last request
+  DWORD ResError;
+  HRESULT WriteRes;     // write-behind: the first error of background write
+
+  CFileStreamAsync():
+      _exit(false),
+      _finished(false),
+      _threadBuf(NULL),
+      _threadSize(0),
+      InFile(NULL),
+      OutFile(NULL),
+      BufIndex(0),
+      Pos(0),
+      Lim(0),
+      StartPos(0),
+      Busy(false),
+      ResSize(0),
+      ResError(0),
+      WriteRes(S_OK)
+      {}
+  ~CFileStreamAsync();
+
+  WRes Create();
+  void Start(Byte *buf, size_t size)
+  {
+    _threadBuf = buf;
+    _threadSize = size;
+    _finished = false;
+    Busy = true;
+    _startEvent.Set();
+  }
+  // Wait() waits for the end of request. The result is kept as not consumed.
+  void Wait()
+  {
+    if (Busy && !_finished)
+    {
+      _finishedEvent.Lock();
+      _finished = true;
+    }
+  }
+  void WaitAndConsume()
+  {
+    Wait();
+    Busy = false;
+  }
+
+  void StartRead()
+  {
+    ResSize = 0;
+    ResError = 0;
+    Start(Bufs[BufIndex ^ 1], kAsyncBufSize);
+  }
+  void ReadNext();
+  HRESULT WriteBuf();
+};
+
+THREAD_FUNC_DECL CFileStreamAsync::ThreadFunc(void *p)
+{
+  ((CFileStreamAsync *)p)->Execute();
+  return 0;
+}
+
+void CFileStreamAsync::Execute()
+{
+  for (;;)
+  {
+    _startEvent.Lock();
+    if (_exit)
+      return;
+    DWORD error = 0;
+    size_t processed = 0;
+    if (InFile)
+    {
+      if (!InFile->ReadFull(_threadBuf, _threadSize, processed))
+      {
+        error = ::GetLastError();
+        if (error == 0)
+          error = (DWORD)E_FAIL;
+      }
+    }
+    else if (OutFile->WriteFull(_threadBuf, _threadSize))
+      processed = _threadSize;
+    else
+    {
+      error = ::GetLastError();
+      if (error == 0)
+        error = (DWORD)E_FAIL;
+    }
+    ResSize = processed;
+    ResError = error;
+    _finishedEvent.Set();
+  }
+}
+
+WRes CFileStreamAsync::Create()
+{
+  Bufs[0].Alloc(kAsyncBufSize);
+  Bufs[1].Alloc(kAsyncBufSize);
+  RINOK_WRes(_startEvent.Create())
+  RINOK_WRes(_finishedEvent.Create())
+  return _thread.Create(ThreadFunc, this);
+}
+
+CFileStreamAsync::~CFileStreamAsync()
+{
+  if (_thread.IsCreated())
+  {
+    Wait();
+    _exit = true;
+    _startEvent.Set();
+    _thread.Wait_Close();
+  }
+}
+
+// ReadNext() switches the caller to buffer that was filled by thread
+// and starts the reading of next block.
+
+void CFileStreamAsync::ReadNext()
+{
+  WaitAndConsume();
+  StartPos += Lim;
+  BufIndex ^= 1;
+  Pos = 0;
+  Lim = ResSize;
+  if (ResError == 0 && ResSize == kAsyncBufSize)
+    StartRead();
+}
+
+// WriteBuf() sends the data of caller's buffer to thread.
+
+HRESULT CFileStreamAsync::WriteBuf()
+{
+  WaitAndConsume();
+  if (ResError != 0 && WriteRes == S_OK)
+    WriteRes = HRESULT_FROM_WIN32(ResError);
+  ResError = 0;
+  if (WriteRes != S_OK)
+    return WriteRes;
+  if (Pos != 0)
+  {
+    Start(Bufs[BufIndex], Pos);
+    BufIndex ^= 1;
+    Pos = 0;
+  }
+  return S_OK;
+}
+
+#endif
+
 CInFileStream::CInFileStream():
  #ifdef Z7_DEVICE_FILE
   VirtPos(0),
@@ -71,20 +264,197 @@ CInFileStream::CInFileStream():
   Callback(NULL),
   CallbackRef(0)
 {
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  _mapData = NULL;
+  _mapSize = 0;
+  _mapPos = 0;
+ #endif
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  _async = NULL;
+ #endif
 }
 
 CInFileStream::~CInFileStream()
 {
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  FreeAsync();
+ #endif
+
   #ifdef Z7_DEVICE_FILE
   MidFree(Buf);
   #endif
 
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  Unmap();
+ #endif
+
   if (Callback)
     Callback->InFileStream_On_Destroy(this, CallbackRef);
 }
 
+#ifdef Z7_FILE_STREAMS_USE_MMAP
+
+void CInFileStream::Unmap()
+{
+  if (_mapData)
+  {
+    munmap((void *)(Byte *)_mapData, _mapSize);
+    _mapData = NULL;
+    _mapSize = 0;
+  }
+}
+
+bool CInFileStream::MapToMemory()
+{
+  Unmap();
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  if (_async)
+    return false;
+ #endif
+  struct stat st;
+  if (File.my_fstat(&st) != 0 || !S_ISREG(st.st_mode))
+    return false;
+  const UInt64 size = (UInt64)st.st_size;
+  if (size == 0 || size != (size_t)size)
+    return false;
+  const off_t pos = File.seekToCur();
+  if (pos == -1)
+    return false;
+  void *p = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, File.GetHandle(), 0);
+  if (p == MAP_FAILED)
+    return false;
+  _mapData = (const Byte *)p;
+  _mapSize = (size_t)size;
+  _mapPos = (UInt64)pos;
+  return true;
+}
+
+#endif
+
+#ifdef Z7_FILE_STREAMS_USE_ASYNC
+
+void CInFileStream::FreeAsync()
+{
+  if (_async)
+  {
+    delete _async;
+    _async = NULL;
+  }
+}
+
+#endif
+
+bool CInFileStream::StartReadAhead()
+{
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  if (_async)
+    return true;
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  if (_mapData)
+    return false;
+ #endif
+ #ifdef Z7_DEVICE_FILE
+  if (File.IsDeviceFile)
+    return false;
+ #endif
+  UInt64 pos, size;
+ #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
+  if (!File.GetPosition(pos))
+    return false;
+ #else
+  {
+    const off_t pos2 = File.seekToCur();
+    if (pos2 == -1)
+      return false;
+    pos = (UInt64)pos2;
+  }
+ #endif
+  // for small files the helper thread is slower than direct reading
+  if (!File.GetLength(size) || size <= pos || size - pos <= kAsyncBufSize)
+    return false;
+  CFileStreamAsync *async = new CFileStreamAsync;
+  async->InFile = &File;
+  async->StartPos = pos;
+  if (async->Create() != 0)
+  {
+    delete async;
+    return false;
+  }
+  _async = async;
+  async->StartRead();
+  return true;
+ #else
+  return false;
+ #endif
+}
+
+Z7_COM7F_IMF(CInFileStream::GetDataPtr(const Byte **data, UInt64 *size))
+{
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  if (_mapData)
+  {
+    *data = _mapData;
+    *size = _mapSize;
+    return S_OK;
+  }
+ #endif
+  *data = NULL;
+  *size = 0;
+  return S_FALSE;
+}
+
 Z7_COM7F_IMF(CInFileStream::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  if (_async)
+  {
+    if (processedSize)
+      *processedSize = 0;
+    if (size == 0)
+      return S_OK;
+    CFileStreamAsync &a = *_async;
+    while (a.Pos == a.Lim)
+    {
+      if (!a.Busy)
+      {
+        const DWORD error = a.ResError;
+        if (error == 0)
+          return S_OK;
+        if (Callback)
+          return Callback->InFileStream_On_Error(CallbackRef, error);
+        return HRESULT_FROM_WIN32(error);
+      }
+      a.ReadNext();
+    }
+    size_t rem = a.Lim - a.Pos;
+    if (rem > size)
+      rem = (size_t)size;
+    memcpy(data, a.Bufs[a.BufIndex] + a.Pos, rem);
+    a.Pos += rem;
+    if (processedSize)
+      *processedSize = (UInt32)rem;
+    return S_OK;
+  }
+ #endif
+
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  if (_mapData)
+  {
+    if (processedSize)
+      *processedSize = 0;
+    if (_mapPos >= _mapSize)
+      return S_OK;
+    size_t rem = _mapSize - (size_t)_mapPos;
+    if (rem > size)
+      rem = (size_t)size;
+    memcpy(data, _mapData + (size_t)_mapPos, rem);
+    _mapPos += rem;
+    if (processedSize)
+      *processedSize = (UInt32)rem;
+    return S_OK;
+  }
+ #endif
+
   #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
   
   #ifdef Z7_DEVICE_FILE
@@ -266,6 +636,61 @@ Z7_COM7F_IMF(CInFileStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPos
   if (seekOrigin >= 3)
     return STG_E_INVALIDFUNCTION;
 
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  if (_async)
+  {
+    CFileStreamAsync &a = *_async;
+    if (seekOrigin != STREAM_SEEK_END)
+    {
+      if (seekOrigin == STREAM_SEEK_CUR)
+      {
+        offset += (Int64)(a.StartPos + a.Pos);
+        seekOrigin = STREAM_SEEK_SET;
+      }
+      if (offset < 0)
+        return HRESULT_WIN32_ERROR_NEGATIVE_SEEK;
+      if ((UInt64)offset >= a.StartPos && (UInt64)offset <= a.StartPos + a.Lim)
+      {
+        a.Pos = (size_t)((UInt64)offset - a.StartPos);
+        if (newPosition)
+          *newPosition = (UInt64)offset;
+        return S_OK;
+      }
+    }
+    // the new position is out of buffer. So we seek in file and restart reading.
+    a.WaitAndConsume();
+    UInt64 pos = 0;
+    _async = NULL;
+    const HRESULT res = Seek(offset, seekOrigin, &pos);
+    _async = &a;
+    a.StartPos = pos;
+    a.Pos = 0;
+    a.Lim = 0;
+    a.StartRead();
+    if (newPosition)
+      *newPosition = pos;
+    return res;
+  }
+ #endif
+
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  if (_mapData)
+  {
+    switch (seekOrigin)
+    {
+      case STREAM_SEEK_SET: break;
+      case STREAM_SEEK_CUR: offset += _mapPos; break;
+      default: offset += _mapSize; break;
+    }
+    if (offset < 0)
+      return HRESULT_WIN32_ERROR_NEGATIVE_SEEK;
+    _mapPos = (UInt64)offset;
+    if (newPosition)
+      *newPosition = (UInt64)offset;
+    return S_OK;
+  }
+ #endif
+
   #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
 
   #ifdef Z7_DEVICE_FILE
@@ -323,6 +748,18 @@ Z7_COM7F_IMF(CInFileStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPos
 
 Z7_COM7F_IMF(CInFileStream::GetSize(UInt64 *size))
 {
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  // GetLength() can change the position of file
+  if (_async)
+    _async->Wait();
+ #endif
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  if (_mapData)
+  {
+    *size = _mapSize;
+    return S_OK;
+  }
+ #endif
   return ConvertBoolToHRESULT(File.GetLength(*size));
 }
 
@@ -671,13 +1108,91 @@ Z7_COM7F_IMF(CInFileStream::ReloadProps())
 //////////////////////////
 // COutFileStream
 
+#ifdef Z7_FILE_STREAMS_USE_ASYNC
+
+void COutFileStream::FreeAsync()
+{
+  if (_async)
+  {
+    Flush_WriteBehind();
+    delete _async;
+    _async = NULL;
+  }
+}
+
+#endif
+
+bool COutFileStream::StartWriteBehind()
+{
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  if (_async)
+    return true;
+  CFileStreamAsync *async = new CFileStreamAsync;
+  async->OutFile = &File;
+  if (async->Create() != 0)
+  {
+    delete async;
+    return false;
+  }
+  _async = async;
+  return true;
+ #else
+  return false;
+ #endif
+}
+
+HRESULT COutFileStream::Flush_WriteBehind()
+{
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  if (_async)
+  {
+    CFileStreamAsync &a = *_async;
+    RINOK(a.WriteBuf())
+    return a.WriteBuf();
+  }
+ #endif
+  return S_OK;
+}
+
 HRESULT COutFileStream::Close()
 {
-  return ConvertBoolToHRESULT(File.Close());
+  const HRESULT res = Flush_WriteBehind();
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  FreeAsync();
+ #endif
+  const HRESULT res2 = ConvertBoolToHRESULT(File.Close());
+  return res != S_OK ? res : res2;
 }
 
 Z7_COM7F_IMF(COutFileStream::Write(const void *data, UInt32 size, UInt32 *processedSize))
 {
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  if (_async)
+  {
+    if (processedSize)
+      *processedSize = 0;
+    CFileStreamAsync &a = *_async;
+    while (size != 0)
+    {
+      if (a.Pos == kAsyncBufSize)
+      {
+        RINOK(a.WriteBuf())
+      }
+      size_t cur = kAsyncBufSize - a.Pos;
+      if (cur > size)
+        cur = size;
+      memcpy(a.Bufs[a.BufIndex] + a.Pos, data, cur);
+      a.Pos += cur;
+      data = (const void *)((const Byte *)data + cur);
+      size -= (UInt32)cur;
+      ProcessedSize += cur;
+      if (processedSize)
+        *processedSize += (UInt32)cur;
+    }
+    return a.WriteRes;
+  }
+ #endif
+
   #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
 
   UInt32 realProcessedSize;
@@ -707,6 +1222,7 @@ Z7_COM7F_IMF(COutFileStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPo
 {
   if (seekOrigin >= 3)
     return STG_E_INVALIDFUNCTION;
+  RINOK(Flush_WriteBehind())
   
   #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
 
@@ -730,11 +1246,13 @@ Z7_COM7F_IMF(COutFileStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPo
 
 Z7_COM7F_IMF(COutFileStream::SetSize(UInt64 newSize))
 {
+  RINOK(Flush_WriteBehind())
   return ConvertBoolToHRESULT(File.SetLength_KeepPosition(newSize));
 }
 
 HRESULT COutFileStream::GetSize(UInt64 *size)
 {
+  RINOK(Flush_WriteBehind())
   return ConvertBoolToHRESULT(File.GetLength(*size));
 }
 
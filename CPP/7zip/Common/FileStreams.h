@@ -5,6 +5,12 @@
 
 #ifdef _WIN32
 #define Z7_FILE_STREAMS_USE_WIN_FILE
+#else
+#define Z7_FILE_STREAMS_USE_MMAP
+#endif
+
+#ifndef Z7_ST
+#define Z7_FILE_STREAMS_USE_ASYNC
 #endif
 
 #include "../../Common/MyCom.h"
@@ -19,6 +25,10 @@
 
 class CInFileStream;
 
+#ifdef Z7_FILE_STREAMS_USE_ASYNC
+class CFileStreamAsync;
+#endif
+
 Z7_PURE_INTERFACES_BEGIN
 DECLARE_INTERFACE(IInFileStream_Callback)
 {
@@ -29,13 +39,14 @@ Z7_PURE_INTERFACES_END
 
 
 /*
-Z7_CLASS_IMP_COM_5(
+Z7_CLASS_IMP_COM_6(
   CInFileStream
   , IInStream
   , IStreamGetSize
   , IStreamGetProps
   , IStreamGetProps2
   , IStreamGetProp
+  , IStreamGetDataPtr
 )
 */
 Z7_class_final(CInFileStream) :
@@ -44,14 +55,16 @@ Z7_class_final(CInFileStream) :
   public IStreamGetProps,
   public IStreamGetProps2,
   public IStreamGetProp,
+  public IStreamGetDataPtr,
   public CMyUnknownImp
 {
-  Z7_COM_UNKNOWN_IMP_5(
+  Z7_COM_UNKNOWN_IMP_6(
       IInStream,
       IStreamGetSize,
       IStreamGetProps,
       IStreamGetProps2,
-      IStreamGetProp)
+      IStreamGetProp,
+      IStreamGetDataPtr)
 
   Z7_IFACE_COM7_IMP(ISequentialInStream)
   Z7_IFACE_COM7_IMP(IInStream)
@@ -62,9 +75,21 @@ private:
 public:
   Z7_IFACE_COM7_IMP(IStreamGetProps2)
   Z7_IFACE_COM7_IMP(IStreamGetProp)
+  Z7_IFACE_COM7_IMP(IStreamGetDataPtr)
 
 private:
   NWindows::NFile::NIO::CInFile File;
+
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  const Byte *_mapData;
+  size_t _mapSize;
+  UInt64 _mapPos;
+  void Unmap();
+ #endif
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  CFileStreamAsync *_async;
+  void FreeAsync();
+ #endif
 public:
 
   #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
@@ -112,14 +137,43 @@ public:
   bool Open(CFSTR fileName)
   {
     _info_WasLoaded = false;
+   #ifdef Z7_FILE_STREAMS_USE_MMAP
+    Unmap();
+   #endif
+   #ifdef Z7_FILE_STREAMS_USE_ASYNC
+    FreeAsync();
+   #endif
     return File.Open(fileName);
   }
   
   bool OpenShared(CFSTR fileName, bool shareForWrite)
   {
     _info_WasLoaded = false;
+   #ifdef Z7_FILE_STREAMS_USE_MMAP
+    Unmap();
+   #endif
+   #ifdef Z7_FILE_STREAMS_USE_ASYNC
+    FreeAsync();
+   #endif
     return File.OpenShared(fileName, shareForWrite);
   }
+
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  /* MapToMemory() maps the opened file to memory. Then Read() and Seek()
+     work with memory without system calls, and GetDataPtr() returns
+     the pointer to data of file.
+     It returns false, if the file can't be mapped (for example, if it's not a regular file).
+     Note: if another process truncates the file, the access to mapped data
+     after new end of file raises SIGBUS signal. */
+  bool MapToMemory();
+ #endif
+
+  /* StartReadAhead() starts helper thread that reads next block of file,
+     while the caller processes the data of previous block.
+     Seek() inside the buffered block doesn't call the system.
+     It returns false, if the file is small or if read-ahead mode is not supported.
+     Note: GetLength() must not be called in read-ahead mode. */
+  bool StartReadAhead();
 };
 
 
@@ -135,33 +189,72 @@ Z7_CLASS_IMP_COM_1(
   , IOutStream
 )
   Z7_IFACE_COM7_IMP(ISequentialOutStream)
+
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  CFileStreamAsync *_async;
+  void FreeAsync();
+ #endif
 public:
 
   NWindows::NFile::NIO::COutFile File;
 
+ #ifdef Z7_FILE_STREAMS_USE_ASYNC
+  COutFileStream(): _async(NULL) {}
+  ~COutFileStream() { FreeAsync(); }
+ #endif
+
   bool Create(CFSTR fileName, bool createAlways)
   {
     ProcessedSize = 0;
+   #ifdef Z7_FILE_STREAMS_USE_ASYNC
+    FreeAsync();
+   #endif
     return File.Create(fileName, createAlways);
   }
   bool Open(CFSTR fileName, DWORD creationDisposition)
   {
     ProcessedSize = 0;
+   #ifdef Z7_FILE_STREAMS_USE_ASYNC
+    FreeAsync();
+   #endif
     return File.Open(fileName, creationDisposition);
   }
+  bool Open_EXISTING(CFSTR fileName)
+  {
+    ProcessedSize = 0;
+   #ifdef Z7_FILE_STREAMS_USE_ASYNC
+    FreeAsync();
+   #endif
+    return File.Open_EXISTING(fileName);
+  }
 
   HRESULT Close();
   
   UInt64 ProcessedSize;
 
+  /* StartWriteBehind() starts helper thread that writes the data to file,
+     while the caller fills next block. Write() returns the error of
+     previous background write, and Flush_WriteBehind() waits for
+     all data to be written. Another methods call Flush_WriteBehind() themselves.
+     It returns false, if write-behind mode is not supported. */
+  bool StartWriteBehind();
+  HRESULT Flush_WriteBehind();
+
   bool SetTime(const CFiTime *cTime, const CFiTime *aTime, const CFiTime *mTime)
   {
+    Flush_WriteBehind();
     return File.SetTime(cTime, aTime, mTime);
   }
-  bool SetMTime(const CFiTime *mTime) {  return File.SetMTime(mTime); }
+  bool SetMTime(const CFiTime *mTime)
+  {
+    Flush_WriteBehind();
+    return File.SetMTime(mTime);
+  }
 
   bool SeekToBegin_bool()
   {
+    if (Flush_WriteBehind() != S_OK)
+      return false;
     #ifdef Z7_FILE_STREAMS_USE_WIN_FILE
     return File.SeekToBegin();
     #else
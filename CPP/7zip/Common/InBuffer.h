@@ -96,6 +96,12 @@ public:
   
   size_t ReadBytes(Byte *buf, size_t size);
   size_t Skip(size_t size);
+
+  // direct access to the data in buffer for external decoding loops.
+  // SetBufPtr() must set the position in range of current buffer.
+  Byte *GetBufPtr() const { return _buf; }
+  const Byte *GetBufLim() const { return _bufLim; }
+  void SetBufPtr(Byte *p) { _buf = p; }
 };
 
 class CInBuffer: public CInBufferBase
@@ -85,6 +85,65 @@ HRESULT CreateLimitedInStream(IInStream *inStream, UInt64 pos, UInt64 size, ISeq
   return S_OK;
 }
 
+HRESULT CSharedInStream::Read2(void *data, UInt32 size, UInt32 *processedSize)
+{
+  RINOK(InStream_SeekSet(Stream, _pos))
+  UInt32 processed = 0;
+  const HRESULT res = Stream->Read(data, size, &processed);
+  _pos += processed;
+  if (processedSize)
+    *processedSize = processed;
+  return res;
+}
+
+Z7_COM7F_IMF(CSharedInStream::Read(void *data, UInt32 size, UInt32 *processedSize))
+{
+  if (processedSize)
+    *processedSize = 0;
+ #ifndef Z7_ST
+  if (CS)
+  {
+    NWindows::NSynchronization::CCriticalSectionLock lock(*CS);
+    return Read2(data, size, processedSize);
+  }
+ #endif
+  return Read2(data, size, processedSize);
+}
+
+Z7_COM7F_IMF(CSharedInStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPosition))
+{
+  switch (seekOrigin)
+  {
+    case STREAM_SEEK_SET: break;
+    case STREAM_SEEK_CUR: offset += _pos; break;
+    case STREAM_SEEK_END:
+    {
+      UInt64 size;
+     #ifndef Z7_ST
+      if (CS)
+      {
+        NWindows::NSynchronization::CCriticalSectionLock lock(*CS);
+        RINOK(InStream_GetSize_SeekToEnd(Stream, size))
+      }
+      else
+     #endif
+      {
+        RINOK(InStream_GetSize_SeekToEnd(Stream, size))
+      }
+      offset += size;
+      break;
+    }
+    default: return STG_E_INVALIDFUNCTION;
+  }
+  if (offset < 0)
+    return HRESULT_WIN32_ERROR_NEGATIVE_SEEK;
+  _pos = (UInt64)offset;
+  if (newPosition)
+    *newPosition = (UInt64)offset;
+  return S_OK;
+}
+
+
 Z7_COM7F_IMF(CClusterInStream::Read(void *data, UInt32 size, UInt32 *processedSize))
 {
   if (processedSize)
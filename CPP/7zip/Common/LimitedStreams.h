@@ -8,6 +8,10 @@
 #include "../../Common/MyVector.h"
 #include "../IStream.h"
 
+#ifndef Z7_ST
+#include "../../Windows/Synchronization.h"
+#endif
+
 #include "StreamUtils.h"
 
 Z7_CLASS_IMP_COM_1(
@@ -59,6 +63,30 @@ public:
 HRESULT CreateLimitedInStream(IInStream *inStream, UInt64 pos, UInt64 size, ISequentialInStream **resStream);
 
 
+/* CSharedInStream reads from (Stream) with own position.
+   It calls Seek() for (Stream) before each Read(), so (Stream)
+   can be shared by several objects.
+   If (CS) is set, (Stream) is locked for each access,
+   so CSharedInStream objects can be used from several threads. */
+
+Z7_CLASS_IMP_IInStream(
+  CSharedInStream
+)
+  UInt64 _pos;
+  HRESULT Read2(void *data, UInt32 size, UInt32 *processedSize);
+public:
+  CMyComPtr<IInStream> Stream;
+ #ifndef Z7_ST
+  NWindows::NSynchronization::CCriticalSection *CS;
+ #endif
+  CSharedInStream(): _pos(0)
+    #ifndef Z7_ST
+      , CS(NULL)
+    #endif
+      {}
+};
+
+
 Z7_CLASS_IMP_IInStream(
   CClusterInStream
 )
@@ -406,7 +406,9 @@ static const CNameToPropID g_NameToPropID[] =
   { VT_UI8, "memuse" },
   { VT_UI8, "aff" },
   { VT_UI4, "offset" },
-  { VT_UI4, "zhb" }
+  { VT_UI4, "zhb" },
+  { VT_BOOL, "numa" },
+  { VT_BOOL, "overlap" }
   /*
   ,
   // { VT_UI4, "zhc" },
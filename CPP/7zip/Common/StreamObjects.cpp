@@ -76,6 +76,13 @@ Z7_COM7F_IMF(CBufInStream::Seek(Int64 offset, UInt32 seekOrigin, UInt64 *newPosi
   return S_OK;
 }
 
+Z7_COM7F_IMF(CBufInStream::GetDataPtr(const Byte **data, UInt64 *size))
+{
+  *data = _data;
+  *size = _size;
+  return S_OK;
+}
+
 void Create_BufInStream_WithReference(const void *data, size_t size, IUnknown *ref, ISequentialInStream **stream)
 {
   *stream = NULL;
@@ -27,9 +27,13 @@ public:
 };
 
 
-Z7_CLASS_IMP_IInStream(
-  CBufInStream
-)
+class CBufInStream Z7_final :
+  public IInStream,
+  public IStreamGetDataPtr,
+  public CMyUnknownImp
+{
+  Z7_IFACES_IMP_UNK_3(ISequentialInStream, IInStream, IStreamGetDataPtr)
+
   const Byte *_data;
   UInt64 _pos;
   size_t _size;
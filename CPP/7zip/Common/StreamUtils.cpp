@@ -50,6 +50,22 @@ HRESULT InStream_GetPos_GetSize(IInStream *stream, UInt64 &curPosRes, UInt64 &si
 }
 
 
+const Byte *InStream_GetDataPtr(IInStream *stream, UInt64 pos, size_t size) throw()
+{
+  Z7_DECL_CMyComPtr_QI_FROM(
+      IStreamGetDataPtr,
+      streamGetDataPtr, stream)
+  if (!streamGetDataPtr)
+    return NULL;
+  const Byte *data = NULL;
+  UInt64 streamSize = 0;
+  if (streamGetDataPtr->GetDataPtr(&data, &streamSize) != S_OK || !data)
+    return NULL;
+  if (pos > streamSize || streamSize - pos < size)
+    return NULL;
+  return data + (size_t)pos;
+}
+
 
 HRESULT ReadStream(ISequentialInStream *stream, void *data, size_t *processedSize) throw()
 {
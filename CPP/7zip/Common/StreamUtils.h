@@ -22,6 +22,11 @@ inline HRESULT InStream_GetSize_SeekToBegin(IInStream *stream, UInt64 &sizeRes)
   return InStream_AtBegin_GetSize(stream, sizeRes);
 }
 
+/* it returns the pointer to data at position (pos) in stream, if (size) bytes
+   from that position are available in memory via IStreamGetDataPtr interface.
+   it returns NULL otherwise. */
+const Byte *InStream_GetDataPtr(IInStream *stream, UInt64 pos, size_t size) throw();
+
 
 HRESULT ReadStream(ISequentialInStream *stream, void *data, size_t *size) throw();
 HRESULT ReadStream_FALSE(ISequentialInStream *stream, void *data, size_t size) throw();
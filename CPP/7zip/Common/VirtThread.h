@@ -10,7 +10,7 @@ struct CVirtThread
 {
   NWindows::NSynchronization::CAutoResetEvent StartEvent;
   NWindows::NSynchronization::CAutoResetEvent FinishedEvent;
-  NWindows::CThread Thread;
+  NWindows::CPoolThread Thread;
   bool Exit;
 
   virtual ~CVirtThread() { WaitThreadFinish(); }
@@ -149,6 +149,7 @@ CEncoder::CEncoder()
   #ifndef Z7_ST
   ThreadsInfo = NULL;
   m_NumThreadsPrev = 0;
+  m_NumThreadsMax = 1;
   NumThreads = 1;
   #endif
 }
@@ -189,7 +190,7 @@ HRESULT CEncoder::Create()
       HRESULT res = ti.Create();
       if (res != S_OK)
       {
-        NumThreads = t;
+        m_NumThreadsPrev = t;
         Free();
         return res;
       }
@@ -204,7 +205,7 @@ void CEncoder::Free()
     return;
   CloseThreads = true;
   CanProcessEvent.Set();
-  for (UInt32 t = 0; t < NumThreads; t++)
+  for (UInt32 t = 0; t < m_NumThreadsPrev; t++)
   {
     CThreadInfo &ti = ThreadsInfo[t];
     if (MtMode)
@@ -856,10 +857,20 @@ HRESULT CEncoder::CodeReal(ISequentialInStream *inStream, ISequentialOutStream *
 Z7_COM7F_IMF(CEncoder::Code(ISequentialInStream *inStream, ISequentialOutStream *outStream,
     const UInt64 *inSize, const UInt64 *outSize, ICompressProgressInfo *progress))
 {
-  try { return CodeReal(inStream, outStream, inSize, outSize, progress); }
-  catch(const CInBufferException &e) { return e.ErrorCode; }
-  catch(const COutBufferException &e) { return e.ErrorCode; }
-  catch(...) { return S_FALSE; }
+ #ifndef Z7_ST
+  // we limit the number of threads, if there is process-wide limit in thread pool
+  const UInt32 numThreads = ThreadPool_ReserveThreads(m_NumThreadsMax);
+  NumThreads = numThreads;
+ #endif
+  HRESULT res;
+  try { res = CodeReal(inStream, outStream, inSize, outSize, progress); }
+  catch(const CInBufferException &e) { res = e.ErrorCode; }
+  catch(const COutBufferException &e) { res = e.ErrorCode; }
+  catch(...) { res = S_FALSE; }
+ #ifndef Z7_ST
+  ThreadPool_ReleaseThreads(numThreads);
+ #endif
+  return res;
 }
 
 Z7_COM7F_IMF(CEncoder::SetCoderProperties(const PROPID *propIDs, const PROPVARIANT *coderProps, UInt32 numProps))
@@ -911,7 +922,7 @@ Z7_COM7F_IMF(CEncoder::SetNumberOfThreads(UInt32 numThreads))
   const UInt32 kNumThreadsMax = 64;
   if (numThreads < 1) numThreads = 1;
   if (numThreads > kNumThreadsMax) numThreads = kNumThreadsMax;
-  NumThreads = numThreads;
+  m_NumThreadsMax = numThreads;
   return S_OK;
 }
 #endif
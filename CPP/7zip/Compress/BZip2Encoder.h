@@ -119,7 +119,7 @@ public:
   bool m_OptimizeNumTables;
   CEncoder *Encoder;
  #ifndef Z7_ST
-  NWindows::CThread Thread;
+  NWindows::CPoolThread Thread;
 
   NWindows::NSynchronization::CAutoResetEvent StreamWasFinishedEvent;
   NWindows::NSynchronization::CAutoResetEvent WaitingWasStartedEvent;
@@ -185,6 +185,7 @@ class CEncoder Z7_final:
 
  #ifndef Z7_ST
   UInt32 m_NumThreadsPrev;
+  UInt32 m_NumThreadsMax; // the value from SetNumberOfThreads()
  #endif
 public:
   CInBuffer m_InStream;
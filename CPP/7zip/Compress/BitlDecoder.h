@@ -53,6 +53,8 @@ public:
   UInt64 GetProcessedSize() const { return _stream.GetProcessedSize() - ((kNumBigValueBits - _bitPos) >> 3); }
 
   bool ThereAreDataInBitsBuffer() const { return this->_bitPos != kNumBigValueBits; }
+
+  TInByte &GetInByteStream() { return _stream; }
   
   Z7_FORCE_INLINE
   void Normalize()
@@ -137,6 +139,29 @@ public:
   }
 
   void AlignToByte() { MovePos((32 - this->_bitPos) & 7); }
+
+  /* ExportBits() and ImportBits() allow to use external decoding loop
+     that reads the data directly from TInByte buffer.
+     ExportBits() returns the number of bits in bits buffer and these bits (LSB-first). */
+  unsigned ExportBits(UInt32 &value) const
+  {
+    value = _normalValue;
+    return kNumBigValueBits - this->_bitPos;
+  }
+
+  // (numBits <= 32). The bits in (value) above (numBits) must be zeros.
+  void ImportBits(UInt32 value, unsigned numBits)
+  {
+    this->_bitPos = kNumBigValueBits - numBits;
+    _normalValue = value;
+    // (_value) contains the bits in reversed order. Next bit is at position (31 - _bitPos).
+    value = (UInt32)((UInt64)value << this->_bitPos);
+    this->_value =
+          ((UInt32)kInvertTable[(Byte)value] << 24)
+        | ((UInt32)kInvertTable[(Byte)(value >> 8)] << 16)
+        | ((UInt32)kInvertTable[(Byte)(value >> 16)] << 8)
+        | ((UInt32)kInvertTable[(Byte)(value >> 24)]);
+  }
   
   Z7_FORCE_INLINE
   Byte ReadDirectByte() { return this->_stream.ReadByte(); }
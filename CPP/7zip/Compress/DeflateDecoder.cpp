@@ -2,13 +2,191 @@
 
 #include "StdAfx.h"
 
+#include <string.h>
+
+#include "../../../C/CpuArch.h"
+
 #include "DeflateDecoder.h"
 
 namespace NCompress {
 namespace NDeflate {
 namespace NDecoder {
 
+/*
+  The entry of fast table:
+    bits  0..4  : the number of bits to skip: code length + the number of extra bits,
+                  or the length of two codes for two literals.
+    bit   5     : kFast_Sub   : reference to sub-table. (bits 16..31) contain the offset of sub-table.
+    bit   6     : kFast_Lit   : literal. (bits 16..23) contain the literal.
+    bit   7     : kFast_Lit2  : second literal. (bits 24..31) contain second literal.
+    bits  8..11 : code length (the length of code of first literal for literal entry)
+    bit  12     : kFast_Stop  : end of block or error
+    bit  13     : kFast_Error : unused code or wrong symbol
+    bits 16..31 : the base value of length or distance
+*/
+
+static const UInt32 kFast_Lit   = 1 << 6;
+static const UInt32 kFast_Lit2  = 1 << 7;
+static const UInt32 kFast_Stop  = 1 << 12;
+static const UInt32 kFast_Error = 1 << 13;
+
+// the fast loop reads 8 bytes from input buffer for each symbol
+static const size_t kFastInMargin = 8;
+// the fast loop can write up to 7 bytes after the end of match
+static const UInt32 kFastOutMargin = kMatchMaxLen32 + 8;
+// the output window is larger than history, so the bytes written after the end of match
+// don't overwrite the bytes of history.
+static const UInt32 kFastOutWindowSize = (UInt32)1 << 18;
+
+static UInt32 g_FastLitEntries[kFixedMainTableSize];
+static UInt32 g_FastDistEntries[kFixedDistTableSize];
+
+static
+struct CFastEntriesInitializer
+{
+  CFastEntriesInitializer()
+  {
+    unsigned i;
+    for (i = 0; i < kFixedMainTableSize; i++)
+    {
+      UInt32 e;
+      if (i < kSymbolEndOfBlock)
+        e = ((UInt32)i << 16) | kFast_Lit;
+      else if (i == kSymbolEndOfBlock)
+        e = kFast_Stop;
+      else if (i < kMainTableSize)
+      {
+        const unsigned k = i - kSymbolMatch;
+        e = ((UInt32)(kMatchMinLen + kLenStart32[k]) << 16) | kLenDirectBits32[k];
+      }
+      else
+        e = kFast_Stop | kFast_Error;
+      g_FastLitEntries[i] = e;
+    }
+    for (i = 0; i < kFixedDistTableSize; i++)
+      g_FastDistEntries[i] = (i < kDistTableSize32) ?
+          ((kDistStart[i] << 16) | kDistDirectBits[i]) :
+          (kFast_Stop | kFast_Error);
+  }
+} g_FastEntriesInitializer;
+
+
+/* BuildFastTable() supports incomplete codes like NHuffman::CDecoder::Build(),
+   if (strict) mode is not set. */
+
+bool BuildFastTable(UInt32 *table, unsigned tableBits, const Byte *lens, unsigned numSyms,
+    const UInt32 *entries, UInt32 emptyEntry, bool strict)
+{
+  unsigned counts[kNumHuffmanBits + 1];
+  unsigned offsets[kNumHuffmanBits + 1];
+  UInt16 sorted[kFixedMainTableSize];
+  unsigned i;
+
+  for (i = 0; i <= kNumHuffmanBits; i++)
+    counts[i] = 0;
+  for (i = 0; i < numSyms; i++)
+    counts[lens[i]]++;
+  counts[0] = 0;
+
+  {
+    Int32 left = 1;
+    unsigned numCodes = 0;
+    for (i = 1; i <= kNumHuffmanBits; i++)
+    {
+      left <<= 1;
+      left -= (Int32)counts[i];
+      if (left < 0)
+        return false;
+      numCodes += counts[i];
+    }
+    if (strict && left != 0 && numCodes > 1)
+      return false;
+  }
+
+  offsets[1] = 0;
+  for (i = 1; i < kNumHuffmanBits; i++)
+    offsets[i + 1] = offsets[i] + counts[i];
+  for (i = 0; i < numSyms; i++)
+    if (lens[i] != 0)
+      sorted[offsets[lens[i]]++] = (UInt16)i;
+
+  const UInt32 tableSize = (UInt32)1 << tableBits;
+  const unsigned subBits = kNumHuffmanBits - tableBits;
+  for (i = 0; i < tableSize; i++)
+    table[i] = emptyEntry;
+
+  UInt32 code = 0;
+  UInt32 subOffset = tableSize;
+  unsigned k = 0;
+
+  for (unsigned len = 1; len <= kNumHuffmanBits; len++)
+  {
+    for (unsigned n = counts[len]; n != 0; n--, code++)
+    {
+      const UInt32 sym = sorted[k++];
+      UInt32 rev = 0;
+      {
+        UInt32 c = code;
+        for (unsigned b = 0; b < len; b++, c >>= 1)
+          rev = (rev << 1) | (c & 1);
+      }
+      const UInt32 entry = (entries ? entries[sym] : (sym << 16)) + len + (len << kFast_CodeLenShift);
+      if (len <= tableBits)
+      {
+        for (UInt32 j = rev; j < tableSize; j += ((UInt32)1 << len))
+          table[j] = entry;
+        continue;
+      }
+      UInt32 *sub;
+      {
+        UInt32 &ref = table[rev & (tableSize - 1)];
+        if ((ref & kFast_Sub) == 0)
+        {
+          ref = (subOffset << 16) | kFast_Sub;
+          sub = table + subOffset;
+          for (UInt32 j = 0; j < ((UInt32)1 << subBits); j++)
+            sub[j] = emptyEntry;
+          subOffset += (UInt32)1 << subBits;
+        }
+        else
+          sub = table + (ref >> 16);
+      }
+      for (UInt32 j = rev >> tableBits; j < ((UInt32)1 << subBits); j += ((UInt32)1 << (len - tableBits)))
+        sub[j] = entry;
+    }
+    code <<= 1;
+  }
+  return true;
+}
+
+
+/* AddLiteralPairs() replaces the literal entries in main table by entries for two literals,
+   if the codes of both literals fit to (kFastLitTableBits) bits. */
+
+static void AddLiteralPairs(UInt32 *table)
+{
+  for (UInt32 i = 0; i < ((UInt32)1 << kFastLitTableBits); i++)
+  {
+    const UInt32 e = table[i];
+    if ((e & kFast_Lit) == 0)
+      continue;
+    const unsigned len = (e >> kFast_CodeLenShift) & 0xF;
+    // (table[i >> len]) can be pair entry already, but it contains first literal and its code length.
+    const UInt32 e2 = table[i >> len];
+    if ((e2 & kFast_Lit) == 0)
+      continue;
+    const unsigned len2 = (e2 >> kFast_CodeLenShift) & 0xF;
+    if (len + len2 > kFastLitTableBits)
+      continue;
+    table[i] = (e & ((UInt32)0xFF << 16)) | ((e2 & ((UInt32)0xFF << 16)) << 8)
+        | kFast_Lit | kFast_Lit2
+        | ((UInt32)len << kFast_CodeLenShift) | (len + len2);
+  }
+}
+
+
 CCoder::CCoder(bool deflate64Mode):
+    _fastTablesAreFixed(false),
     _deflateNSIS(false),
     _deflate64Mode(deflate64Mode),
     _keepHistory(false),
@@ -144,7 +322,177 @@ bool CCoder::ReadTables(void)
     memcpy(levels.distLevels, tmpLevels + numLitLenLevels, _numDistLevels);
   }
   RIF(m_MainDecoder.Build(levels.litLenLevels))
-  return m_DistDecoder.Build(levels.distLevels);
+  RIF(m_DistDecoder.Build(levels.distLevels))
+
+  if (!_deflate64Mode)
+  {
+    const bool isFixed = (blockType == NBlockType::kFixedHuffman);
+    if (!isFixed || !_fastTablesAreFixed)
+    {
+      _fastTablesAreFixed = false;
+      RIF(BuildFastTable(_fastLitTable, kFastLitTableBits, levels.litLenLevels, kFixedMainTableSize,
+          g_FastLitEntries, kFast_Stop | kFast_Error, false))
+      RIF(BuildFastTable(_fastDistTable, kFastDistTableBits, levels.distLevels, kFixedDistTableSize,
+          g_FastDistEntries, kFast_Stop | kFast_Error, false))
+      AddLiteralPairs(_fastLitTable);
+      _fastTablesAreFixed = isFixed;
+    }
+  }
+  return true;
+}
+
+
+#define FAST_REFILL \
+  bitBuf |= GetUi64(in) << numBits; \
+  in += (63 - numBits) >> 3; \
+  numBits |= 56;
+
+#define FAST_SKIP_BITS(num) { const unsigned _num_ = (num); bitBuf >>= _num_; numBits -= _num_; }
+
+#define FAST_DECODE_SYM(table, tableBits, e) \
+  e = table[(size_t)bitBuf & (((size_t)1 << (tableBits)) - 1)]; \
+  if (e & kFast_Sub) \
+    e = table[(e >> 16) + ((size_t)(bitBuf >> (tableBits)) & (((size_t)1 << (kNumHuffmanBits - (tableBits))) - 1))];
+
+#define FAST_GET_VALUE(e, val) \
+  { \
+    const unsigned _numBits_ = e & kFast_NumBitsMask; \
+    val = (e >> 16) + ((UInt32)(bitBuf & (((UInt32)1 << _numBits_) - 1)) >> ((e >> kFast_CodeLenShift) & 0xF)); \
+    FAST_SKIP_BITS(_numBits_) \
+  }
+
+/*
+  DecodeFast() decodes the symbols of Huffman block, while there is enough data
+  in input buffer and there is enough space in output window. Each iteration of loop
+  refills 64-bit bit buffer to (56+) bits, that is enough for (length + distance) pair.
+  It returns false in case of data error.
+  If the end of block was reached, it sets (_needReadTable = true).
+*/
+
+bool CCoder::DecodeFast(UInt32 &curSize)
+{
+  Byte *outBuf = m_OutWindowStream.GetBuf();
+  const UInt32 outPos = m_OutWindowStream.GetPos();
+  UInt32 outLimPos = m_OutWindowStream.GetLimitPos();
+  if (outLimPos - outPos > curSize)
+    outLimPos = outPos + curSize;
+  if (outLimPos - outPos <= kFastOutMargin)
+    return true;
+
+  CInBuffer &inStream = m_InBitStream.GetInByteStream();
+  Byte *in = inStream.GetBufPtr();
+  const Byte *inLim = inStream.GetBufLim();
+  if ((size_t)(inLim - in) <= kFastInMargin)
+    return true;
+  inLim -= kFastInMargin;
+
+  Byte *out = outBuf + outPos;
+  const Byte *outLim = outBuf + outLimPos - kFastOutMargin;
+  const UInt32 bufSize = m_OutWindowStream.GetBufSize();
+  const bool overDict = m_OutWindowStream.IsOverDict();
+  const UInt32 *litTable = _fastLitTable;
+  const UInt32 *distTable = _fastDistTable;
+  bool res = true;
+
+  UInt64 bitBuf;
+  unsigned numBits;
+  {
+    UInt32 v;
+    numBits = m_InBitStream.ExportBits(v);
+    bitBuf = v;
+  }
+
+  do
+  {
+    FAST_REFILL
+    UInt32 e;
+    FAST_DECODE_SYM(litTable, kFastLitTableBits, e)
+    if (e & kFast_Lit)
+    {
+      out[0] = (Byte)(e >> 16);
+      out[1] = (Byte)(e >> 24);
+      out += 1 + ((e >> 7) & 1);
+      FAST_SKIP_BITS(e & kFast_NumBitsMask)
+      continue;
+    }
+    if (e & kFast_Stop)
+    {
+      if (e & kFast_Error)
+      {
+        res = false;
+        break;
+      }
+      FAST_SKIP_BITS(e & kFast_NumBitsMask)
+      _needReadTable = true;
+      break;
+    }
+    UInt32 len;
+    FAST_GET_VALUE(e, len)
+    FAST_DECODE_SYM(distTable, kFastDistTableBits, e)
+    if (e & kFast_Stop)
+    {
+      res = false;
+      break;
+    }
+    UInt32 dist;
+    FAST_GET_VALUE(e, dist)
+
+    const UInt32 pos = (UInt32)(out - outBuf);
+    if (dist >= pos)
+    {
+      if (!overDict || dist >= bufSize)
+      {
+        res = false;
+        break;
+      }
+      UInt32 src = pos + bufSize - dist - 1;
+      do
+      {
+        *out++ = outBuf[src++];
+        if (src == bufSize)
+          src = 0;
+      }
+      while (--len != 0);
+      continue;
+    }
+
+    const Byte *src = out - dist - 1;
+    Byte *dest = out;
+    out += len;
+    if (dist >= 7)
+    {
+      do
+      {
+        SetUi64(dest, GetUi64(src))
+        dest += 8;
+        src += 8;
+      }
+      while (dest < out);
+    }
+    else if (dist == 0)
+      memset(dest, *src, len);
+    else
+    {
+      do
+        *dest++ = *src++;
+      while (dest != out);
+    }
+  }
+  while (out < outLim && in < inLim);
+
+  m_OutWindowStream.SetPos((UInt32)(out - outBuf));
+  curSize -= (UInt32)(out - outBuf) - outPos;
+
+  // we return unused whole bytes to input buffer, so only (<= 32) bits remain in bit buffer.
+  if (numBits > 32)
+  {
+    const unsigned num = (numBits - 32 + 7) >> 3;
+    in -= num;
+    numBits -= num << 3;
+  }
+  inStream.SetBufPtr(in);
+  m_InBitStream.ImportBits((UInt32)(bitBuf & (((UInt64)1 << numBits) - 1)), numBits);
+  return res;
 }
 
 
@@ -172,7 +520,7 @@ HRESULT CCoder::CodeSpec(UInt32 curSize, bool finishInputStream, UInt32 inputPro
   if (_remainLen == kLenIdNeedInit)
   {
     if (!_keepHistory)
-      if (!m_OutWindowStream.Create(_deflate64Mode ? kHistorySize64: kHistorySize32))
+      if (!m_OutWindowStream.Create(_deflate64Mode ? kHistorySize64: kFastOutWindowSize))
         return E_OUTOFMEMORY;
     RINOK(InitInStream(_needInitInStream))
     m_OutWindowStream.Init(_keepHistory);
@@ -234,6 +582,14 @@ HRESULT CCoder::CodeSpec(UInt32 curSize, bool finishInputStream, UInt32 inputPro
     
     while (curSize > 0)
     {
+      if (!_deflate64Mode)
+      {
+        if (!DecodeFast(curSize))
+          return S_FALSE;
+        if (_needReadTable || curSize == 0)
+          break;
+      }
+
       if (m_InBitStream.ExtraBitsWereRead_Fast())
         return S_FALSE;
 
@@ -21,6 +21,39 @@ namespace NDecoder {
 const int kLenIdFinished = -1;
 const int kLenIdNeedInit = -2;
 
+/*
+  Fast decoding loop (for Deflate, but not for Deflate64) uses 64-bit bit buffer
+  and the tables for LSB-first bit order, where one lookup in main table
+  returns one or two literals, or the length with extra bits.
+  The fast loop is used, if there is enough data in input buffer and
+  there is enough space in output window. Other cases are processed by main loop.
+*/
+const unsigned kFastLitTableBits = 11;
+const unsigned kFastDistTableBits = 8;
+const size_t kFastLitTableSize =
+    ((size_t)1 << kFastLitTableBits) + ((size_t)kFixedMainTableSize << (kNumHuffmanBits - kFastLitTableBits));
+const size_t kFastDistTableSize =
+    ((size_t)1 << kFastDistTableBits) + ((size_t)kFixedDistTableSize << (kNumHuffmanBits - kFastDistTableBits));
+
+const UInt32 kFast_NumBitsMask = 0x1F;
+const UInt32 kFast_Sub = 1 << 5;
+const unsigned kFast_CodeLenShift = 8;
+
+/*
+  BuildFastTable() builds Huffman table for LSB-first bit order.
+  It's used by the fast loop and by multithreaded decoder.
+  The entry for symbol (sym) with code length (len) is
+    (entries[sym] + len + (len << kFast_CodeLenShift)), or
+    ((sym << 16) + len + (len << kFast_CodeLenShift)), if (entries == NULL).
+  The codes that are longer than (tableBits) are stored in sub-tables:
+    the entry of main table is ((subOffset << 16) | kFast_Sub), and
+    the entry of sub-table is selected by the code bits after (tableBits) bits.
+  The entries of unused codes are (emptyEntry).
+  (strict) mode rejects incomplete codes, if there are two or more codes.
+*/
+bool BuildFastTable(UInt32 *table, unsigned tableBits, const Byte *lens, unsigned numSyms,
+    const UInt32 *entries, UInt32 emptyEntry, bool strict);
+
 class CCoder:
   public ICompressCoder,
   public ICompressSetFinishMode,
@@ -64,6 +97,10 @@ private:
   NCompress::NHuffman::CDecoder<kNumHuffmanBits, kFixedDistTableSize> m_DistDecoder;
   NCompress::NHuffman::CDecoder7b<kLevelTableSize> m_LevelDecoder;
 
+  bool _fastTablesAreFixed;
+  UInt32 _fastLitTable[kFastLitTableSize];
+  UInt32 _fastDistTable[kFastDistTableSize];
+
   UInt32 m_StoredBlockSize;
 
   UInt32 _numDistLevels;
@@ -91,6 +128,7 @@ private:
 
   bool DecodeLevels(Byte *levels, unsigned numSymbols);
   bool ReadTables();
+  bool DecodeFast(UInt32 &curSize);
   
   HRESULT Flush() { return m_OutWindowStream.Flush(); }
   class CCoderReleaser
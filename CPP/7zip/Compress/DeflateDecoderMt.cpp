@@ -0,0 +1,750 @@
+// DeflateDecoderMt.cpp
+
+#include "StdAfx.h"
+
+#ifndef Z7_ST
+
+#include <string.h>
+
+#include "../../../C/Alloc.h"
+#include "../../../C/CpuArch.h"
+
+#include "../../Common/MyBuffer.h"
+
+#include "../Common/StreamUtils.h"
+
+#include "DeflateConst.h"
+#include "DeflateDecoder.h"
+#include "DeflateDecoderMt.h"
+
+namespace NCompress {
+namespace NDeflate {
+namespace NDecoder {
+
+/*
+  Huffman tables are built by BuildFastTable() without (entries):
+    (sym << 16) | (len << kFast_CodeLenShift) | len : symbol entry. (len == 0) means an unused code.
+    (subOffset << 16) | kFast_Sub                   : reference to sub-table.
+*/
+
+static const UInt32 kLenMask = kFast_NumBitsMask;
+
+static const unsigned kLitTableBits = 10;
+static const unsigned kDistTableBits = 8;
+static const unsigned kLevelTableBits = 7;
+
+#define TABLE_SIZE(bits, numSyms) (((size_t)1 << (bits)) + (size_t)(numSyms) * ((size_t)1 << (kNumHuffmanBits - (bits))))
+
+static const size_t kLitTableSize = TABLE_SIZE(kLitTableBits, kFixedMainTableSize);
+static const size_t kDistTableSize = TABLE_SIZE(kDistTableBits, kFixedDistTableSize);
+
+// the size of zero padding after input data. It allows to read bits without buffer checks.
+static const size_t kInBufPadSize = 32;
+
+// the maximum number of output symbols for one call of CChunkDecoder::Decode() or Continue()
+static const size_t kOutSizeMax = (size_t)kMtChunkSize << 5;
+
+
+#define GET_BITS_VAL(buf, pos)  (GetUi64((buf) + ((pos) >> 3)) >> ((unsigned)(pos) & 7))
+
+#define DECODE_SYM(table, tableBits, v, e) \
+  e = table[(size_t)v & (((size_t)1 << tableBits) - 1)]; \
+  if (e & kFast_Sub) e = table[(e >> 16) + ((size_t)(v >> tableBits) & (((size_t)1 << (kNumHuffmanBits - tableBits)) - 1))];
+
+
+enum EChunkRes
+{
+  k_ChunkRes_Boundary,  // the start of block at position (>= boundaryPos) was reached
+  k_ChunkRes_Finished,  // the final block was decoded
+  k_ChunkRes_Error,
+  k_ChunkRes_NeedInput,
+  k_ChunkRes_OutLimit
+};
+
+
+/*
+  CChunkDecoder decodes the Deflate blocks from buffer to array of UInt16 symbols:
+    (sym < 256)  : byte value
+    (sym >= 256) : marker that refers to byte (history[sym - 256]) in the history
+                   of (kHistorySize32) bytes before the start position.
+*/
+
+class CChunkDecoder
+{
+  const Byte *_buf;
+  size_t _bitLim;
+  size_t _boundaryPos;
+  size_t _pos;                  // the position for Continue()
+  const UInt32 *_blockLitTable; // (!= NULL) : Continue() continues current Huffman block
+  const UInt32 *_blockDistTable;
+  bool _finalBlock;
+
+  UInt32 *_litTable;
+  UInt32 *_distTable;
+  UInt32 *_fixedLitTable;
+  UInt32 *_fixedDistTable;
+  UInt32 _levelTable[(size_t)1 << kLevelTableBits];
+
+  bool GrowOut(size_t size);
+  EChunkRes ReadTables(size_t &pos, bool strict);
+  EChunkRes DecodeHuffmanBlock(size_t &pos, const UInt32 *litTable, const UInt32 *distTable, UInt32 historySize);
+public:
+  UInt16 *Out;
+  size_t OutSize;
+  size_t OutCapacity;
+  size_t EndPos; // bit position after the decoded data
+
+  CChunkDecoder(): _blockLitTable(NULL), _litTable(NULL), Out(NULL), OutSize(0), OutCapacity(0) {}
+  ~CChunkDecoder()
+  {
+    ::MidFree(_litTable);
+    ::MidFree(Out);
+  }
+  bool Create();
+
+  /* Decode() decodes the blocks from bit position (pos), until
+     the start of block at position (>= boundaryPos) or the end of final block. */
+  EChunkRes Decode(const Byte *buf, size_t size, size_t pos, size_t boundaryPos,
+      UInt32 historySize, bool strict);
+
+  /* Continue() continues decoding after (k_ChunkRes_OutLimit) result.
+     The caller must process (Out) data before that call,
+     because Continue() writes new data from the start of (Out). */
+  EChunkRes Continue(UInt32 historySize, bool strict);
+
+  /* Search() finds the first position (< boundaryPos) of non-final Dynamic Huffman block,
+     where speculative decoding doesn't return error. */
+  EChunkRes Search(const Byte *buf, size_t size, size_t boundaryPos, size_t &startPos);
+};
+
+
+bool CChunkDecoder::Create()
+{
+  if (_litTable)
+    return true;
+  const size_t num = (kLitTableSize + kDistTableSize) * 2;
+  UInt32 *p = (UInt32 *)::MidAlloc(num * sizeof(UInt32));
+  if (!p)
+    return false;
+  _litTable = p;
+  _distTable = p + kLitTableSize;
+  _fixedLitTable = p + kLitTableSize + kDistTableSize;
+  _fixedDistTable = _fixedLitTable + kLitTableSize;
+  CLevels levels;
+  levels.SetFixedLevels();
+  BuildFastTable(_fixedLitTable, kLitTableBits, levels.litLenLevels, kFixedMainTableSize, NULL, 0, false);
+  BuildFastTable(_fixedDistTable, kDistTableBits, levels.distLevels, kFixedDistTableSize, NULL, 0, false);
+  return true;
+}
+
+
+bool CChunkDecoder::GrowOut(size_t size)
+{
+  if (size > kOutSizeMax)
+    return false;
+  size_t newCap = OutCapacity * 2;
+  if (newCap < ((size_t)1 << 20))
+    newCap = (size_t)1 << 20;
+  if (newCap > kOutSizeMax)
+    newCap = kOutSizeMax;
+  if (newCap < size)
+    newCap = size;
+  UInt16 *p = (UInt16 *)::MidAlloc(newCap * sizeof(UInt16));
+  if (!p)
+    return false;
+  if (OutSize != 0)
+    memcpy(p, Out, OutSize * sizeof(UInt16));
+  ::MidFree(Out);
+  Out = p;
+  OutCapacity = newCap;
+  return true;
+}
+
+
+EChunkRes CChunkDecoder::ReadTables(size_t &pos, bool strict)
+{
+  const Byte *buf = _buf;
+  UInt64 v = GET_BITS_VAL(buf, pos);
+  const unsigned numLitLenLevels = (unsigned)(v & 31) + kNumLitLenCodesMin;
+  const unsigned numDistLevels = (unsigned)((v >> 5) & 31) + kNumDistCodesMin;
+  const unsigned numLevelCodes = (unsigned)((v >> 10) & 15) + kNumLevelCodesMin;
+  pos += kNumLenCodesFieldSize + kNumDistCodesFieldSize + kNumLevelCodesFieldSize;
+  if (numLitLenLevels > kMainTableSize || numDistLevels > kDistTableSize32)
+    return k_ChunkRes_Error;
+
+  Byte levelLevels[kLevelTableSize];
+  unsigned i;
+  for (i = 0; i < kLevelTableSize; i++)
+    levelLevels[i] = 0;
+  for (i = 0; i < numLevelCodes; i++, pos += kLevelFieldSize)
+    levelLevels[kCodeLengthAlphabetOrder[i]] = (Byte)(GET_BITS_VAL(buf, pos) & 7);
+  if (pos > _bitLim)
+    return k_ChunkRes_NeedInput;
+  if (!BuildFastTable(_levelTable, kLevelTableBits, levelLevels, kLevelTableSize, NULL, 0, true))
+    return k_ChunkRes_Error;
+
+  Byte lens[kMainTableSize + kDistTableSize32];
+  const unsigned numLevels = numLitLenLevels + numDistLevels;
+  i = 0;
+  do
+  {
+    if (pos > _bitLim)
+      return k_ChunkRes_NeedInput;
+    v = GET_BITS_VAL(buf, pos);
+    const UInt32 e = _levelTable[(size_t)v & (((size_t)1 << kLevelTableBits) - 1)];
+    const unsigned len = e & kLenMask;
+    if (len == 0)
+      return k_ChunkRes_Error;
+    pos += len;
+    v >>= len;
+    const unsigned sym = e >> 16;
+    if (sym < kTableDirectLevels)
+    {
+      lens[i++] = (Byte)sym;
+      continue;
+    }
+    unsigned num;
+    Byte val = 0;
+    if (sym == kTableLevelRepNumber)
+    {
+      if (i == 0)
+        return k_ChunkRes_Error;
+      val = lens[i - 1];
+      num = 3 + (unsigned)(v & 3);
+      pos += 2;
+    }
+    else if (sym == kTableLevel0Number)
+    {
+      num = 3 + (unsigned)(v & 7);
+      pos += 3;
+    }
+    else
+    {
+      num = 11 + (unsigned)(v & 0x7f);
+      pos += 7;
+    }
+    if (num > numLevels - i)
+      return k_ChunkRes_Error;
+    do
+      lens[i++] = val;
+    while (--num);
+  }
+  while (i < numLevels);
+
+  if (lens[kSymbolEndOfBlock] == 0)
+    return k_ChunkRes_Error;
+  if (!BuildFastTable(_litTable, kLitTableBits, lens, numLitLenLevels, NULL, 0, strict))
+    return k_ChunkRes_Error;
+  if (!BuildFastTable(_distTable, kDistTableBits, lens + numLitLenLevels, numDistLevels, NULL, 0, strict))
+    return k_ChunkRes_Error;
+  return k_ChunkRes_Boundary;
+}
+
+
+EChunkRes CChunkDecoder::DecodeHuffmanBlock(size_t &posRef, const UInt32 *litTable, const UInt32 *distTable,
+    UInt32 historySize)
+{
+  const Byte *buf = _buf;
+  const size_t bitLim = _bitLim;
+  size_t pos = posRef;
+  size_t outSize = OutSize;
+  EChunkRes res = k_ChunkRes_Error;
+
+  for (;;)
+  {
+    if (pos > bitLim)
+    {
+      res = k_ChunkRes_NeedInput;
+      break;
+    }
+    if (OutCapacity - outSize < kMatchMaxLen32)
+    {
+      OutSize = outSize;
+      if (!GrowOut(outSize + kMatchMaxLen32))
+      {
+        res = k_ChunkRes_OutLimit;
+        break;
+      }
+    }
+    UInt64 v = GET_BITS_VAL(buf, pos);
+    UInt32 e;
+    DECODE_SYM(litTable, kLitTableBits, v, e)
+    unsigned len = e & kLenMask;
+    if (len == 0)
+      break;
+    pos += len;
+    UInt32 sym = e >> 16;
+    if (sym < 0x100)
+    {
+      Out[outSize++] = (UInt16)sym;
+      continue;
+    }
+    if (sym == kSymbolEndOfBlock)
+    {
+      res = k_ChunkRes_Boundary;
+      break;
+    }
+    sym -= kSymbolMatch;
+    if (sym >= kNumLenSlots)
+      break;
+    v >>= len;
+    {
+      const unsigned numBits = kLenDirectBits32[sym];
+      len = kMatchMinLen + kLenStart32[sym] + (unsigned)(v & (((UInt32)1 << numBits) - 1));
+      pos += numBits;
+      v >>= numBits;
+    }
+    DECODE_SYM(distTable, kDistTableBits, v, e)
+    {
+      const unsigned numBits = e & kLenMask;
+      if (numBits == 0)
+        break;
+      pos += numBits;
+      v >>= numBits;
+    }
+    sym = e >> 16;
+    if (sym >= kDistTableSize32)
+      break;
+    size_t dist;
+    {
+      const unsigned numBits = kDistDirectBits[sym];
+      dist = kDistStart[sym] + 1 + (size_t)(v & (((UInt32)1 << numBits) - 1));
+      pos += numBits;
+    }
+    UInt16 *dest = Out + outSize;
+    outSize += len;
+    if (dist > (size_t)(dest - Out))
+    {
+      const size_t back = dist - (size_t)(dest - Out);
+      if (back > historySize)
+        break;
+      UInt32 marker = 0x100 + kHistorySize32 - (UInt32)back;
+      size_t num = back;
+      if (num > len)
+        num = len;
+      len -= (unsigned)num;
+      do
+        *dest++ = (UInt16)(marker++);
+      while (--num);
+    }
+    if (len != 0)
+    {
+      const UInt16 *src = dest - dist;
+      do
+        *dest++ = *src++;
+      while (--len);
+    }
+  }
+
+  OutSize = outSize;
+  posRef = pos;
+  return res;
+}
+
+
+EChunkRes CChunkDecoder::Decode(const Byte *buf, size_t size, size_t pos, size_t boundaryPos,
+    UInt32 historySize, bool strict)
+{
+  _buf = buf;
+  _bitLim = size << 3;
+  _boundaryPos = boundaryPos;
+  _pos = pos;
+  _blockLitTable = NULL;
+  return Continue(historySize, strict);
+}
+
+
+EChunkRes CChunkDecoder::Continue(UInt32 historySize, bool strict)
+{
+  const Byte *buf = _buf;
+  size_t pos = _pos;
+  OutSize = 0;
+
+  for (;;)
+  {
+    EChunkRes res;
+
+    if (_blockLitTable)
+    {
+      res = DecodeHuffmanBlock(pos, _blockLitTable, _blockDistTable, historySize);
+      if (res == k_ChunkRes_OutLimit)
+      {
+        // DecodeHuffmanBlock() stops at symbol boundary, so we can continue from (pos)
+        _pos = pos;
+        return res;
+      }
+      _blockLitTable = NULL;
+    }
+    else
+    {
+      if (pos >= _boundaryPos)
+      {
+        EndPos = pos;
+        return k_ChunkRes_Boundary;
+      }
+      if (pos > _bitLim)
+        return k_ChunkRes_NeedInput;
+      const size_t blockPos = pos;
+      const UInt32 v = (UInt32)GET_BITS_VAL(buf, pos);
+      _finalBlock = ((v & 1) != 0);
+      const unsigned blockType = (unsigned)(v >> 1) & 3;
+      pos += kFinalBlockFieldSize + kBlockTypeFieldSize;
+
+      if (blockType == NBlockType::kStored)
+      {
+        const size_t size = _bitLim >> 3;
+        size_t offset = (pos + 7) >> 3;
+        if (offset + 4 > size)
+          return k_ChunkRes_NeedInput;
+        const UInt32 len = GetUi16(buf + offset);
+        if (len != (UInt32)(UInt16)~GetUi16(buf + offset + 2))
+          return k_ChunkRes_Error;
+        offset += 4;
+        if (len > size - offset)
+          return k_ChunkRes_NeedInput;
+        if (OutCapacity - OutSize < len)
+          if (!GrowOut(OutSize + len))
+          {
+            // we will read the header of this block again in Continue()
+            _pos = blockPos;
+            return k_ChunkRes_OutLimit;
+          }
+        UInt16 *dest = Out + OutSize;
+        OutSize += len;
+        for (UInt32 i = 0; i < len; i++)
+          dest[i] = buf[offset + i];
+        pos = (offset + len) << 3;
+      }
+      else if (blockType == NBlockType::kFixedHuffman)
+      {
+        _blockLitTable = _fixedLitTable;
+        _blockDistTable = _fixedDistTable;
+        continue;
+      }
+      else if (blockType == NBlockType::kDynamicHuffman)
+      {
+        res = ReadTables(pos, strict);
+        if (res != k_ChunkRes_Boundary)
+          return res;
+        _blockLitTable = _litTable;
+        _blockDistTable = _distTable;
+        continue;
+      }
+      else
+        return k_ChunkRes_Error;
+      res = k_ChunkRes_Boundary;
+    }
+
+    if (res != k_ChunkRes_Boundary)
+      return res;
+    if (pos > _bitLim)
+      return k_ChunkRes_NeedInput;
+    if (_finalBlock)
+    {
+      EndPos = pos;
+      return k_ChunkRes_Finished;
+    }
+  }
+}
+
+
+EChunkRes CChunkDecoder::Search(const Byte *buf, size_t size, size_t boundaryPos, size_t &startPos)
+{
+  for (size_t pos = 0; pos < boundaryPos; pos++)
+  {
+    const UInt32 v = (UInt32)GET_BITS_VAL(buf, pos);
+    // non-final Dynamic Huffman block, (numLitLenLevels <= 286), (numDistLevels <= 30)
+    if ((v & 7) != (NBlockType::kDynamicHuffman << 1)
+        || ((v >> 3) & 31) > kMainTableSize - kNumLitLenCodesMin
+        || ((v >> 8) & 31) > kDistTableSize32 - kNumDistCodesMin)
+      continue;
+    const EChunkRes res = Decode(buf, size, pos, boundaryPos, kHistorySize32, true);
+    if (res == k_ChunkRes_Error)
+      continue;
+    startPos = pos;
+    return res;
+  }
+  return k_ChunkRes_Error;
+}
+
+
+class CMtJob
+{
+public:
+  Byte *InBuf;        // chunk data, then the data of next chunk
+  size_t ChunkSize;
+  size_t DataSize;
+  UInt64 ChunkPos;    // the offset of chunk in stream
+  bool IsFirst;
+  bool Exit;
+
+  EChunkRes Res;
+  size_t StartPos;
+  CChunkDecoder Decoder;
+
+  NWindows::CPoolThread Thread;
+  NWindows::NSynchronization::CAutoResetEvent StartEvent;
+  NWindows::NSynchronization::CAutoResetEvent FinishedEvent;
+
+  CMtJob(): InBuf(NULL), Exit(false) {}
+  ~CMtJob();
+  HRESULT Create();
+  void Decode();
+  THREAD_FUNC_RET_TYPE ThreadFunc();
+};
+
+static THREAD_FUNC_DECL MtJobThreadFunc(void *p)
+{
+  return ((CMtJob *)p)->ThreadFunc();
+}
+
+CMtJob::~CMtJob()
+{
+  if (Thread.IsCreated())
+  {
+    Exit = true;
+    StartEvent.Set();
+    Thread.Wait_Close();
+  }
+  ::MidFree(InBuf);
+}
+
+HRESULT CMtJob::Create()
+{
+  InBuf = (Byte *)::MidAlloc((size_t)kMtChunkSize * 2 + kInBufPadSize);
+  if (!InBuf || !Decoder.Create())
+    return E_OUTOFMEMORY;
+  WRes             wres = StartEvent.Create();
+  if (wres == 0) { wres = FinishedEvent.Create();
+  if (wres == 0) { wres = Thread.Create(MtJobThreadFunc, this); }}
+  return HRESULT_FROM_WIN32(wres);
+}
+
+void CMtJob::Decode()
+{
+  memset(InBuf + DataSize, 0, kInBufPadSize);
+  if (IsFirst)
+  {
+    StartPos = 0;
+    Res = Decoder.Decode(InBuf, DataSize, 0, ChunkSize << 3, 0, false);
+  }
+  else
+    Res = Decoder.Search(InBuf, DataSize, ChunkSize << 3, StartPos);
+}
+
+THREAD_FUNC_RET_TYPE CMtJob::ThreadFunc()
+{
+  for (;;)
+  {
+    if (StartEvent.Lock() != 0)
+      return 0;
+    if (Exit)
+      return 0;
+    Decode();
+    FinishedEvent.Set();
+  }
+}
+
+
+void CMtDecoder::Free()
+{
+  delete []_jobs;
+  _jobs = NULL;
+  _numJobs = 0;
+}
+
+HRESULT CMtDecoder::Create(UInt32 numJobs)
+{
+  if (_jobs && _numJobs == numJobs)
+    return S_OK;
+  Free();
+  _jobs = new CMtJob[numJobs];
+  _numJobs = numJobs;
+  for (UInt32 i = 0; i < numJobs; i++)
+  {
+    const HRESULT res = _jobs[i].Create();
+    if (res != S_OK)
+    {
+      Free();
+      return res;
+    }
+  }
+  return S_OK;
+}
+
+
+// it converts the symbols to bytes in place
+static bool ResolveMarkers(UInt16 *data, size_t size, const Byte *history, UInt32 historySize)
+{
+  Byte *dest = (Byte *)(void *)data;
+  const UInt32 lim = 0x100 + kHistorySize32 - historySize;
+  for (size_t i = 0; i < size; i++)
+  {
+    UInt32 v = data[i];
+    if (v >= 0x100)
+    {
+      if (v < lim)
+        return false;
+      v = history[v - 0x100];
+    }
+    dest[i] = (Byte)v;
+  }
+  return true;
+}
+
+
+HRESULT CMtDecoder::Decode(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    ICompressProgressInfo *progress)
+{
+  InProcessed = 0;
+  OutProcessed = 0;
+
+  UInt32 numThreads = NumThreads;
+  if (numThreads < 1)
+    numThreads = 1;
+  const UInt32 numJobs = numThreads + 1;
+  RINOK(Create(numJobs))
+
+  CByteBuffer history(kHistorySize32);
+  UInt32 historySize = 0;
+
+  UInt64 numRead = 0;
+  UInt64 numStarted = 0;
+  UInt64 numWritten = 0;
+  bool inEof = false;
+  size_t startPos = 0; // the start position of block in chunk (numWritten)
+  HRESULT res = S_FALSE;
+
+  for (;;)
+  {
+    if (!inEof && numRead - numWritten < numJobs)
+    {
+      CMtJob &job = _jobs[(unsigned)(numRead % numJobs)];
+      size_t size = kMtChunkSize;
+      res = ReadStream(inStream, job.InBuf, &size);
+      if (res != S_OK)
+        break;
+      res = S_FALSE;
+      if (size != kMtChunkSize)
+        inEof = true;
+      if (numRead != 0)
+      {
+        // the job for previous chunk is ready, if the data of current chunk is available
+        CMtJob &prev = _jobs[(unsigned)((numRead - 1) % numJobs)];
+        memcpy(prev.InBuf + prev.ChunkSize, job.InBuf, size);
+        prev.DataSize += size;
+        numStarted++;
+        prev.StartEvent.Set();
+      }
+      if (size == 0)
+      {
+        if (numRead == 0)
+          break;
+        continue;
+      }
+      job.ChunkSize = size;
+      job.DataSize = size;
+      job.ChunkPos = numRead * kMtChunkSize;
+      job.IsFirst = (numRead == 0);
+      numRead++;
+      if (inEof)
+      {
+        numStarted++;
+        job.StartEvent.Set();
+      }
+      continue;
+    }
+
+    if (numWritten == numStarted)
+      break;
+
+    CMtJob &job = _jobs[(unsigned)(numWritten % numJobs)];
+    numWritten++;
+    if (job.FinishedEvent.Lock() != 0)
+    {
+      res = E_FAIL;
+      break;
+    }
+
+    CChunkDecoder &dec = job.Decoder;
+    if ((job.Res != k_ChunkRes_Boundary
+          && job.Res != k_ChunkRes_Finished
+          && job.Res != k_ChunkRes_OutLimit)
+        || job.StartPos != startPos)
+    {
+      // speculative decoding failed, so we decode the chunk from correct position
+      job.Res = dec.Decode(job.InBuf, job.DataSize, startPos, job.ChunkSize << 3, historySize, false);
+    }
+
+    bool chunkWritten = false;
+    for (;;)
+    {
+      if (job.Res != k_ChunkRes_Boundary
+          && job.Res != k_ChunkRes_Finished
+          && job.Res != k_ChunkRes_OutLimit)
+        break;
+      if (!ResolveMarkers(dec.Out, dec.OutSize, history, historySize))
+        break;
+      const Byte *data = (const Byte *)(const void *)dec.Out;
+      const size_t size = dec.OutSize;
+      res = WriteStream(outStream, data, size);
+      if (res != S_OK)
+        break;
+      res = S_FALSE;
+      OutProcessed += size;
+
+      if (size >= kHistorySize32)
+        memcpy(history, data + size - kHistorySize32, kHistorySize32);
+      else
+      {
+        memmove(history, history + size, kHistorySize32 - size);
+        memcpy(history + kHistorySize32 - size, data, size);
+      }
+      historySize += (UInt32)size;
+      if (size >= kHistorySize32 || historySize > kHistorySize32)
+        historySize = kHistorySize32;
+
+      if (job.Res != k_ChunkRes_OutLimit)
+      {
+        chunkWritten = true;
+        break;
+      }
+      /* the chunk is expanded to big data (more than kOutSizeMax symbols).
+         We have written the decoded part, and we continue decoding of that chunk
+         with new history instead of falling back to single-threaded decoder. */
+      job.Res = dec.Continue(historySize, false);
+    }
+    if (!chunkWritten)
+      break;
+
+    if (job.Res == k_ChunkRes_Finished)
+    {
+      InProcessed = job.ChunkPos + ((dec.EndPos + 7) >> 3);
+      res = S_OK;
+      break;
+    }
+
+    if (numWritten == numRead && inEof)
+      break; // unexpected end of stream
+    startPos = dec.EndPos - (job.ChunkSize << 3);
+
+    if (progress)
+    {
+      const UInt64 inSize = job.ChunkPos + job.ChunkSize;
+      res = progress->SetRatioInfo(&inSize, &OutProcessed);
+      if (res != S_OK)
+        break;
+      res = S_FALSE;
+    }
+  }
+
+  // we wait all started jobs
+  for (; numWritten < numStarted; numWritten++)
+    _jobs[(unsigned)(numWritten % numJobs)].FinishedEvent.Lock();
+
+  return res;
+}
+
+}}}
+
+#endif
@@ -0,0 +1,73 @@
+// DeflateDecoderMt.h
+
+#ifndef ZIP7_INC_DEFLATE_DECODER_MT_H
+#define ZIP7_INC_DEFLATE_DECODER_MT_H
+
+#ifndef Z7_ST
+
+#include "../../Common/MyCom.h"
+
+#include "../../Windows/Synchronization.h"
+#include "../../Windows/Thread.h"
+
+#include "../ICoder.h"
+
+namespace NCompress {
+namespace NDeflate {
+namespace NDecoder {
+
+/*
+  Multithreaded decoder for Deflate stream (rapidgzip-like).
+  The compressed stream is split to chunks of fixed size.
+  Each thread searches the start of Dynamic Huffman block in its chunk,
+  and it decodes the data speculatively from that position. The bytes that
+  refer to unknown history (the data before speculative start position)
+  are stored as markers. The main thread checks that the start position
+  of each chunk is equal to the end position of previous chunk, resolves
+  the markers with the history of previous chunk, and writes the data in order.
+  If the start position of chunk is wrong, the main thread decodes that chunk again
+  from the correct position.
+*/
+
+const UInt32 kMtChunkSize = (UInt32)1 << 21;
+// estimated memory usage per thread for typical compression ratio
+const UInt32 kMtMemUsagePerThread = kMtChunkSize * 12;
+
+class CMtJob;
+
+class CMtDecoder
+{
+  CMtJob *_jobs;
+  UInt32 _numJobs;
+
+  void Free();
+  HRESULT Create(UInt32 numJobs);
+public:
+  UInt32 NumThreads;
+
+  UInt64 InProcessed;  // the size of deflate stream, if (Decode() == S_OK)
+  UInt64 OutProcessed; // the size of data that was written to (outStream)
+
+  CMtDecoder(): _jobs(NULL), _numJobs(0), NumThreads(1) {}
+  ~CMtDecoder() { Free(); }
+
+  /*
+  Decode() decodes one Deflate stream that starts at current position of (inStream).
+  It can read data after the end of Deflate stream.
+  returns:
+    S_OK    : the stream was decoded. (InProcessed) contains the size of Deflate stream.
+    S_FALSE : the stream can't be decoded in multithreaded mode (data error or some unsupported case).
+              (OutProcessed) bytes of correct data were written to (outStream).
+              The caller can decode the stream with single-threaded decoder again
+              to get the remaining data and exact error status.
+    another code : read / write / progress error.
+  */
+  HRESULT Decode(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+      ICompressProgressInfo *progress);
+};
+
+}}}
+
+#endif
+
+#endif
@@ -4,10 +4,17 @@
 
 #include "../../../C/Alloc.h"
 #include "../../../C/HuffEnc.h"
+#ifndef Z7_ST
+#include "../../../C/7zCrc.h"
+#endif
 
 #include "../../Common/ComTry.h"
 
 #include "../Common/CWrappers.h"
+#ifndef Z7_ST
+#include "../Common/StreamObjects.h"
+#include "../Common/StreamUtils.h"
+#endif
 
 #include "DeflateEncoder.h"
 
@@ -103,10 +110,12 @@ void CEncProps::Normalize()
   if (btMode < 0) btMode = (algo == 0 ? 0 : 1);
   if (mc == 0) mc = (16 + ((unsigned)fb >> 1));
   if (numPasses == (UInt32)(Int32)-1) numPasses = (level < 7 ? 1 : (level < 9 ? 3 : 10));
+  if (blockSize == 0) blockSize = kMtBlockSizeDefault;
 }
 
 void CCoder::SetProps(const CEncProps *props2)
 {
+  _props = *props2;
   CEncProps props = *props2;
   props.Normalize();
 
@@ -143,6 +152,14 @@ CCoder::CCoder(bool deflate64Mode):
   m_Created(false),
   m_Deflate64Mode(deflate64Mode),
   m_Tables(NULL)
+ #ifndef Z7_ST
+  , m_NumThreads(1)
+  , m_NumThreadsPrev(0)
+  , m_BlockSizePrev(0)
+  , m_MtThreads(NULL)
+  , MtCrc(0)
+  , MtInSize(0)
+ #endif
 {
   m_MatchMaxLen = deflate64Mode ? kMatchMaxLen64 : kMatchMaxLen32;
   m_NumLenCombinations = deflate64Mode ? kNumLenSymbols64 : kNumLenSymbols32;
@@ -214,6 +231,9 @@ HRESULT CCoder::Create()
 HRESULT CCoder::BaseSetEncoderProperties2(const PROPID *propIDs, const PROPVARIANT *coderProps, UInt32 numProps)
 {
   CEncProps props;
+ #ifndef Z7_ST
+  m_NumThreads = 1;
+ #endif
   for (UInt32 i = 0; i < numProps; i++)
   {
     const PROPVARIANT &prop = coderProps[i];
@@ -230,7 +250,16 @@ HRESULT CCoder::BaseSetEncoderProperties2(const PROPID *propIDs, const PROPVARIA
       case NCoderPropID::kMatchFinderCycles: props.mc = v; break;
       case NCoderPropID::kAlgorithm: props.algo = (int)v; break;
       case NCoderPropID::kLevel: props.Level = (int)v; break;
-      case NCoderPropID::kNumThreads: break;
+      case NCoderPropID::kBlockSize: props.blockSize = v; break;
+      case NCoderPropID::kNumThreads:
+      {
+       #ifndef Z7_ST
+        if (v < 1) v = 1;
+        if (v > kNumThreadsMax) v = kNumThreadsMax;
+        m_NumThreads = v;
+       #endif
+        break;
+      }
       default: return E_INVALIDARG;
     }
   }
@@ -248,6 +277,9 @@ void CCoder::Free()
 
 CCoder::~CCoder()
 {
+ #ifndef Z7_ST
+  FreeMt();
+ #endif
   Free();
   MatchFinder_Free(&_lzInWindow, &g_AlignedAlloc);
 }
@@ -940,30 +972,12 @@ void CCoder::CodeBlock(unsigned tableIndex, bool finalBlock)
 }
 
 
-HRESULT CCoder::CodeReal(ISequentialInStream *inStream, ISequentialOutStream *outStream,
-    const UInt64 * /* inSize */ , const UInt64 * /* outSize */ , ICompressProgressInfo *progress)
+HRESULT CCoder::CodeBlocks(bool finalStream, ICompressProgressInfo *progress)
 {
-  m_CheckStatic = (m_NumPasses != 1 || m_NumDivPasses != 1);
-  m_IsMultiPass = (m_CheckStatic || (m_NumPasses != 1 || m_NumDivPasses != 1));
-
-  /* we can set stream mode before MatchFinder_Create
-    if default MatchFinder mode was not STREAM_MODE) */
-  // MatchFinder_SET_STREAM_MODE(&_lzInWindow);
-
-  CSeqInStreamWrap _seqInStream;
-  _seqInStream.Init(inStream);
-  MatchFinder_SET_STREAM(&_lzInWindow, &_seqInStream.vt)
-
-  RINOK(Create())
-
   m_ValueBlockSize = (7 << 10) + (1 << 12) * m_NumDivPasses;
 
   UInt64 nowPos = 0;
 
-  MatchFinder_Init(&_lzInWindow);
-  m_OutStream.SetStream(outStream);
-  m_OutStream.Init();
-
   m_OptimumEndIndex = m_OptimumCurrentIndex = 0;
 
   CTables &t = m_Tables[1];
@@ -976,7 +990,7 @@ HRESULT CCoder::CodeReal(ISequentialInStream *inStream, ISequentialOutStream *ou
     t.BlockSizeRes = kBlockUncompressedSizeThreshold;
     m_SecondPass = false;
     GetBlockPrice(1, m_NumDivPasses);
-    CodeBlock(1, Inline_MatchFinder_GetNumAvailableBytes(&_lzInWindow) == 0);
+    CodeBlock(1, finalStream && Inline_MatchFinder_GetNumAvailableBytes(&_lzInWindow) == 0);
     nowPos += m_Tables[1].BlockSizeRes;
     if (progress != NULL)
     {
@@ -985,6 +999,36 @@ HRESULT CCoder::CodeReal(ISequentialInStream *inStream, ISequentialOutStream *ou
     }
   }
   while (Inline_MatchFinder_GetNumAvailableBytes(&_lzInWindow) != 0);
+  return S_OK;
+}
+
+
+HRESULT CCoder::CodeReal(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    const UInt64 * /* inSize */ , const UInt64 * /* outSize */ , ICompressProgressInfo *progress)
+{
+ #ifndef Z7_ST
+  if (m_NumThreads > 1)
+    return CodeMt(inStream, outStream, progress);
+ #endif
+
+  m_CheckStatic = (m_NumPasses != 1 || m_NumDivPasses != 1);
+  m_IsMultiPass = (m_CheckStatic || (m_NumPasses != 1 || m_NumDivPasses != 1));
+
+  /* we can set stream mode before MatchFinder_Create
+    if default MatchFinder mode was not STREAM_MODE) */
+  // MatchFinder_SET_STREAM_MODE(&_lzInWindow);
+
+  CSeqInStreamWrap _seqInStream;
+  _seqInStream.Init(inStream);
+  MatchFinder_SET_STREAM(&_lzInWindow, &_seqInStream.vt)
+
+  RINOK(Create())
+
+  MatchFinder_Init(&_lzInWindow);
+  m_OutStream.SetStream(outStream);
+  m_OutStream.Init();
+
+  RINOK(CodeBlocks(true, progress))
   
   if (_seqInStream.Res != S_OK)
     return _seqInStream.Res;
@@ -994,6 +1038,302 @@ HRESULT CCoder::CodeReal(ISequentialInStream *inStream, ISequentialOutStream *ou
   return m_OutStream.Flush();
 }
 
+
+#ifndef Z7_ST
+
+/*
+  Multithreaded mode (like pigz):
+  the input stream is split to blocks of (_props.blockSize) bytes.
+  Each block is encoded in separate thread, and the tail (up to history size)
+  of previous block is used as preset dictionary.
+  Each non-final block is finished with empty stored block (sync flush),
+  so the output blocks are byte-aligned and can be concatenated.
+*/
+
+HRESULT CCoder::CodeChunk(const Byte *data, size_t dictSize, size_t size, bool finalBlock,
+    ISequentialOutStream *outStream)
+{
+  m_CheckStatic = (m_NumPasses != 1 || m_NumDivPasses != 1);
+  m_IsMultiPass = (m_CheckStatic || (m_NumPasses != 1 || m_NumDivPasses != 1));
+
+  MatchFinder_SET_DIRECT_INPUT_BUF(&_lzInWindow, data, dictSize + size)
+
+  RINOK(Create())
+
+  MatchFinder_Init(&_lzInWindow);
+  if (dictSize != 0)
+  {
+    if (_btMode)
+      Bt3Zip_MatchFinder_Skip(&_lzInWindow, (UInt32)dictSize);
+    else
+      Hc3Zip_MatchFinder_Skip(&_lzInWindow, (UInt32)dictSize);
+  }
+  m_OutStream.SetStream(outStream);
+  m_OutStream.Init();
+
+  RINOK(CodeBlocks(finalBlock, NULL))
+
+  if (!finalBlock)
+    WriteStoreBlock(0, 0, false);
+  return m_OutStream.Flush();
+}
+
+
+/* Crc32_Combine() returns CRC32 of (data1 + data2) from CRC32 of data1,
+   CRC32 of data2 and the size of data2.
+   CRC32 of data1 is multiplied by x^(size2 * 8) modulo CRC polynomial.
+   The polynomials are stored in reflected bit order: (1 << 31) is x^0. */
+
+#define CRC32_POLY_REFLECTED 0xEDB88320
+
+static UInt32 Crc32_MulModP(UInt32 a, UInt32 b)
+{
+  UInt32 m = (UInt32)1 << 31;
+  UInt32 p = 0;
+  for (;;)
+  {
+    if (a & m)
+    {
+      p ^= b;
+      if ((a & (m - 1)) == 0)
+        break;
+    }
+    m >>= 1;
+    b = (b >> 1) ^ (((UInt32)0 - (b & 1)) & CRC32_POLY_REFLECTED);
+  }
+  return p;
+}
+
+static UInt32 Crc32_Combine(UInt32 crc1, UInt32 crc2, UInt64 size2)
+{
+  // (x2n) is x^(2^k) for k = 0, 1, 2, ...; the size is in bytes, so we start from x^8.
+  UInt32 x2n = (UInt32)1 << 30;
+  UInt32 xn = (UInt32)1 << 31;
+  for (unsigned k = 0; k < 3; k++)
+    x2n = Crc32_MulModP(x2n, x2n);
+  for (; size2 != 0; size2 >>= 1)
+  {
+    if (size2 & 1)
+      xn = Crc32_MulModP(x2n, xn);
+    x2n = Crc32_MulModP(x2n, x2n);
+  }
+  return Crc32_MulModP(xn, crc1) ^ crc2;
+}
+
+
+class CMtThread
+{
+public:
+  CCoder *Coder;
+  Byte *Buf; // (dictionary + block) buffer
+  size_t DictSize;
+  size_t Size;
+  bool FinalBlock;
+  bool Exit;
+  HRESULT Res;
+  UInt32 Crc; // CRC32 of block data
+  CDynBufSeqOutStream *OutStreamSpec;
+  CMyComPtr<ISequentialOutStream> OutStream;
+
+  NWindows::CPoolThread Thread;
+  NWindows::NSynchronization::CAutoResetEvent StartEvent;
+  NWindows::NSynchronization::CAutoResetEvent FinishedEvent;
+
+  CMtThread(): Coder(NULL), Buf(NULL), Exit(false) {}
+  ~CMtThread();
+  HRESULT Create(const CCoder &owner, size_t bufSize);
+  void Encode();
+  THREAD_FUNC_RET_TYPE ThreadFunc();
+};
+
+static THREAD_FUNC_DECL MtThreadFunc(void *p)
+{
+  return ((CMtThread *)p)->ThreadFunc();
+}
+
+CMtThread::~CMtThread()
+{
+  if (Thread.IsCreated())
+  {
+    Exit = true;
+    StartEvent.Set();
+    Thread.Wait_Close();
+  }
+  delete Coder;
+  ::MidFree(Buf);
+}
+
+HRESULT CMtThread::Create(const CCoder &owner, size_t bufSize)
+{
+  Coder = new CCoder(owner.m_Deflate64Mode);
+  Coder->SetProps(&owner._props);
+  Buf = (Byte *)::MidAlloc(bufSize);
+  if (!Buf)
+    return E_OUTOFMEMORY;
+  OutStreamSpec = new CDynBufSeqOutStream;
+  OutStream = OutStreamSpec;
+  WRes             wres = StartEvent.Create();
+  if (wres == 0) { wres = FinishedEvent.Create();
+  if (wres == 0) { wres = Thread.Create(MtThreadFunc, this); }}
+  return HRESULT_FROM_WIN32(wres);
+}
+
+void CMtThread::Encode()
+{
+  OutStreamSpec->Init();
+  const Byte *data = Buf + (Coder->m_Deflate64Mode ? kHistorySize64 : kHistorySize32);
+  Crc = CrcCalc(data, Size);
+  try
+  {
+    Res = Coder->CodeChunk(data - DictSize, DictSize, Size, FinalBlock, OutStream);
+  }
+  catch(const COutBufferException &e) { Res = e.ErrorCode; }
+  catch(...) { Res = E_FAIL; }
+}
+
+THREAD_FUNC_RET_TYPE CMtThread::ThreadFunc()
+{
+  for (;;)
+  {
+    if (StartEvent.Lock() != 0)
+      return 0;
+    if (Exit)
+      return 0;
+    Encode();
+    FinishedEvent.Set();
+  }
+}
+
+
+void CCoder::FreeMt()
+{
+  delete []m_MtThreads;
+  m_MtThreads = NULL;
+  m_NumThreadsPrev = 0;
+}
+
+HRESULT CCoder::CreateMt(UInt32 blockSize)
+{
+  if (m_MtThreads && m_NumThreadsPrev == m_NumThreads && m_BlockSizePrev == blockSize)
+    return S_OK;
+  FreeMt();
+  m_MtThreads = new CMtThread[m_NumThreads];
+  m_NumThreadsPrev = m_NumThreads;
+  m_BlockSizePrev = blockSize;
+  const size_t dictMax = m_Deflate64Mode ? kHistorySize64 : kHistorySize32;
+  for (UInt32 i = 0; i < m_NumThreads; i++)
+  {
+    const HRESULT res = m_MtThreads[i].Create(*this, dictMax + blockSize);
+    if (res != S_OK)
+    {
+      FreeMt();
+      return res;
+    }
+  }
+  return S_OK;
+}
+
+
+HRESULT CCoder::CodeMt(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    ICompressProgressInfo *progress)
+{
+  CEncProps props = _props;
+  props.Normalize();
+  UInt32 blockSize = props.blockSize;
+  const UInt32 kBlockSizeMin = (UInt32)1 << 16;
+  const UInt32 kBlockSizeMax = (UInt32)1 << 30;
+  if (blockSize < kBlockSizeMin) blockSize = kBlockSizeMin;
+  if (blockSize > kBlockSizeMax) blockSize = kBlockSizeMax;
+
+  RINOK(CreateMt(blockSize))
+
+  const size_t dictMax = m_Deflate64Mode ? kHistorySize64 : kHistorySize32;
+  const UInt32 numThreads = m_NumThreadsPrev;
+  UInt64 numStarted = 0;
+  UInt64 numWritten = 0;
+  UInt64 inSize = 0;
+  UInt64 outSize = 0;
+  bool finished = false;
+  bool needFinalBlock = false;
+  HRESULT res = S_OK;
+  MtCrc = 0;
+  MtInSize = 0;
+
+  for (;;)
+  {
+    if (numStarted != numWritten
+        && (finished || numStarted - numWritten == numThreads))
+    {
+      // we write the oldest encoded block
+      CMtThread &t = m_MtThreads[(unsigned)(numWritten % numThreads)];
+      numWritten++;
+      if (t.FinishedEvent.Lock() != 0 && res == S_OK)
+        res = E_FAIL;
+      if (res == S_OK)
+        res = t.Res;
+      if (res == S_OK)
+        res = WriteStream(outStream, t.OutStreamSpec->GetBuffer(), t.OutStreamSpec->GetSize());
+      if (res == S_OK)
+      {
+        MtCrc = Crc32_Combine(MtCrc, t.Crc, t.Size);
+        inSize += t.Size;
+        outSize += t.OutStreamSpec->GetSize();
+        if (progress)
+          res = progress->SetRatioInfo(&inSize, &outSize);
+      }
+      if (res != S_OK)
+        finished = true;
+      continue;
+    }
+    if (finished)
+      break;
+
+    CMtThread &t = m_MtThreads[(unsigned)(numStarted % numThreads)];
+    size_t dictSize = 0;
+    if (numStarted != 0)
+    {
+      // we copy the tail of previous block as dictionary
+      const CMtThread &prev = m_MtThreads[(unsigned)((numStarted - 1) % numThreads)];
+      dictSize = prev.DictSize + prev.Size;
+      if (dictSize > dictMax)
+        dictSize = dictMax;
+      memcpy(t.Buf + dictMax - dictSize, prev.Buf + dictMax + prev.Size - dictSize, dictSize);
+    }
+    size_t size = blockSize;
+    res = ReadStream(inStream, t.Buf + dictMax, &size);
+    if (res != S_OK)
+    {
+      finished = true;
+      continue;
+    }
+    if (size == 0 && numStarted != 0)
+    {
+      // the previous block was not final, so we need final empty block
+      needFinalBlock = true;
+      finished = true;
+      continue;
+    }
+    t.DictSize = dictSize;
+    t.Size = size;
+    t.FinalBlock = (size != blockSize);
+    finished = t.FinalBlock;
+    numStarted++;
+    t.StartEvent.Set();
+  }
+
+  if (res == S_OK && needFinalBlock)
+  {
+    // final fixed Huffman block that contains only End-Of-Block symbol
+    const Byte kFinalBlock[2] = { 3, 0 };
+    res = WriteStream(outStream, kFinalBlock, 2);
+  }
+  MtInSize = inSize;
+  return res;
+}
+
+#endif
+
+
 HRESULT CCoder::BaseCode(ISequentialInStream *inStream, ISequentialOutStream *outStream,
     const UInt64 *inSize, const UInt64 *outSize, ICompressProgressInfo *progress)
 {
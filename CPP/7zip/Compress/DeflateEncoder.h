@@ -7,6 +7,11 @@
 
 #include "../../Common/MyCom.h"
 
+#ifndef Z7_ST
+#include "../../Windows/Synchronization.h"
+#include "../../Windows/Thread.h"
+#endif
+
 #include "../ICoder.h"
 
 #include "BitlEncoder.h"
@@ -47,6 +52,9 @@ struct CTables: public CLevels
 };
 
 
+// the default size of input block in multithreaded mode
+const UInt32 kMtBlockSizeDefault = (UInt32)1 << 20;
+
 struct CEncProps
 {
   int Level;
@@ -55,6 +63,7 @@ struct CEncProps
   int btMode;
   UInt32 mc;
   UInt32 numPasses;
+  UInt32 blockSize; // the size of input block in multithreaded mode
 
   CEncProps()
   {
@@ -62,10 +71,18 @@ struct CEncProps
     mc = 0;
     algo = fb = btMode = -1;
     numPasses = (UInt32)(Int32)-1;
+    blockSize = 0;
   }
   void Normalize();
 };
 
+#ifndef Z7_ST
+class CMtThread;
+const UInt32 kNumThreadsMax = 64;
+// estimated memory usage per thread in multithreaded mode for default block size
+const UInt32 kMtMemUsagePerThread = (UInt32)6 << 20;
+#endif
+
 class CCoder
 {
   CMatchFinder _lzInWindow;
@@ -129,6 +146,28 @@ public:
 
   UInt32 m_MatchFinderCycles;
 
+  CEncProps _props;
+
+ #ifndef Z7_ST
+  UInt32 m_NumThreads;
+  UInt32 m_NumThreadsPrev;
+  UInt32 m_BlockSizePrev;
+  CMtThread *m_MtThreads;
+
+  HRESULT CreateMt(UInt32 blockSize);
+  void FreeMt();
+  HRESULT CodeMt(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+      ICompressProgressInfo *progress);
+  HRESULT CodeChunk(const Byte *data, size_t dictSize, size_t size, bool finalBlock,
+      ISequentialOutStream *outStream);
+
+  /* multithreaded mode calculates CRC32 and size of input data.
+     Each thread calculates CRC32 of its block, and CodeMt() combines them. */
+  UInt32 MtCrc;
+  UInt64 MtInSize;
+  bool IsMtMode() const { return m_NumThreads > 1; }
+ #endif
+
   void GetMatches();
   void MovePos(UInt32 num);
   UInt32 Backward(UInt32 &backRes, UInt32 cur);
@@ -160,6 +199,7 @@ public:
 
   UInt32 GetBlockPrice(unsigned tableIndex, unsigned numDivPasses);
   void CodeBlock(unsigned tableIndex, bool finalBlock);
+  HRESULT CodeBlocks(bool finalStream, ICompressProgressInfo *progress);
 
   void SetProps(const CEncProps *props2);
 public:
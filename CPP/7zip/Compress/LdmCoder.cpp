@@ -0,0 +1,586 @@
+// LdmCoder.cpp
+
+#include "StdAfx.h"
+
+#include <string.h>
+
+#include "../../../C/CpuArch.h"
+
+#include "../Common/StreamUtils.h"
+
+#include "LdmCoder.h"
+
+namespace NCompress {
+namespace NLdm {
+
+static const size_t kInBufSize = (size_t)1 << 20;
+static const size_t kOutBufSize = (size_t)1 << 20;
+static const size_t kFlushSize = (size_t)1 << 22;
+
+#ifndef Z7_EXTRACT_ONLY
+
+/*
+The encoder calculates gear rolling hash, that depends on last 64 bytes only.
+The position is sampled, if high (kHashRateLog) bits of hash are zeros.
+So the hash table contains one position per (1 << kHashRateLog) bytes
+of window in average, and each repeat that is much longer than
+(1 << kHashRateLog) bytes is found with high probability.
+The match is extended forward and backward, and the repeats
+shorter than (kMatchLen_Min) are left to next LZ coder.
+*/
+
+static const unsigned kAnchorSize = 64;
+static const unsigned kHashRateLog = 8;
+static const unsigned kBucketLog = 2;
+static const unsigned kBucketSize = 1 << kBucketLog;
+static const UInt32 kMatchLen_Min = 256;
+static const size_t kBlockSize_Max = (size_t)1 << 22;
+
+#define SAMPLE_MASK  ((((UInt64)1 << kHashRateLog) - 1) << (64 - kHashRateLog))
+#define HASH_MUL  UINT64_CONST(0x9E3779B97F4A7C15)
+
+static UInt64 g_Gear[256];
+
+static struct CGearTableInit { CGearTableInit()
+{
+  UInt64 x = 0;
+  for (unsigned i = 0; i < 256; i++)
+  {
+    x += HASH_MUL;
+    UInt64 z = x;
+    z = (z ^ (z >> 30)) * UINT64_CONST(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_CONST(0x94D049BB133111EB);
+    g_Gear[i] = z ^ (z >> 31);
+  }
+}} g_GearTableInit;
+
+
+CEncoder::CEncoder():
+    _windowLog(kWindowLog_Default)
+  {}
+
+Z7_COM7F_IMF(CEncoder::SetCoderProperties(const PROPID *propIDs, const PROPVARIANT *coderProps, UInt32 numProps))
+{
+  UInt64 winSize = (UInt64)1 << kWindowLog_Default;
+  UInt64 reduceSize = (UInt64)(Int64)-1;
+  for (UInt32 i = 0; i < numProps; i++)
+  {
+    const PROPVARIANT &prop = coderProps[i];
+    const PROPID propID = propIDs[i];
+    if (propID >= NCoderPropID::kReduceSize)
+    {
+      if (propID == NCoderPropID::kReduceSize && prop.vt == VT_UI8)
+        reduceSize = prop.uhVal.QuadPart;
+      continue;
+    }
+    switch (propID)
+    {
+      case NCoderPropID::kDictionarySize:
+        if (prop.vt == VT_UI4)
+          winSize = prop.ulVal;
+        else if (prop.vt == VT_UI8)
+          winSize = prop.uhVal.QuadPart;
+        else
+          return E_INVALIDARG;
+        if (winSize > ((UInt64)1 << kWindowLog_Max))
+          return E_INVALIDARG;
+        break;
+      case NCoderPropID::kNumThreads: break;
+      case NCoderPropID::kLevel: break;
+      default: return E_INVALIDARG;
+    }
+  }
+  unsigned wlog = kWindowLog_Min;
+  while (wlog < kWindowLog_Max && ((UInt64)1 << wlog) < winSize)
+    wlog++;
+  while (wlog > kWindowLog_Min && ((UInt64)1 << (wlog - 1)) >= reduceSize)
+    wlog--;
+  _windowLog = wlog;
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CEncoder::WriteCoderProperties(ISequentialOutStream *outStream))
+{
+  const Byte prop = (Byte)_windowLog;
+  return WriteStream(outStream, &prop, 1);
+}
+
+
+HRESULT CEncoder::ReadBlock()
+{
+  // (_readPos) is aligned for (_blockSize) before end of stream. So the block is contiguous in window.
+  size_t size = _blockSize;
+  const HRESULT res = ReadStream(_inStream, _win + ((size_t)_readPos & (((size_t)1 << _windowLog) - 1)), &size);
+  _readPos += size;
+  if (size != _blockSize)
+    _inEof = true;
+  return res;
+}
+
+HRESULT CEncoder::FlushOut()
+{
+  const size_t size = _outPos;
+  if (size == 0)
+    return S_OK;
+  _outPos = 0;
+  _outProcessed += size;
+  return WriteStream(_outStream, _outBuf, size);
+}
+
+HRESULT CEncoder::WriteNumber(UInt64 v)
+{
+  if (_outPos > kOutBufSize - 10)
+  {
+    RINOK(FlushOut())
+  }
+  Byte *p = (Byte *)_outBuf + _outPos;
+  for (; v >= 0x80; v >>= 7)
+    *p++ = (Byte)(v | 0x80);
+  *p++ = (Byte)v;
+  _outPos = (size_t)(p - (Byte *)_outBuf);
+  return S_OK;
+}
+
+HRESULT CEncoder::WriteLiterals(UInt64 pos, UInt64 size)
+{
+  const size_t winSize = (size_t)1 << _windowLog;
+  while (size != 0)
+  {
+    const size_t offs = (size_t)pos & (winSize - 1);
+    size_t cur = winSize - offs;
+    if (cur > size)
+      cur = (size_t)size;
+    const Byte *data = (const Byte *)_win + offs;
+    if (cur > kOutBufSize - _outPos)
+    {
+      RINOK(FlushOut())
+      if (cur >= kOutBufSize)
+      {
+        RINOK(WriteStream(_outStream, data, cur))
+        _outProcessed += cur;
+        pos += cur;
+        size -= cur;
+        continue;
+      }
+    }
+    memcpy((Byte *)_outBuf + _outPos, data, cur);
+    _outPos += cur;
+    pos += cur;
+    size -= cur;
+  }
+  return S_OK;
+}
+
+
+// it returns the number of equal bytes at (src) and (cur) positions in circular window
+
+static UInt64 GetMatchLen(const Byte *win, size_t mask, UInt64 src, UInt64 cur, UInt64 maxLen)
+{
+  UInt64 len = 0;
+  while (len != maxLen)
+  {
+    const size_t s = (size_t)(src + len) & mask;
+    const size_t c = (size_t)(cur + len) & mask;
+    size_t rem = mask + 1 - (s > c ? s : c);
+    if (rem > maxLen - len)
+      rem = (size_t)(maxLen - len);
+    const Byte *p1 = win + s;
+    const Byte *p2 = win + c;
+    size_t i = 0;
+    for (; rem - i >= 8; i += 8)
+      if (GetUi64(p1 + i) != GetUi64(p2 + i))
+        break;
+    for (; i < rem; i++)
+      if (p1[i] != p2[i])
+        return len + i;
+    len += rem;
+  }
+  return len;
+}
+
+
+HRESULT CEncoder::CodeReal(ICompressProgressInfo *progress)
+{
+  const unsigned wlog = _windowLog;
+  const size_t winSize = (size_t)1 << wlog;
+  const size_t mask = winSize - 1;
+  size_t blockSize = winSize >> 3;
+  if (blockSize > kBlockSize_Max)
+    blockSize = kBlockSize_Max;
+  _blockSize = blockSize;
+  // the match source must stay in window, while we read next block to continue the match
+  const UInt64 maxDist = winSize - blockSize;
+  const unsigned tableLog = wlog - kHashRateLog - kBucketLog;
+  const size_t tableSize = (size_t)1 << (tableLog + kBucketLog);
+
+  _win.AllocAtLeast(winSize);
+  _table.AllocAtLeast(tableSize * sizeof(CEntry));
+  _outBuf.AllocAtLeast(kOutBufSize);
+  if (!_win.IsAllocated() || !_table.IsAllocated() || !_outBuf.IsAllocated())
+    return E_OUTOFMEMORY;
+
+  CEntry *table = (CEntry *)(void *)(Byte *)_table;
+  memset(table, 0, tableSize * sizeof(CEntry));
+  const Byte *win = _win;
+
+  _outPos = 0;
+  _outProcessed = 0;
+  _readPos = 0;
+  _inEof = false;
+
+  UInt64 pos = 0;
+  UInt64 litStart = 0;
+  UInt64 hash = 0;
+  unsigned numHashed = 0;
+
+  for (;;)
+  {
+    if (!_inEof && _readPos - pos < blockSize)
+    {
+      if (_readPos + blockSize - litStart > winSize)
+      {
+        // new block will overwrite the literals. So we write them before.
+        RINOK(WriteNumber(pos - litStart))
+        RINOK(WriteLiterals(litStart, pos - litStart))
+        RINOK(WriteNumber(0))
+        litStart = pos;
+      }
+      RINOK(ReadBlock())
+      if (progress)
+      {
+        const UInt64 outSize = _outProcessed + _outPos;
+        RINOK(progress->SetRatioInfo(&_readPos, &outSize))
+      }
+      continue;
+    }
+
+    if (pos == _readPos)
+      break;
+
+    const Byte *start = win + ((size_t)pos & mask);
+    size_t rem = winSize - ((size_t)pos & mask);
+    if (rem > _readPos - pos)
+      rem = (size_t)(_readPos - pos);
+    const Byte *p = start;
+    const Byte *lim = start + rem;
+
+    if (numHashed < kAnchorSize)
+    {
+      size_t n = kAnchorSize - numHashed;
+      if (n > rem)
+        n = rem;
+      numHashed += (unsigned)n;
+      do
+        hash = (hash << 1) + g_Gear[*p++];
+      while (--n);
+    }
+
+    for (;;)
+    {
+      if (p == lim)
+        break;
+      hash = (hash << 1) + g_Gear[*p++];
+      if ((hash & SAMPLE_MASK) != 0)
+        continue;
+
+      const UInt64 cur = pos + (size_t)(p - start);
+      const UInt64 histStart = (_readPos > winSize ? _readPos - winSize : 0);
+      CEntry *bucket = table + ((size_t)((hash * HASH_MUL) >> (64 - tableLog)) << kBucketLog);
+      const UInt32 check = (UInt32)(hash >> 24);
+
+      UInt64 bestLen = 0;
+      UInt64 bestBack = 0;
+      UInt64 bestDist = 0;
+
+      for (unsigned k = 0; k < kBucketSize; k++)
+      {
+        const CEntry &e = bucket[k];
+        if (e.Check != check || e.Pos <= histStart || e.Pos >= cur)
+          continue;
+        const UInt64 dist = cur - e.Pos;
+        if (dist > maxDist)
+          continue;
+        const UInt64 len = GetMatchLen(win, mask, e.Pos, cur, _readPos - cur);
+        UInt64 back = 0;
+        {
+          UInt64 backLim = cur - litStart;
+          if (backLim > e.Pos - histStart)
+            backLim = e.Pos - histStart;
+          while (back != backLim
+              && win[(size_t)(e.Pos - back - 1) & mask] ==
+                 win[(size_t)(cur   - back - 1) & mask])
+            back++;
+        }
+        if (bestLen < back + len)
+        {
+          bestLen = back + len;
+          bestBack = back;
+          bestDist = dist;
+        }
+      }
+
+      for (unsigned k = kBucketSize - 1; k != 0; k--)
+        bucket[k] = bucket[k - 1];
+      bucket[0].Pos = cur;
+      bucket[0].Check = check;
+
+      if (bestLen < kMatchLen_Min)
+        continue;
+
+      const UInt64 matchStart = cur - bestBack;
+      UInt64 matchEnd = matchStart + bestLen;
+      RINOK(WriteNumber(matchStart - litStart))
+      RINOK(WriteLiterals(litStart, matchStart - litStart))
+
+      // the literals were written already. So we can read next blocks to continue the match.
+      while (matchEnd == _readPos && !_inEof)
+      {
+        RINOK(ReadBlock())
+        matchEnd += GetMatchLen(win, mask, matchEnd - bestDist, matchEnd, _readPos - matchEnd);
+        if (progress)
+        {
+          const UInt64 outSize = _outProcessed + _outPos;
+          RINOK(progress->SetRatioInfo(&_readPos, &outSize))
+        }
+      }
+
+      RINOK(WriteNumber(matchEnd - matchStart))
+      RINOK(WriteNumber(bestDist - 1))
+      litStart = matchEnd;
+      hash = 0;
+      numHashed = 0;
+      break;
+    }
+
+    if (p == lim)
+      pos += rem;
+    else
+      pos = litStart;
+  }
+
+  if (pos != litStart)
+  {
+    RINOK(WriteNumber(pos - litStart))
+    RINOK(WriteLiterals(litStart, pos - litStart))
+    RINOK(WriteNumber(0))
+  }
+  // end marker
+  RINOK(WriteNumber(0))
+  RINOK(WriteNumber(0))
+  return FlushOut();
+}
+
+
+Z7_COM7F_IMF(CEncoder::Code(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    const UInt64 * /* inSize */, const UInt64 * /* outSize */, ICompressProgressInfo *progress))
+{
+  _inStream = inStream;
+  _outStream = outStream;
+  const HRESULT res = CodeReal(progress);
+  _inStream = NULL;
+  _outStream = NULL;
+  return res;
+}
+
+#endif
+
+
+
+Z7_COM7F_IMF(CDecoder::SetDecoderProperties2(const Byte *props, UInt32 size))
+{
+  if (size < 1)
+    return E_NOTIMPL;
+  const unsigned wlog = props[0];
+  if (wlog < kWindowLog_Min || wlog > kWindowLog_Max)
+    return E_NOTIMPL;
+  _windowLog = wlog;
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CDecoder::SetMemLimit(UInt64 memUsage))
+{
+  _memUsage = memUsage;
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CDecoder::SetFinishMode(UInt32 finishMode))
+{
+  _finishMode = (finishMode != 0);
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CDecoder::GetInStreamProcessedSize(UInt64 *value))
+{
+  *value = _inStream.GetProcessedSize();
+  return S_OK;
+}
+
+
+bool CDecoder::ReadNumber(UInt64 &v)
+{
+  v = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7)
+  {
+    Byte b;
+    if (!_inStream.ReadByte(b))
+      return false;
+    v |= (UInt64)(b & 0x7F) << shift;
+    if ((b & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+HRESULT CDecoder::Flush()
+{
+  while (_flushed != _pos)
+  {
+    const size_t offs = (size_t)_flushed & (_winSize - 1);
+    size_t size = _winSize - offs;
+    if (size > _pos - _flushed)
+      size = (size_t)(_pos - _flushed);
+    RINOK(WriteStream(_outStream, (const Byte *)_win + offs, size))
+    _flushed += size;
+  }
+  return S_OK;
+}
+
+HRESULT CDecoder::CodeReal(const UInt64 *outSize, ICompressProgressInfo *progress)
+{
+  Byte *win = _win;
+  const size_t winSize = _winSize;
+  const size_t mask = winSize - 1;
+
+  for (;;)
+  {
+    UInt64 litLen, matchLen, dist;
+    if (!ReadNumber(litLen))
+      return S_FALSE;
+    if (outSize && litLen > *outSize - _pos)
+      return S_FALSE;
+    const bool isEnd = (litLen == 0);
+
+    while (litLen != 0)
+    {
+      const size_t offs = (size_t)_pos & mask;
+      size_t cur = winSize - offs;
+      if (cur > litLen)
+        cur = (size_t)litLen;
+      if (cur > _flushed + winSize - _pos)
+        cur = (size_t)(_flushed + winSize - _pos);
+      if (cur == 0)
+      {
+        RINOK(Flush())
+        continue;
+      }
+      const size_t processed = _inStream.ReadBytes(win + offs, cur);
+      _pos += processed;
+      litLen -= processed;
+      if (processed != cur)
+        return S_FALSE;
+    }
+
+    if (!ReadNumber(matchLen))
+      return S_FALSE;
+    if (matchLen == 0)
+    {
+      if (isEnd)
+        return S_OK;
+    }
+    else
+    {
+      if (!ReadNumber(dist))
+        return S_FALSE;
+      if (dist >= _pos || dist >= winSize)
+        return S_FALSE;
+      dist++;
+      if (outSize && matchLen > *outSize - _pos)
+        return S_FALSE;
+
+      while (matchLen != 0)
+      {
+        const size_t offs = (size_t)_pos & mask;
+        const size_t src = (size_t)(_pos - dist) & mask;
+        size_t cur = winSize - (offs > src ? offs : src);
+        if (cur > matchLen)
+          cur = (size_t)matchLen;
+        // for overlapped copying we copy (dist) bytes per step
+        if (cur > dist)
+          cur = (size_t)dist;
+        if (cur > _flushed + winSize - _pos)
+          cur = (size_t)(_flushed + winSize - _pos);
+        if (cur == 0)
+        {
+          RINOK(Flush())
+          continue;
+        }
+        memmove(win + offs, win + src, cur);
+        _pos += cur;
+        matchLen -= cur;
+      }
+    }
+
+    if (_pos - _flushed >= kFlushSize)
+    {
+      RINOK(Flush())
+      if (progress)
+      {
+        const UInt64 inSize = _inStream.GetProcessedSize();
+        RINOK(progress->SetRatioInfo(&inSize, &_pos))
+      }
+    }
+  }
+}
+
+
+Z7_COM7F_IMF(CDecoder::Code(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    const UInt64 *inSize, const UInt64 *outSize, ICompressProgressInfo *progress))
+{
+  if (_windowLog == 0)
+    return E_NOTIMPL;
+
+  // the window larger than unpack size is not required
+  unsigned wlog = 16;
+  while (wlog < _windowLog && (!outSize || ((UInt64)1 << wlog) < *outSize))
+    wlog++;
+  // the decoder can't work without full window
+  if (wlog >= sizeof(size_t) * 8 || ((UInt64)1 << wlog) > _memUsage)
+    return E_OUTOFMEMORY;
+  _winSize = (size_t)1 << wlog;
+  _win.AllocAtLeast(_winSize);
+  if (!_win.IsAllocated())
+    return E_OUTOFMEMORY;
+  if (!_inStream.Create(kInBufSize))
+    return E_OUTOFMEMORY;
+
+  _inStream.SetStream(inStream);
+  _inStream.Init();
+  _outStream = outStream;
+  _pos = 0;
+  _flushed = 0;
+
+  HRESULT res;
+  try
+  {
+    res = CodeReal(outSize, progress);
+    const HRESULT res2 = Flush();
+    if (res == S_OK)
+      res = res2;
+  }
+  catch(const CSystemException &e) { res = e.ErrorCode; }
+  catch(...) { res = S_FALSE; }
+
+  _inStream.SetStream(NULL);
+  _outStream = NULL;
+
+  if (res == S_OK && _finishMode)
+  {
+    if (outSize && *outSize != _pos)
+      res = S_FALSE;
+    else if (inSize && *inSize != _inStream.GetProcessedSize())
+      res = S_FALSE;
+  }
+  return res;
+}
+
+}}
@@ -0,0 +1,112 @@
+// LdmCoder.h
+
+#ifndef ZIP7_INC_COMPRESS_LDM_CODER_H
+#define ZIP7_INC_COMPRESS_LDM_CODER_H
+
+#include "../../Common/MyBuffer2.h"
+#include "../../Common/MyCom.h"
+
+#include "../ICoder.h"
+
+#include "../Common/InBuffer.h"
+
+namespace NCompress {
+namespace NLdm {
+
+/*
+LDM (long distance matching) coder replaces long repeats in the stream
+with references to earlier data. The window of LDM can be much larger
+than the dictionary of next LZ coder (LZMA2) in the chain, and the memory
+usage is low:
+  encoder : (window_size + window_size / 16)
+  decoder : (window_size), or (unpack_size), if it's smaller.
+
+Properties: 1 byte : log2(window_size)
+
+Stream is a sequence of records:
+  NUMBER  litLen
+  BYTE    literals[litLen]
+  NUMBER  matchLen
+  NUMBER  (dist - 1)  : if (matchLen != 0)
+
+  the record with (litLen == 0 && matchLen == 0) is end marker.
+  NUMBER : 7 bits in each byte, low bits first.
+           (0x80) flag in byte means that next byte follows.
+*/
+
+const unsigned kWindowLog_Min = 20;
+const unsigned kWindowLog_Max = (sizeof(size_t) > 4 ? 40 : 30);
+const unsigned kWindowLog_Default = (sizeof(size_t) > 4 ? 30 : 26);
+
+#ifndef Z7_EXTRACT_ONLY
+
+Z7_CLASS_IMP_COM_3(
+  CEncoder
+  , ICompressCoder
+  , ICompressSetCoderProperties
+  , ICompressWriteCoderProperties
+)
+  struct CEntry
+  {
+    UInt64 Pos; // the end of sampled block
+    UInt32 Check;
+    UInt32 Pad;
+  };
+
+  CMidBuffer _win;
+  CMidBuffer _table;
+  CMidBuffer _outBuf;
+
+  ISequentialInStream *_inStream;
+  ISequentialOutStream *_outStream;
+  size_t _outPos;
+  UInt64 _outProcessed;
+  UInt64 _readPos;
+  size_t _blockSize;
+  bool _inEof;
+  unsigned _windowLog;
+
+  HRESULT ReadBlock();
+  HRESULT FlushOut();
+  HRESULT WriteNumber(UInt64 v);
+  HRESULT WriteLiterals(UInt64 pos, UInt64 size);
+  HRESULT CodeReal(ICompressProgressInfo *progress);
+public:
+  CEncoder();
+};
+
+#endif
+
+
+Z7_CLASS_IMP_COM_5(
+  CDecoder
+  , ICompressCoder
+  , ICompressSetDecoderProperties2
+  , ICompressSetFinishMode
+  , ICompressGetInStreamProcessedSize
+  , ICompressSetMemLimit
+)
+  CMidBuffer _win;
+  CInBuffer _inStream;
+  ISequentialOutStream *_outStream;
+  size_t _winSize;
+  UInt64 _pos;
+  UInt64 _flushed;
+  UInt64 _memUsage;
+  unsigned _windowLog;
+  bool _finishMode;
+
+  bool ReadNumber(UInt64 &v);
+  HRESULT Flush();
+  HRESULT CodeReal(const UInt64 *outSize, ICompressProgressInfo *progress);
+public:
+  CDecoder():
+      _memUsage((UInt64)(sizeof(size_t)) << 28),
+      _windowLog(0),
+      _finishMode(false)
+      {}
+};
+
+}}
+
+#endif
@@ -0,0 +1,18 @@
+// LdmRegister.cpp
+
+#include "StdAfx.h"
+
+#include "../Common/RegisterCodec.h"
+
+#include "LdmCoder.h"
+
+namespace NCompress {
+namespace NLdm {
+
+REGISTER_CODEC_E(LDM,
+    CDecoder(),
+    CEncoder(),
+    0x3F9D4193CDC70001,
+    "LDM")
+
+}}
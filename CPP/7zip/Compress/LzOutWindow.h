@@ -90,6 +90,15 @@ public:
     _pos = pos;
   }
   
+  // direct access to the buffer for external decoding loops:
+  // the data can be written to (GetBuf() + GetPos()) up to (GetBuf() + GetLimitPos()).
+  Byte *GetBuf() const { return _buf; }
+  UInt32 GetPos() const { return _pos; }
+  UInt32 GetLimitPos() const { return _limitPos; }
+  UInt32 GetBufSize() const { return _bufSize; }
+  bool IsOverDict() const { return _overDict; }
+  void SetPos(UInt32 pos) { _pos = pos; }
+
   Byte GetByte(UInt32 distance) const
   {
     UInt32 pos = _pos - distance - 1;
@@ -54,6 +54,16 @@ HRESULT SetLzma2Prop(PROPID propID, const PROPVARIANT &prop, CLzma2EncProps &lzm
         return E_INVALIDARG;
       lzma2Props.numTotalThreads = (int)(prop.ulVal);
       break;
+    case NCoderPropID::kNumaMode:
+      if (prop.vt != VT_BOOL)
+        return E_INVALIDARG;
+      lzma2Props.numaMode = (prop.boolVal != VARIANT_FALSE) ? 1 : 0;
+      break;
+    case NCoderPropID::kBlockOverlap:
+      if (prop.vt != VT_BOOL)
+        return E_INVALIDARG;
+      lzma2Props.blockOverlap = (prop.boolVal != VARIANT_FALSE) ? 1 : 0;
+      break;
     default:
       RINOK(NLzma::SetLzmaProp(propID, prop, lzma2Props.lzmaProps))
   }
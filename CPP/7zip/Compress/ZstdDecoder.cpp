@@ -0,0 +1,505 @@
+// ZstdDecoder.cpp
+
+#include "StdAfx.h"
+
+#include <string.h>
+
+#include "../../../C/Alloc.h"
+#include "../../../C/CpuArch.h"
+
+#include "../Common/StreamUtils.h"
+
+#include "ZstdDecoder.h"
+
+namespace NCompress {
+namespace NZstd {
+
+static const size_t kInBufSize = (size_t)1 << 20;
+
+static HRESULT SResToHRESULT_Code(SRes res) throw()
+{
+  if (res < 0)
+    return res;
+  switch (res)
+  {
+    case SZ_OK: return S_OK;
+    case SZ_ERROR_MEM: return E_OUTOFMEMORY;
+    case SZ_ERROR_UNSUPPORTED: return E_NOTIMPL;
+  }
+  return S_FALSE;
+}
+
+
+#ifndef Z7_ST
+
+CDecoderJob::~CDecoderJob()
+{
+  if (Dec)
+    ZstdDec_Destroy(Dec);
+  ::MidFree(OutBuf);
+}
+
+void CDecoderJob::Decode()
+{
+  NumBlocks = 0;
+  if (!Dec)
+  {
+    Dec = ZstdDec_Create(&g_Alloc, &g_MidAlloc);
+    if (!Dec)
+    {
+      Res = SZ_ERROR_MEM;
+      return;
+    }
+  }
+  ZstdDec_Init(Dec);
+  ZstdDec_SetOutBuf(Dec, OutBuf, OutSize);
+  CZstdDecState s;
+  s.inBuf = Src;
+  s.inPos = 0;
+  s.inLim = SrcSize;
+  s.disableHash = False;
+  for (;;)
+  {
+    Res = ZstdDec_Decode(Dec, &s);
+    if (Res != SZ_OK)
+      return;
+    if (s.status == ZSTD_STATUS_FRAME_FINISHED)
+      break;
+    if (s.status != ZSTD_STATUS_OUT_BLOCK)
+    {
+      Res = SZ_ERROR_DATA;
+      return;
+    }
+  }
+  if (s.inPos != SrcSize)
+    Res = SZ_ERROR_DATA;
+  NumBlocks = ZstdDec_GetInfo(Dec)->num_Blocks;
+}
+
+static THREAD_FUNC_DECL DecoderThread(void *p)
+{
+  ((CDecoderJob *)p)->Decode();
+  return 0;
+}
+
+#endif
+
+
+CDecoder::CDecoder():
+    _dec(NULL),
+    _inBuf(NULL),
+    _inBufSize(0),
+    _finishMode(false)
+  #ifndef Z7_ST
+    , _numThreads(1)
+    , _memUsage((UInt64)(sizeof(size_t)) << 28)
+  #endif
+{
+  memset(&Info, 0, sizeof(Info));
+  DataAfterEnd = false;
+  UnexpectedEnd = false;
+  CrcError = false;
+}
+
+CDecoder::~CDecoder()
+{
+  if (_dec)
+    ZstdDec_Destroy(_dec);
+  ::MidFree(_inBuf);
+}
+
+
+HRESULT CDecoder::AllocInBuf(size_t size)
+{
+  if (_inBuf && _inBufSize >= size)
+    return S_OK;
+  Byte *buf = (Byte *)::MidAlloc(size);
+  if (!buf)
+    return E_OUTOFMEMORY;
+  if (_inLim != _inPos)
+    memcpy(buf, _inBuf + _inPos, _inLim - _inPos);
+  _inLim -= _inPos;
+  _inPos = 0;
+  ::MidFree(_inBuf);
+  _inBuf = buf;
+  _inBufSize = size;
+  return S_OK;
+}
+
+
+// it fills the free space at the end of input buffer
+
+HRESULT CDecoder::ReadInput(ISequentialInStream *inStream)
+{
+  if (_inputFinished)
+    return S_OK;
+  size_t size = _inBufSize - _inLim;
+  if (size == 0)
+    return S_OK;
+  const HRESULT res = ReadStream(inStream, _inBuf + _inLim, &size);
+  _inLim += size;
+  _inReadSize += size;
+  if (size == 0)
+    _inputFinished = true;
+  return res;
+}
+
+
+HRESULT CDecoder::WriteOutData(ISequentialOutStream *outStream, const Byte *data, size_t size)
+{
+  if (_outSizeDefined)
+  {
+    const UInt64 rem = _outSize - _outProcessed;
+    if (size > rem)
+    {
+      size = (size_t)rem;
+      _outOverflow = true;
+    }
+  }
+  _outProcessed += size;
+  if (outStream && size != 0)
+    return WriteStream(outStream, data, size);
+  return S_OK;
+}
+
+
+#define IS_OUT_FINISHED (_outSizeDefined && _outProcessed == _outSize)
+
+HRESULT CDecoder::DecodeSt(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    ICompressProgressInfo *progress)
+{
+  CZstdDecState s;
+  s.disableHash = False;
+
+  for (;;)
+  {
+    if (_inPos == _inLim && !_inputFinished)
+    {
+      _inPos = 0;
+      _inLim = 0;
+      RINOK(ReadInput(inStream))
+      if (progress)
+      {
+        const UInt64 inSize = _inReadSize - (_inLim - _inPos);
+        RINOK(progress->SetRatioInfo(&inSize, &_outProcessed))
+      }
+    }
+
+    s.inBuf = _inBuf;
+    s.inPos = _inPos;
+    s.inLim = _inLim;
+    const SRes res = ZstdDec_Decode(_dec, &s);
+    _inPos = s.inPos;
+    if (res != SZ_OK)
+    {
+      if (res == SZ_ERROR_CRC)
+        CrcError = true;
+      return SResToHRESULT_Code(res);
+    }
+
+    if (s.status == ZSTD_STATUS_OUT_BLOCK)
+    {
+      RINOK(WriteOutData(outStream, s.outBuf, s.outSize))
+      if (_outOverflow)
+        return S_FALSE;
+      continue;
+    }
+    if (s.status == ZSTD_STATUS_FRAME_FINISHED)
+    {
+      if (IS_OUT_FINISHED && !_finishMode)
+        return S_OK;
+      continue;
+    }
+    if (s.status == ZSTD_STATUS_WRONG_SIGNATURE)
+    {
+      DataAfterEnd = true;
+      return S_OK;
+    }
+    // (s.status == ZSTD_STATUS_NEEDS_MORE_INPUT)
+    if (_inputFinished)
+    {
+      if (!ZstdDec_IsBetweenFrames(_dec))
+        UnexpectedEnd = true;
+      return S_OK;
+    }
+  }
+}
+
+
+#ifndef Z7_ST
+
+/*
+  Multithreaded decoding:
+  the decoder reads a batch of complete frames to input buffer.
+  The frames that have content size field are decoded in parallel,
+  and the output data is written in original order.
+  For other frames (or if there is not enough memory) we use DecodeSt().
+*/
+
+HRESULT CDecoder::DecodeMt(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    ICompressProgressInfo *progress)
+{
+  unsigned numThreads = (unsigned)_numThreads;
+  if (numThreads > kNumDecoderThreadsMax)
+    numThreads = kNumDecoderThreadsMax;
+
+  size_t bufSizeMax = (size_t)1 << (sizeof(size_t) == 4 ? 28 : 31);
+  if (bufSizeMax > _memUsage / 4)
+    bufSizeMax = (size_t)(_memUsage / 4);
+
+  for (;;)
+  {
+    if (_inPos != 0)
+    {
+      memmove(_inBuf, _inBuf + _inPos, _inLim - _inPos);
+      _inLim -= _inPos;
+      _inPos = 0;
+    }
+    RINOK(ReadInput(inStream))
+    if (_inPos == _inLim)
+      return S_OK;
+
+    size_t pos = _inPos;
+    unsigned numJobs = 0;
+    UInt64 memTotal = _inBufSize;
+    SRes parseRes = SZ_OK;
+
+    while (numJobs < numThreads && !IS_OUT_FINISHED)
+    {
+      UInt64 frameSize;
+      CZstdFrameHeader h;
+      const size_t rem = _inLim - pos;
+      parseRes = ZstdDec_ParseFrame(_inBuf + pos, rem, &frameSize, &h);
+      if (parseRes != SZ_OK)
+        break;
+      if ((GetUi32(_inBuf + pos) & ZSTD_SIGNATURE_SKIP_MASK) == ZSTD_SIGNATURE_SKIP)
+      {
+        if (numJobs != 0)
+          break;
+        pos += (size_t)frameSize;
+        _inPos = pos;
+        _mtInfo.num_SkipFrames++;
+        _mtInfo.inProcessed += frameSize;
+        _mtInfo.inProcessed_Frames = _mtInfo.inProcessed;
+        continue;
+      }
+      if (h.contentSize == (UInt64)(Int64)-1 || h.dictId != 0)
+        break;
+      memTotal += h.contentSize + ZSTD_DEC_BUF_SLACK;
+      if (memTotal > _memUsage || h.contentSize > ((size_t)0 - 1 - ZSTD_DEC_BUF_SLACK))
+        break;
+      CDecoderJob &job = _jobs[numJobs++];
+      job.Src = _inBuf + pos;
+      job.SrcSize = (size_t)frameSize;
+      job.OutSize = (size_t)h.contentSize;
+      pos += (size_t)frameSize;
+    }
+
+    if (numJobs < numThreads
+        && parseRes == SZ_ERROR_INPUT_EOF
+        && !_inputFinished
+        && _inLim == _inBufSize
+        && _inBufSize < bufSizeMax)
+    {
+      // we increase input buffer to get more frames for threads
+      size_t newSize = _inBufSize * 2;
+      if (newSize > bufSizeMax)
+        newSize = bufSizeMax;
+      RINOK(AllocInBuf(newSize))
+      continue;
+    }
+
+    if (numJobs == 0)
+    {
+      if (parseRes == SZ_ERROR_INPUT_EOF && _inPos != 0 && !_inputFinished)
+        continue;
+      return S_OK;
+    }
+
+    HRESULT res = S_OK;
+    unsigned i;
+
+    for (i = 0; i < numJobs; i++)
+    {
+      CDecoderJob &job = _jobs[i];
+      if (!job.OutBuf || job.OutBufSize < job.OutSize)
+      {
+        ::MidFree(job.OutBuf);
+        job.OutBufSize = 0;
+        job.OutBuf = (Byte *)::MidAlloc(job.OutSize + ZSTD_DEC_BUF_SLACK);
+        if (!job.OutBuf)
+        {
+          res = E_OUTOFMEMORY;
+          break;
+        }
+        job.OutBufSize = job.OutSize;
+      }
+    }
+    if (res != S_OK)
+      return res;
+
+    for (i = 0; i < numJobs; i++)
+    {
+      CDecoderJob &job = _jobs[i];
+      if (i == numJobs - 1 || job.Thread.Create(DecoderThread, &job) != 0)
+        job.Decode();
+    }
+
+    // (errorJob) : the frame from that position will be decoded again by DecodeSt() to get error code
+    unsigned errorJob = numJobs;
+    size_t inPos = 0;
+
+    for (i = 0; i < numJobs; i++)
+    {
+      CDecoderJob &job = _jobs[i];
+      if (job.Thread.IsCreated())
+        job.Thread.Wait_Close();
+      if (errorJob != numJobs || res != S_OK)
+        continue;
+      if (job.Res != SZ_OK)
+      {
+        errorJob = i;
+        continue;
+      }
+      inPos += job.SrcSize;
+      _mtInfo.num_DataFrames++;
+      _mtInfo.num_Blocks += job.NumBlocks;
+      _mtInfo.inProcessed += job.SrcSize;
+      _mtInfo.inProcessed_Frames = _mtInfo.inProcessed;
+      _mtInfo.outProcessed += job.OutSize;
+      res = WriteOutData(outStream, job.OutBuf, job.OutSize);
+      if (res == S_OK && _outOverflow)
+        res = S_FALSE;
+      if (res == S_OK && progress)
+      {
+        const UInt64 inSize = _inReadSize - (_inLim - (_inPos + inPos));
+        res = progress->SetRatioInfo(&inSize, &_outProcessed);
+      }
+    }
+
+    RINOK(res)
+    if (errorJob != numJobs)
+    {
+      _inPos += inPos;
+      return S_OK;
+    }
+    _inPos = pos;
+  }
+}
+
+#endif
+
+
+HRESULT CDecoder::Decode2(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    ICompressProgressInfo *progress)
+{
+  if (!_dec)
+  {
+    _dec = ZstdDec_Create(&g_Alloc, &g_MidAlloc);
+    if (!_dec)
+      return E_OUTOFMEMORY;
+  }
+  ZstdDec_Init(_dec);
+
+  _inPos = 0;
+  _inLim = 0;
+  RINOK(AllocInBuf(kInBufSize))
+
+ #ifndef Z7_ST
+  memset(&_mtInfo, 0, sizeof(_mtInfo));
+  if (_numThreads > 1)
+  {
+    RINOK(DecodeMt(inStream, outStream, progress))
+    if (IS_OUT_FINISHED && !_finishMode)
+      return S_OK;
+  }
+ #endif
+
+  return DecodeSt(inStream, outStream, progress);
+}
+
+
+HRESULT CDecoder::Decode(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    const UInt64 *outSize, ICompressProgressInfo *progress)
+{
+  DataAfterEnd = false;
+  UnexpectedEnd = false;
+  CrcError = false;
+  _inputFinished = false;
+  _inReadSize = 0;
+  _outProcessed = 0;
+  _outOverflow = false;
+  _outSizeDefined = (outSize != NULL);
+  _outSize = 0;
+  if (outSize)
+    _outSize = *outSize;
+
+  HRESULT res = Decode2(inStream, outStream, progress);
+
+  memset(&Info, 0, sizeof(Info));
+  if (_dec)
+  {
+    Info = *ZstdDec_GetInfo(_dec);
+   #ifndef Z7_ST
+    // DecodeMt() processes only whole frames before DecodeSt() starts
+    const CZstdDecInfo &mt = _mtInfo;
+    Info.num_DataFrames += mt.num_DataFrames;
+    Info.num_SkipFrames += mt.num_SkipFrames;
+    Info.num_Blocks += mt.num_Blocks;
+    Info.outProcessed += mt.outProcessed;
+    Info.inProcessed += mt.inProcessed;
+    Info.inProcessed_Frames += mt.inProcessed;
+   #endif
+  }
+
+  if (res == S_OK && _finishMode)
+  {
+    if (_outSizeDefined && _outProcessed != _outSize)
+      res = S_FALSE;
+    else if (UnexpectedEnd || DataAfterEnd)
+      res = S_FALSE;
+  }
+  return res;
+}
+
+
+Z7_COM7F_IMF(CDecoder::Code(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+    const UInt64 * /* inSize */, const UInt64 *outSize, ICompressProgressInfo *progress))
+{
+  return Decode(inStream, outStream, outSize, progress);
+}
+
+Z7_COM7F_IMF(CDecoder::SetDecoderProperties2(const Byte * /* prop */, UInt32 /* size */))
+{
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CDecoder::SetFinishMode(UInt32 finishMode))
+{
+  _finishMode = (finishMode != 0);
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CDecoder::GetInStreamProcessedSize(UInt64 *value))
+{
+  *value = Info.inProcessed;
+  return S_OK;
+}
+
+#ifndef Z7_ST
+
+Z7_COM7F_IMF(CDecoder::SetNumberOfThreads(UInt32 numThreads))
+{
+  _numThreads = numThreads;
+  return S_OK;
+}
+
+Z7_COM7F_IMF(CDecoder::SetMemLimit(UInt64 memUsage))
+{
+  _memUsage = memUsage;
+  return S_OK;
+}
+
+#endif
+
+}}
@@ -0,0 +1,129 @@
+// ZstdDecoder.h
+
+#ifndef ZIP7_INC_ZSTD_DECODER_H
+#define ZIP7_INC_ZSTD_DECODER_H
+
+#include "../../../C/ZstdDec.h"
+
+#include "../../Common/MyCom.h"
+
+#ifndef Z7_ST
+#include "../../Windows/Thread.h"
+#endif
+
+#include "../ICoder.h"
+
+namespace NCompress {
+namespace NZstd {
+
+#ifndef Z7_ST
+
+struct CDecoderJob
+{
+  CZstdDecHandle Dec;
+  const Byte *Src;
+  size_t SrcSize;
+  Byte *OutBuf;
+  size_t OutBufSize; // allocated size without ZSTD_DEC_BUF_SLACK
+  size_t OutSize;
+  UInt64 NumBlocks;
+  SRes Res;
+  NWindows::CThread Thread;
+
+  CDecoderJob(): Dec(NULL), OutBuf(NULL), OutBufSize(0) {}
+  ~CDecoderJob();
+  void Decode();
+};
+
+const unsigned kNumDecoderThreadsMax = 64;
+
+#endif
+
+
+class CDecoder Z7_final:
+  public ICompressCoder,
+  public ICompressSetDecoderProperties2,
+  public ICompressSetFinishMode,
+  public ICompressGetInStreamProcessedSize,
+ #ifndef Z7_ST
+  public ICompressSetCoderMt,
+  public ICompressSetMemLimit,
+ #endif
+  public CMyUnknownImp
+{
+  Z7_COM_QI_BEGIN2(ICompressCoder)
+  Z7_COM_QI_ENTRY(ICompressSetDecoderProperties2)
+  Z7_COM_QI_ENTRY(ICompressSetFinishMode)
+  Z7_COM_QI_ENTRY(ICompressGetInStreamProcessedSize)
+ #ifndef Z7_ST
+  Z7_COM_QI_ENTRY(ICompressSetCoderMt)
+  Z7_COM_QI_ENTRY(ICompressSetMemLimit)
+ #endif
+  Z7_COM_QI_END
+  Z7_COM_ADDREF_RELEASE
+
+  Z7_IFACE_COM7_IMP(ICompressCoder)
+  Z7_IFACE_COM7_IMP(ICompressSetDecoderProperties2)
+  Z7_IFACE_COM7_IMP(ICompressSetFinishMode)
+  Z7_IFACE_COM7_IMP(ICompressGetInStreamProcessedSize)
+public:
+ #ifndef Z7_ST
+  Z7_IFACE_COM7_IMP(ICompressSetCoderMt)
+  Z7_IFACE_COM7_IMP(ICompressSetMemLimit)
+ #endif
+private:
+
+  CZstdDecHandle _dec;
+  Byte *_inBuf;
+  size_t _inBufSize;
+  size_t _inPos;
+  size_t _inLim;
+  bool _inputFinished;
+  bool _finishMode;
+  bool _outSizeDefined;
+  bool _outOverflow;
+  UInt64 _outSize;
+  UInt64 _inReadSize;    // total size of data that was read from input stream
+  UInt64 _outProcessed;
+
+ #ifndef Z7_ST
+  UInt32 _numThreads;
+  UInt64 _memUsage;
+  CZstdDecInfo _mtInfo;
+  CDecoderJob _jobs[kNumDecoderThreadsMax];
+
+  HRESULT DecodeMt(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+      ICompressProgressInfo *progress);
+ #endif
+
+  HRESULT AllocInBuf(size_t size);
+  HRESULT ReadInput(ISequentialInStream *inStream);
+  HRESULT WriteOutData(ISequentialOutStream *outStream, const Byte *data, size_t size);
+  HRESULT DecodeSt(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+      ICompressProgressInfo *progress);
+  HRESULT Decode2(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+      ICompressProgressInfo *progress);
+
+public:
+  // the results of last decoding:
+  CZstdDecInfo Info;
+  bool DataAfterEnd;
+  bool UnexpectedEnd;
+  bool CrcError;
+
+  /* Decode() can return S_OK, if there is data after good zstd frames,
+     and that data is not new zstd frame. Check (DataAfterEnd) flag */
+  HRESULT Decode(ISequentialInStream *inStream, ISequentialOutStream *outStream,
+      const UInt64 *outSize, ICompressProgressInfo *progress);
+
+  // the size of input data in finished frames
+  UInt64 GetPackSize() const { return Info.inProcessed_Frames; }
+  UInt64 GetOutProcessedSize() const { return Info.outProcessed; }
+
+  CDecoder();
+  ~CDecoder();
+};
+
+}}
+
+#endif
@@ -0,0 +1,32 @@
+// ZstdEncoder.h
+
+#ifndef ZIP7_INC_ZSTD_ENCODER_H
+#define ZIP7_INC_ZSTD_ENCODER_H
+
+#include "../../Common/MyCom.h"
+
+#include "../ICoder.h"
+
+#include "ZstdEncoderProps.h"
+
+namespace NCompress {
+namespace NZstd {
+
+Z7_CLASS_IMP_COM_4(
+  CEncoder
+  , ICompressCoder
+  , ICompressSetCoderProperties
+  , ICompressWriteCoderProperties
+  , ICompressSetCoderPropertiesOpt
+)
+  CZstdEncHandle _encoder;
+public:
+  CEncoderProps Props;
+
+  CEncoder();
+  ~CEncoder();
+};
+
+}}
+
+#endif
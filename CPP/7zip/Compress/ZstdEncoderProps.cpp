@@ -0,0 +1,96 @@
+// ZstdEncoderProps.cpp
+
+#include "StdAfx.h"
+
+#include "ZstdEncoderProps.h"
+
+namespace NCompress {
+namespace NZstd {
+
+static unsigned GetLog(UInt64 v)
+{
+  unsigned i = 0;
+  while (i < 63 && ((UInt64)1 << i) < v)
+    i++;
+  return i;
+}
+
+HRESULT CEncoderProps::SetCoderProp(PROPID propID, const PROPVARIANT &prop)
+{
+  if (propID == NCoderPropID::kAffinity)
+    return S_OK;
+
+  if (propID == NCoderPropID::kReduceSize)
+  {
+    if (prop.vt == VT_UI8)
+      EncProps.expectedDataSize = prop.uhVal.QuadPart;
+    return S_OK;
+  }
+
+  if (propID == NCoderPropID::kBlockSize
+      || propID == NCoderPropID::kBlockSize2)
+  {
+    if (prop.vt == VT_UI4)
+      EncProps.jobSize = prop.ulVal;
+    else if (prop.vt == VT_UI8)
+      EncProps.jobSize = prop.uhVal.QuadPart;
+    else
+      return E_INVALIDARG;
+    return S_OK;
+  }
+
+  if (propID == NCoderPropID::kDictionarySize)
+  {
+    UInt64 v;
+    if (prop.vt == VT_UI4)
+      v = prop.ulVal;
+    else if (prop.vt == VT_UI8)
+      v = prop.uhVal.QuadPart;
+    else
+      return E_INVALIDARG;
+    unsigned log = GetLog(v);
+    if (log < ZSTD_ENC_WINDOW_LOG_MIN)
+      log = ZSTD_ENC_WINDOW_LOG_MIN;
+    if (log > ZSTD_ENC_WINDOW_LOG_MAX)
+      return E_INVALIDARG;
+    EncProps.windowLog = log;
+    return S_OK;
+  }
+
+  if (prop.vt != VT_UI4)
+    return E_INVALIDARG;
+  const UInt32 v = prop.ulVal;
+
+  switch (propID)
+  {
+    case NCoderPropID::kLevel:
+      EncProps.level = (int)(v > ZSTD_ENC_LEVEL_MAX ? ZSTD_ENC_LEVEL_MAX : v);
+      break;
+    case NCoderPropID::kNumThreads:
+      // we don't use multithreaded mode with one worker
+      EncProps.nbWorkers = (v <= 1 ? 0 : v);
+      break;
+    case NCoderPropID::kCheckSize:
+      if (v != 0 && v != 4)
+        return E_INVALIDARG;
+      EncProps.checksumFlag = (v != 0);
+      break;
+    default:
+      return E_INVALIDARG;
+  }
+  return S_OK;
+}
+
+
+HRESULT CEncoderProps::SetFromMethodProps(const CMethodProps &props)
+{
+  ZstdEncProps_Init(&EncProps);
+  FOR_VECTOR (i, props.Props)
+  {
+    const CProp &prop = props.Props[i];
+    RINOK(SetCoderProp(prop.Id, prop.Value))
+  }
+  return S_OK;
+}
+
+}}
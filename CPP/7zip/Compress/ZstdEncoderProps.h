@@ -0,0 +1,25 @@
+// ZstdEncoderProps.h
+
+#ifndef ZIP7_INC_ZSTD_ENCODER_PROPS_H
+#define ZIP7_INC_ZSTD_ENCODER_PROPS_H
+
+#include "../../../C/ZstdEnc.h"
+
+#include "../Common/MethodProps.h"
+
+namespace NCompress {
+namespace NZstd {
+
+struct CEncoderProps
+{
+  CZstdEncProps EncProps;
+
+  CEncoderProps() { ZstdEncProps_Init(&EncProps); }
+  
+  HRESULT SetCoderProp(PROPID propID, const PROPVARIANT &prop);
+  HRESULT SetFromMethodProps(const CMethodProps &props);
+};
+
+}}
+
+#endif
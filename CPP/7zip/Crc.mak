@@ -1,5 +1,6 @@
 C_OBJS = $(C_OBJS) \
-  $O\7zCrc.obj
+  $O\7zCrc.obj \
+  $O\CrcFold.obj
 !IF "$(PLATFORM)" == "ia64" || "$(PLATFORM)" == "mips" || "$(PLATFORM)" == "arm" || "$(PLATFORM)" == "arm64"
 C_OBJS = $(C_OBJS) \
 !ELSE
@@ -136,6 +136,8 @@ namespace NCoderPropID
     kAffinity,          // VT_UI8
     kBranchOffset,      // VT_UI4
     kHashBits,          // VT_UI4
+    kNumaMode,          // VT_BOOL
+    kBlockOverlap,      // VT_BOOL
     /*
     // kHash3Bits,          // VT_UI4
     // kHash2Bits,          // VT_UI4
@@ -140,6 +140,23 @@ Z7_IFACE_CONSTR_STREAM(IStreamGetProps2, 0x09)
 Z7_IFACE_CONSTR_STREAM(IStreamGetProp, 0x0a)
 
 
+/*
+IStreamGetDataPtr::GetDataPtr(const Byte **data, UInt64 *size)
+  It allows zero-copy access to data of stream, if all data of stream
+  is available in memory (memory-mapped file or memory buffer).
+  The seek pointer of stream is not changed.
+  The data is available while the stream object exists.
+  returns:
+    S_OK    : (*data) points to all data of stream, and (*size) is the size of stream.
+    S_FALSE : the data is not available in memory. (*data) is set to NULL.
+              The caller must use Read() calls.
+*/
+
+#define Z7_IFACEM_IStreamGetDataPtr(x) \
+  x(GetDataPtr(const Byte **data, UInt64 *size))
+Z7_IFACE_CONSTR_STREAM(IStreamGetDataPtr, 0x11)
+
+
 /*
 IStreamSetRestriction::SetRestriction(UInt64 begin, UInt64 end)
   
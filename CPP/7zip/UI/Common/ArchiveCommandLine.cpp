@@ -19,6 +19,10 @@
 #include "../../../../C/Alloc.h"
 #endif
 
+#ifndef Z7_ST
+#include "../../../../C/Threads.h"
+#endif
+
 #include "../../../Common/IntToString.h"
 #include "../../../Common/ListFileUtils.h"
 #include "../../../Common/StringConvert.h"
@@ -130,6 +134,7 @@ enum Enum
   kRecursed,
 
   kAffinity,
+  kThreadPool,
   kSfx,
   kEmail,
   kHash,
@@ -140,6 +145,9 @@ enum Enum
   kStdOut,
 
   kLargePages,
+  kMemMap,
+  kAsyncFileIo,
+  kScanThreads,
   kListfileCharSet,
   kConsoleCharSet,
   kTechMode,
@@ -172,7 +180,8 @@ enum Enum
   kNameTrailReplace,
 
   kDeleteAfterCompressing,
-  kSetArcMTime
+  kSetArcMTime,
+  kAppendMode
 
   #ifndef Z7_NO_CRYPTO
   , kPassword
@@ -278,6 +287,7 @@ static const CSwitchForm kSwitchForms[] =
   { "r",  NSwitchType::kChar, false, 0, kRecursedPostCharSet },
   
   { "stm", SWFRM_STRING },
+  { "stp", SWFRM_STRING },
   { "sfx", SWFRM_STRING },
   { "seml", SWFRM_STRING_SINGL(0) },
   { "scrc", SWFRM_STRING_MULT(0) },
@@ -288,6 +298,9 @@ static const CSwitchForm kSwitchForms[] =
   { "so", SWFRM_SIMPLE },
 
   { "slp", SWFRM_STRING },
+  { "smm", SWFRM_SIMPLE },
+  { "sfio", SWFRM_SIMPLE },
+  { "sdt", SWFRM_STRING },
   { "scs", SWFRM_STRING },
   { "scc", SWFRM_STRING },
   { "slt", SWFRM_SIMPLE },
@@ -320,7 +333,8 @@ static const CSwitchForm kSwitchForms[] =
   { "snt", SWFRM_MINUS },
   
   { "sdel", SWFRM_SIMPLE },
-  { "stl", SWFRM_SIMPLE }
+  { "stl", SWFRM_SIMPLE },
+  { "sap", SWFRM_SIMPLE }
 
   #ifndef Z7_NO_CRYPTO
   , { "p", SWFRM_STRING }
@@ -1075,7 +1089,7 @@ void CArcCmdLineParser::Parse1(const UStringVector &commandStrings,
           #endif
         )
     {
-      #ifdef _WIN32 // change it !
+      #if defined(_WIN32) || defined(Z7_LARGE_PAGES_LINUX)
       SetLargePageSize();
       #endif
       // note: this process also can inherit that Privilege from parent process
@@ -1090,6 +1104,34 @@ void CArcCmdLineParser::Parse1(const UStringVector &commandStrings,
   }
 
 
+  if (parser[NKey::kMemMap].ThereIs)
+    g_ArcMemMapMode = true;
+
+  if (parser[NKey::kScanThreads].ThereIs)
+  {
+    // directory scanning mostly waits for file system, so we use more threads than cores
+    UInt32 numThreads = 4;
+    const UString &s = parser[NKey::kScanThreads].PostStrings[0];
+    if (!s.IsEmpty())
+      if (!StringToUInt32(s, numThreads) || numThreads == 0 || numThreads > 64)
+        throw CArcCmdLineException("Unsupported switch postfix for -sdt", s);
+    options.NumScanThreads = numThreads;
+  }
+
+  if (parser[NKey::kThreadPool].ThereIs)
+  {
+    UInt32 numThreadsMax = 0;
+    const UString &s = parser[NKey::kThreadPool].PostStrings[0];
+    if (!s.IsEmpty())
+      if (!StringToUInt32(s, numThreadsMax))
+        throw CArcCmdLineException("Unsupported switch postfix for -stp", s);
+    #ifndef Z7_ST
+    // the idle threads are reused by next coders in this process
+    const UInt32 kNumIdleThreadsMax = 64;
+    ThreadPool_Set(numThreadsMax, kNumIdleThreadsMax);
+    #endif
+  }
+
   #ifndef UNDER_CE
 
   if (parser[NKey::kAffinity].ThereIs)
@@ -1439,6 +1481,8 @@ void CArcCmdLineParser::Parse2(CArcCmdLineOptions &options)
         nt.PreserveATime = true;
       if (parser[NKey::kShareForWrite].ThereIs)
         nt.OpenShareForWrite = true;
+      if (parser[NKey::kAsyncFileIo].ThereIs)
+        nt.AsyncFileIo = true;
     }
 
     if (parser[NKey::kZoneFile].ThereIs)
@@ -1571,6 +1615,9 @@ void CArcCmdLineParser::Parse2(CArcCmdLineOptions &options)
       updateOptions.OpenShareForWrite = true;
     if (parser[NKey::kStopAfterOpenError].ThereIs)
       updateOptions.StopAfterOpenError = true;
+    if (parser[NKey::kAsyncFileIo].ThereIs)
+      updateOptions.AsyncFileIo = true;
+    updateOptions.NumScanThreads = options.NumScanThreads;
 
     updateOptions.PathMode = censorPathMode;
 
@@ -1599,6 +1646,7 @@ void CArcCmdLineParser::Parse2(CArcCmdLineOptions &options)
 
     updateOptions.DeleteAfterCompressing = parser[NKey::kDeleteAfterCompressing].ThereIs;
     updateOptions.SetArcMTime = parser[NKey::kSetArcMTime].ThereIs;
+    updateOptions.AppendMode = parser[NKey::kAppendMode].ThereIs;
 
     if (updateOptions.StdOutMode && updateOptions.EMailMode)
       throw CArcCmdLineException("stdout mode and email mode cannot be combined");
@@ -1646,6 +1694,24 @@ void CArcCmdLineParser::Parse2(CArcCmdLineOptions &options)
       hashOptions.PreserveATime = true;
     if (parser[NKey::kShareForWrite].ThereIs)
       hashOptions.OpenShareForWrite = true;
+    hashOptions.NumScanThreads = options.NumScanThreads;
+   #ifndef Z7_ST
+    FOR_VECTOR (i, options.Properties)
+    {
+      // -mmt[N] switch sets the number of threads for hashing
+      const CProperty &prop = options.Properties[i];
+      UString name = prop.Name;
+      name.MakeLower_Ascii();
+      if (!name.IsPrefixedBy_Ascii_NoCase("mt"))
+        continue;
+      NCOM::CPropVariant propVariant;
+      if (!prop.Value.IsEmpty())
+        propVariant = prop.Value;
+      if (ParseMtProp(name.Ptr(2), propVariant, NSystem::GetNumberOfProcessors(), hashOptions.NumThreads) != S_OK
+          || hashOptions.NumThreads == 0)
+        throw CArcCmdLineException("Unsupported -mmt value", prop.Name);
+    }
+   #endif
     hashOptions.StdInMode = options.StdInMode;
     hashOptions.AltStreamsMode = options.AltStreams.Val;
     hashOptions.SymLinks = options.SymLinks;
@@ -77,6 +77,7 @@ struct CArcCmdLineOptions
   AString ListFields;
 
   int ConsoleCodePage;
+  UInt32 NumScanThreads;
 
   NWildcard::CCensor Censor;
 
@@ -138,6 +139,7 @@ struct CArcCmdLineOptions
       ShowTime(false),
 
       ConsoleCodePage(-1),
+      NumScanThreads(1),
 
       Number_for_Out(k_OutStream_stdout),
       Number_for_Errors(k_OutStream_stderr),
@@ -1520,6 +1520,8 @@ HRESULT CArchiveExtractCallback::GetExtractStream(CMyComPtr<ISequentialOutStream
     {
       RINOK(outFileStream_Loc->Seek((Int64)_position, STREAM_SEEK_SET, NULL))
     }
+    if (_ntOptions.AsyncFileIo && (!_curSize_Defined || _curSize > (1 << 20)))
+      _outFileStreamSpec->StartWriteBehind();
     outStreamLoc = outFileStream_Loc;
   } // if not reprase
 
@@ -1885,7 +1887,7 @@ HRESULT CArchiveExtractCallback::CloseFile()
   if (!_outFileStream)
     return S_OK;
   
-  HRESULT hres = S_OK;
+  HRESULT hres = _outFileStreamSpec->Flush_WriteBehind();
   
   const UInt64 processedSize = _outFileStreamSpec->ProcessedSize;
   if (_fileLength_WasSet && _fileLength_that_WasSet > processedSize)
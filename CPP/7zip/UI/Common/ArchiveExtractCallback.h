@@ -61,6 +61,7 @@ struct CExtractNtOptions
   bool ExtractOwner;
 
   bool PreAllocateOutFile;
+  bool AsyncFileIo;
 
   // used for hash arcs only, when we open external files
   bool PreserveATime;
@@ -70,6 +71,7 @@ struct CExtractNtOptions
       ReplaceColonForAltStream(false),
       WriteToAltStreamIfColon(false),
       ExtractOwner(false),
+      AsyncFileIo(false),
       PreserveATime(false),
       OpenShareForWrite(false)
   {
@@ -11,6 +11,7 @@
 #include "../../Common/StreamUtils.h"
 
 #include "ArchiveOpenCallback.h"
+#include "OpenArchive.h"
 
 // #define DEBUG_VOLUMES
 
@@ -225,6 +226,10 @@ HRESULT CMultiStreams::EnsureOpen(unsigned index)
       CMyComPtr<IInStream> inStreamTemp = inFile;
       if (!inFile->Open(s.Path))
         return GetLastError_noZero_HRESULT();
+     #ifdef Z7_FILE_STREAMS_USE_MMAP
+      if (g_ArcMemMapMode)
+        inFile->MapToMemory();
+     #endif
       s.FileSpec = inFile;
       s.Stream = s.FileSpec;
       InsertToList(index);
@@ -334,6 +339,10 @@ Z7_COM7F_IMF(COpenCallbackImp::GetStream(const wchar_t *name, IInStream **inStre
     CMyComPtr<IInStream> inStreamTemp = inFile;
     if (!inFile->Open(fullPath))
       return GetLastError_noZero_HRESULT();
+   #ifdef Z7_FILE_STREAMS_USE_MMAP
+    if (g_ArcMemMapMode)
+      inFile->MapToMemory();
+   #endif
     RINOK(Volumes.PrepareToOpenNew())
     s.FileSpec = inFile;
     s.Stream = s.FileSpec;
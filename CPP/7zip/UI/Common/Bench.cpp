@@ -34,6 +34,7 @@
 #endif
 
 #include "../../../../C/7zCrc.h"
+#include "../../../../C/Alloc.h"
 #include "../../../../C/RotateDefs.h"
 
 #ifndef Z7_ST
@@ -2697,15 +2698,26 @@ static const CBenchHash g_Hash[] =
   { 20,   339, 0x21e207bb, "CRC32:8" } ,
   {  2,   128 *ARM_CRC_MUL, 0x21e207bb, "CRC32:32" },
   {  2,    64 *ARM_CRC_MUL, 0x21e207bb, "CRC32:64" },
-  { 10,   512, 0x41b901d1, "CRC64" },
+  {  2,     8, 0x21e207bb, "CRC32:128" },
+  { 10,   512, 0x41b901d1, "CRC64:4" },
+  {  2,     8, 0x41b901d1, "CRC64:128" },
   
   { 10, 5100,       0x7913ba03, "SHA256:1" },
   {  2, CMPLX((32 * 4 + 1) * 4 + 4), 0x7913ba03, "SHA256:2" },
   
   { 10, 2340,       0xff769021, "SHA1:1" },
   {  2, CMPLX((20 * 6 + 1) * 4 + 4), 0xff769021, "SHA1:2" },
+
+  { 10, 2800, 0xe7aeb394, "SHA512:1" },
+  {  2, 1900, 0xe7aeb394, "SHA512:2" },
+  {  2, 2800, 0x600aaf77, "SHA384:1" },
   
-  {  2,  5500, 0x85189d02, "BLAKE2sp" }
+  {  2,  5500, 0x85189d02, "BLAKE2sp" },
+
+  { 10,    64, 0x43eac94f, "XXH64" },
+  {  2,   160, 0xe8b2159b, "XXH128:1" },
+  {  2,    68, 0xe8b2159b, "XXH128:2" },
+  {  2,    44, 0xe8b2159b, "XXH128:3" }
 };
 
 static void PrintNumber(IBenchPrintCallback &f, UInt64 value, unsigned size)
@@ -2917,7 +2929,7 @@ AString GetProcessThreadsInfo(const NSystem::CProcessAffinity &ti)
 
 #ifdef Z7_LARGE_PAGES
 
-#ifdef _WIN32
+#if defined(_WIN32) || defined(Z7_LARGE_PAGES_LINUX)
 extern bool g_LargePagesMode;
 extern "C"
 {
@@ -2927,7 +2939,7 @@ extern "C"
 
 void Add_LargePages_String(AString &s)
 {
-  #ifdef _WIN32
+  #if defined(_WIN32) || defined(Z7_LARGE_PAGES_LINUX)
   if (g_LargePagesMode || g_LargePageSize != 0)
   {
     s.Add_OptSpaced("(LP-");
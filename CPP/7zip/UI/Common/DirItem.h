@@ -293,12 +293,20 @@ struct CDirItem: public NWindows::NFile::NFind::CFileInfoBase
 
 
 
-class CDirItems
+#ifndef Z7_ST
+class CDirScanThreads;
+#endif
+
+class CDirItems  MY_UNCOPYABLE
 {
   UStringVector Prefixes;
   CIntVector PhyParents;
   CIntVector LogParents;
 
+ #ifndef Z7_ST
+  CDirScanThreads *_scanThreads;
+ #endif
+
   UString GetPrefixesPath(const CIntVector &parents, int index, const UString &name) const;
 
   HRESULT EnumerateDir(int phyParent, int logParent, const FString &phyPrefix);
@@ -312,6 +320,11 @@ public:
   bool ExcludeFileItems;
   bool ShareForWrite;
 
+  /* if (NumScanThreads > 1), the helper threads read the subdirectories
+     before the main thread needs them. The main thread adds the items
+     in same order as in single-threaded mode. */
+  UInt32 NumScanThreads;
+
   /* it must be called after anotrher checks */
   bool CanIncludeItem(bool isDir) const
   {
@@ -351,6 +364,7 @@ public:
   IDirItemsCallback *Callback;
 
   CDirItems();
+  ~CDirItems();
 
   void AddDirFileInfo(int phyParent, int logParent, int secureIndex,
       const NWindows::NFile::NFind::CFileInfo &fi);
@@ -368,7 +382,9 @@ public:
   void DeleteLastPrefix();
 
   // HRESULT EnumerateOneDir(const FString &phyPrefix, CObjectVector<NWindows::NFile::NFind::CDirEntry> &files);
-  HRESULT EnumerateOneDir(const FString &phyPrefix, CObjectVector<NWindows::NFile::NFind::CFileInfo> &files);
+  HRESULT EnumerateOneDir(const FString &phyPrefix, CObjectVector<NWindows::NFile::NFind::CFileInfo> &files,
+      bool prefetchSubDirs = true);
+  void StopScanThreads();
   
   HRESULT EnumerateItems2(
     const FString &phyPrefix,
@@ -17,6 +17,11 @@
 #include "../../../Windows/FileIO.h"
 #include "../../../Windows/FileName.h"
 
+#ifndef Z7_ST
+#include "../../../Windows/Synchronization.h"
+#include "../../../Windows/Thread.h"
+#endif
+
 #if defined(_WIN32) && !defined(UNDER_CE)
 #define Z7_USE_SECURITY_CODE
 #include "../../../Windows/SecurityUtils.h"
@@ -183,6 +188,7 @@ CDirItems::CDirItems():
     , ExcludeDirItems(false)
     , ExcludeFileItems(false)
     , ShareForWrite(false)
+    , NumScanThreads(1)
    #ifdef Z7_USE_SECURITY_CODE
     , ReadSecure(false)
    #endif
@@ -191,11 +197,19 @@ CDirItems::CDirItems():
    #endif
     , Callback(NULL)
 {
+ #ifndef Z7_ST
+  _scanThreads = NULL;
+ #endif
   #ifdef Z7_USE_SECURITY_CODE
   _saclEnabled = InitLocalPrivileges();
   #endif
 }
 
+CDirItems::~CDirItems()
+{
+  StopScanThreads();
+}
+
 
 #ifdef Z7_USE_SECURITY_CODE
 
@@ -256,8 +270,423 @@ HRESULT CDirItems::AddSecurityItem(const FString &path, int &secureIndex)
 #endif // Z7_USE_SECURITY_CODE
 
 
-HRESULT CDirItems::EnumerateOneDir(const FString &phyPrefix, CObjectVector<NFind::CFileInfo> &files)
+#ifndef Z7_ST
+
+/*
+  CDirScanThreads reads directories in helper threads.
+  When the main thread gets the list of files of some directory,
+  it adds the group of jobs for subdirectories of that directory.
+  The main thread walks the tree in same order as in single-threaded mode,
+  and it takes the result of job instead of reading the directory itself.
+  So the order of items and the order of reported errors don't depend
+  on number of threads. The jobs of deepest group are started first.
+  If the main thread leaves the directory, the remaining jobs of
+  that directory are cancelled.
+*/
+
+struct CDirScanJob
+{
+  FString Prefix;
+  CObjectVector<NFind::CFileInfo> Files;
+  FStringVector ErrorPaths;
+  CRecordVector<DWORD> ErrorCodes;
+  DWORD DirError;
+  bool DirError_Defined;
+  bool Started;
+  bool Finished;
+  bool Cancelled;
+
+  CDirScanJob(const FString &prefix):
+      Prefix(prefix),
+      DirError(0),
+      DirError_Defined(false),
+      Started(false),
+      Finished(false),
+      Cancelled(false)
+      {}
+  void Read(bool followLink);
+};
+
+void CDirScanJob::Read(bool followLink)
 {
+  NFind::CEnumerator enumerator;
+  enumerator.SetDirPrefix(Prefix);
+
+ #ifdef _WIN32
+
+  UNUSED_VAR(followLink)
+  for (;;)
+  {
+    NFind::CFileInfo fi;
+    bool found;
+    if (!enumerator.Next(fi, found))
+    {
+      DirError = ::GetLastError();
+      DirError_Defined = true;
+      return;
+    }
+    if (!found)
+      return;
+    Files.Add(fi);
+  }
+
+ #else
+
+  CObjectVector<NFind::CDirEntry> entries;
+  for (;;)
+  {
+    bool found;
+    NFind::CDirEntry de;
+    if (!enumerator.Next(de, found))
+    {
+      DirError = ::GetLastError();
+      DirError_Defined = true;
+      return;
+    }
+    if (!found)
+      break;
+    entries.Add(de);
+  }
+
+  FOR_VECTOR (i, entries)
+  {
+    const NFind::CDirEntry &de = entries[i];
+    NFind::CFileInfo fi;
+    // Fill_FileInfo() uses fstatat() relative to descriptor of directory
+    if (!enumerator.Fill_FileInfo(de, fi, followLink))
+    {
+      ErrorCodes.Add(::GetLastError());
+      ErrorPaths.Add(Prefix + de.Name);
+      continue;
+    }
+    Files.Add(fi);
+  }
+
+ #endif
+}
+
+
+struct CDirScanGroup
+{
+  FString Prefix;
+  CRecordVector<CDirScanJob *> Jobs;
+  unsigned NextJob;  // all jobs before (NextJob) were started
+  unsigned NextGet;  // the main thread usually takes the jobs in same order
+
+  CDirScanGroup(): NextJob(0), NextGet(0) {}
+};
+
+
+class CDirScanThreads
+{
+  NSynchronization::CCriticalSection _cs;
+  NSynchronization::CAutoResetEvent _workEvent;
+  NSynchronization::CAutoResetEvent _finishedEvent;
+  CObjectVector<NWindows::CPoolThread> _threads;
+  CObjectVector<CDirScanGroup> _groups;
+  unsigned _numPending; // the number of started jobs that were not taken by main thread
+  bool _exit;
+  bool _followLink;
+
+  CDirScanJob *GetJobToStart();
+  void CancelGroup(CDirScanGroup &group);
+  static THREAD_FUNC_DECL ThreadFunc(void *p);
+  void Execute();
+public:
+  CDirScanThreads(bool followLink): _numPending(0), _exit(false), _followLink(followLink) {}
+  ~CDirScanThreads();
+
+  WRes Create(UInt32 numThreads);
+  CDirScanJob *GetJob(const FString &prefix);
+  void AddGroup(const FString &prefix, const CObjectVector<NFind::CFileInfo> &files);
+};
+
+// the limit for the number of directory lists that were read ahead of main thread
+static const unsigned kDirScan_NumPendingMax = 1 << 8;
+
+THREAD_FUNC_DECL CDirScanThreads::ThreadFunc(void *p)
+{
+  ((CDirScanThreads *)p)->Execute();
+  return 0;
+}
+
+CDirScanJob *CDirScanThreads::GetJobToStart()
+{
+  if (_numPending >= kDirScan_NumPendingMax)
+    return NULL;
+  for (unsigned i = _groups.Size(); i != 0;)
+  {
+    CDirScanGroup &group = _groups[--i];
+    while (group.NextJob < group.Jobs.Size())
+    {
+      CDirScanJob *job = group.Jobs[group.NextJob++];
+      if (job && !job->Started)
+      {
+        job->Started = true;
+        _numPending++;
+        return job;
+      }
+    }
+  }
+  return NULL;
+}
+
+void CDirScanThreads::Execute()
+{
+  for (;;)
+  {
+    CDirScanJob *job = NULL;
+    bool exit;
+    {
+      NSynchronization::CCriticalSectionLock lock(_cs);
+      exit = _exit;
+      if (!exit)
+        job = GetJobToStart();
+    }
+    if (exit)
+    {
+      // we wake up next thread that must exit too
+      _workEvent.Set();
+      return;
+    }
+    if (!job)
+    {
+      _workEvent.Lock();
+      continue;
+    }
+    // we wake up another thread, because there can be more jobs
+    _workEvent.Set();
+    job->Read(_followLink);
+    {
+      NSynchronization::CCriticalSectionLock lock(_cs);
+      job->Finished = true;
+      if (job->Cancelled)
+      {
+        _numPending--;
+        delete job;
+        job = NULL;
+      }
+    }
+    if (job)
+      _finishedEvent.Set();
+  }
+}
+
+WRes CDirScanThreads::Create(UInt32 numThreads)
+{
+  RINOK_WRes(_workEvent.Create())
+  RINOK_WRes(_finishedEvent.Create())
+  for (UInt32 i = 0; i < numThreads; i++)
+  {
+    NWindows::CPoolThread &thread = _threads.AddNew();
+    RINOK_WRes(thread.Create(ThreadFunc, this))
+  }
+  return 0;
+}
+
+CDirScanThreads::~CDirScanThreads()
+{
+  {
+    NSynchronization::CCriticalSectionLock lock(_cs);
+    _exit = true;
+    while (!_groups.IsEmpty())
+    {
+      CancelGroup(_groups.Back());
+      _groups.DeleteBack();
+    }
+  }
+  _workEvent.Set();
+  FOR_VECTOR (i, _threads)
+  {
+    if (_threads[i].IsCreated())
+      _threads[i].Wait_Close();
+  }
+}
+
+// it's called inside (_cs) lock
+void CDirScanThreads::CancelGroup(CDirScanGroup &group)
+{
+  FOR_VECTOR (i, group.Jobs)
+  {
+    CDirScanJob *job = group.Jobs[i];
+    if (!job)
+      continue;
+    if (job->Started && !job->Finished)
+    {
+      // the thread will delete the job
+      job->Cancelled = true;
+      continue;
+    }
+    if (job->Started)
+      _numPending--;
+    delete job;
+  }
+  group.Jobs.Clear();
+}
+
+static bool IsDirPrefixOf(const FString &dirPrefix, const FString &path)
+{
+  return dirPrefix.Len() <= path.Len()
+      && memcmp(dirPrefix.Ptr(), path.Ptr(), dirPrefix.Len() * sizeof(FChar)) == 0;
+}
+
+/* GetJob() returns the job for (prefix) that was read or that must be read
+   by main thread. It returns NULL, if there is no such job. */
+
+CDirScanJob *CDirScanThreads::GetJob(const FString &prefix)
+{
+  CDirScanJob *job = NULL;
+  bool finished;
+  bool readInMain = false;
+  {
+    NSynchronization::CCriticalSectionLock lock(_cs);
+    // the main thread has left the directories that are not parents of (prefix)
+    while (!_groups.IsEmpty() && !IsDirPrefixOf(_groups.Back().Prefix, prefix))
+    {
+      CancelGroup(_groups.Back());
+      _groups.DeleteBack();
+    }
+    if (_groups.IsEmpty())
+      return NULL;
+    CDirScanGroup &group = _groups.Back();
+    const unsigned numJobs = group.Jobs.Size();
+    for (unsigned k = 0; k < numJobs; k++)
+    {
+      unsigned i = group.NextGet + k;
+      if (i >= numJobs)
+        i -= numJobs;
+      CDirScanJob *job2 = group.Jobs[i];
+      if (job2 && job2->Prefix == prefix)
+      {
+        group.Jobs[i] = NULL;
+        group.NextGet = i + 1;
+        job = job2;
+        break;
+      }
+    }
+    if (!job)
+      return NULL;
+    if (!job->Started)
+    {
+      // no thread has started that job, so we read the directory in main thread
+      job->Started = true;
+      readInMain = true;
+    }
+    finished = job->Finished;
+  }
+
+  if (readInMain)
+  {
+    job->Read(_followLink);
+    return job;
+  }
+
+  if (!finished)
+  {
+    for (;;)
+    {
+      _finishedEvent.Lock();
+      NSynchronization::CCriticalSectionLock lock(_cs);
+      if (job->Finished)
+        break;
+    }
+  }
+  {
+    NSynchronization::CCriticalSectionLock lock(_cs);
+    _numPending--;
+  }
+  // the number of pending jobs was reduced, so some thread can start new job
+  _workEvent.Set();
+  return job;
+}
+
+void CDirScanThreads::AddGroup(const FString &prefix, const CObjectVector<NFind::CFileInfo> &files)
+{
+  {
+    NSynchronization::CCriticalSectionLock lock(_cs);
+    CDirScanGroup &group = _groups.AddNew();
+    group.Prefix = prefix;
+    FOR_VECTOR (i, files)
+    {
+      const NFind::CFileInfo &fi = files[i];
+      if (fi.IsDir())
+        group.Jobs.Add(new CDirScanJob(prefix + fi.Name + FCHAR_PATH_SEPARATOR));
+    }
+    if (group.Jobs.IsEmpty())
+      return;
+  }
+  _workEvent.Set();
+}
+
+#endif
+
+
+void CDirItems::StopScanThreads()
+{
+ #ifndef Z7_ST
+  if (_scanThreads)
+  {
+    delete _scanThreads;
+    _scanThreads = NULL;
+  }
+ #endif
+}
+
+
+HRESULT CDirItems::EnumerateOneDir(const FString &phyPrefix, CObjectVector<NFind::CFileInfo> &files,
+    bool prefetchSubDirs)
+{
+ #ifndef Z7_ST
+  if (NumScanThreads > 1 && !_scanThreads)
+  {
+    _scanThreads = new CDirScanThreads(!SymLinks);
+    if (_scanThreads->Create(NumScanThreads) != 0)
+      StopScanThreads();
+  }
+  if (_scanThreads)
+  {
+    CDirScanJob *job = _scanThreads->GetJob(phyPrefix);
+    if (!job)
+    {
+      job = new CDirScanJob(phyPrefix);
+      job->Read(!SymLinks);
+    }
+    // the job could be waited for long time, so we report progress and errors
+    // in same way as single-threaded code does it for directory reading.
+    HRESULT res = ScanProgress(phyPrefix);
+    if (res == S_OK)
+    FOR_VECTOR (i, job->ErrorPaths)
+    {
+      res = AddError(job->ErrorPaths[i], job->ErrorCodes[i]);
+      if (res != S_OK)
+        break;
+    }
+    if (res == S_OK)
+    {
+      files.ClearAndReserve(job->Files.Size());
+      FOR_VECTOR (i, job->Files)
+      {
+        files.AddInReserved(job->Files[i]);
+        if (Callback && (i & kScanProgressStepMask) == kScanProgressStepMask)
+        {
+          res = ScanProgress(phyPrefix);
+          if (res != S_OK)
+            break;
+        }
+      }
+      if (res == S_OK && job->DirError_Defined)
+        res = AddError(phyPrefix, job->DirError);
+    }
+    delete job;
+    RINOK(res)
+    if (prefetchSubDirs)
+      _scanThreads->AddGroup(phyPrefix, files);
+    return S_OK;
+  }
+ #else
+  UNUSED_VAR(prefetchSubDirs)
+ #endif
+
   NFind::CEnumerator enumerator;
   // printf("\n  enumerator.SetDirPrefix(phyPrefix) \n");
 
@@ -467,6 +896,7 @@ HRESULT CDirItems::EnumerateItems2(
     }
   }
   
+  StopScanThreads();
   ReserveDown();
   return S_OK;
 }
@@ -1104,7 +1534,7 @@ static HRESULT EnumerateDirItems(
   // for (int y = 0; y < 1; y++)
   {
     // files.Clear();
-    RINOK(dirItems.EnumerateOneDir(phyPrefix, files))
+    RINOK(dirItems.EnumerateOneDir(phyPrefix, files, enterToSubFolders))
   /*
   FOR_VECTOR (i, files)
   {
@@ -1188,6 +1618,7 @@ HRESULT EnumerateItems(
         false // enterToSubFolders
         ))
   }
+  dirItems.StopScanThreads();
   dirItems.ReserveDown();
 
  #if defined(_WIN32) && !defined(UNDER_CE)
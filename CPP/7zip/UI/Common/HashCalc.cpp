@@ -9,6 +9,11 @@
 #include "../../../Common/IntToString.h"
 #include "../../../Common/StringToInt.h"
 
+#ifndef Z7_ST
+#include "../../../Windows/Synchronization.h"
+#include "../../../Windows/Thread.h"
+#endif
+
 #include "../../Common/FileStreams.h"
 #include "../../Common/ProgressUtils.h"
 #include "../../Common/StreamObjects.h"
@@ -116,6 +121,18 @@ HRESULT CHashBundle::SetMethods(DECL_EXTERNAL_CODECS_LOC_VARS const UStringVecto
   return S_OK;
 }
 
+HRESULT CHashBundle::SetNumThreads(UInt32 numThreads)
+{
+  FOR_VECTOR (i, Hashers)
+  {
+    CMyComPtr<ICompressSetCoderMt> setCoderMt;
+    Hashers[i].Hasher.QueryInterface(IID_ICompressSetCoderMt, &setCoderMt);
+    if (setCoderMt)
+      RINOK(setCoderMt->SetNumberOfThreads(numThreads))
+  }
+  return S_OK;
+}
+
 void CHashBundle::InitForNewFile()
 {
   CurSize = 0;
@@ -183,6 +200,19 @@ void CHasherState::AddDigest(unsigned groupIndex, const Byte *data)
 }
 
 void CHashBundle::Final(bool isDir, bool isAltStream, const UString &path)
+{
+  if (!isDir)
+  {
+    FOR_VECTOR (i, Hashers)
+    {
+      CHasherState &h = Hashers[i];
+      h.Hasher->Final(h.Digests[k_HashCalc_Index_Current]);
+    }
+  }
+  Final_Digests(isDir, isAltStream, path);
+}
+
+void CHashBundle::Final_Digests(bool isDir, bool isAltStream, const UString &path)
 {
   if (isDir)
     NumDirs++;
@@ -205,12 +235,8 @@ void CHashBundle::Final(bool isDir, bool isAltStream, const UString &path)
   FOR_VECTOR (i, Hashers)
   {
     CHasherState &h = Hashers[i];
-    if (!isDir)
-    {
-      h.Hasher->Final(h.Digests[0]); // k_HashCalc_Index_Current
-      if (!isAltStream)
-        h.AddDigest(k_HashCalc_Index_DataSum, h.Digests[0]);
-    }
+    if (!isDir && !isAltStream)
+      h.AddDigest(k_HashCalc_Index_DataSum, h.Digests[0]);
 
     h.Hasher->Init();
     h.Hasher->Update(pre, sizeof(pre));
@@ -448,6 +474,445 @@ static void WriteLine(CDynLimBuf &hashFileString,
 }
 
 
+#ifndef Z7_ST
+
+/*
+  Multithreaded mode of HashCalc():
+  Several file threads hash different items concurrently.
+  Each file thread uses its own CHashBundle and it reads the file by big blocks.
+  If there are several hashers, the file thread can use additional lane threads
+  that run the subsets of hashers for same block of data in parallel.
+  The main thread waits the items in original order, and it calls
+  the callback functions in same order as single-threaded code.
+*/
+
+static const UInt32 kHashMt_BlockSize = (UInt32)1 << 20;
+// the minimal size of block that is hashed by lane threads
+static const UInt32 kHashMt_LaneBlockSizeMin = (UInt32)1 << 16;
+// the limit for the number of items that were hashed ahead of main thread
+static const unsigned kHashMt_NumSlots = 1 << 10;
+
+struct CHashMtSlot
+{
+  bool Finished;
+  bool OpenError;
+  bool Size_Defined;
+  DWORD SystemError;
+  HRESULT Res;
+  UInt64 Size;      // the size of file from GetSize()
+  UInt64 FileSize;  // the size of hashed data
+  CByteBuffer Digests;
+
+  CHashMtSlot(): Finished(false) {}
+};
+
+class CHashMt;
+class CHashMtFileThread;
+
+struct CHashMtLane
+{
+  CHashMtFileThread *Parent;
+  unsigned Index;
+  NSynchronization::CAutoResetEvent StartEvent;
+  NSynchronization::CAutoResetEvent DoneEvent;
+  NWindows::CPoolThread Thread;
+
+  static THREAD_FUNC_DECL ThreadFunc(void *p);
+};
+
+class CHashMtFileThread
+{
+  const Byte *_laneData;
+  UInt32 _laneSize;
+
+  void UpdateLane(unsigned laneIndex);
+  void Update(const Byte *data, UInt32 size);
+  void HashItem(unsigned index, CHashMtSlot &slot);
+  static THREAD_FUNC_DECL ThreadFunc(void *p);
+  void Execute();
+  friend struct CHashMtLane;
+public:
+  CHashMt *Mt;
+  CHashBundle Hb;
+  CHashMidBuf Buf;
+  CObjectVector<CHashMtLane> Lanes;
+  bool ExitLanes;
+  NWindows::CPoolThread Thread;
+
+  CHashMtFileThread(): _laneData(NULL), _laneSize(0), Mt(NULL), ExitLanes(false) {}
+  WRes Create(unsigned numLanes);
+};
+
+class CHashMt
+{
+public:
+  const CDirItems *DirItems;
+  bool PreserveATime;
+  bool OpenShareForWrite;
+
+  NSynchronization::CCriticalSection CS;
+  NSynchronization::CSemaphore SlotSemaphore;
+  NSynchronization::CAutoResetEvent ProgressEvent;
+  CObjectVector<CHashMtSlot> Slots;
+  CObjectVector<CHashMtFileThread> FileThreads;
+  unsigned NextItem;
+  UInt64 CompleteValue;
+  bool Stop;
+  bool SemaphoreCreated;
+
+  CHashMt(): NextItem(0), CompleteValue(0), Stop(false), SemaphoreCreated(false) {}
+  ~CHashMt() { StopThreads(); }
+  WRes Create(unsigned numLanes);
+  void StopThreads();
+  void ReleaseSlot(CHashMtSlot &slot);
+};
+
+
+THREAD_FUNC_DECL CHashMtLane::ThreadFunc(void *p)
+{
+  CHashMtLane &lane = *(CHashMtLane *)p;
+  for (;;)
+  {
+    lane.StartEvent.Lock();
+    if (lane.Parent->ExitLanes)
+      return 0;
+    lane.Parent->UpdateLane(lane.Index);
+    lane.DoneEvent.Set();
+  }
+}
+
+void CHashMtFileThread::UpdateLane(unsigned laneIndex)
+{
+  const unsigned numLanes = Lanes.Size() + 1;
+  for (unsigned i = laneIndex; i < Hb.Hashers.Size(); i += numLanes)
+    Hb.Hashers[i].Hasher->Update(_laneData, _laneSize);
+}
+
+void CHashMtFileThread::Update(const Byte *data, UInt32 size)
+{
+  if (Lanes.IsEmpty() || size < kHashMt_LaneBlockSizeMin)
+  {
+    FOR_VECTOR (i, Hb.Hashers)
+      Hb.Hashers[i].Hasher->Update(data, size);
+    return;
+  }
+  _laneData = data;
+  _laneSize = size;
+  unsigned i;
+  for (i = 0; i < Lanes.Size(); i++)
+    Lanes[i].StartEvent.Set();
+  UpdateLane(0);
+  for (i = 0; i < Lanes.Size(); i++)
+    Lanes[i].DoneEvent.Lock();
+}
+
+void CHashMtFileThread::HashItem(unsigned index, CHashMtSlot &slot)
+{
+  const CDirItems &dirItems = *Mt->DirItems;
+  const CDirItem &di = dirItems.Items[index];
+
+  slot.Res = S_OK;
+  slot.OpenError = false;
+  slot.Size_Defined = false;
+  slot.FileSize = 0;
+
+  Hb.InitForNewFile();
+
+  CMyComPtr<ISequentialInStream> inStream;
+  bool isDir = false;
+
+  #ifndef UNDER_CE
+  if (di.ReparseData.Size() != 0)
+  {
+    CBufInStream *inStreamSpec = new CBufInStream();
+    inStream = inStreamSpec;
+    inStreamSpec->Init(di.ReparseData, di.ReparseData.Size());
+  }
+  else
+  #endif
+  {
+    isDir = di.IsDir();
+    if (!isDir)
+    {
+      CInFileStream *inStreamSpec = new CInFileStream;
+      inStreamSpec->Set_PreserveATime(Mt->PreserveATime);
+      inStream = inStreamSpec;
+      if (!inStreamSpec->OpenShared(dirItems.GetPhyPath(index), Mt->OpenShareForWrite))
+      {
+        slot.SystemError = ::GetLastError();
+        slot.OpenError = true;
+        return;
+      }
+      if (inStreamSpec->GetSize(&slot.Size) == S_OK)
+        slot.Size_Defined = true;
+    }
+  }
+
+  if (inStream)
+  {
+    for (;;)
+    {
+      UInt32 size;
+      const HRESULT res = inStream->Read(Buf, kHashMt_BlockSize, &size);
+      if (res != S_OK)
+      {
+        slot.Res = res;
+        break;
+      }
+      if (size == 0)
+        break;
+      Update((const Byte *)(void *)Buf, size);
+      slot.FileSize += size;
+      bool stop;
+      {
+        NSynchronization::CCriticalSectionLock lock(Mt->CS);
+        Mt->CompleteValue += size;
+        stop = Mt->Stop;
+      }
+      Mt->ProgressEvent.Set();
+      if (stop)
+      {
+        slot.Res = E_ABORT;
+        break;
+      }
+    }
+  }
+
+  FOR_VECTOR (i, Hb.Hashers)
+  {
+    CHasherState &h = Hb.Hashers[i];
+    if (!isDir)
+      h.Hasher->Final(h.Digests[k_HashCalc_Index_Current]);
+    memcpy(slot.Digests + i * k_HashCalc_DigestSize_Max,
+        h.Digests[k_HashCalc_Index_Current], h.DigestSize);
+  }
+}
+
+THREAD_FUNC_DECL CHashMtFileThread::ThreadFunc(void *p)
+{
+  ((CHashMtFileThread *)p)->Execute();
+  return 0;
+}
+
+void CHashMtFileThread::Execute()
+{
+  const unsigned numItems = Mt->DirItems->Items.Size();
+  for (;;)
+  {
+    if (Mt->SlotSemaphore.Lock() != 0)
+      return;
+    unsigned index;
+    {
+      NSynchronization::CCriticalSectionLock lock(Mt->CS);
+      if (Mt->Stop || Mt->NextItem >= numItems)
+        return;
+      index = Mt->NextItem++;
+    }
+    CHashMtSlot &slot = Mt->Slots[index % kHashMt_NumSlots];
+    HashItem(index, slot);
+    {
+      NSynchronization::CCriticalSectionLock lock(Mt->CS);
+      slot.Finished = true;
+    }
+    Mt->ProgressEvent.Set();
+  }
+}
+
+WRes CHashMtFileThread::Create(unsigned numLanes)
+{
+  for (unsigned i = 1; i < numLanes; i++)
+  {
+    CHashMtLane &lane = Lanes.AddNew();
+    lane.Parent = this;
+    lane.Index = i;
+    RINOK_WRes(lane.StartEvent.Create())
+    RINOK_WRes(lane.DoneEvent.Create())
+    RINOK_WRes(lane.Thread.Create(CHashMtLane::ThreadFunc, &lane))
+  }
+  return Thread.Create(ThreadFunc, this);
+}
+
+WRes CHashMt::Create(unsigned numLanes)
+{
+  RINOK_WRes(ProgressEvent.Create())
+  RINOK_WRes(SlotSemaphore.Create(kHashMt_NumSlots, kHashMt_NumSlots + FileThreads.Size()))
+  SemaphoreCreated = true;
+  for (unsigned i = 0; i < kHashMt_NumSlots; i++)
+  {
+    CHashMtSlot &slot = Slots.AddNew();
+    slot.Digests.Alloc(FileThreads[0].Hb.Hashers.Size() * k_HashCalc_DigestSize_Max);
+  }
+  FOR_VECTOR (i, FileThreads)
+  {
+    CHashMtFileThread &ft = FileThreads[i];
+    ft.Mt = this;
+    RINOK_WRes(ft.Create(numLanes))
+  }
+  return 0;
+}
+
+void CHashMt::StopThreads()
+{
+  {
+    NSynchronization::CCriticalSectionLock lock(CS);
+    Stop = true;
+  }
+  // we wake up the threads that wait free slot
+  if (SemaphoreCreated)
+    SlotSemaphore.Release(FileThreads.Size());
+  FOR_VECTOR (i, FileThreads)
+  {
+    CHashMtFileThread &ft = FileThreads[i];
+    if (ft.Thread.IsCreated())
+      ft.Thread.Wait_Close();
+    ft.ExitLanes = true;
+    FOR_VECTOR (k, ft.Lanes)
+    {
+      CHashMtLane &lane = ft.Lanes[k];
+      if (lane.Thread.IsCreated())
+      {
+        lane.StartEvent.Set();
+        lane.Thread.Wait_Close();
+      }
+    }
+  }
+}
+
+void CHashMt::ReleaseSlot(CHashMtSlot &slot)
+{
+  {
+    NSynchronization::CCriticalSectionLock lock(CS);
+    slot.Finished = false;
+  }
+  SlotSemaphore.Release();
+}
+
+
+struct CHashThreadsReserve
+{
+  UInt32 NumThreads;
+  CHashThreadsReserve(): NumThreads(0) {}
+  ~CHashThreadsReserve() { ThreadPool_ReleaseThreads(NumThreads); }
+};
+
+static HRESULT HashItems_Mt(
+    DECL_EXTERNAL_CODECS_LOC_VARS
+    const CDirItems &dirItems,
+    const CHashOptions &options,
+    UInt32 numThreads,
+    CHashBundle &hb,
+    UInt64 &totalSize,
+    IHashCallbackUI *callback)
+{
+  const unsigned numHashers = hb.Hashers.Size();
+  const unsigned numItems = dirItems.Items.Size();
+  
+  unsigned numLanes = numHashers;
+  if (numLanes > numThreads)
+    numLanes = numThreads;
+  if (numLanes == 0)
+    numLanes = 1;
+  unsigned numFileThreads = numThreads / numLanes;
+  if (numFileThreads > numItems)
+    numFileThreads = numItems;
+  if (numFileThreads == 0)
+    numFileThreads = 1;
+
+  // the threads that are not used by files and lanes are given to multithreaded hashers
+  const UInt32 numHasherThreads = numThreads / (numFileThreads * numLanes);
+
+  CHashMt mt;
+  mt.DirItems = &dirItems;
+  mt.PreserveATime = options.PreserveATime;
+  mt.OpenShareForWrite = options.OpenShareForWrite;
+  {
+    for (unsigned i = 0; i < numFileThreads; i++)
+    {
+      CHashMtFileThread &ft = mt.FileThreads.AddNew();
+      RINOK(ft.Hb.SetMethods(EXTERNAL_CODECS_LOC_VARS options.Methods))
+      if (numHasherThreads > 1)
+        RINOK(ft.Hb.SetNumThreads(numHasherThreads))
+      if (!ft.Buf.Alloc(kHashMt_BlockSize))
+        return E_OUTOFMEMORY;
+    }
+    const WRes wres = mt.Create(numLanes);
+    if (wres != 0)
+      return HRESULT_FROM_WIN32(wres);
+  }
+
+  for (unsigned i = 0; i < numItems; i++)
+  {
+    CHashMtSlot &slot = mt.Slots[i % kHashMt_NumSlots];
+    for (;;)
+    {
+      bool finished;
+      UInt64 completeValue;
+      {
+        NSynchronization::CCriticalSectionLock lock(mt.CS);
+        finished = slot.Finished;
+        completeValue = mt.CompleteValue;
+      }
+      RINOK(callback->SetCompleted(&completeValue))
+      if (finished)
+        break;
+      mt.ProgressEvent.Lock();
+    }
+
+    const UString path = dirItems.GetLogPath(i);
+    const CDirItem &di = dirItems.Items[i];
+    bool isAltStream = false;
+   #ifdef _WIN32
+    isAltStream = di.IsAltStream;
+   #endif
+    bool isDir = di.IsDir();
+   #ifndef UNDER_CE
+    if (di.ReparseData.Size() != 0)
+      isDir = false;
+   #endif
+
+    if (slot.OpenError)
+    {
+      const HRESULT res = callback->OpenFileError(dirItems.GetPhyPath(i), slot.SystemError);
+      hb.NumErrors++;
+      if (res != S_FALSE)
+        return res;
+      mt.ReleaseSlot(slot);
+      continue;
+    }
+    if (slot.Size_Defined && slot.Size > di.Size)
+    {
+      totalSize += slot.Size - di.Size;
+      RINOK(callback->SetTotal(totalSize))
+    }
+
+    RINOK(callback->GetStream(path, isDir))
+    RINOK(slot.Res)
+    
+    hb.InitForNewFile();
+    hb.SetSize(slot.FileSize);
+    FOR_VECTOR (k, hb.Hashers)
+    {
+      CHasherState &h = hb.Hashers[k];
+      memcpy(h.Digests[k_HashCalc_Index_Current],
+          slot.Digests + k * k_HashCalc_DigestSize_Max, h.DigestSize);
+    }
+    hb.Final_Digests(isDir, isAltStream, path);
+    
+    RINOK(callback->SetOperationResult(slot.FileSize, hb, !isDir))
+    mt.ReleaseSlot(slot);
+  }
+
+  UInt64 completeValue;
+  {
+    NSynchronization::CCriticalSectionLock lock(mt.CS);
+    completeValue = mt.CompleteValue;
+  }
+  return callback->SetCompleted(&completeValue);
+}
+
+#endif
+
+
 HRESULT HashCalc(
     DECL_EXTERNAL_CODECS_LOC_VARS
     const NWildcard::CCensor &censor,
@@ -475,6 +940,7 @@ HRESULT HashCalc(
     dirItems.ExcludeFileItems = censor.ExcludeFileItems;
 
     dirItems.ShareForWrite = options.OpenShareForWrite;
+    dirItems.NumScanThreads = options.NumScanThreads;
 
     HRESULT res = EnumerateItems(censor,
         options.PathMode,
@@ -508,15 +974,41 @@ HRESULT HashCalc(
     RINOK(callback->SetTotal(totalSize))
   }
 
-  const UInt32 kBufSize = 1 << 15;
-  CHashMidBuf buf;
-  if (!buf.Alloc(kBufSize))
-    return E_OUTOFMEMORY;
-
   UInt64 completeValue = 0;
 
   RINOK(callback->BeforeFirstFile(hb))
 
+  const UInt32 kBufSize = 1 << 15;
+  UInt32 bufSize = kBufSize;
+  unsigned progressMask = 0xFF;
+
+ #ifndef Z7_ST
+  CHashThreadsReserve threadsReserve;
+  if (options.NumThreads > 1)
+  {
+    // we limit the number of threads, if there is process-wide limit in thread pool
+    threadsReserve.NumThreads = ThreadPool_ReserveThreads(options.NumThreads);
+    if (!options.StdInMode && dirItems.Items.Size() > 1)
+    {
+      RINOK(HashItems_Mt(EXTERNAL_CODECS_LOC_VARS
+          dirItems, options, threadsReserve.NumThreads, hb, totalSize, callback))
+      return callback->AfterLastFile(hb);
+    }
+    /* there is only one stream. So we use threads inside hashers,
+       and the big buffer allows to split data to big subtrees */
+    if (threadsReserve.NumThreads > 1)
+    {
+      RINOK(hb.SetNumThreads(threadsReserve.NumThreads))
+      bufSize = kHashMt_BlockSize << 2;
+      progressMask = 0x1;
+    }
+  }
+ #endif
+
+  CHashMidBuf buf;
+  if (!buf.Alloc(bufSize))
+    return E_OUTOFMEMORY;
+
   /*
   CDynLimBuf hashFileString((size_t)1 << 31);
   const bool needGenerate = !options.HashFilePath.IsEmpty();
@@ -594,13 +1086,13 @@ HRESULT HashCalc(
     {
       for (UInt32 step = 0;; step++)
       {
-        if ((step & 0xFF) == 0)
+        if ((step & progressMask) == 0)
         {
           // printf("\ncompl = %d\n", (unsigned)(completeValue >> 20));
           RINOK(callback->SetCompleted(&completeValue))
         }
         UInt32 size;
-        RINOK(inStream->Read(buf, kBufSize, &size))
+        RINOK(inStream->Read(buf, bufSize, &size))
         if (size == 0)
           break;
         hb.Update(buf, size);
@@ -1409,7 +1901,9 @@ static bool CheckDigests(const Byte *a, const Byte *b, size_t size)
 static void AddDefaultMethod(UStringVector &methods, unsigned size)
 {
   const char *m = NULL;
-       if (size == 32) m = "sha256";
+       if (size == 64) m = "sha512";
+  else if (size == 48) m = "sha384";
+  else if (size == 32) m = "sha256";
   else if (size == 20) m = "sha1";
   else if (size == 16) m = "md5";
   else if (size ==  8) m = "crc64";
@@ -95,6 +95,8 @@ struct CHashBundle Z7_final: public IHashCalc
   UString FirstFileName;
 
   HRESULT SetMethods(DECL_EXTERNAL_CODECS_LOC_VARS const UStringVector &methods);
+  // it sets the number of threads for hashers that support multithreading (ICompressSetCoderMt)
+  HRESULT SetNumThreads(UInt32 numThreads);
   
   // void Init() {}
   CHashBundle()
@@ -106,6 +108,10 @@ struct CHashBundle Z7_final: public IHashCalc
   void Update(const void *data, UInt32 size) Z7_override;
   void SetSize(UInt64 size) Z7_override;
   void Final(bool isDir, bool isAltStream, const UString &path) Z7_override;
+
+  /* Final_Digests() is same as Final(), but it doesn't finalize hashers for data.
+     The caller must write data digests to (Digests[k_HashCalc_Index_Current]) before. */
+  void Final_Digests(bool isDir, bool isAltStream, const UString &path);
 };
 
 Z7_PURE_INTERFACES_BEGIN
@@ -196,6 +202,8 @@ struct CHashOptions
   bool StdInMode;
   bool AltStreamsMode;
   CBoolPair SymLinks;
+  UInt32 NumScanThreads;
+  UInt32 NumThreads; // the number of threads for hashing of files
 
   NWildcard::ECensorPathMode PathMode;
 
@@ -204,6 +212,8 @@ struct CHashOptions
       OpenShareForWrite(false),
       StdInMode(false),
       AltStreamsMode(false),
+      NumScanThreads(1),
+      NumThreads(1),
       PathMode(NWildcard::k_RelatPath) {}
 };
 
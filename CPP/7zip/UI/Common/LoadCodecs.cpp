@@ -33,6 +33,10 @@ EXPORT_CODECS
 
 #include "StdAfx.h"
 
+#ifdef Z7_LARGE_PAGES
+#include "../../../../C/Alloc.h"
+#endif
+
 #include "../../../Common/MyCom.h"
 #include "../../../Common/StringToInt.h"
 #include "../../../Common/StringConvert.h"
@@ -497,7 +501,7 @@ HRESULT CCodecs::LoadFormats()
   return S_OK;
 }
 
-#ifdef Z7_LARGE_PAGES
+#if defined(Z7_LARGE_PAGES) && (defined(_WIN32) || defined(Z7_LARGE_PAGES_LINUX))
 extern "C"
 {
   extern SIZE_T g_LargePageSize;
@@ -631,7 +635,7 @@ HRESULT CCodecs::LoadDll(const FString &dllPath, bool needCheckDll, bool *loaded
     }
     */
 
-    #ifdef Z7_LARGE_PAGES
+    #if defined(Z7_LARGE_PAGES) && (defined(_WIN32) || defined(Z7_LARGE_PAGES_LINUX))
     if (g_LargePageSize != 0)
     {
       MY_GET_FUNC_LOC (setLargePageMode, Func_SetLargePageMode, lib.Lib, "SetLargePageMode")
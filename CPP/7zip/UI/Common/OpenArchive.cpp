@@ -44,6 +44,18 @@
 // increase it, if you need to support larger SFX stubs
 static const UInt64 kMaxCheckStartPosition = 1 << 23;
 
+bool g_ArcMemMapMode = false;
+
+static void MapArcFileToMemory(CInFileStream *stream)
+{
+ #ifdef Z7_FILE_STREAMS_USE_MMAP
+  if (g_ArcMemMapMode)
+    stream->MapToMemory(); // if mapping fails, we read the file with Read() calls
+ #else
+  UNUSED_VAR(stream)
+ #endif
+}
+
 /*
 Open:
   - formatIndex >= 0 (exact Format)
@@ -3093,8 +3105,9 @@ HRESULT CArc::OpenStreamOrFile(COpenOptions &op)
     fileStreamSpec = new CInFileStream;
     fileStream = fileStreamSpec;
     Path = filePath;
-    if (!fileStreamSpec->Open(us2fs(Path)))
+    if (!fileStreamSpec->OpenShared(us2fs(Path), op.shareForWrite))
       return GetLastError_noZero_HRESULT();
+    MapArcFileToMemory(fileStreamSpec);
     op.stream = fileStream;
     #ifdef Z7_SFX
     IgnoreSplit = true;
@@ -3519,6 +3532,7 @@ HRESULT CArchiveLink::ReOpen(COpenOptions &op)
   CMyComPtr<IInStream> stream(fileStreamSpec);
   if (!fileStreamSpec->Open(us2fs(op.filePath)))
     return GetLastError_noZero_HRESULT();
+  MapArcFileToMemory(fileStreamSpec);
   op.stream = stream;
 
   CArc &arc = Arcs[0];
@@ -129,6 +129,7 @@ struct COpenOptions
   // bool openOnlySpecifiedByExtension,
 
   bool stdInMode;
+  bool shareForWrite; // allow other handles to write to archive file (for append mode)
   UString filePath;
 
   COpenOptions():
@@ -139,7 +140,8 @@ struct COpenOptions
       seqStream(NULL),
       callback(NULL),
       callbackSpec(NULL),
-      stdInMode(false)
+      stdInMode(false),
+      shareForWrite(false)
     {}
 
 };
@@ -445,6 +447,9 @@ struct CArchiveLink
 
 bool ParseOpenTypes(CCodecs &codecs, const UString &s, CObjectVector<COpenType> &types);
 
+// if (g_ArcMemMapMode), archive files are mapped to memory (-smm switch)
+extern bool g_ArcMemMapMode;
+
 // bool IsHashType(const CObjectVector<COpenType> &types);
 
 
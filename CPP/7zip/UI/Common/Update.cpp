@@ -624,6 +624,7 @@ static HRESULT Compress(
   updateCallbackSpec->ShareForWrite = options.OpenShareForWrite;
   updateCallbackSpec->StopAfterOpenError = options.StopAfterOpenError;
   updateCallbackSpec->StdInMode = options.StdInMode;
+  updateCallbackSpec->AsyncFileIo = options.AsyncFileIo;
   updateCallbackSpec->Callback = callback;
 
   if (arc)
@@ -676,6 +677,34 @@ static HRESULT Compress(
   CStdOutFileStream *stdOutFileStreamSpec = NULL;
   CMultiOutStream *volStreamSpec = NULL;
 
+  /* In append mode the handler writes new data to the end of existing archive file
+     instead of creating new temp archive. We use it only for simple case:
+     the archive that is updated itself without SFX module and volumes. */
+  CMyComPtr<IOutArchiveAppend> outArchiveAppend;
+  bool appendMode = false;
+  UInt64 appendArcSize = 0;
+
+  if (options.AppendMode
+      && isUpdatingItself
+      && archivePath.Temp
+      && !options.StdOutMode
+      && !options.SfxMode
+      && options.VolumesSizes.Size() == 0
+      && arc
+      && arc->ArcStreamOffset == 0)
+  {
+    outArchive.QueryInterface(IID_IOutArchiveAppend, &outArchiveAppend);
+    if (outArchiveAppend)
+    {
+      const HRESULT res = outArchiveAppend->SetAppendMode(1);
+      if (res != S_FALSE)
+      {
+        RINOK(res)
+        appendMode = true;
+      }
+    }
+  }
+
   if (options.VolumesSizes.Size() == 0)
   {
     if (options.StdOutMode)
@@ -690,7 +719,26 @@ static HRESULT Compress(
       outStream = outSeekStream;
       bool isOK = false;
       FString realPath;
+
+      if (appendMode)
+      {
+        realPath = us2fs(archivePath.GetFinalPath());
+        if (outStreamSpec->Open_EXISTING(realPath)
+            && outStreamSpec->GetSize(&appendArcSize) == S_OK)
+        {
+          isOK = true;
+          // the archive will not be moved from temp path
+          archivePath.Temp = false;
+        }
+        else
+        {
+          // we can't write to archive file, so we use usual update mode
+          RINOK(outArchiveAppend->SetAppendMode(0))
+          appendMode = false;
+        }
+      }
       
+      if (!appendMode)
       for (unsigned i = 0; i < (1 << 16); i++)
       {
         if (archivePath.Temp)
@@ -852,6 +900,11 @@ static HRESULT Compress(
 
   HRESULT result = outArchive->UpdateItems(tailStream, updatePairs2.Size(), updateCallback);
   // callback->Finalize();
+  if (result != S_OK && appendMode)
+  {
+    // the start header of archive is written last, so we only remove appended data
+    outSeekStream->SetSize(appendArcSize);
+  }
   RINOK(result)
 
   if (!updateCallbackSpec->AreAllFilesClosed())
@@ -1254,6 +1307,8 @@ HRESULT UpdateArchive(
       op.types = &types2;
       op.excludedFormats = &excl;
       op.stdInMode = false;
+      // in append mode we write to archive file, while it's open for reading
+      op.shareForWrite = options.AppendMode;
       op.stream = NULL;
       op.filePath = arcPath;
 
@@ -1363,6 +1418,7 @@ HRESULT UpdateArchive(
       dirItems.ExcludeFileItems = censor.ExcludeFileItems;
       
       dirItems.ShareForWrite = options.OpenShareForWrite;
+      dirItems.NumScanThreads = options.NumScanThreads;
 
      #ifndef _WIN32
       dirItems.StoreOwnerName = options.StoreOwnerName.Val;
@@ -1587,7 +1643,8 @@ HRESULT UpdateArchive(
   RINOK(multiStreams.Destruct())
 
   tempFiles.Paths.Clear();
-  if (createTempFile)
+  // (ArchivePath.Temp) was cleared in Compress(), if new data was appended to archive file
+  if (createTempFile && options.Commands[0].ArchivePath.Temp)
   {
     try
     {
@@ -87,6 +87,8 @@ struct CUpdateOptions
   bool PreserveATime;
   bool OpenShareForWrite;
   bool StopAfterOpenError;
+  bool AsyncFileIo;
+  UInt32 NumScanThreads;
 
   bool StdInMode;
   bool StdOutMode;
@@ -96,6 +98,7 @@ struct CUpdateOptions
 
   bool DeleteAfterCompressing;
   bool SetArcMTime;
+  bool AppendMode; // write new data to the end of existing archive instead of temp archive
 
   CBoolPair NtSecurity;
   CBoolPair AltStreams;
@@ -132,6 +135,8 @@ struct CUpdateOptions
     PreserveATime(false),
     OpenShareForWrite(false),
     StopAfterOpenError(false),
+    AsyncFileIo(false),
+    NumScanThreads(1),
 
     StdInMode(false),
     StdOutMode(false),
@@ -141,6 +146,7 @@ struct CUpdateOptions
     
     DeleteAfterCompressing(false),
     SetArcMTime(false),
+    AppendMode(false),
 
     ArcNameMode(k_ArcNameMode_Smart),
     PathMode(NWildcard::k_RelatPath)
@@ -66,6 +66,7 @@ CArchiveUpdateCallback::CArchiveUpdateCallback():
     ShareForWrite(false),
     StopAfterOpenError(false),
     StdInMode(false),
+    AsyncFileIo(false),
     
     KeepOriginalItemNames(false),
     StoreNtSecurity(false),
@@ -741,6 +742,9 @@ Z7_COM7F_IMF(CArchiveUpdateCallback::GetStream2(UInt32 index, ISequentialInStrea
     }
     // #endif
 
+    if (AsyncFileIo && mode != NUpdateNotifyOp::kAnalyze)
+      inStreamSpec->StartReadAhead();
+
     UpdateProcessedItemStatus((unsigned)up.DirIndex);
     *inStream = inStreamLoc.Detach();
   }
@@ -166,15 +166,19 @@ static const char * const kHelpString =
     #endif
     "  -r[-|0] : Recurse subdirectories for name search\n"
     "  -sa{a|e|s} : set Archive name mode\n"
+    "  -sap : append new data to the end of existing archive without rewriting it\n"
     "  -scc{UTF-8|WIN|DOS} : set charset for console input/output\n"
     "  -scs{UTF-8|UTF-16LE|UTF-16BE|WIN|DOS|{id}} : set charset for list files\n"
     "  -scrc[CRC32|CRC64|SHA1|SHA256|*] : set hash function for x, e, h commands\n"
     "  -sdel : delete files after compression\n"
+    "  -sdt[N] : scan directories with N threads\n"
     "  -seml[.] : send archive by email\n"
+    "  -sfio : use read-ahead and write-behind threads for files\n"
     "  -sfx[{name}] : Create SFX archive\n"
     "  -si[{name}] : read data from stdin\n"
     "  -slp : set Large Pages mode\n"
     "  -slt : show technical information for l (List) command\n"
+    "  -smm : use memory-mapped files for reading of archives\n"
     "  -snh : store hard links as links\n"
     "  -snl : store symbolic links as links\n"
     "  -sni : store NT security information\n"
@@ -189,6 +193,7 @@ static const char * const kHelpString =
     "  -ssw : compress shared files\n"
     "  -stl : set archive timestamp from the most recently modified file\n"
     "  -stm{HexMask} : set CPU thread affinity mask (hexadecimal number)\n"
+    "  -stp[N] : use shared pool of threads, N : max number of busy coder threads\n"
     "  -stx{Type} : exclude archive type\n"
     "  -t{Type} : Set type of archive\n"
     "  -u[-][p#][q#][r#][x#][y#][z#][!newArchiveName] : Update options\n"
@@ -0,0 +1,264 @@
+// Blake3Reg.cpp
+
+#include "StdAfx.h"
+
+#include "../../C/Blake3.h"
+
+#include "../Common/MyBuffer2.h"
+#include "../Common/MyCom.h"
+
+#ifndef Z7_ST
+#include "../Common/MyVector.h"
+#include "../Windows/Synchronization.h"
+#include "../Windows/Thread.h"
+#endif
+
+#include "../7zip/Common/RegisterCodec.h"
+
+static struct CBlake3Prepare { CBlake3Prepare() { Blake3Prepare(); } } g_Blake3Prepare;
+
+#ifndef Z7_ST
+
+// the minimal size of subtree that is hashed by one thread
+static const size_t kBlake3_MtPartSizeMin = (size_t)1 << 17;
+
+class CBlake3Hasher;
+
+struct CBlake3HasherThread
+{
+  CBlake3Hasher *Hasher;
+  const Byte *Data;
+  size_t Size;
+  UInt64 ChunkIndex;
+  Byte Cv[BLAKE3_CV_SIZE];
+  NWindows::NSynchronization::CAutoResetEvent StartEvent;
+  NWindows::NSynchronization::CAutoResetEvent DoneEvent;
+  NWindows::CPoolThread Thread;
+
+  static THREAD_FUNC_DECL ThreadFunc(void *p);
+};
+
+#endif
+
+class CBlake3Hasher Z7_final:
+  public IHasher,
+  public ICompressSetCoderProperties,
+ #ifndef Z7_ST
+  public ICompressSetCoderMt,
+ #endif
+  public CMyUnknownImp
+{
+  Z7_COM_QI_BEGIN2(IHasher)
+  Z7_COM_QI_ENTRY(ICompressSetCoderProperties)
+ #ifndef Z7_ST
+  Z7_COM_QI_ENTRY(ICompressSetCoderMt)
+ #endif
+  Z7_COM_QI_END
+  Z7_COM_ADDREF_RELEASE
+
+  Z7_IFACE_COM7_IMP(IHasher)
+  Z7_IFACE_COM7_IMP(ICompressSetCoderProperties)
+ #ifndef Z7_ST
+  Z7_IFACE_COM7_IMP(ICompressSetCoderMt)
+ #endif
+
+  CAlignedBuffer1 _buf;
+ #ifndef Z7_ST
+  UInt32 _numThreads;
+  CObjectVector<CBlake3HasherThread> _threads;
+  bool _exitThreads;
+
+  unsigned CreateThreads(unsigned numThreads);
+  void UpdateMt(const Byte *data, size_t size);
+  friend struct CBlake3HasherThread;
+ #endif
+public:
+  Byte _mtDummy[1 << 7];
+
+  CBlake3 *Blake() { return (CBlake3 *)(void *)(Byte *)_buf; }
+public:
+  CBlake3Hasher():
+      _buf(sizeof(CBlake3))
+     #ifndef Z7_ST
+      , _numThreads(1)
+      , _exitThreads(false)
+     #endif
+  {
+    Blake3_SetFunction(Blake(), BLAKE3_ALGO_DEFAULT);
+    Blake3_InitState(Blake());
+  }
+ #ifndef Z7_ST
+  ~CBlake3Hasher();
+ #endif
+};
+
+
+#ifndef Z7_ST
+
+THREAD_FUNC_DECL CBlake3HasherThread::ThreadFunc(void *p)
+{
+  CBlake3HasherThread &t = *(CBlake3HasherThread *)p;
+  for (;;)
+  {
+    t.StartEvent.Lock();
+    if (t.Hasher->_exitThreads)
+      return 0;
+    Blake3_HashSubtree(t.Hasher->Blake(), t.Data, t.Size, t.ChunkIndex, t.Cv);
+    t.DoneEvent.Set();
+  }
+}
+
+CBlake3Hasher::~CBlake3Hasher()
+{
+  _exitThreads = true;
+  FOR_VECTOR (i, _threads)
+  {
+    CBlake3HasherThread &t = _threads[i];
+    if (t.Thread.IsCreated())
+    {
+      t.StartEvent.Set();
+      t.Thread.Wait_Close();
+    }
+  }
+}
+
+/* it creates the worker threads, if they were not created before.
+   It returns the number of threads that can be used (including main thread). */
+
+unsigned CBlake3Hasher::CreateThreads(unsigned numThreads)
+{
+  while (_threads.Size() + 1 < numThreads)
+  {
+    CBlake3HasherThread &t = _threads.AddNew();
+    t.Hasher = this;
+    if (t.StartEvent.Create() != 0
+        || t.DoneEvent.Create() != 0
+        || t.Thread.Create(CBlake3HasherThread::ThreadFunc, &t) != 0)
+    {
+      _threads.DeleteBack();
+      break;
+    }
+  }
+  return _threads.Size() + 1;
+}
+
+void CBlake3Hasher::UpdateMt(const Byte *data, size_t size)
+{
+  CBlake3 *p = Blake();
+  for (;;)
+  {
+    {
+      const size_t processed = Blake3_Update_ToChunkBoundary(p, data, size);
+      data += processed;
+      size -= processed;
+    }
+    const size_t subtreeSize = Blake3_GetSubtreeSize(p, size);
+    if (subtreeSize == 0)
+      break;
+    unsigned numParts = 1;
+    while (numParts * 2 <= _numThreads && subtreeSize / (numParts * 2) >= kBlake3_MtPartSizeMin)
+      numParts *= 2;
+    if (numParts > 1)
+    {
+      const unsigned numCreated = CreateThreads(numParts);
+      while (numParts > numCreated)
+        numParts /= 2;
+    }
+    if (numParts < 2)
+      Blake3_Update(p, data, subtreeSize);
+    else
+    {
+      Byte cvs[BLAKE3_CV_SIZE * 64];
+      const size_t partSize = subtreeSize / numParts;
+      const UInt64 numPartChunks = partSize / BLAKE3_CHUNK_SIZE;
+      unsigned i;
+      for (i = 1; i < numParts; i++)
+      {
+        CBlake3HasherThread &t = _threads[i - 1];
+        t.Data = data + partSize * i;
+        t.Size = partSize;
+        t.ChunkIndex = p->chunkCounter + numPartChunks * i;
+        t.StartEvent.Set();
+      }
+      Blake3_HashSubtree(p, data, partSize, p->chunkCounter, cvs);
+      for (i = 1; i < numParts; i++)
+      {
+        CBlake3HasherThread &t = _threads[i - 1];
+        t.DoneEvent.Lock();
+        memcpy(cvs + BLAKE3_CV_SIZE * i, t.Cv, BLAKE3_CV_SIZE);
+      }
+      Blake3_AddSubtree(p, cvs, numParts, subtreeSize);
+    }
+    data += subtreeSize;
+    size -= subtreeSize;
+  }
+  Blake3_Update(p, data, size);
+}
+
+Z7_COM7F_IMF(CBlake3Hasher::SetNumberOfThreads(UInt32 numThreads))
+{
+  // (cvs) buffer in UpdateMt() is limited to 64 parts
+  if (numThreads > 64)
+    numThreads = 64;
+  if (numThreads == 0)
+    numThreads = 1;
+  _numThreads = numThreads;
+  return S_OK;
+}
+
+#endif
+
+
+Z7_COM7F_IMF2(void, CBlake3Hasher::Init())
+{
+  Blake3_InitState(Blake());
+}
+
+Z7_COM7F_IMF2(void, CBlake3Hasher::Update(const void *data, UInt32 size))
+{
+ #ifndef Z7_ST
+  if (_numThreads > 1 && size >= kBlake3_MtPartSizeMin * 2)
+  {
+    UpdateMt((const Byte *)data, size);
+    return;
+  }
+ #endif
+  Blake3_Update(Blake(), (const Byte *)data, size);
+}
+
+Z7_COM7F_IMF2(void, CBlake3Hasher::Final(Byte *digest))
+{
+  Blake3_Final(Blake(), digest);
+}
+
+
+Z7_COM7F_IMF(CBlake3Hasher::SetCoderProperties(const PROPID *propIDs, const PROPVARIANT *coderProps, UInt32 numProps))
+{
+  unsigned algo = BLAKE3_ALGO_DEFAULT;
+  for (UInt32 i = 0; i < numProps; i++)
+  {
+    const PROPVARIANT &prop = coderProps[i];
+    const PROPID propID = propIDs[i];
+    if (propID == NCoderPropID::kDefaultProp)
+    {
+      if (prop.vt != VT_UI4)
+        return E_INVALIDARG;
+      if (prop.ulVal > BLAKE3_ALGO_AVX512)
+        return E_NOTIMPL;
+      algo = (unsigned)prop.ulVal;
+    }
+   #ifndef Z7_ST
+    else if (propID == NCoderPropID::kNumThreads)
+    {
+      if (prop.vt != VT_UI4)
+        return E_INVALIDARG;
+      RINOK(SetNumberOfThreads(prop.ulVal))
+    }
+   #endif
+  }
+  if (!Blake3_SetFunction(Blake(), algo))
+    return E_NOTIMPL;
+  return S_OK;
+}
+
+REGISTER_HASHER(CBlake3Hasher, 0x204, "BLAKE3", BLAKE3_DIGEST_SIZE)
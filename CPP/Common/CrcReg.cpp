@@ -18,6 +18,7 @@ extern CRC_FUNC g_CrcUpdate;
 extern CRC_FUNC g_CrcUpdateT8;
 extern CRC_FUNC g_CrcUpdateT0_32;
 extern CRC_FUNC g_CrcUpdateT0_64;
+extern CRC_FUNC g_CrcUpdateFold;
 
 EXTERN_C_END
 
@@ -47,6 +48,7 @@ bool CCrcHasher::SetFunctions(UInt32 tSize)
   else if (tSize ==  8) f = g_CrcUpdateT8;
   else if (tSize == 32) f = g_CrcUpdateT0_32;
   else if (tSize == 64) f = g_CrcUpdateT0_64;
+  else if (tSize == 128) f = g_CrcUpdateFold;
   
   if (!f)
   {
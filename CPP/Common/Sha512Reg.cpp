@@ -0,0 +1,91 @@
+// Sha512Reg.cpp
+
+#include "StdAfx.h"
+
+#include "../../C/Sha512.h"
+
+#include "../Common/MyBuffer2.h"
+#include "../Common/MyCom.h"
+
+#include "../7zip/Common/RegisterCodec.h"
+
+Z7_CLASS_IMP_COM_2(
+  CSha512Hasher
+  , IHasher
+  , ICompressSetCoderProperties
+)
+  unsigned _digestSize;
+  CAlignedBuffer1 _buf;
+public:
+  Byte _mtDummy[1 << 7];
+
+  CSha512 *Sha() { return (CSha512 *)(void *)(Byte *)_buf; }
+public:
+  CSha512Hasher(unsigned digestSize):
+    _digestSize(digestSize),
+    _buf(sizeof(CSha512))
+  {
+    Sha512_SetFunction(Sha(), 0);
+    Sha512_InitState(Sha(), _digestSize);
+  }
+};
+
+Z7_COM7F_IMF2(void, CSha512Hasher::Init())
+{
+  Sha512_InitState(Sha(), _digestSize);
+}
+
+Z7_COM7F_IMF2(void, CSha512Hasher::Update(const void *data, UInt32 size))
+{
+  Sha512_Update(Sha(), (const Byte *)data, size);
+}
+
+Z7_COM7F_IMF2(void, CSha512Hasher::Final(Byte *digest))
+{
+  Sha512_Final(Sha(), digest, _digestSize);
+}
+
+Z7_COM7F_IMF2(UInt32, CSha512Hasher::GetDigestSize())
+{
+  return (UInt32)_digestSize;
+}
+
+
+Z7_COM7F_IMF(CSha512Hasher::SetCoderProperties(const PROPID *propIDs, const PROPVARIANT *coderProps, UInt32 numProps))
+{
+  unsigned algo = 0;
+  for (UInt32 i = 0; i < numProps; i++)
+  {
+    if (propIDs[i] == NCoderPropID::kDefaultProp)
+    {
+      const PROPVARIANT &prop = coderProps[i];
+      if (prop.vt != VT_UI4)
+        return E_INVALIDARG;
+      if (prop.ulVal > 2)
+        return E_NOTIMPL;
+      algo = (unsigned)prop.ulVal;
+    }
+  }
+  if (!Sha512_SetFunction(Sha(), algo))
+    return E_NOTIMPL;
+  return S_OK;
+}
+
+// SHA-384 uses same code as SHA-512 with another initial state and truncated digest
+
+static IHasher *CreateHasherSpec_Sha512() { return new CSha512Hasher(SHA512_DIGEST_SIZE); }
+static IHasher *CreateHasherSpec_Sha384() { return new CSha512Hasher(SHA512_384_DIGEST_SIZE); }
+
+static const CHasherInfo g_HasherInfo_Sha512 = { CreateHasherSpec_Sha512, 0x208, "SHA512", SHA512_DIGEST_SIZE };
+static const CHasherInfo g_HasherInfo_Sha384 = { CreateHasherSpec_Sha384, 0x207, "SHA384", SHA512_384_DIGEST_SIZE };
+
+struct CRegHasher_Sha512
+{
+  CRegHasher_Sha512()
+  {
+    RegisterHasher(&g_HasherInfo_Sha512);
+    RegisterHasher(&g_HasherInfo_Sha384);
+  }
+};
+
+static CRegHasher_Sha512 g_RegisterHasher;
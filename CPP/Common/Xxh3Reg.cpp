@@ -0,0 +1,69 @@
+// Xxh3Reg.cpp
+
+#include "StdAfx.h"
+
+#include "../../C/Xxh3.h"
+
+#include "../Common/MyBuffer2.h"
+#include "../Common/MyCom.h"
+
+#include "../7zip/Common/RegisterCodec.h"
+
+static struct CXxh3Prepare { CXxh3Prepare() { Xxh3Prepare(); } } g_Xxh3Prepare;
+
+Z7_CLASS_IMP_COM_2(
+  CXxh128Hasher
+  , IHasher
+  , ICompressSetCoderProperties
+)
+  CAlignedBuffer1 _buf;
+public:
+  Byte _mtDummy[1 << 7];
+
+  CXxh3 *Xxh() { return (CXxh3 *)(void *)(Byte *)_buf; }
+public:
+  CXxh128Hasher():
+    _buf(sizeof(CXxh3))
+  {
+    Xxh3_SetFunction(Xxh(), XXH3_ALGO_DEFAULT);
+    Xxh3_InitState(Xxh());
+  }
+};
+
+Z7_COM7F_IMF2(void, CXxh128Hasher::Init())
+{
+  Xxh3_InitState(Xxh());
+}
+
+Z7_COM7F_IMF2(void, CXxh128Hasher::Update(const void *data, UInt32 size))
+{
+  Xxh3_Update(Xxh(), (const Byte *)data, size);
+}
+
+Z7_COM7F_IMF2(void, CXxh128Hasher::Final(Byte *digest))
+{
+  Xxh3_128_Final(Xxh(), digest);
+}
+
+
+Z7_COM7F_IMF(CXxh128Hasher::SetCoderProperties(const PROPID *propIDs, const PROPVARIANT *coderProps, UInt32 numProps))
+{
+  unsigned algo = XXH3_ALGO_DEFAULT;
+  for (UInt32 i = 0; i < numProps; i++)
+  {
+    if (propIDs[i] == NCoderPropID::kDefaultProp)
+    {
+      const PROPVARIANT &prop = coderProps[i];
+      if (prop.vt != VT_UI4)
+        return E_INVALIDARG;
+      if (prop.ulVal > XXH3_ALGO_AVX2)
+        return E_NOTIMPL;
+      algo = (unsigned)prop.ulVal;
+    }
+  }
+  if (!Xxh3_SetFunction(Xxh(), algo))
+    return E_NOTIMPL;
+  return S_OK;
+}
+
+REGISTER_HASHER(CXxh128Hasher, 0x212, "XXH128", XXH3_128_DIGEST_SIZE)
@@ -0,0 +1,39 @@
+// Xxh64Reg.cpp
+
+#include "StdAfx.h"
+
+#include "../../C/CpuArch.h"
+#include "../../C/Xxh64.h"
+
+#include "../Common/MyCom.h"
+
+#include "../7zip/Common/RegisterCodec.h"
+
+Z7_CLASS_IMP_COM_1(
+  CXxh64Hasher
+  , IHasher
+)
+  CXxh64State _state;
+public:
+  Byte _mtDummy[1 << 7];  // it's public to eliminate clang warning: unused private field
+
+  CXxh64Hasher() { Xxh64State_Init(&_state); }
+};
+
+Z7_COM7F_IMF2(void, CXxh64Hasher::Init())
+{
+  Xxh64State_Init(&_state);
+}
+
+Z7_COM7F_IMF2(void, CXxh64Hasher::Update(const void *data, UInt32 size))
+{
+  Xxh64State_Update(&_state, data, size);
+}
+
+Z7_COM7F_IMF2(void, CXxh64Hasher::Final(Byte *digest))
+{
+  const UInt64 val = Xxh64State_Digest(&_state);
+  SetUi64(digest, val)
+}
+
+REGISTER_HASHER(CXxh64Hasher, 0x211, "XXH64", 8)
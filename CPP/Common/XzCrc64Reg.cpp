@@ -9,17 +9,63 @@
 
 #include "../7zip/Common/RegisterCodec.h"
 
-Z7_CLASS_IMP_COM_1(
+EXTERN_C_BEGIN
+
+extern CRC64_FUNC g_Crc64Update;
+extern CRC64_FUNC g_Crc64UpdateT4;
+extern CRC64_FUNC g_Crc64UpdateFold;
+
+EXTERN_C_END
+
+Z7_CLASS_IMP_COM_2(
   CXzCrc64Hasher
   , IHasher
+  , ICompressSetCoderProperties
 )
   UInt64 _crc;
+  CRC64_FUNC _updateFunc;
+
+  Z7_CLASS_NO_COPY(CXzCrc64Hasher)
+
+  bool SetFunctions(UInt32 tSize);
 public:
   Byte _mtDummy[1 << 7];  // it's public to eliminate clang warning: unused private field
 
-  CXzCrc64Hasher(): _crc(CRC64_INIT_VAL) {}
+  CXzCrc64Hasher(): _crc(CRC64_INIT_VAL) { SetFunctions(0); }
 };
 
+bool CXzCrc64Hasher::SetFunctions(UInt32 tSize)
+{
+  CRC64_FUNC f = NULL;
+       if (tSize ==   0) f = g_Crc64Update;
+  else if (tSize ==   4) f = g_Crc64UpdateT4;
+  else if (tSize == 128) f = g_Crc64UpdateFold;
+
+  if (!f)
+  {
+    _updateFunc = g_Crc64Update;
+    return false;
+  }
+  _updateFunc = f;
+  return true;
+}
+
+Z7_COM7F_IMF(CXzCrc64Hasher::SetCoderProperties(const PROPID *propIDs, const PROPVARIANT *coderProps, UInt32 numProps))
+{
+  for (UInt32 i = 0; i < numProps; i++)
+  {
+    if (propIDs[i] == NCoderPropID::kDefaultProp)
+    {
+      const PROPVARIANT &prop = coderProps[i];
+      if (prop.vt != VT_UI4)
+        return E_INVALIDARG;
+      if (!SetFunctions(prop.ulVal))
+        return E_NOTIMPL;
+    }
+  }
+  return S_OK;
+}
+
 Z7_COM7F_IMF2(void, CXzCrc64Hasher::Init())
 {
   _crc = CRC64_INIT_VAL;
@@ -27,7 +73,7 @@ Z7_COM7F_IMF2(void, CXzCrc64Hasher::Init())
 
 Z7_COM7F_IMF2(void, CXzCrc64Hasher::Update(const void *data, UInt32 size))
 {
-  _crc = Crc64Update(_crc, data, size);
+  _crc = _updateFunc(_crc, data, size, g_Crc64Table);
 }
 
 Z7_COM7F_IMF2(void, CXzCrc64Hasher::Final(Byte *digest))
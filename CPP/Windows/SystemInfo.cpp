@@ -91,7 +91,7 @@ static bool ReadFile_to_Buffer(CFSTR fileName, CByteBuffer &buf)
 #endif
 
 
-#if defined(_WIN32) || defined(AT_HWCAP) || defined(AT_HWCAP2)
+#if defined(_WIN32) || defined(AT_HWCAP) || defined(AT_HWCAP2) || defined(Z7_LARGE_PAGES)
 static void PrintHex(AString &s, UInt64 v)
 {
   char temp[32];
@@ -335,8 +335,9 @@ static AString TypeToString2(const char * const table[], unsigned num, UInt32 va
   return (AString)p;
 }
 
-// #if defined(Z7_LARGE_PAGES) || defined(_WIN32)
-// #ifdef _WIN32
+#endif
+
+#if defined(Z7_LARGE_PAGES) || defined(_WIN32)
 void PrintSize_KMGT_Or_Hex(AString &s, UInt64 v)
 {
   char c = 0;
@@ -356,8 +357,9 @@ void PrintSize_KMGT_Or_Hex(AString &s, UInt64 v)
     s += c;
   s += 'B';
 }
-// #endif
-// #endif
+#endif
+
+#ifdef _WIN32
 
 static void SysInfo_To_String(AString &s, const SYSTEM_INFO &si)
 {
@@ -39,6 +39,24 @@ public:
   #endif
 };
 
+/* CPoolThread can use the thread from process-wide thread pool (C/Threads.h).
+   The caller must stop the thread function before Wait_Close() call. */
+
+class CPoolThread  MY_UNCOPYABLE
+{
+  ::CPoolThread thread;
+public:
+  CPoolThread() { PoolThread_CONSTRUCT(&thread) }
+  ~CPoolThread() { if (IsCreated()) Wait_Close(); }
+  bool IsCreated() { return PoolThread_WasCreated(&thread) != 0; }
+  WRes Wait_Close() { return PoolThread_Wait_Close(&thread); }
+
+  WRes Create(THREAD_FUNC_TYPE startAddress, LPVOID param)
+    { return PoolThread_Create(&thread, startAddress, param); }
+  WRes Create_With_Affinity(THREAD_FUNC_TYPE startAddress, LPVOID param, CAffinityMask affinity)
+    { return PoolThread_Create_With_Affinity(&thread, startAddress, param, affinity); }
+};
+
 }
 
 #endif